@@ -19,52 +19,342 @@
 
 #include "BackendFactory.h"
 #include "Database.h"
+#include "SQLQuerry.h"
+#include "Transaction.h"
+#include "exceptions.h"
+#include "support.h"
+#include "../Support/NaturalOrder.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <stdexcept>
 #include <thread>
+#include <utility>
+#include <variant>
 
 namespace PhotoLibrary {
 namespace Backend {
 
-BackendFactory::BackendFactory(const char* filename) : db(nullptr) {
-	/// \todo load values
-	window_properties[WindowProperties::WINDOW_WIDTH] = 1800;
-	window_properties[WindowProperties::WINDOW_HEIGHT] = 1200;
-	window_properties[WindowProperties::LEFT_PANE_WIDTH] = 250;
-	window_properties[WindowProperties::RIGHT_PANE_WIDTH] = 250;
-	window_properties[WindowProperties::TILE_WIDTH] = 250;
-//	window_properties[WindowProperties::TILE_HEIGHT] = 250;
-	window_properties[WindowProperties::N_THREADS] =
-		std::thread::hardware_concurrency()?std::thread::hardware_concurrency():1;
-
-	db                  = std::make_unique<SQLiteAdapter::Database>(":memory:", true);
+BackendFactory::BackendFactory(const char* filename) :
+		db(nullptr),
+		write_queue([this](std::vector<Support::WriteBehindQueue::Write>& writes) { runWriteGroup(writes); },
+				[this](std::exception_ptr error) { reportWriteError(error); }) {
+	db                  = std::make_unique<SQLiteAdapter::Database>(filename ? filename : ":memory:", true);
+	// pragmas and collations belong to the connection, not to the database file
+	std::string error_msg;
+	if(db->querryNoThrow("PRAGMA foreign_keys = ON;"
+			//needed to propagate photo counts to the parents
+			"PRAGMA recursive_triggers = ON;", nullptr, nullptr, error_msg))
+		throw(std::runtime_error("Error configuring database: " + error_msg));
+	db->createCollation("NATURAL_ORDER", Support::naturalCompare);
+	// with WAL a commit doesn't sync to disk, the checkpoints after the
+	// queued writes do (in their own connection, see runWriteGroup())
+	std::string name = filename ? filename : "";
+	if(!name.empty() && name != ":memory:") {
+		if(db->querryNoThrow("PRAGMA journal_mode = WAL;"
+				"PRAGMA synchronous = NORMAL;", nullptr, nullptr, error_msg))
+			throw(std::runtime_error("Error configuring database: " + error_msg));
+		checkpoint_db = std::make_unique<SQLiteAdapter::Database>(filename, false);
+	}
 	tables_interface    = std::make_unique<PhotoLibrary::DatabaseInterface::AccessTables<Glib::ustring>>(*db);
 	relations_interface = std::make_unique<PhotoLibrary::DatabaseInterface::RelationsTable>(*db);
 
-	bool initialise {true};
-	if(initialise)
+	if(!hasTables())
 		createTables();
-	else
-		;
+
+	loadWindowProperties();
+	buildRelationsIndex(Relations::PHOTOS_ALBUMS);
+	buildRelationsIndex(Relations::PHOTOS_KEYWORDS);
+	loadSmartAlbums();
+}
+
+BackendFactory::~BackendFactory() {
+	// queued here, written by write_queue's destructor
+	saveWindowProperties();
+}
+
+std::unordered_map<int,Support::RoaringBitmap>& BackendFactory::getRelationsIndex(Relations relation) {
+	if(!relations_index_valid[static_cast<int>(relation)])
+		buildRelationsIndex(relation);
+	return relations_index[static_cast<int>(relation)];
+}
+
+void BackendFactory::buildRelationsIndex(Relations relation) {
+	auto& index = relations_index[static_cast<int>(relation)];
+	index.clear();
+	// sorted by collection and photo, so the photos are appended to the bitmaps
+	for(auto [collection, photo] : relations_interface->getRelations(relations_tables[static_cast<int>(relation)]))
+		index[collection].add(photo);
+	relations_index_valid[static_cast<int>(relation)] = true;
+}
+
+void BackendFactory::removePhotosFromRelationsIndex(std::span<const int> photos) {
+	if(photos.empty())
+		return;
+	Support::RoaringBitmap removed(photos.begin(), photos.end());
+	for(std::size_t relation = 0; relation < relations_index.size(); ++relation)
+		if(relations_index_valid[relation])
+			for(auto& [collection, bitmap] : relations_index[relation])
+				bitmap -= removed;
+}
+
+/*
+ * Called before an entry of 'table' is deleted. Deleting an album or a
+ * keyword deletes its subtree and the relations of all entries in it,
+ * deleting a directory deletes the photos in its subtree.
+ */
+void BackendFactory::removeDeletedFromRelationsIndex(const std::string& table, int id) {
+	if(table == RecordClasses::PhotoRecord::table.raw()) {
+		removePhotosFromRelationsIndex(std::span<const int>(&id, 1));
+	}
+	else if(table == RecordClasses::DirectoryRecord::table.raw()) {
+		SQLiteAdapter::SQLQuerry querry(*db,
+				"SELECT id FROM Photos WHERE directory IN (SELECT descendant FROM DirectoriesClosure WHERE ancestor = ?);");
+		querry.bind(1, id);
+		std::vector<int> photos;
+		int i;
+		while((i = querry.nextRow()) == SQLITE_ROW)
+			photos.push_back(querry.getColumnInt(0));
+		if(i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error getting photos (error code: " + std::to_string(i) + ")"));
+		removePhotosFromRelationsIndex(photos);
+	}
+	else {
+		auto& index = relations_index[static_cast<int>(table == RecordClasses::AlbumRecord::table.raw() ?
+				Relations::PHOTOS_ALBUMS : Relations::PHOTOS_KEYWORDS)];
+		index.erase(id);
+		for(int descendant : getDescendants(table, id))
+			index.erase(descendant);
+	}
 }
 
 int BackendFactory::getWindowProperty(WindowProperties property) const {
-	return window_properties.at(property);
+	std::lock_guard<std::mutex> lck {window_properties_mutex};
+	return window_properties.at(static_cast<std::size_t>(property));
 }
 
 void BackendFactory::setWindowProperty(WindowProperties property, int value) {
-	/// \todo save value
-	window_properties[property] = value;
+	std::lock_guard<std::mutex> lck {window_properties_mutex};
+	auto i = static_cast<std::size_t>(property);
+	if(window_properties.at(i) == value)
+		return;
+	window_properties[i] = value;
+	window_properties_changed[i] = true;
+	last_window_property_change = std::chrono::steady_clock::now();
+}
+
+bool BackendFactory::saveWindowProperties(std::chrono::milliseconds quiet) {
+	std::vector<std::pair<std::size_t,int>> changed;
+	{
+		std::lock_guard<std::mutex> lck {window_properties_mutex};
+		if(std::chrono::steady_clock::now() - last_window_property_change < quiet)
+			return false;
+		for(std::size_t i = 0; i < n_window_properties; ++i)
+			if(std::exchange(window_properties_changed[i], false))
+				changed.emplace_back(i, window_properties[i]);
+	}
+	if(changed.empty())
+		return false;
+
+	queueWrite([changed = std::move(changed)](BackendFactory& backend) {
+		SQLiteAdapter::SQLQuerry querry(*backend.db,
+				"INSERT INTO Settings (key, value) VALUES (?, ?)"
+				" ON CONFLICT (key) DO UPDATE SET value = excluded.value;");
+		for(auto [property, value] : changed) {
+			querry.bind(1, window_property_keys[property]);
+			querry.bind(2, value);
+			if(int i = querry.nextRow(); i != SQLITE_DONE)
+				throw(DatabaseInterface::database_error("Error saving setting " + window_property_keys[property]
+						+ " (error code: " + std::to_string(i) + ")"));
+			querry.reset();
+		}
+	});
+	return true;
+}
+
+void BackendFactory::loadWindowProperties() {
+	DatabaseLock lck {*this};
+	std::array<int,n_window_properties> values;
+	values[static_cast<std::size_t>(WindowProperties::WINDOW_WIDTH)]     = 1800;
+	values[static_cast<std::size_t>(WindowProperties::WINDOW_HEIGHT)]    = 1200;
+	values[static_cast<std::size_t>(WindowProperties::LEFT_PANE_WIDTH)]  = 250;
+	values[static_cast<std::size_t>(WindowProperties::RIGHT_PANE_WIDTH)] = 250;
+	values[static_cast<std::size_t>(WindowProperties::TILE_WIDTH)]       = 250;
+	values[static_cast<std::size_t>(WindowProperties::N_THREADS)]        =
+		std::thread::hardware_concurrency()?std::thread::hardware_concurrency():1;
+
+	// keys not known (any more) are ignored
+	SQLiteAdapter::SQLQuerry querry(*db, "SELECT key, value FROM Settings;");
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW) {
+		auto key = std::find(window_property_keys.begin(), window_property_keys.end(), querry.getColumnText(0));
+		if(key != window_property_keys.end())
+			values[key - window_property_keys.begin()] = querry.getColumnInt(1);
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error loading settings (error code: " + std::to_string(i) + ")"));
+
+	std::lock_guard<std::mutex> properties_lck {window_properties_mutex};
+	window_properties = values;
+	window_properties_changed.fill(false);
 }
 
 int BackendFactory::getCentreWidth() const {
-	return window_properties.at(WindowProperties::WINDOW_WIDTH) -
-			window_properties.at(WindowProperties::RIGHT_PANE_WIDTH) -
-			window_properties.at(WindowProperties::RIGHT_PANE_WIDTH) - 4;
+	std::lock_guard<std::mutex> lck {window_properties_mutex};
+	return window_properties[static_cast<std::size_t>(WindowProperties::WINDOW_WIDTH)] -
+			window_properties[static_cast<std::size_t>(WindowProperties::RIGHT_PANE_WIDTH)] -
+			window_properties[static_cast<std::size_t>(WindowProperties::RIGHT_PANE_WIDTH)] - 4;
+}
+
+int BackendFactory::addChangeObserver(ChangeObserver observer) {
+	DatabaseLock lck {*this};
+	change_observers.emplace(next_change_observer, std::move(observer));
+	return next_change_observer++;
+}
+
+void BackendFactory::removeChangeObserver(int observer) noexcept {
+	DatabaseLock lck {*this};
+	change_observers.erase(observer);
+}
+
+BackendFactory::DatabaseLock::DatabaseLock(BackendFactory& backend) :
+		backend(backend) {
+	// only this thread can set database_owner to its own id
+	if(backend.database_owner.load(std::memory_order_relaxed) != std::this_thread::get_id()) {
+		backend.write_queue.waitForOwnWrites();
+		backend.database_mutex.lock();
+		backend.database_owner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+	}
+	++backend.database_lock_depth;
+}
+
+BackendFactory::DatabaseLock::~DatabaseLock() {
+	if(--backend.database_lock_depth == 0) {
+		backend.database_owner.store(std::thread::id(), std::memory_order_relaxed);
+		backend.database_mutex.unlock();
+	}
+}
+
+void BackendFactory::notifyChange(const Change& change) {
+	// changes of queued writes are reported after their commit
+	if(deferring_changes) {
+		deferred_changes.push_back(change);
+		return;
+	}
+	for(auto& [id, observer] : change_observers)
+		observer(change);
+}
+
+std::unordered_map<int,int> BackendFactory::getPhotoDirectories(std::span<const int> photos) {
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT id, directory FROM Photos WHERE id IN (SELECT value FROM json_each(?));");
+	querry.bind(1, DatabaseInterface::toJSONArray(photos));
+	std::unordered_map<int,int> directories;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		directories.emplace(querry.getColumnInt(0), querry.getColumnInt(1));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error getting photos (error code: " + std::to_string(i) + ")"));
+	return directories;
+}
+
+void BackendFactory::notifyPhotosChanged(const std::set<int>& directories) {
+	for(int directory : directories)
+		notifyChange({Change::Type::PHOTOS_CHANGED, RecordClasses::DirectoryRecord::table.raw(), directory,
+				getEntry<RecordClasses::DirectoryRecord>(directory).getParent()});
+}
+
+void BackendFactory::queueWrite(std::function<void(BackendFactory&)> write) {
+	write_queue.push([this, write = std::move(write)]() { write(*this); });
+}
+
+void BackendFactory::flushWrites() {
+	write_queue.flush();
+}
+
+void BackendFactory::setWriteErrorHandler(std::function<void(std::exception_ptr)> handler) {
+	std::lock_guard<std::mutex> lck {write_error_mutex};
+	write_error_handler = std::move(handler);
+}
+
+/*
+ * One transaction for the whole group, so there is only one commit; a
+ * savepoint per write keeps a failing write from taking the others with
+ * it. The changes are reported once the group is committed, without the
+ * changes of the rolled back writes. The sync to disk is done by the
+ * checkpoint afterwards, in the writer's own connection, so the other
+ * threads can use the database meanwhile.
+ */
+void BackendFactory::runWriteGroup(std::vector<Support::WriteBehindQueue::Write>& writes) {
+	{
+		DatabaseLock lck {*this};
+		deferring_changes = true;
+		try {
+			SQLiteAdapter::Transaction transaction(*db);
+			for(auto& write : writes) {
+				std::size_t n_changes = deferred_changes.size();
+				try {
+					SQLiteAdapter::Transaction savepoint(*db, "queued_write");
+					write();
+					savepoint.commit();
+				}
+				catch (...) {
+					// the bitmaps may hold changes of the rolled back write
+					invalidateRelationsIndex();
+					deferred_changes.erase(deferred_changes.begin() + n_changes, deferred_changes.end());
+					reportWriteError(std::current_exception());
+				}
+			}
+			transaction.commit();
+		}
+		catch (...) {
+			invalidateRelationsIndex();
+			deferring_changes = false;
+			deferred_changes.clear();
+			throw;
+		}
+		deferring_changes = false;
+		std::vector<Change> changes;
+		changes.swap(deferred_changes);
+		for(const auto& change : changes)
+			notifyChange(change);
+	}
+
+	std::string error_msg;
+	if(checkpoint_db && checkpoint_db->querryNoThrow("PRAGMA wal_checkpoint(PASSIVE);", nullptr, nullptr, error_msg))
+		throw(std::runtime_error("Error writing the database to disk: " + error_msg));
+}
+
+void BackendFactory::reportWriteError(std::exception_ptr error) {
+	std::lock_guard<std::mutex> lck {write_error_mutex};
+	if(write_error_handler) {
+		write_error_handler(error);
+		return;
+	}
+	try {
+		std::rethrow_exception(error);
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Queued write failed: " << e.what() << '\n';
+	}
+	catch (...) {
+		std::cerr << "Queued write failed\n";
+	}
+}
+
+bool BackendFactory::hasTables() {
+	SQLiteAdapter::SQLQuerry querry(*db, "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'Photos';");
+	int i = querry.nextRow();
+	if(i != SQLITE_ROW && i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error reading database schema (error code: " + std::to_string(i) + ")"));
+	return i == SQLITE_ROW;
 }
 
 void BackendFactory::createTables() {
 	/// \todo Add database structure.
 	const char* tables =
-			"PRAGMA foreign_keys = ON;"
 		//Keywords table
 			"CREATE TABLE Keywords("
 			"  id				INTEGER	PRIMARY KEY AUTOINCREMENT"	//AUTOINCREMENT?
@@ -156,17 +446,51 @@ void BackendFactory::createTables() {
 			", datetime			INTEGER"
 			", width			INTEGER"
 			", height			INTEGER"
+			", orientation		INTEGER	DEFAULT 1"
+			//Fingerprint of the file (see FileFingerprint)
+			", size				INTEGER	DEFAULT 0"
+			", mtime			INTEGER	DEFAULT 0"
+			", inode			INTEGER	DEFAULT 0"
+			//Perceptual hash of the image (see Support::PerceptualHash), NULL until computed
+			", phash			INTEGER"
+			//Hash of the content of the file (see Support::ContentHash), NULL until computed
+			", content_hash		INTEGER"
+			//1 if the file couldn't be hashed, so it isn't tried again until it changes
+			", phash_failed		INTEGER	NOT NULL DEFAULT 0"
+			", content_hash_failed	INTEGER	NOT NULL DEFAULT 0"
 			/// \todo add other attributes
 			//Constraints
 			", UNIQUE			(directory, filename)"
 			", FOREIGN KEY		(directory) REFERENCES Directories ON DELETE CASCADE"
 			");"
-			//Create index for directory
+			//Create index for directory (also PhotoOrder::ID)
 			"CREATE INDEX photosDirIndex ON Photos(directory);"
+			//Indexes for the other PhotoOrders within a directory (see photoOrderBy()); FILENAME has none,
+			//an index with the collation NATURAL_ORDER would keep other programs from writing to Photos
+			"CREATE INDEX photosDirDatetimeIndex ON Photos(directory, datetime);"
+			"CREATE INDEX photosDirRatingIndex ON Photos(directory, rating, datetime);"
+			"CREATE INDEX photosDirDimensionsIndex ON Photos(directory, (width * height));"
+			//Index for ranges of dates (see getPhotosTaken())
+			"CREATE INDEX photosDatetimeIndex ON Photos(datetime);"
+			//Index of the photos still to be hashed (see getUnhashedPhotos())
+			"CREATE INDEX photosUnhashedIndex ON Photos(id) WHERE phash IS NULL AND phash_failed = 0;"
+			//Indexes for finding identical files (see getContentHashCandidates() and findDuplicatePhotos())
+			"CREATE INDEX photosContentUnhashedIndex ON Photos(id) WHERE content_hash IS NULL AND content_hash_failed = 0;"
+			"CREATE INDEX photosSizeIndex ON Photos(size);"
+			"CREATE INDEX photosContentHashIndex ON Photos(content_hash, size) WHERE content_hash IS NOT NULL;"
+			//The hashes of a changed file have to be computed again
+			"CREATE TRIGGER trigger_photos_hashes_reset AFTER UPDATE OF size, mtime, inode"
+			"  ON Photos WHEN (NEW.size IS NOT OLD.size OR NEW.mtime IS NOT OLD.mtime OR NEW.inode IS NOT OLD.inode)"
+			"    BEGIN"
+			"      UPDATE Photos SET phash = NULL, content_hash = NULL, phash_failed = 0, content_hash_failed = 0"
+			"        WHERE id = NEW.id;"
+			"    END;"
 		//Photos-Albums relations table
 			"CREATE TABLE PhotosAlbumsRelations("
 			"  photoId			INTEGER"
 			", albumId			INTEGER"
+			//1 if the photo is only in the (smart) album because it matches its rule
+			", smart			INTEGER	NOT NULL DEFAULT 0"
 			//Constraints
 			", UNIQUE			(photoId, albumId)"
 			", FOREIGN KEY		(photoId) REFERENCES Photos ON DELETE CASCADE"
@@ -187,11 +511,1536 @@ void BackendFactory::createTables() {
 			//Create indeces for id and albumId
 			"CREATE INDEX photosKeywordsRelationsIdIndex ON PhotosKeywordsRelations(photoId);"
 			"CREATE INDEX photosKeywordsRelationsKeywordIdIndex ON PhotosKeywordsRelations(keywordId);"
+		//Smart albums table
+			"CREATE TABLE SmartAlbums("
+			"  albumId			INTEGER	PRIMARY KEY"
+			", rule				TEXT	NOT NULL"
+			//Constraints
+			", FOREIGN KEY		(albumId) REFERENCES Albums ON DELETE CASCADE"
+			");"
+		//Settings table, see WindowProperties
+			"CREATE TABLE Settings("
+			"  key				TEXT	PRIMARY KEY"
+			", value			INTEGER	NOT NULL"
+			") WITHOUT ROWID;"
 			;
 
 	std::string error_msg;
 	if(db->querryNoThrow(tables, nullptr, nullptr, error_msg))
 		throw(std::runtime_error("Error creating tables: " + error_msg));
+
+	for(const auto& table : photo_count_tables)
+		if(db->querryNoThrow(createPhotoCountTable(table).c_str(), nullptr, nullptr, error_msg))
+			throw(std::runtime_error("Error creating photo count tables: " + error_msg));
+
+	for(const auto& table : photo_count_tables)
+		if(db->querryNoThrow(createClosureTable(table[0]).c_str(), nullptr, nullptr, error_msg))
+			throw(std::runtime_error("Error creating closure tables: " + error_msg));
+
+	if(db->querryNoThrow(createTimelineTable().c_str(), nullptr, nullptr, error_msg))
+		throw(std::runtime_error("Error creating timeline table: " + error_msg));
+
+	if(db->querryNoThrow(createKeywordSearchTable().c_str(), nullptr, nullptr, error_msg))
+		throw(std::runtime_error("Error creating keyword search table: " + error_msg));
+}
+
+/*
+ * The table <table>PhotoCount holds the number of photos directly in an entry
+ * ('photos') and in the entry and all its descendants ('subtree').
+ * Changes of 'subtree' are propagated to the parent by a recursive trigger.
+ * An entry about to be deleted is removed from its parent's count before its
+ * own count row is deleted, so deletions cascading from it stop there.
+ */
+std::string BackendFactory::createPhotoCountTable(const std::array<const std::string,3>& table) {
+	const std::string& hierarchy = table[0];
+	const std::string& source    = table[1];
+	const std::string& column    = table[2];
+	const std::string  count     = hierarchy + "PhotoCount";
+
+	return
+			"CREATE TABLE " + count + "("
+			"  id				INTEGER	PRIMARY KEY"
+			", photos			INTEGER	NOT NULL DEFAULT 0"
+			", subtree			INTEGER	NOT NULL DEFAULT 0"
+			");"
+			"INSERT INTO " + count + " (id) SELECT id FROM " + hierarchy + ";"
+		//Keep a count row for every entry of the hierarchy
+			"CREATE TRIGGER trigger_" + count + "_insert AFTER INSERT"
+			"  ON " + hierarchy +
+			"    BEGIN"
+			"      INSERT INTO " + count + " (id) VALUES (NEW.id);"
+			"    END;"
+			"CREATE TRIGGER trigger_" + count + "_delete BEFORE DELETE"
+			"  ON " + hierarchy +
+			"    BEGIN"
+			"      UPDATE " + count + " SET subtree = subtree - "
+			"          (SELECT subtree FROM " + count + " WHERE id = OLD.id)"
+			"        WHERE id = OLD.parent AND OLD.parent IS NOT OLD.id;"
+			"      DELETE FROM " + count + " WHERE id = OLD.id;"
+			"    END;"
+			"CREATE TRIGGER trigger_" + count + "_move AFTER UPDATE OF parent"
+			"  ON " + hierarchy + " WHEN (NEW.parent IS NOT OLD.parent)"
+			"    BEGIN"
+			"      UPDATE " + count + " SET subtree = subtree - "
+			"          (SELECT subtree FROM " + count + " WHERE id = NEW.id)"
+			"        WHERE id = OLD.parent;"
+			"      UPDATE " + count + " SET subtree = subtree + "
+			"          (SELECT subtree FROM " + count + " WHERE id = NEW.id)"
+			"        WHERE id = NEW.parent;"
+			"    END;"
+		//Propagate changes to the parent
+			"CREATE TRIGGER trigger_" + count + "_propagate AFTER UPDATE OF subtree"
+			"  ON " + count + " WHEN (NEW.subtree IS NOT OLD.subtree)"
+			"    BEGIN"
+			"      UPDATE " + count + " SET subtree = subtree + NEW.subtree - OLD.subtree"
+			"        WHERE id = (SELECT parent FROM " + hierarchy +
+			"          WHERE id = NEW.id AND parent IS NOT id);"
+			"    END;"
+		//Count the photos
+			"CREATE TRIGGER trigger_" + count + "_photo_insert AFTER INSERT"
+			"  ON " + source +
+			"    BEGIN"
+			"      UPDATE " + count + " SET photos = photos + 1, subtree = subtree + 1"
+			"        WHERE id = NEW." + column + ";"
+			"    END;"
+			"CREATE TRIGGER trigger_" + count + "_photo_delete AFTER DELETE"
+			"  ON " + source +
+			"    BEGIN"
+			"      UPDATE " + count + " SET photos = photos - 1, subtree = subtree - 1"
+			"        WHERE id = OLD." + column + ";"
+			"    END;"
+			"CREATE TRIGGER trigger_" + count + "_photo_move AFTER UPDATE OF " + column +
+			"  ON " + source + " WHEN (NEW." + column + " IS NOT OLD." + column + ")"
+			"    BEGIN"
+			"      UPDATE " + count + " SET photos = photos - 1, subtree = subtree - 1"
+			"        WHERE id = OLD." + column + ";"
+			"      UPDATE " + count + " SET photos = photos + 1, subtree = subtree + 1"
+			"        WHERE id = NEW." + column + ";"
+			"    END;"
+			;
+}
+
+/*
+ * The table <hierarchy>Closure has a row for every entry and each of its
+ * ancestors (including the roots) with their distance 'depth', and a row
+ * with depth 0 for every entry and itself. The descendants of an entry are
+ * a range of the primary key, its ancestors a range of the index on
+ * 'descendant'. A moved entry takes its subtree along: the links of the
+ * subtree to the old ancestors are replaced by links to the new ones.
+ * Moving an entry into its own subtree is rejected. Deleting an entry
+ * deletes its descendants (ON DELETE CASCADE), whose triggers remove
+ * their own rows.
+ */
+std::string BackendFactory::createClosureTable(const std::string& hierarchy) {
+	const std::string closure = hierarchy + "Closure";
+
+	return
+			"CREATE TABLE " + closure + "("
+			"  ancestor			INTEGER	NOT NULL"
+			", descendant		INTEGER	NOT NULL"
+			", depth			INTEGER	NOT NULL"
+			", PRIMARY KEY		(ancestor, descendant)"
+			") WITHOUT ROWID;"
+			"CREATE UNIQUE INDEX " + closure + "DescendantIndex ON " + closure + "(descendant, ancestor);"
+			"WITH RECURSIVE paths(ancestor, descendant, depth) AS ("
+			"    SELECT id, id, 0 FROM " + hierarchy +
+			"    UNION ALL"
+			"    SELECT paths.ancestor, h.id, paths.depth + 1 FROM " + hierarchy + " AS h"
+			"      JOIN paths ON h.parent = paths.descendant WHERE h.id IS NOT h.parent"
+			"  )"
+			" INSERT INTO " + closure + " (ancestor, descendant, depth) SELECT * FROM paths;"
+			"CREATE TRIGGER trigger_" + closure + "_insert AFTER INSERT"
+			"  ON " + hierarchy +
+			"    BEGIN"
+			"      INSERT INTO " + closure + " (ancestor, descendant, depth)"
+			"        SELECT ancestor, NEW.id, depth + 1 FROM " + closure +
+			"          WHERE descendant = NEW.parent AND NEW.id IS NOT NEW.parent"
+			"        UNION ALL SELECT NEW.id, NEW.id, 0;"
+			"    END;"
+			"CREATE TRIGGER trigger_" + closure + "_delete AFTER DELETE"
+			"  ON " + hierarchy +
+			"    BEGIN"
+			"      DELETE FROM " + closure + " WHERE descendant = OLD.id;"
+			"    END;"
+			"CREATE TRIGGER trigger_" + closure + "_cycle BEFORE UPDATE OF parent"
+			"  ON " + hierarchy + " WHEN (NEW.parent IS NOT OLD.parent AND EXISTS"
+			"      (SELECT 1 FROM " + closure + " WHERE ancestor = NEW.id AND descendant = NEW.parent))"
+			"    BEGIN"
+			"      SELECT RAISE(ABORT, 'trying to move an entry of " + hierarchy + " into its own subtree');"
+			"    END;"
+			"CREATE TRIGGER trigger_" + closure + "_move AFTER UPDATE OF parent"
+			"  ON " + hierarchy + " WHEN (NEW.parent IS NOT OLD.parent)"
+			"    BEGIN"
+			"      DELETE FROM " + closure +
+			"        WHERE descendant IN (SELECT descendant FROM " + closure + " WHERE ancestor = NEW.id)"
+			"          AND ancestor NOT IN (SELECT descendant FROM " + closure + " WHERE ancestor = NEW.id);"
+			"      INSERT INTO " + closure + " (ancestor, descendant, depth)"
+			"        SELECT above.ancestor, below.descendant, above.depth + below.depth + 1"
+			"          FROM " + closure + " AS above JOIN " + closure + " AS below"
+			"          WHERE above.descendant = NEW.parent AND below.ancestor = NEW.id;"
+			"    END;"
+			;
+}
+
+/*
+ * The table Timeline holds the number of photos taken on every day, in
+ * every month, and in every year (UTC) with photos. The periods are
+ * identified by 'date' = YYYYMMDD, with DD = 00 for a month and
+ * MMDD = 0000 for a year, so each period has a unique key and the periods
+ * within another one are a range of keys. A photo without a date has
+ * 'datetime' 0 (or NULL) and isn't counted: its keys are NULL.
+ */
+std::string BackendFactory::createTimelineTable() {
+	auto keys = [](const std::string& row) {
+		const std::string day = "CAST(strftime('%Y%m%d', nullif(" + row + ".datetime, 0), 'unixepoch') AS INTEGER)";
+		return "(" + day + "), (" + day + " / 100 * 100), (" + day + " / 10000 * 10000)";
+	};
+	auto add = [&keys](const std::string& row) {
+		return
+			"      INSERT INTO Timeline (date, photos)"
+			"        SELECT column1, 1 FROM (VALUES " + keys(row) + ") WHERE column1 IS NOT NULL"
+			"        ON CONFLICT (date) DO UPDATE SET photos = photos + 1;";
+	};
+	auto remove = [&keys](const std::string& row) {
+		return
+			"      UPDATE Timeline SET photos = photos - 1"
+			"        WHERE date IN (VALUES " + keys(row) + ");"
+			"      DELETE FROM Timeline WHERE date IN (VALUES " + keys(row) + ") AND photos = 0;";
+	};
+
+	return
+			"CREATE TABLE Timeline("
+			"  date				INTEGER	PRIMARY KEY"
+			", photos			INTEGER	NOT NULL"
+			") WITHOUT ROWID;"
+			+ expectedTimeline() + " INSERT INTO Timeline (date, photos) SELECT * FROM expected;"
+			"CREATE TRIGGER trigger_timeline_photo_insert AFTER INSERT"
+			"  ON Photos"
+			"    BEGIN"
+			+ add("NEW") +
+			"    END;"
+			"CREATE TRIGGER trigger_timeline_photo_delete AFTER DELETE"
+			"  ON Photos"
+			"    BEGIN"
+			+ remove("OLD") +
+			"    END;"
+			"CREATE TRIGGER trigger_timeline_photo_update AFTER UPDATE OF datetime"
+			"  ON Photos WHEN (NEW.datetime IS NOT OLD.datetime)"
+			"    BEGIN"
+			+ remove("OLD") + add("NEW") +
+			"    END;"
+			;
+}
+
+/*
+ * The full-text index KeywordsSearch has a row for every keyword (except
+ * the roots) with the keyword's id as rowid. 'path' holds the names of the
+ * ancestors, e.g. "Places / Italy" for Venice, and is taken from the
+ * parent's row, so a keyword's row has to be updated before its children's.
+ * After a keyword is renamed or moved, its children are touched with a
+ * no-op update, which updates their rows through the (recursive) trigger;
+ * this stops at the children whose path didn't change.
+ * The prefix indexes make type-ahead queries for short prefixes fast.
+ */
+std::string BackendFactory::createKeywordSearchTable() {
+	const std::string path =
+			"coalesce((SELECT CASE path WHEN '' THEN keyword ELSE path || ' / ' || keyword END"
+			"  FROM KeywordsSearch WHERE rowid = NEW.parent), '')";
+
+	return
+			"CREATE VIRTUAL TABLE KeywordsSearch USING fts5("
+			"  keyword, synonyms, path"
+			", tokenize = 'unicode61 remove_diacritics 2'"
+			", prefix = '1 2 3'"
+			");"
+			"CREATE TRIGGER trigger_keywords_search_insert AFTER INSERT"
+			"  ON Keywords WHEN (NEW.id > 1)"
+			"    BEGIN"
+			"      INSERT INTO KeywordsSearch (rowid, keyword, synonyms, path)"
+			"        VALUES (NEW.id, NEW.keyword, coalesce(NEW.synonyms, ''), " + path + ");"
+			"    END;"
+			"CREATE TRIGGER trigger_keywords_search_delete AFTER DELETE"
+			"  ON Keywords WHEN (OLD.id > 1)"
+			"    BEGIN"
+			"      DELETE FROM KeywordsSearch WHERE rowid = OLD.id;"
+			"    END;"
+			"CREATE TRIGGER trigger_keywords_search_synonyms AFTER UPDATE OF synonyms"
+			"  ON Keywords WHEN (NEW.id > 1 AND NEW.synonyms IS NOT OLD.synonyms)"
+			"    BEGIN"
+			"      UPDATE KeywordsSearch SET synonyms = coalesce(NEW.synonyms, '') WHERE rowid = NEW.id;"
+			"    END;"
+			"CREATE TRIGGER trigger_keywords_search_path AFTER UPDATE OF keyword, parent"
+			"  ON Keywords WHEN (NEW.id > 1 AND (NEW.keyword IS NOT OLD.keyword"
+			"      OR " + path + " IS NOT (SELECT path FROM KeywordsSearch WHERE rowid = NEW.id)))"
+			"    BEGIN"
+			"      UPDATE KeywordsSearch SET keyword = NEW.keyword, path = " + path + " WHERE rowid = NEW.id;"
+			"      UPDATE Keywords SET parent = parent WHERE parent = NEW.id AND id IS NOT parent;"
+			"    END;"
+			;
+}
+
+//Common table expression 'expected(date, photos)' with the correct timeline counts
+std::string BackendFactory::expectedTimeline() {
+	return
+			"WITH days(date) AS ("
+			"    SELECT CAST(strftime('%Y%m%d', datetime, 'unixepoch') AS INTEGER) FROM Photos"
+			"      WHERE datetime IS NOT NULL AND datetime != 0"
+			"  ), expected(date, photos) AS ("
+			"    SELECT date, COUNT(*) FROM days GROUP BY date"
+			"    UNION ALL SELECT date / 100 * 100, COUNT(*) FROM days GROUP BY date / 100"
+			"    UNION ALL SELECT date / 10000 * 10000, COUNT(*) FROM days GROUP BY date / 10000"
+			"  )";
+}
+
+//Common table expression 'expected(id, photos, subtree)' with the correct photo counts
+std::string BackendFactory::expectedPhotoCounts(const std::array<const std::string,3>& table) {
+	const std::string& hierarchy = table[0];
+	const std::string& source    = table[1];
+	const std::string& column    = table[2];
+
+	return
+			"WITH RECURSIVE descendants(ancestor, id) AS ("
+			"    SELECT id, id FROM " + hierarchy +
+			"    UNION ALL"
+			"    SELECT descendants.ancestor, h.id FROM " + hierarchy + " AS h"
+			"      JOIN descendants ON h.parent = descendants.id WHERE h.id IS NOT h.parent"
+			"  ), direct(id, photos) AS ("
+			"    SELECT h.id, (SELECT COUNT(*) FROM " + source + " AS s WHERE s." + column + " = h.id)"
+			"      FROM " + hierarchy + " AS h"
+			"  ), expected(id, photos, subtree) AS ("
+			"    SELECT direct.id, direct.photos, (SELECT SUM(d.photos) FROM descendants"
+			"        JOIN direct AS d ON d.id = descendants.id WHERE descendants.ancestor = direct.id)"
+			"      FROM direct"
+			"  )";
+}
+
+int BackendFactory::getNumberPhotos(const std::string& table, int id, bool include_descendants) {
+	std::string sql = std::string("SELECT ") + (include_descendants ? "subtree" : "photos") +
+			" FROM " + table + "PhotoCount WHERE id IS " + std::to_string(id) + ";";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+
+	if(int i = querry.nextRow(); i == SQLITE_ROW)
+		return querry.getColumnInt(0);
+	else if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error retrieving number of photos (error code: " + std::to_string(i) + ")"));
+
+	return 0;
+}
+
+void BackendFactory::setOptionBits(const std::string& table, const std::string& column, std::span<const int> ids,
+		int mask, bool value) {
+	if(ids.empty())
+		return;
+	std::string sql = "UPDATE " + table + " SET " + column + " = (" + column + " & ~?1) | ?2"
+			" WHERE id IN (SELECT value FROM json_each(?3));";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	querry.bind(1, mask);
+	querry.bind(2, value ? mask : 0);
+	querry.bind(3, DatabaseInterface::toJSONArray(ids));
+	if(int i = querry.nextRow(); i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error setting options (error code: " + std::to_string(i) + ")"));
+}
+
+std::vector<int> BackendFactory::getPhotos(int directory, PhotoOrder order, bool descending) {
+	DatabaseLock lck {*this};
+	return getSortedPhotos("SELECT Photos.id FROM Photos WHERE Photos.directory = ?" + photoOrderBy(order, descending),
+			{directory});
+}
+
+std::vector<int> BackendFactory::getPhotosInSubtree(int directory, PhotoOrder order, bool descending) {
+	DatabaseLock lck {*this};
+	return getSortedPhotos("SELECT Photos.id FROM DirectoriesClosure AS c JOIN Photos ON Photos.directory = c.descendant"
+			" WHERE c.ancestor = ?" + photoOrderBy(order, descending), {directory});
+}
+
+std::vector<int> BackendFactory::sortPhotos(std::span<const int> photos, PhotoOrder order, bool descending) {
+	DatabaseLock lck {*this};
+	if(photos.empty())
+		return {};
+	return getSortedPhotos("SELECT Photos.id FROM Photos WHERE Photos.id IN (SELECT value FROM json_each(?))"
+			+ photoOrderBy(order, descending), {DatabaseInterface::toJSONArray(photos)});
+}
+
+std::vector<BackendFactory::TimelinePeriod> BackendFactory::getTimeline(int year, int month) {
+	DatabaseLock lck {*this};
+	std::string sql = "SELECT date, photos FROM Timeline";
+	if(month)
+		sql += " WHERE date > ?1 AND date < ?1 + 100";
+	else if(year)
+		sql += " WHERE date > ?1 AND date < ?1 + 10000 AND date % 100 = 0";
+	else
+		sql += " WHERE date % 10000 = 0";
+	sql += " ORDER BY date;";
+
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	if(year)
+		querry.bind(1, year * 10000 + month * 100);
+	std::vector<TimelinePeriod> periods;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW) {
+		int date = querry.getColumnInt(0);
+		periods.push_back({date / 10000, date / 100 % 100, date % 100, querry.getColumnInt(1)});
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error loading timeline (error code: " + std::to_string(i) + ")"));
+	return periods;
+}
+
+std::vector<int> BackendFactory::getPhotosTaken(int year, int month, int day, PhotoOrder order, bool descending) {
+	using namespace std::chrono;
+	year_month_day first {std::chrono::year(year), std::chrono::month(month ? month : 1), std::chrono::day(day ? day : 1)};
+	if(!first.ok() || (!month && day))
+		throw(std::invalid_argument("Invalid date " + std::to_string(year) + "-" + std::to_string(month) + "-"
+				+ std::to_string(day)));
+	sys_days last;
+	if(day)
+		last = sys_days(first) + days(1);
+	else if(month)
+		last = sys_days(first + months(1));
+	else
+		last = sys_days(first + years(1));
+
+	DatabaseLock lck {*this};
+	// photos without a date (0) aren't taken on 1970-01-01
+	return getSortedPhotos("SELECT Photos.id FROM Photos WHERE Photos.datetime >= ? AND Photos.datetime < ?"
+			" AND Photos.datetime != 0"
+			+ photoOrderBy(order, descending), {
+				duration_cast<seconds>(sys_days(first).time_since_epoch()).count(),
+				duration_cast<seconds>(last.time_since_epoch()).count()});
+}
+
+/*
+ * Every word becomes a quoted prefix query, so characters with a special
+ * meaning in FTS5 queries are searched for literally. Words without letters
+ * or digits would match nothing, because the tokenizer drops them.
+ */
+std::vector<int> BackendFactory::searchKeywords(std::string_view text, int limit) {
+	std::string query;
+	auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v'; };
+	for(std::size_t begin = 0, end; begin < text.size(); begin = end) {
+		for(; begin < text.size() && is_space(text[begin]); ++begin)
+			;
+		for(end = begin; end < text.size() && !is_space(text[end]); ++end)
+			;
+		std::string_view word = text.substr(begin, end - begin);
+		if(std::none_of(word.begin(), word.end(), [](char c) {
+			return static_cast<unsigned char>(c) >= 0x80 || std::isalnum(static_cast<unsigned char>(c));
+		}))
+			continue;
+
+		if(!query.empty())
+			query += ' ';
+		query += '"';
+		for(char c : word) {
+			if(c == '"')
+				query += '"';
+			query += c;
+		}
+		query += "\"*";
+	}
+	if(query.empty())
+		return {};
+
+	DatabaseLock lck {*this};
+	// matches in the keyword rank higher than in the synonyms and in the path
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT rowid FROM KeywordsSearch WHERE KeywordsSearch MATCH ?"
+			" ORDER BY bm25(KeywordsSearch, 10.0, 5.0, 1.0) LIMIT ?;");
+	querry.bind(1, query);
+	querry.bind(2, limit);
+	std::vector<int> keywords;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		keywords.push_back(querry.getColumnInt(0));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error searching keywords (error code: " + std::to_string(i) + ")"));
+	return keywords;
+}
+
+std::vector<int> BackendFactory::getAncestors(const std::string& table, std::span<const int> ids) {
+	if(ids.empty())
+		return {};
+	std::string sql =
+			"SELECT DISTINCT c.ancestor FROM " + table + "Closure AS c JOIN " + table + " AS t ON t.id = c.ancestor"
+			" WHERE c.descendant IN (SELECT value FROM json_each(?)) AND c.depth > 0 AND t.id IS NOT t.parent"
+			" ORDER BY c.ancestor;";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	querry.bind(1, DatabaseInterface::toJSONArray(ids));
+	std::vector<int> ancestors;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		ancestors.push_back(querry.getColumnInt(0));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error retrieving ancestors (error code: " + std::to_string(i) + ")"));
+	return ancestors;
+}
+
+std::vector<int> BackendFactory::getDescendants(const std::string& table, int id) {
+	std::string sql = "SELECT descendant FROM " + table + "Closure WHERE ancestor = ? AND depth > 0"
+			" ORDER BY descendant;";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	querry.bind(1, id);
+	std::vector<int> descendants;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		descendants.push_back(querry.getColumnInt(0));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error retrieving descendants (error code: " + std::to_string(i) + ")"));
+	return descendants;
+}
+
+bool BackendFactory::isAncestor(const std::string& table, int ancestor, int id) {
+	std::string sql = "SELECT depth > 0 FROM " + table + "Closure WHERE ancestor = ? AND descendant = ?;";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	querry.bind(1, ancestor);
+	querry.bind(2, id);
+	if(int i = querry.nextRow(); i == SQLITE_ROW)
+		return querry.getColumnInt(0);
+	else if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error checking ancestor (error code: " + std::to_string(i) + ")"));
+	return false;
+}
+
+std::vector<int> BackendFactory::getSortedPhotos(const std::string& sql,
+		const std::vector<PhotoFilter::Parameter>& parameters) {
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	for(std::size_t i = 0; i < parameters.size(); ++i)
+		std::visit([&querry, i](const auto& value) { querry.bind(static_cast<int>(i) + 1, value); }, parameters[i]);
+	std::vector<int> photos;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		photos.push_back(querry.getColumnInt(0));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error sorting photos (error code: " + std::to_string(i) + ")"));
+	return photos;
+}
+
+/*
+ * The keys match the indexes on Photos (see createTables()), with the id
+ * (the rowid stored in every index) as the last key, so SQLite can read
+ * the photos of a directory from the index instead of sorting them. The
+ * file names are sorted in the query, the collation only exists in this
+ * connection.
+ */
+std::string BackendFactory::photoOrderBy(PhotoOrder order, bool descending) {
+	std::vector<const char*> keys;
+	switch(order) {
+	case PhotoOrder::ID:
+		break;
+	case PhotoOrder::DATETIME:
+		keys = {"Photos.datetime"};
+		break;
+	case PhotoOrder::RATING:
+		keys = {"Photos.rating", "Photos.datetime"};
+		break;
+	case PhotoOrder::FILENAME:
+		keys = {"Photos.filename COLLATE NATURAL_ORDER"};
+		break;
+	case PhotoOrder::DIMENSIONS:
+		keys = {"Photos.width * Photos.height"};
+		break;
+	}
+	keys.push_back("Photos.id");
+
+	std::string order_by;
+	for(const char* key : keys) {
+		order_by += order_by.empty() ? " ORDER BY " : ", ";
+		order_by += key;
+		if(descending)
+			order_by += " DESC";
+	}
+	return order_by + ";";
+}
+
+bool BackendFactory::checkPhotoCounts() {
+	DatabaseLock lck {*this};
+	for(const auto& table : photo_count_tables) {
+		const std::string count = table[0] + "PhotoCount";
+		std::string sql = expectedPhotoCounts(table) +
+				" SELECT (SELECT COUNT(*) FROM (SELECT * FROM expected"
+				"     EXCEPT SELECT id, photos, subtree FROM " + count + "))"
+				"  + (SELECT COUNT(*) FROM (SELECT id, photos, subtree FROM " + count +
+				"     EXCEPT SELECT * FROM expected));";
+		SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+
+		if(int i = querry.nextRow(); i != SQLITE_ROW)
+			throw(DatabaseInterface::database_error("Error checking photo counts (error code: " + std::to_string(i) + ")"));
+		if(querry.getColumnInt(0))
+			return false;
+	}
+
+	std::string sql = expectedTimeline() +
+			" SELECT (SELECT COUNT(*) FROM (SELECT * FROM expected EXCEPT SELECT date, photos FROM Timeline))"
+			"  + (SELECT COUNT(*) FROM (SELECT date, photos FROM Timeline EXCEPT SELECT * FROM expected));";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	if(int i = querry.nextRow(); i != SQLITE_ROW)
+		throw(DatabaseInterface::database_error("Error checking timeline (error code: " + std::to_string(i) + ")"));
+	return querry.getColumnInt(0) == 0;
+}
+
+void BackendFactory::rebuildPhotoCounts() {
+	DatabaseLock lck {*this};
+	std::string sql;
+	for(const auto& table : photo_count_tables) {
+		const std::string count = table[0] + "PhotoCount";
+		sql += "DELETE FROM " + count + ";" + expectedPhotoCounts(table) +
+				" INSERT INTO " + count + " (id, photos, subtree) SELECT * FROM expected;";
+	}
+	sql += "DELETE FROM Timeline;" + expectedTimeline() + " INSERT INTO Timeline (date, photos) SELECT * FROM expected;";
+
+	SQLiteAdapter::Transaction transaction(*db);
+	std::string error_msg;
+	if(db->querryNoThrow(sql.c_str(), nullptr, nullptr, error_msg))
+		throw(DatabaseInterface::database_error("Error rebuilding photo counts: " + error_msg));
+	transaction.commit();
+}
+
+int BackendFactory::getOrAddDirectory(const RecordClasses::DirectoryRecord& directory) {
+	DatabaseLock lck {*this};
+	auto getDirectory = [this, &directory]() {
+		SQLiteAdapter::SQLQuerry querry(*db, "SELECT id FROM Directories WHERE parent = ? AND fullname = ?;");
+		querry.bind(1, directory.getParent());
+		querry.bind(2, directory.getFullDirectory().raw());
+		int i = querry.nextRow();
+		if(i == SQLITE_ROW)
+			return querry.getColumnInt(0);
+		if(i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error getting directory (error code: " + std::to_string(i) + ")"));
+		return -1;
+	};
+
+	if(int id = getDirectory(); id >= 0)
+		return id;
+	newEntry(directory);
+	return getDirectory();
+}
+
+int BackendFactory::newPhotos(std::span<const RecordClasses::PhotoRecord> photos, std::span<const FileFingerprint> fingerprints) {
+	DatabaseLock lck {*this};
+	if(photos.empty())
+		return 0;
+
+	int max_id;
+	{
+		SQLiteAdapter::SQLQuerry querry(*db, "SELECT IFNULL(MAX(id), 0) FROM Photos;");
+		if(int i = querry.nextRow(); i != SQLITE_ROW)
+			throw(DatabaseInterface::database_error("Error adding photos (error code: " + std::to_string(i) + ")"));
+		max_id = querry.getColumnInt(0);
+	}
+
+	SQLiteAdapter::Transaction transaction(*db);
+	int n = 0;
+	int i = SQLITE_DONE;
+	// directories with added photos (the skipped ones don't change anything)
+	std::set<int> directories;
+	{
+		SQLiteAdapter::SQLQuerry querry(*db,
+				"INSERT OR IGNORE INTO Photos (directory, filename, rating, datetime, width, height, orientation, size, mtime, inode) "
+				"VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+		for(std::size_t j = 0; j < photos.size(); ++j) {
+			const auto& photo = photos[j];
+			FileFingerprint fingerprint = fingerprints.empty() ? FileFingerprint() : fingerprints[j];
+			querry.bind(1, photo.getDirectory());
+			querry.bind(2, photo.getFilename().raw());
+			querry.bind(3, photo.getRating());
+			querry.bind(4, photo.getDatetime());
+			querry.bind(5, photo.getWidth());
+			querry.bind(6, photo.getHeight());
+			querry.bind(7, photo.getOrientation());
+			querry.bind(8, fingerprint.size);
+			querry.bind(9, fingerprint.mtime);
+			querry.bind(10, fingerprint.inode);
+			if((i = querry.nextRow()) != SQLITE_DONE)
+				break;
+			if(db->changes()) {
+				++n;
+				directories.insert(photo.getDirectory());
+			}
+			querry.reset();
+		}
+	}
+	if(i == SQLITE_CONSTRAINT)
+		throw(DatabaseInterface::constraint_error("Constraint Error adding photos"));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error adding photos (error code: " + std::to_string(i) + ")"));
+	transaction.commit();
+
+	// new photos get ids larger than all existing ones, the skipped photos keep theirs
+	if(n && !smart_albums.empty()) {
+		std::vector<int> added;
+		{
+			SQLiteAdapter::SQLQuerry querry(*db, "SELECT id FROM Photos WHERE id > ?;");
+			querry.bind(1, max_id);
+			while((i = querry.nextRow()) == SQLITE_ROW)
+				added.push_back(querry.getColumnInt(0));
+		}
+		if(i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error getting the added photos (error code: "
+					+ std::to_string(i) + ")"));
+		updateSmartAlbums(added);
+	}
+	if(n && !change_observers.empty())
+		notifyPhotosChanged(directories);
+	return n;
+}
+
+void BackendFactory::updatePhotoFiles(
+		std::span<const int> ids,
+		std::span<const RecordClasses::PhotoRecord> photos,
+		std::span<const FileFingerprint> fingerprints) {
+	DatabaseLock lck {*this};
+	if(ids.empty())
+		return;
+	// the directories of moved photos are reported
+	std::unordered_map<int,int> old_directories;
+	if(!change_observers.empty())
+		old_directories = getPhotoDirectories(ids);
+
+	SQLiteAdapter::Transaction transaction(*db);
+	int i = SQLITE_DONE;
+	{
+		SQLiteAdapter::SQLQuerry querry(*db,
+				"UPDATE Photos SET directory = ?, filename = ?, datetime = ?, width = ?, height = ?, orientation = ?, "
+				"size = ?, mtime = ?, inode = ? WHERE id = ?;");
+		for(std::size_t j = 0; j < ids.size(); ++j) {
+			querry.bind(1, photos[j].getDirectory());
+			querry.bind(2, photos[j].getFilename().raw());
+			querry.bind(3, photos[j].getDatetime());
+			querry.bind(4, photos[j].getWidth());
+			querry.bind(5, photos[j].getHeight());
+			querry.bind(6, photos[j].getOrientation());
+			querry.bind(7, fingerprints[j].size);
+			querry.bind(8, fingerprints[j].mtime);
+			querry.bind(9, fingerprints[j].inode);
+			querry.bind(10, ids[j]);
+			if((i = querry.nextRow()) != SQLITE_DONE)
+				break;
+			querry.reset();
+		}
+	}
+	if(i == SQLITE_CONSTRAINT)
+		throw(DatabaseInterface::constraint_error("Constraint Error updating photos"));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error updating photos (error code: " + std::to_string(i) + ")"));
+	transaction.commit();
+
+	updateSmartAlbums(ids);
+	std::set<int> directories;
+	for(std::size_t j = 0; j < ids.size(); ++j)
+		if(auto old = old_directories.find(ids[j]);
+				old != old_directories.end() && old->second != photos[j].getDirectory()) {
+			directories.insert(old->second);
+			directories.insert(photos[j].getDirectory());
+		}
+	notifyPhotosChanged(directories);
+}
+
+int BackendFactory::deletePhotos(std::span<const int> ids) {
+	DatabaseLock lck {*this};
+	if(ids.empty())
+		return 0;
+	std::set<int> directories;
+	if(!change_observers.empty())
+		for(auto [photo, directory] : getPhotoDirectories(ids))
+			directories.insert(directory);
+
+	SQLiteAdapter::SQLQuerry querry(*db, "DELETE FROM Photos WHERE id IN (SELECT value FROM json_each(?));");
+	querry.bind(1, DatabaseInterface::toJSONArray(ids));
+	if(int i = querry.nextRow(); i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error deleting photos (error code: " + std::to_string(i) + ")"));
+	int n = db->changes();
+	// the relations of the photos are deleted through foreign keys
+	removePhotosFromRelationsIndex(ids);
+	notifyPhotosChanged(directories);
+	return n;
+}
+
+std::vector<BackendFactory::CataloguedPhoto> BackendFactory::getCataloguedPhotos(int directory) {
+	DatabaseLock lck {*this};
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT id, filename, size, mtime, inode FROM Photos WHERE directory = ? ORDER BY filename;");
+	querry.bind(1, directory);
+	std::vector<CataloguedPhoto> photos;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		photos.push_back({
+			querry.getColumnInt(0),
+			querry.getColumnText(1),
+			{querry.getColumnInt<std::int64_t>(2), querry.getColumnInt<std::int64_t>(3), querry.getColumnInt<std::int64_t>(4)}
+		});
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error getting photos (error code: " + std::to_string(i) + ")"));
+	return photos;
+}
+
+std::vector<BackendFactory::PhotoFile> BackendFactory::getPhotosWithFingerprints(
+		std::span<const FileFingerprint> fingerprints) {
+	DatabaseLock lck {*this};
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT id, directory, filename FROM Photos WHERE size = ? AND mtime = ? AND inode = ?;");
+	std::vector<PhotoFile> photos;
+	std::unordered_map<int,std::string> paths;
+	for(const auto& fingerprint : fingerprints) {
+		if(!fingerprint.size)
+			continue;
+		querry.bind(1, fingerprint.size);
+		querry.bind(2, fingerprint.mtime);
+		querry.bind(3, fingerprint.inode);
+		int i;
+		while((i = querry.nextRow()) == SQLITE_ROW) {
+			int directory = querry.getColumnInt(1);
+			auto path = paths.find(directory);
+			if(path == paths.end())
+				path = paths.emplace(directory, getDirectoryPath(directory)).first;
+			photos.push_back({querry.getColumnInt(0), path->second + querry.getColumnText(2), fingerprint});
+		}
+		if(i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error getting photos (error code: " + std::to_string(i) + ")"));
+		querry.reset();
+	}
+	return photos;
+}
+
+std::vector<BackendFactory::UnhashedPhoto> BackendFactory::getUnhashedPhotos(int after, int limit) {
+	DatabaseLock lck {*this};
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT id, directory, filename FROM Photos WHERE phash IS NULL AND phash_failed = 0 AND id > ?"
+			" ORDER BY id LIMIT ?;");
+	querry.bind(1, after);
+	querry.bind(2, limit);
+	std::vector<UnhashedPhoto> photos;
+	std::unordered_map<int,std::string> paths;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW) {
+		int directory = querry.getColumnInt(1);
+		auto path = paths.find(directory);
+		if(path == paths.end())
+			path = paths.emplace(directory, getDirectoryPath(directory)).first;
+		photos.push_back({querry.getColumnInt(0), path->second + querry.getColumnText(2)});
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error getting photos (error code: " + std::to_string(i) + ")"));
+	return photos;
+}
+
+void BackendFactory::setPerceptualHashes(std::span<const int> ids, std::span<const std::uint64_t> hashes) {
+	DatabaseLock lck {*this};
+	setHashes("phash", ids, hashes);
+}
+
+void BackendFactory::setPerceptualHashesFailed(std::span<const int> ids) {
+	DatabaseLock lck {*this};
+	setHashesFailed("phash_failed", ids);
+}
+
+std::vector<std::vector<int>> BackendFactory::findSimilarPhotos(int max_distance) {
+	DatabaseLock lck {*this};
+	Support::HammingIndex index = getHammingIndex();
+
+	// union-find over the photos with a hash, the root of a group is its smallest photo
+	std::unordered_map<int,int> group;
+	auto find = [&group](int photo) {
+		for(; group[photo] != photo; photo = group[photo])
+			group[photo] = group[group[photo]];
+		return photo;
+	};
+	SQLiteAdapter::SQLQuerry querry(*db, "SELECT id, phash FROM Photos WHERE phash IS NOT NULL ORDER BY id;");
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW) {
+		int photo = querry.getColumnInt(0);
+		group.try_emplace(photo, photo);
+		for(auto [similar, distance] : index.find(querry.getColumnInt<std::uint64_t>(1), max_distance))
+			if(similar < photo) {
+				int a = find(similar), b = find(photo);
+				group[std::max(a, b)] = std::min(a, b);
+			}
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error finding similar photos (error code: " + std::to_string(i) + ")"));
+
+	std::map<int,std::vector<int>> groups;
+	for(const auto& [photo, parent] : group)
+		groups[find(photo)].push_back(photo);
+	std::vector<std::vector<int>> similar;
+	for(auto& [root, photos] : groups)
+		if(photos.size() > 1) {
+			std::sort(photos.begin(), photos.end());
+			similar.push_back(std::move(photos));
+		}
+	return similar;
+}
+
+std::vector<int> BackendFactory::getSimilarPhotos(int photo, int max_distance) {
+	DatabaseLock lck {*this};
+	SQLiteAdapter::SQLQuerry querry(*db, "SELECT phash FROM Photos WHERE id = ? AND phash IS NOT NULL;");
+	querry.bind(1, photo);
+	int i = querry.nextRow();
+	if(i == SQLITE_DONE)
+		return {};
+	if(i != SQLITE_ROW)
+		throw(DatabaseInterface::database_error("Error finding similar photos (error code: " + std::to_string(i) + ")"));
+
+	std::vector<int> similar;
+	for(auto [id, distance] : getHammingIndex().find(querry.getColumnInt<std::uint64_t>(0), max_distance))
+		if(id != photo)
+			similar.push_back(id);
+	return similar;
+}
+
+std::vector<BackendFactory::UnhashedPhoto> BackendFactory::getContentHashCandidates(int after, int limit) {
+	DatabaseLock lck {*this};
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT id, directory, filename FROM Photos AS p"
+			" WHERE content_hash IS NULL AND content_hash_failed = 0 AND id > ? AND size > 0"
+			"  AND EXISTS (SELECT 1 FROM Photos AS q WHERE q.size = p.size AND q.id IS NOT p.id)"
+			" ORDER BY id LIMIT ?;");
+	querry.bind(1, after);
+	querry.bind(2, limit);
+	std::vector<UnhashedPhoto> photos;
+	std::unordered_map<int,std::string> paths;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW) {
+		int directory = querry.getColumnInt(1);
+		auto path = paths.find(directory);
+		if(path == paths.end())
+			path = paths.emplace(directory, getDirectoryPath(directory)).first;
+		photos.push_back({querry.getColumnInt(0), path->second + querry.getColumnText(2)});
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error getting photos (error code: " + std::to_string(i) + ")"));
+	return photos;
+}
+
+void BackendFactory::setContentHashes(std::span<const int> ids, std::span<const std::uint64_t> hashes) {
+	DatabaseLock lck {*this};
+	setHashes("content_hash", ids, hashes);
+}
+
+void BackendFactory::setContentHashesFailed(std::span<const int> ids) {
+	DatabaseLock lck {*this};
+	setHashesFailed("content_hash_failed", ids);
+}
+
+/*
+ * Files are identical if both their sizes and their hashes are equal, so a
+ * collision of the hashes of files of different sizes doesn't matter.
+ */
+std::vector<std::vector<int>> BackendFactory::findDuplicatePhotos() {
+	DatabaseLock lck {*this};
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT p.content_hash, p.size, p.id FROM Photos AS p JOIN"
+			" (SELECT content_hash, size FROM Photos WHERE content_hash IS NOT NULL"
+			"  GROUP BY content_hash, size HAVING COUNT(*) > 1) AS d"
+			" ON p.content_hash = d.content_hash AND p.size = d.size"
+			" ORDER BY p.content_hash, p.size, p.id;");
+	std::vector<std::vector<int>> duplicates;
+	std::int64_t hash = 0, size = -1;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW) {
+		if(querry.getColumnInt<std::int64_t>(0) != hash || querry.getColumnInt<std::int64_t>(1) != size) {
+			hash = querry.getColumnInt<std::int64_t>(0);
+			size = querry.getColumnInt<std::int64_t>(1);
+			duplicates.emplace_back();
+		}
+		duplicates.back().push_back(querry.getColumnInt(2));
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error finding duplicate photos (error code: " + std::to_string(i) + ")"));
+	std::sort(duplicates.begin(), duplicates.end());
+	return duplicates;
+}
+
+/*
+ * A savepoint instead of a transaction, so the hashes can also be set in a
+ * queued write.
+ */
+void BackendFactory::setHashes(const char* column, std::span<const int> ids, std::span<const std::uint64_t> hashes) {
+	if(ids.empty())
+		return;
+
+	SQLiteAdapter::Transaction transaction(*db, "set_hashes");
+	int i = SQLITE_DONE;
+	{
+		std::string sql = std::string("UPDATE Photos SET ") + column + " = ? WHERE id = ?;";
+		SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+		for(std::size_t j = 0; j < ids.size(); ++j) {
+			querry.bind(1, hashes[j]);
+			querry.bind(2, ids[j]);
+			if((i = querry.nextRow()) != SQLITE_DONE)
+				break;
+			querry.reset();
+		}
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error setting hashes (error code: " + std::to_string(i) + ")"));
+	transaction.commit();
+}
+
+void BackendFactory::setHashesFailed(const char* column, std::span<const int> ids) {
+	if(ids.empty())
+		return;
+	std::string sql = std::string("UPDATE Photos SET ") + column + " = 1 WHERE id IN (SELECT value FROM json_each(?));";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	querry.bind(1, DatabaseInterface::toJSONArray(ids));
+	int i = querry.nextRow();
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error marking failed hashes (error code: " + std::to_string(i) + ")"));
+}
+
+Support::HammingIndex BackendFactory::getHammingIndex() {
+	SQLiteAdapter::SQLQuerry querry(*db, "SELECT id, phash FROM Photos WHERE phash IS NOT NULL;");
+	Support::HammingIndex index;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		index.add(querry.getColumnInt(0), querry.getColumnInt<std::uint64_t>(1));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error loading hashes (error code: " + std::to_string(i) + ")"));
+	return index;
+}
+
+// the full names of the ancestors from the top, each followed by '/'
+std::string BackendFactory::getDirectoryPath(int directory) {
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"SELECT d.fullname FROM DirectoriesClosure AS c JOIN Directories AS d ON d.id = c.ancestor"
+			" WHERE c.descendant = ? AND d.id IS NOT d.parent ORDER BY c.depth DESC;");
+	querry.bind(1, directory);
+	std::string path;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		path += querry.getColumnText(0) + "/";
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error getting directory path (error code: " + std::to_string(i) + ")"));
+	return path;
+}
+
+std::vector<int> BackendFactory::filterPhotos(std::string_view expression) {
+	DatabaseLock lck {*this};
+	return filterPhotos(PhotoFilter(expression), std::nullopt);
+}
+
+/*
+ * If 'photos' is given only those photos are tested.
+ */
+std::vector<int> BackendFactory::filterPhotos(const PhotoFilter& filter, std::optional<std::span<const int>> photos) {
+	DatabaseLock lck {*this};
+	std::vector<PhotoFilter::Parameter> parameters;
+	std::string sql = filter.compile([this](const PhotoFilter::Predicate& predicate) {
+				return compilePredicate(predicate);
+			}, parameters);
+	if(photos) {
+		sql = "(" + sql + ") AND id IN (SELECT value FROM json_each(?))";
+		parameters.push_back(DatabaseInterface::toJSONArray(*photos));
+	}
+	sql = "SELECT id FROM Photos WHERE " + sql + " ORDER BY id;";
+
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	for(std::size_t i = 0; i < parameters.size(); ++i)
+		std::visit([&querry, i](const auto& value) { querry.bind(static_cast<int>(i) + 1, value); }, parameters[i]);
+
+	std::vector<int> matching;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		matching.push_back(querry.getColumnInt(0));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error filtering photos (error code: " + std::to_string(i) + ")"));
+
+	return matching;
+}
+
+/*
+ * The album, its rule, and its photos are added in one savepoint, so a
+ * rejected rule doesn't leave an album behind.
+ */
+int BackendFactory::newSmartAlbum(const RecordClasses::AlbumRecord& album, std::string_view rule) {
+	DatabaseLock lck {*this};
+	PhotoFilter filter(rule);
+
+	RecordClasses::AlbumRecord smart_album(album);
+	smart_album.setOptions() = smart_album.getOptions() | RecordClasses::AlbumRecord::Options::SMART_ALBUM;
+	SQLiteAdapter::Transaction transaction(*db, "new_smart_album");
+	tables_interface->newEntry(smart_album);
+	int id = getID(smart_album);
+
+	{
+		SQLiteAdapter::SQLQuerry querry(*db, "INSERT INTO SmartAlbums (albumId, rule) VALUES (?, ?);");
+		querry.bind(1, id);
+		querry.bind(2, std::string(rule));
+		if(int i = querry.nextRow(); i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error adding smart album (error code: " + std::to_string(i) + ")"));
+	}
+
+	smart_albums.try_emplace(id, std::string(rule), std::move(filter));
+	try {
+		orderSmartAlbums(true);
+		updateSmartAlbums({{id, std::nullopt}});
+		transaction.commit();
+	}
+	catch (...) {
+		smart_albums.erase(id);
+		smart_album_order_valid = false;
+		// the bitmaps may hold relations that are rolled back
+		invalidateRelationsIndex();
+		throw;
+	}
+	notifyChange({Change::Type::ADDED, RecordClasses::AlbumRecord::table.raw(), id, smart_album.getParent()});
+	return id;
+}
+
+/*
+ * Only 'album' is evaluated for all photos, the smart albums referring to
+ * it only for the photos added to or removed from it.
+ */
+void BackendFactory::setSmartAlbumRule(int album, std::string_view rule) {
+	DatabaseLock lck {*this};
+	PhotoFilter filter(rule);
+
+	auto entry = smart_albums.find(album);
+	if(entry == smart_albums.end())
+		throw(DatabaseInterface::missing_entry("Album " + std::to_string(album) + " is not a smart album"));
+
+	SQLiteAdapter::Transaction transaction(*db, "set_smart_album_rule");
+	{
+		SQLiteAdapter::SQLQuerry querry(*db, "UPDATE SmartAlbums SET rule = ? WHERE albumId = ?;");
+		querry.bind(1, std::string(rule));
+		querry.bind(2, album);
+		if(int i = querry.nextRow(); i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error changing rule of smart album (error code: " + std::to_string(i) + ")"));
+	}
+
+	auto previous = std::exchange(entry->second, {std::string(rule), std::move(filter)});
+	try {
+		orderSmartAlbums(true);
+		updateSmartAlbums({{album, std::nullopt}});
+		transaction.commit();
+	}
+	catch (...) {
+		entry->second = std::move(previous);
+		smart_album_order_valid = false;
+		invalidateRelationsIndex();
+		throw;
+	}
+}
+
+std::string BackendFactory::getSmartAlbumRule(int album) {
+	DatabaseLock lck {*this};
+	auto entry = smart_albums.find(album);
+	if(entry == smart_albums.end())
+		throw(DatabaseInterface::missing_entry("Album " + std::to_string(album) + " is not a smart album"));
+	return entry->second.first;
+}
+
+void BackendFactory::loadSmartAlbums() {
+	smart_albums.clear();
+	smart_album_order_valid = false;
+	SQLiteAdapter::SQLQuerry querry(*db, "SELECT albumId, rule FROM SmartAlbums ORDER BY albumId;");
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW) {
+		std::string rule = querry.getColumnText(1);
+		PhotoFilter filter(rule);
+		smart_albums.try_emplace(querry.getColumnInt(0), std::move(rule), std::move(filter));
+	}
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error loading smart albums (error code: " + std::to_string(i) + ")"));
+}
+
+namespace {
+
+void collectPredicates(const PhotoFilter::Node& node, PhotoFilter::Field field,
+		std::vector<const PhotoFilter::Predicate*>& predicates) {
+	if(node.type == PhotoFilter::Node::Type::PREDICATE) {
+		if(node.predicate.field == field)
+			predicates.push_back(&node.predicate);
+		return;
+	}
+	for(const auto& child : node.children)
+		collectPredicates(child, field, predicates);
+}
+
+std::vector<int> toIds(const Support::RoaringBitmap& bitmap) {
+	std::vector<int> ids;
+	ids.reserve(bitmap.cardinality());
+	for(auto id : bitmap.toVector())
+		ids.push_back(static_cast<int>(id));
+	return ids;
+}
+
+}
+
+/*
+ * A smart album depends on the smart albums matched by the album predicates
+ * of its rule (see getMatchingCollections()), it is evaluated after them.
+ * Albums without unevaluated dependencies are taken in the order of their
+ * ids (Kahn's algorithm).
+ */
+void BackendFactory::orderSmartAlbums(bool reject_cycles) {
+	smart_album_order_valid = false;
+	smart_album_order.clear();
+	smart_album_dependents.clear();
+
+	std::map<int,int> n_dependencies;
+	for(const auto& [album, rule] : smart_albums) {
+		std::vector<const PhotoFilter::Predicate*> predicates;
+		collectPredicates(rule.second.getRoot(), PhotoFilter::Field::ALBUM, predicates);
+		std::set<int> dependencies;
+		for(const auto* predicate : predicates)
+			for(int referenced : getMatchingCollections(*predicate))
+				if(smart_albums.contains(referenced))
+					dependencies.insert(referenced);
+		n_dependencies[album] = static_cast<int>(dependencies.size());
+		for(int dependency : dependencies)
+			smart_album_dependents[dependency].push_back(album);
+	}
+
+	std::set<int> ready;
+	for(auto [album, n] : n_dependencies)
+		if(n == 0)
+			ready.insert(album);
+	while(!ready.empty()) {
+		int album = *ready.begin();
+		ready.erase(ready.begin());
+		smart_album_order.push_back(album);
+		if(auto dependents = smart_album_dependents.find(album); dependents != smart_album_dependents.end())
+			for(int dependent : dependents->second)
+				if(--n_dependencies[dependent] == 0)
+					ready.insert(dependent);
+	}
+
+	if(smart_album_order.size() < smart_albums.size()) {
+		if(reject_cycles)
+			throw(filter_error("The rules of smart albums may not refer to each other in a cycle"));
+		for(auto [album, n] : n_dependencies)
+			if(n > 0)
+				smart_album_order.push_back(album);
+	}
+	smart_album_order_valid = true;
+}
+
+/*
+ * Smart albums with a predicate matching the entry 'id' of 'table' (a
+ * directory, album, or keyword). A predicate matches the entries of the
+ * given name and all their descendants, so only the rules matching the
+ * entry before or after a change can depend on the entry's subtree.
+ */
+std::vector<int> BackendFactory::getSmartAlbumsMatching(const std::string& table, int id) {
+	using Field = PhotoFilter::Field;
+	Field field = table == photo_count_tables[0][0] ? Field::DIRECTORY :
+			table == photo_count_tables[1][0] ? Field::ALBUM : Field::KEYWORD;
+
+	std::vector<int> albums;
+	for(const auto& [album, rule] : smart_albums) {
+		std::vector<const PhotoFilter::Predicate*> predicates;
+		collectPredicates(rule.second.getRoot(), field, predicates);
+		for(const auto* predicate : predicates) {
+			std::vector<PhotoFilter::Parameter> parameters;
+			std::string sql = "SELECT EXISTS (SELECT 1 FROM (" + matchingCollectionsSQL(*predicate, parameters) +
+					") WHERE descendant = ?);";
+			SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+			for(std::size_t i = 0; i < parameters.size(); ++i)
+				querry.bind(static_cast<int>(i) + 1, std::get<std::string>(parameters[i]));
+			querry.bind(static_cast<int>(parameters.size()) + 1, id);
+			if(int i = querry.nextRow(); i != SQLITE_ROW)
+				throw(DatabaseInterface::database_error("Error resolving filter predicate (error code: " + std::to_string(i) + ")"));
+			if(querry.getColumnInt(0)) {
+				albums.push_back(album);
+				break;
+			}
+		}
+	}
+	return albums;
+}
+
+// photos in the directory, album, or keyword 'id' of 'table' or its descendants
+std::vector<int> BackendFactory::getPhotosInSubtree(const std::string& table, int id) {
+	std::string sql;
+	if(table == photo_count_tables[0][0])
+		sql = "SELECT id FROM Photos WHERE directory IN (SELECT descendant FROM DirectoriesClosure WHERE ancestor = ?)"
+				" ORDER BY id;";
+	else {
+		const auto& [relations, collection_column, photo_column] =
+				relations_tables[static_cast<int>(table == photo_count_tables[1][0] ? Relations::PHOTOS_ALBUMS : Relations::PHOTOS_KEYWORDS)];
+		sql = "SELECT DISTINCT " + photo_column + " FROM " + relations + " WHERE " + collection_column +
+				" IN (SELECT descendant FROM " + table + "Closure WHERE ancestor = ?) ORDER BY " + photo_column + ";";
+	}
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	querry.bind(1, id);
+	std::vector<int> photos;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		photos.push_back(querry.getColumnInt(0));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error getting photos (error code: " + std::to_string(i) + ")"));
+	return photos;
+}
+
+/*
+ * Renaming, moving, or deleting a directory, album, or keyword can only
+ * change the photos of smart albums whose rules match the entry before or
+ * after the change, and only for the photos in the entry's subtree. The
+ * subtree of a deleted entry is read before it is deleted; deleting a
+ * directory deletes its photos, so no album needs to be evaluated.
+ */
+BackendFactory::HierarchyChange BackendFactory::beginHierarchyChange(const std::string& table, int id, bool deleting) {
+	HierarchyChange change {table, id, deleting, {}, {}};
+	if(smart_albums.empty() || (deleting && table == photo_count_tables[0][0]))
+		return change;
+	change.smart_albums = getSmartAlbumsMatching(table, id);
+	if(deleting && !change.smart_albums.empty())
+		change.photos = getPhotosInSubtree(table, id);
+	return change;
+}
+
+void BackendFactory::endHierarchyChange(const HierarchyChange& change) {
+	// smart albums may refer to other albums by the name of an ancestor
+	if(change.table == photo_count_tables[1][0])
+		smart_album_order_valid = false;
+	if(smart_albums.empty() || (change.deleting && change.table == photo_count_tables[0][0]))
+		return;
+
+	std::vector<int> albums = change.smart_albums;
+	if(!change.deleting)
+		for(int album : getSmartAlbumsMatching(change.table, change.id))
+			if(std::find(albums.begin(), albums.end(), album) == albums.end())
+				albums.push_back(album);
+	if(albums.empty())
+		return;
+
+	std::vector<int> photos = change.deleting ? change.photos : getPhotosInSubtree(change.table, change.id);
+	if(photos.empty())
+		return;
+	Support::RoaringBitmap bitmap(photos.begin(), photos.end());
+	std::map<int,std::optional<Support::RoaringBitmap>> seeds;
+	for(int album : albums)
+		// deleted smart albums are no longer in 'smart_albums'
+		if(smart_albums.contains(album))
+			seeds.emplace(album, bitmap);
+	updateSmartAlbums(std::move(seeds));
+}
+
+/*
+ * Only the relations added because of the rule ('smart') are removed, so
+ * photos added by hand stay in the album. The relations are changed
+ * directly, so the public functions changing relations don't trigger
+ * another update. Returns the photos added to or removed from the album.
+ */
+Support::RoaringBitmap BackendFactory::updateSmartAlbum(int album, const PhotoFilter& rule,
+		const std::optional<Support::RoaringBitmap>& photos) {
+	if(photos && photos->empty())
+		return {};
+	std::optional<std::vector<int>> ids;
+	if(photos)
+		ids = toIds(*photos);
+	std::optional<std::span<const int>> ids_span;
+	if(ids)
+		ids_span = *ids;
+
+	Support::RoaringBitmap matching;
+	for(int photo : filterPhotos(rule, ids_span))
+		matching.add(photo);
+
+	Support::RoaringBitmap members = getEntriesBitmap<Relations::PHOTOS_ALBUMS>(album);
+	if(photos)
+		members &= *photos;
+
+	Support::RoaringBitmap smart;
+	{
+		std::string sql = "SELECT photoId FROM PhotosAlbumsRelations WHERE albumId = ? AND smart";
+		if(ids)
+			sql += " AND photoId IN (SELECT value FROM json_each(?))";
+		SQLiteAdapter::SQLQuerry querry(*db, (sql + ";").c_str());
+		querry.bind(1, album);
+		if(ids)
+			querry.bind(2, DatabaseInterface::toJSONArray(*ids));
+		int i;
+		while((i = querry.nextRow()) == SQLITE_ROW)
+			smart.add(querry.getColumnInt(0));
+		if(i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error updating smart album (error code: " + std::to_string(i) + ")"));
+	}
+
+	std::span<const int> albums(&album, 1);
+	Support::RoaringBitmap added = matching - members;
+	Support::RoaringBitmap removed = smart - matching;
+	if(std::vector<int> added_ids = toIds(added); !added_ids.empty()) {
+		SQLiteAdapter::SQLQuerry querry(*db,
+				"INSERT OR IGNORE INTO PhotosAlbumsRelations (photoId, albumId, smart)"
+				" SELECT value, ?, 1 FROM json_each(?);");
+		querry.bind(1, album);
+		querry.bind(2, DatabaseInterface::toJSONArray(added_ids));
+		if(int i = querry.nextRow(); i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error updating smart album (error code: " + std::to_string(i) + ")"));
+		addToRelationsIndex(Relations::PHOTOS_ALBUMS, added_ids, albums);
+	}
+	if(std::vector<int> removed_ids = toIds(removed); !removed_ids.empty()) {
+		SQLiteAdapter::SQLQuerry querry(*db,
+				"DELETE FROM PhotosAlbumsRelations WHERE albumId = ? AND photoId IN (SELECT value FROM json_each(?));");
+		querry.bind(1, album);
+		querry.bind(2, DatabaseInterface::toJSONArray(removed_ids));
+		if(int i = querry.nextRow(); i != SQLITE_DONE)
+			throw(DatabaseInterface::database_error("Error updating smart album (error code: " + std::to_string(i) + ")"));
+		removeFromRelationsIndex(Relations::PHOTOS_ALBUMS, removed_ids, albums);
+	}
+	return added | removed;
+}
+
+/*
+ * 'photos' holds the photos to evaluate for each smart album (std::nullopt
+ * for all photos). The albums are evaluated in dependency order; the photos
+ * added to or removed from an album are also evaluated for the albums whose
+ * rules refer to it.
+ */
+void BackendFactory::updateSmartAlbums(std::map<int,std::optional<Support::RoaringBitmap>> photos) {
+	if(!smart_album_order_valid)
+		orderSmartAlbums(false);
+	std::vector<int> order = smart_album_order;
+	for(int album : order) {
+		auto entry = photos.find(album);
+		if(entry == photos.end())
+			continue;
+		Support::RoaringBitmap changed = updateSmartAlbum(album, smart_albums.at(album).second, entry->second);
+		if(changed.empty())
+			continue;
+		if(auto dependents = smart_album_dependents.find(album); dependents != smart_album_dependents.end())
+			for(int dependent : dependents->second) {
+				auto [seed, inserted] = photos.try_emplace(dependent, Support::RoaringBitmap());
+				if(seed->second)
+					*seed->second |= changed;
+			}
+	}
+}
+
+void BackendFactory::updateSmartAlbums(std::span<const int> photos) {
+	if(photos.empty() || smart_albums.empty())
+		return;
+	Support::RoaringBitmap bitmap(photos.begin(), photos.end());
+	std::map<int,std::optional<Support::RoaringBitmap>> seeds;
+	for(const auto& [album, rule] : smart_albums)
+		seeds.emplace(album, bitmap);
+	updateSmartAlbums(std::move(seeds));
+}
+
+/*
+ * Photos added to a smart album by hand stay in it when they no longer
+ * match its rule (see updateSmartAlbum()).
+ */
+void BackendFactory::markManualRelations(std::span<const int> photos, std::span<const int> albums) {
+	std::vector<int> smart;
+	for(int album : albums)
+		if(smart_albums.contains(album))
+			smart.push_back(album);
+	if(smart.empty() || photos.empty())
+		return;
+	SQLiteAdapter::SQLQuerry querry(*db,
+			"UPDATE PhotosAlbumsRelations SET smart = 0 WHERE smart"
+			" AND albumId IN (SELECT value FROM json_each(?)) AND photoId IN (SELECT value FROM json_each(?));");
+	querry.bind(1, DatabaseInterface::toJSONArray(smart));
+	querry.bind(2, DatabaseInterface::toJSONArray(photos));
+	if(int i = querry.nextRow(); i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error adding photos to album (error code: " + std::to_string(i) + ")"));
+}
+
+/*
+ * Directories, albums, and keywords are resolved by subqueries on their
+ * closure tables, so the ids of the matching photos aren't read into memory.
+ */
+PhotoFilter::CompiledPredicate BackendFactory::compilePredicate(const PhotoFilter::Predicate& predicate) {
+	using Field = PhotoFilter::Field;
+	using Comparison = PhotoFilter::Comparison;
+	static const std::array<const std::string,4> columns {"rating", "datetime", "width", "height"};
+
+	switch(predicate.field) {
+	case Field::DIRECTORY: {
+		PhotoFilter::CompiledPredicate compiled {"directory IN (", {}};
+		compiled.sql += matchingCollectionsSQL(predicate, compiled.parameters) + ")";
+		return compiled;
+	}
+	case Field::ALBUM:
+	case Field::KEYWORD: {
+		const auto& [table, collection_column, photo_column] =
+				relations_tables[static_cast<int>(predicate.field == Field::ALBUM ? Relations::PHOTOS_ALBUMS : Relations::PHOTOS_KEYWORDS)];
+		PhotoFilter::CompiledPredicate compiled {
+			"id IN (SELECT " + photo_column + " FROM " + table + " WHERE " + collection_column + " IN (", {}};
+		compiled.sql += matchingCollectionsSQL(predicate, compiled.parameters) + "))";
+		return compiled;
+	}
+	default:
+		break;
+	}
+
+	const std::string& column = columns[static_cast<int>(predicate.field)];
+	switch(predicate.comparison) {
+	case Comparison::EQUAL:
+		if(predicate.upper == predicate.lower + 1)
+			return {column + " = ?", {predicate.lower}};
+		return {column + " >= ? AND " + column + " < ?", {predicate.lower, predicate.upper}};
+	case Comparison::NOT_EQUAL:
+		return {column + " < ? OR " + column + " >= ?", {predicate.lower, predicate.upper}};
+	case Comparison::LESS:
+		return {column + " < ?", {predicate.lower}};
+	case Comparison::LESS_EQUAL:
+		return {column + " < ?", {predicate.upper}};
+	case Comparison::GREATER:
+		return {column + " >= ?", {predicate.upper}};
+	case Comparison::GREATER_EQUAL:
+		return {column + " >= ?", {predicate.lower}};
+	}
+	throw std::logic_error("Unknown comparison in filter predicate");
+}
+
+/*
+ * Querry for the ids of the directories, albums, or keywords matching the
+ * name of the predicate and all their descendants. Keywords also match their
+ * (comma separated) synonyms. The name is appended to 'parameters' once for
+ * every '?' in the querry.
+ */
+std::string BackendFactory::matchingCollectionsSQL(const PhotoFilter::Predicate& predicate,
+		std::vector<PhotoFilter::Parameter>& parameters) {
+	using Field = PhotoFilter::Field;
+	std::string hierarchy;
+	std::string condition;
+	int n_parameters = 1;
+	switch(predicate.field) {
+	case Field::DIRECTORY:
+		hierarchy = photo_count_tables[0][0];
+		condition = "(lower(h.name) = lower(?) OR h.fullname = ?)";
+		n_parameters = 2;
+		break;
+	case Field::ALBUM:
+		hierarchy = photo_count_tables[1][0];
+		condition = "lower(h.name) = lower(?)";
+		break;
+	case Field::KEYWORD:
+		hierarchy = photo_count_tables[2][0];
+		condition = "(h.lkeyword = lower(?) OR instr("
+				"',' || replace(replace(lower(h.synonyms), ', ', ','), ' ,', ',') || ',', "
+				"',' || lower(?) || ',') > 0)";
+		n_parameters = 2;
+		break;
+	default:
+		throw std::logic_error("Filter predicate doesn't refer to a hierarchy");
+	}
+
+	for(int i = 0; i < n_parameters; ++i)
+		parameters.push_back(predicate.text);
+	return "SELECT c.descendant FROM " + hierarchy + " AS h"
+			" JOIN " + hierarchy + "Closure AS c ON c.ancestor = h.id"
+			" WHERE h.id IS NOT h.parent AND " + condition;
+}
+
+std::vector<int> BackendFactory::getMatchingCollections(const PhotoFilter::Predicate& predicate) {
+	std::vector<PhotoFilter::Parameter> parameters;
+	std::string sql = "SELECT DISTINCT descendant FROM (" + matchingCollectionsSQL(predicate, parameters) + ");";
+	SQLiteAdapter::SQLQuerry querry(*db, sql.c_str());
+	for(std::size_t i = 0; i < parameters.size(); ++i)
+		querry.bind(static_cast<int>(i) + 1, std::get<std::string>(parameters[i]));
+
+	std::vector<int> ids;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		ids.push_back(querry.getColumnInt(0));
+	if(i != SQLITE_DONE)
+		throw(DatabaseInterface::database_error("Error resolving filter predicate (error code: " + std::to_string(i) + ")"));
+
+	return ids;
 }
 
 } /* namespace Backend */
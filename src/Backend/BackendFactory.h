@@ -22,9 +22,34 @@
 
 #include <AccessTables.h>
 #include <RelationsTable.h>
+#include "../Support/HammingIndex.h"
+#include "../Support/RoaringBitmap.h"
+#include "../Support/WriteBehindQueue.h"
+#include "FileFingerprint.h"
+#include "PhotoFilter.h"
+#include "Record/AlbumRecord.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/KeywordRecord.h"
+#include "Record/Options.h"
+#include "Record/PhotoRecord.h"
 #include <glibmm/ustring.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <unordered_map>
 #include <memory>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <variant>
 
 namespace PhotoLibrary {
 namespace Backend {
@@ -38,6 +63,8 @@ public:
 	 * Properties of the main window.
 	 * Properties of the main window that can be loaded or saved with
 	 * getWindowProperty(WindowProperties) and setWindowProperty(WindowProperties, int).
+	 * They are stored in the table Settings under the names in
+	 * window_property_keys.
 	 */
 	enum class WindowProperties {
 		WINDOW_WIDTH,	/**< Width of the main window. */
@@ -58,10 +85,83 @@ public:
 	};
 
 	/**
-	 * @param filename Filename and path of the database to use
+	 * Orders in which lists of photos can be returned.
+	 * Photos equal in the sort key are ordered by id.
+	 */
+	enum class PhotoOrder {
+		ID,			/**< Order of cataloguing */
+		DATETIME,	/**< Date and time the photo was taken, then id */
+		RATING,		/**< Rating, then date and time */
+		FILENAME,	/**< File name in natural order (see Support::naturalCompare()) */
+		DIMENSIONS	/**< Number of pixels (width * height) */
+	};
+
+	/**
+	 * Change of an entry made through newEntry(), updateEntry(),
+	 * setParent(), or deleteEntry().
+	 * The functions working on many photos at once (newPhotos(),
+	 * updatePhotoFiles(), deletePhotos()) don't report the photos but one
+	 * PHOTOS_CHANGED for each directory whose photos changed.
+	 */
+	struct Change {
+		/**
+		 * What happened to the entry.
+		 */
+		enum class Type {
+			ADDED,		/**< the entry was added */
+			UPDATED,	/**< the entry was updated (possibly including its parent) */
+			MOVED,		/**< the entry was moved to another parent */
+			DELETED,	/**< the entry and its descendants were deleted */
+			PHOTOS_CHANGED	/**< photos were added to or removed from the directory */
+		};
+
+		Type type;
+		std::string_view table;	/**< table of the entry (RecordType::table) */
+		int id;		/**< id of the entry */
+		int parent;	/**< parent of the entry after the change, 0 if DELETED */
+
+		/**
+		 * Check whether the change concerns entries of 'RecordType'.
+		 *
+		 * @tparam RecordType Record based class for the table
+		 * @return true if 'table' is the table of 'RecordType'
+		 */
+		template<typename RecordType>
+		bool concerns() const { return table == RecordType::table.raw(); }
+
+		bool operator==(const Change&) const = default;
+	};
+
+	/**
+	 * A year, month, or day with the number of photos taken in it.
+	 */
+	struct TimelinePeriod {
+		int year;
+		int month;	/**< 1 to 12, 0 for a year */
+		int day;	/**< 1 to 31, 0 for a year or a month */
+		int photos;	/**< number of photos taken in the period */
+
+		bool operator==(const TimelinePeriod&) const = default;
+	};
+
+	/**
+	 * Function called after each Change.
+	 */
+	using ChangeObserver = std::function<void(const Change&)>;
+
+	/**
+	 * Opens the database, creating the tables if it is new.
+	 *
+	 * @param filename Filename and path of the database to use, a private
+	 * 		in-memory database if nullptr or ":memory:"
 	 */
 	BackendFactory(const char* filename = nullptr);
 
+	/**
+	 * Saves the window properties not saved yet.
+	 */
+	~BackendFactory();
+
 	/**
 	 * Retrieve a record.
 	 *
@@ -103,6 +203,23 @@ public:
 	template<typename RecordType>
 	int getNumberChildren(int parent);
 
+	/**
+	 * Get the children of a entry and whether they have children.
+	 * Needs a single querry regardless of the number of children, e.g.
+	 * to show a row with expander for every child without loading its
+	 * children.
+	 *
+	 * @tparam RecordType Record based class for the table (see
+	 * 		AccessTables' class documentation for more information)
+	 * @param parent id of the entry of which the children should be returned
+	 * @return pairs of the id of a child of 'parent' and whether the child
+	 * 		has children
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<typename RecordType>
+	std::vector<std::pair<int,bool>> getChildNodes(int parent);
+
 	/**
 	 * Add new record.
 	 *
@@ -117,6 +234,258 @@ public:
 	template<typename RecordType>
 	void newEntry(const RecordType& entry);
 
+	/**
+	 * Add a directory unless it already exists.
+	 *
+	 * A directory exists if there is a directory with the same parent and
+	 * full name. The options of an existing directory are not changed.
+	 *
+	 * @param directory the directory to add
+	 * @return Id of the new or existing directory
+	 *
+	 * @throws constraint_error If the parent directory doesn't exist
+	 * @throws database_error If any other error occurs in the database
+	 */
+	int getOrAddDirectory(const RecordClasses::DirectoryRecord& directory);
+
+	/**
+	 * Add several photos.
+	 *
+	 * All photos are added in a single transaction with one prepared
+	 * statement, which is much faster than adding them one by one with
+	 * newEntry(). Photos already in the database (same directory and file
+	 * name) are skipped: they are neither changed nor counted, and no change
+	 * is reported for them. Use getID() to get the ids of the photos.
+	 *
+	 * @param photos the photos to add
+	 * @param fingerprints the fingerprints of the files of 'photos' (same
+	 * 		order); if empty, the fingerprints are left unset
+	 * @return Number of photos added (without the skipped ones)
+	 *
+	 * @throws constraint_error If a directory doesn't exist (no photo is
+	 * 		added in that case)
+	 * @throws database_error If any other error occurs in the database (no
+	 * 		photo is added in that case, unless updating the smart albums
+	 * 		fails after the photos were added)
+	 */
+	int newPhotos(std::span<const RecordClasses::PhotoRecord> photos, std::span<const FileFingerprint> fingerprints={});
+
+	/**
+	 * Update the attributes read from the files of several photos.
+	 *
+	 * Sets directory, file name, date and time, width, height, orientation,
+	 * and the fingerprint of each photo in a single transaction; all other
+	 * attributes (rating, albums, keywords, ...) are kept, so a photo whose
+	 * file was moved can be moved along with it.
+	 *
+	 * @param ids ids of the photos
+	 * @param photos new values of the photos (same order as 'ids')
+	 * @param fingerprints new fingerprints of the files (same order as 'ids')
+	 *
+	 * @throws constraint_error If a directory doesn't exist or already
+	 * 		contains a photo with the file name (no photo is changed in that
+	 * 		case)
+	 * @throws database_error If any other error occurs in the database (no
+	 * 		photo is changed in that case)
+	 */
+	void updatePhotoFiles(
+			std::span<const int> ids,
+			std::span<const RecordClasses::PhotoRecord> photos,
+			std::span<const FileFingerprint> fingerprints
+			);
+
+	/**
+	 * Delete several photos.
+	 *
+	 * @param ids ids of the photos
+	 * @return Number of photos deleted
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	int deletePhotos(std::span<const int> ids);
+
+	/**
+	 * A photo as stored in the catalogue (see getCataloguedPhotos()).
+	 */
+	struct CataloguedPhoto {
+		int id;
+		std::string filename;
+		FileFingerprint fingerprint;
+	};
+
+	/**
+	 * Get the file names and fingerprints of the photos in a directory.
+	 *
+	 * @param directory id of the directory
+	 * @return the photos in 'directory' sorted by file name (bytewise)
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	std::vector<CataloguedPhoto> getCataloguedPhotos(int directory);
+
+	/**
+	 * A photo found by the fingerprint of its file (see
+	 * getPhotosWithFingerprints()).
+	 */
+	struct PhotoFile {
+		int id;
+		std::string path;	/**< path of the file */
+		FileFingerprint fingerprint;
+	};
+
+	/**
+	 * Get the photos whose files have one of several fingerprints.
+	 *
+	 * A file keeps its fingerprint when it is renamed or moved within its
+	 * file system, so PhotoImporter uses this to find the photos of moved
+	 * files. The photos are looked up through the index on the size.
+	 *
+	 * @param fingerprints the fingerprints to look for; fingerprints of
+	 * 		size 0 are ignored
+	 * @return the photos with one of the fingerprints
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	std::vector<PhotoFile> getPhotosWithFingerprints(std::span<const FileFingerprint> fingerprints);
+
+	/**
+	 * A photo without a perceptual or content hash (see getUnhashedPhotos()
+	 * and getContentHashCandidates()).
+	 */
+	struct UnhashedPhoto {
+		int id;
+		std::string path;	/**< path of the file */
+	};
+
+	/**
+	 * Get photos whose perceptual hash hasn't been computed yet.
+	 * Photos have no hash until setPerceptualHashes() is called for them;
+	 * the hash of a photo whose file changed (see updatePhotoFiles()) is
+	 * removed. Photos passed to setPerceptualHashesFailed() are left out
+	 * until their file changes. The photos are looked up through a partial
+	 * index, so only the photos without a hash are read.
+	 *
+	 * @param after only photos with a greater id are returned, to continue
+	 * 		after the last photo of the previous call
+	 * @param limit maximum number of photos to return
+	 * @return the photos sorted by id
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	std::vector<UnhashedPhoto> getUnhashedPhotos(int after, int limit);
+
+	/**
+	 * Store the perceptual hashes of several photos.
+	 * Can be called in a queued write (see queueWrite()).
+	 *
+	 * @param ids ids of the photos
+	 * @param hashes the hashes (see Support::PerceptualHash) in the same
+	 * 		order as 'ids'
+	 *
+	 * @throws database_error If any error occurs in the database (no hash
+	 * 		is stored in that case)
+	 */
+	void setPerceptualHashes(std::span<const int> ids, std::span<const std::uint64_t> hashes);
+
+	/**
+	 * Remember that the perceptual hashes of several photos can't be
+	 * computed (e.g. their files can't be decoded), so they aren't
+	 * returned by getUnhashedPhotos() again until their files change.
+	 * Can be called in a queued write (see queueWrite()).
+	 *
+	 * @param ids ids of the photos
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	void setPerceptualHashesFailed(std::span<const int> ids);
+
+	/**
+	 * Find groups of duplicate and near-duplicate photos.
+	 *
+	 * Two photos are similar if the Hamming distance of their perceptual
+	 * hashes is at most 'max_distance'; a group contains the photos
+	 * connected by similar pairs. Photos without a hash are ignored. The
+	 * hashes are searched with a Support::HammingIndex.
+	 *
+	 * @param max_distance largest distance of similar photos (0 for
+	 * 		identical hashes)
+	 * @return the groups of at least two photos, each sorted by id, sorted
+	 * 		by their first photo
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	std::vector<std::vector<int>> findSimilarPhotos(int max_distance = 6);
+
+	/**
+	 * Find the duplicates and near-duplicates of a photo.
+	 *
+	 * @param photo id of the photo
+	 * @param max_distance largest distance of similar photos (see
+	 * 		findSimilarPhotos(int))
+	 * @return the photos similar to 'photo' (without 'photo'), sorted by
+	 * 		distance and id; empty if 'photo' has no hash
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	std::vector<int> getSimilarPhotos(int photo, int max_distance = 6);
+
+	/**
+	 * Get photos whose content hash is needed but hasn't been computed yet.
+	 *
+	 * Only identical files need a hash, so only photos sharing the size of
+	 * their file with another photo are returned: most files have a unique
+	 * size and are never read. A photo gets a hash with
+	 * setContentHashes(); the hash of a photo whose file changed (see
+	 * updatePhotoFiles()) is removed. Photos without a fingerprint (size 0)
+	 * are skipped, as are photos passed to setContentHashesFailed() until
+	 * their file changes.
+	 *
+	 * @param after only photos with a greater id are returned, to continue
+	 * 		after the last photo of the previous call
+	 * @param limit maximum number of photos to return
+	 * @return the photos sorted by id
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	std::vector<UnhashedPhoto> getContentHashCandidates(int after, int limit);
+
+	/**
+	 * Store the content hashes of several photos.
+	 * Can be called in a queued write (see queueWrite()).
+	 *
+	 * @param ids ids of the photos
+	 * @param hashes the hashes of the files (see Support::ContentHash) in
+	 * 		the same order as 'ids'
+	 *
+	 * @throws database_error If any error occurs in the database (no hash
+	 * 		is stored in that case)
+	 */
+	void setContentHashes(std::span<const int> ids, std::span<const std::uint64_t> hashes);
+
+	/**
+	 * Remember that the files of several photos can't be read, so they
+	 * aren't returned by getContentHashCandidates() again until they change.
+	 * Can be called in a queued write (see queueWrite()).
+	 *
+	 * @param ids ids of the photos
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	void setContentHashesFailed(std::span<const int> ids);
+
+	/**
+	 * Find groups of photos with identical files.
+	 *
+	 * Files are identical if they have the same size and content hash.
+	 * Photos without a content hash are ignored (see ContentHasher).
+	 *
+	 * @return the groups of at least two photos, each sorted by id, sorted
+	 * 		by their first photo
+	 *
+	 * @throws database_error If any error occurs in the database
+	 */
+	std::vector<std::vector<int>> findDuplicatePhotos();
+
 	/**
 	 * Updates a record.
 	 *
@@ -152,6 +521,27 @@ public:
 	template<typename RecordType>
 	void setParent(int child_id, int new_parent_id);
 
+	/**
+	 * Set or clear options of several records.
+	 *
+	 * Only the options column is written, with a single UPDATE for all
+	 * records, so unlike updateEntry() no other column is rewritten and
+	 * no trigger on them fires. Meant for options only relevant to the GUI
+	 * (e.g. RecordOptions::ROW_EXPANDED); the change is not reported to the
+	 * change observers.
+	 *
+	 * @tparam RecordType Record based class with options (DirectoryRecord,
+	 * 		AlbumRecord, or KeywordRecord)
+	 * @param ids Ids of the records to change; unknown ids are ignored
+	 * @param mask the options to set or clear
+	 * @param value true to set the options in 'mask', false to clear them
+	 *
+	 * @throws database_error If the database returns an error
+	 */
+	template<typename RecordType>
+		requires (!std::derived_from<RecordType, RecordClasses::PhotoRecord>)
+	void setOptionBits(std::span<const int> ids, RecordClasses::RecordOptions::Options mask, bool value);
+
 	/**
 	 * Get the id to an entry.
 	 *
@@ -193,6 +583,82 @@ public:
 	template<Relations relation>
 	std::vector<int> getEntries(int collection);
 
+	/**
+	 * Get a sorted vector of photos in a collection.
+	 * The photos are sorted by the database.
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param collection Id of the 'collection' (e.g. keyword or album)
+	 * 		for which the photos should be returned.
+	 * @param order Order of the photos
+	 * @param descending true to reverse 'order'
+	 * @return Vector of ids of all photos in the collection
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<Relations relation>
+	std::vector<int> getEntries(int collection, PhotoOrder order, bool descending = false);
+
+	/**
+	 * Get a sorted vector of photos in a collection or any of its
+	 * descendants, e.g. all photos tagged with a keyword or one of its
+	 * child keywords. The descendants are looked up in the closure table of
+	 * the hierarchy, so no recursive querry is needed.
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param collection Id of the 'collection' (e.g. keyword or album)
+	 * @param order Order of the photos
+	 * @param descending true to reverse 'order'
+	 * @return ids of the photos in the collection and its descendants, each
+	 * 		photo once
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<Relations relation>
+	std::vector<int> getEntriesInSubtree(int collection, PhotoOrder order = PhotoOrder::ID, bool descending = false);
+
+	/**
+	 * Get the sorted photos in a directory.
+	 * The sort orders except PhotoOrder::FILENAME are backed by indexes on
+	 * the photos of a directory, so the photos are read in order without
+	 * sorting.
+	 *
+	 * @param directory id of the directory
+	 * @param order Order of the photos
+	 * @param descending true to reverse 'order'
+	 * @return ids of the photos in 'directory'
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<int> getPhotos(int directory, PhotoOrder order, bool descending = false);
+
+	/**
+	 * Get the sorted photos in a directory and all its subdirectories.
+	 * The subdirectories are looked up in the closure table of the
+	 * directories, so no recursive querry is needed.
+	 *
+	 * @param directory id of the directory
+	 * @param order Order of the photos
+	 * @param descending true to reverse 'order'
+	 * @return ids of the photos in 'directory' and its subdirectories
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<int> getPhotosInSubtree(int directory, PhotoOrder order = PhotoOrder::ID, bool descending = false);
+
+	/**
+	 * Sort photos (e.g. the result of filterPhotos()) by the database.
+	 * Ids of photos that don't exist are dropped.
+	 *
+	 * @param photos ids of the photos
+	 * @param order Order of the photos
+	 * @param descending true to reverse 'order'
+	 * @return 'photos' sorted by 'order'
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<int> sortPhotos(std::span<const int> photos, PhotoOrder order, bool descending = false);
+
 	/**
 	 * Get the number of photos in a 'collection'.
 	 *
@@ -207,6 +673,23 @@ public:
 	template<Relations relation>
 	int getNumberEntries(int collection);
 
+	/**
+	 * Get the number of photos out of a selection in every 'collection'.
+	 *
+	 * Counts for every 'collection' (e.g. keyword or album) how many of
+	 * the photos are in it using a single querry.
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param photos Ids of the selected photos
+	 * @return Map from the ids of the 'collections' to the number of
+	 * 		photos in them; 'collections' containing none of the photos
+	 * 		are omitted
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<Relations relation>
+	std::unordered_map<int,int> getNumberEntriesPerCollection(std::span<const int> photos);
+
 	/**
 	 * Get a vector of 'collections' containig a photo
 	 *
@@ -262,6 +745,344 @@ public:
 	template<Relations relation>
 	void deleteRelation(int photo, int collection);
 
+	/**
+	 * Add several photos to a 'collection'.
+	 *
+	 * All relations are added with a single SQL statement. Adding existing
+	 * relations has no effect.
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param photos Ids of the photos
+	 * @param collection Id of the 'collection' (e.g. keyword or album)
+	 * @return Number of relations added
+	 *
+	 * @throws constraint_error if adding the new relations fails due to
+	 * 		a constraint violation (no relation is added in that case)
+	 * @throws database_error if any error occurs in the database
+	 */
+	template<Relations relation>
+	int newRelations(std::span<const int> photos, int collection);
+
+	/**
+	 * Add several photos to several 'collections'.
+	 *
+	 * Adds every photo to every 'collection' with a single SQL statement.
+	 * Adding existing relations has no effect.
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param photos Ids of the photos
+	 * @param collections Ids of the 'collections' (e.g. keywords or albums)
+	 * @return Number of relations added
+	 *
+	 * @throws constraint_error if adding the new relations fails due to
+	 * 		a constraint violation (no relation is added in that case)
+	 * @throws database_error if any error occurs in the database
+	 */
+	template<Relations relation>
+	int newRelations(std::span<const int> photos, std::span<const int> collections);
+
+	/**
+	 * Remove several photos from a 'collection'.
+	 *
+	 * All relations are removed with a single SQL statement. Deleting
+	 * non-existing relations has no effect.
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param photos Ids of the photos
+	 * @param collection Id of the 'collection' (e.g. keyword or album)
+	 * @return Number of relations removed
+	 *
+	 * @throws database_error if any error occurs in the database
+	 */
+	template<Relations relation>
+	int deleteRelations(std::span<const int> photos, int collection);
+
+	/**
+	 * Remove several photos from several 'collections'.
+	 *
+	 * Removes every photo from every 'collection' with a single SQL
+	 * statement. Deleting non-existing relations has no effect.
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param photos Ids of the photos
+	 * @param collections Ids of the 'collections' (e.g. keywords or albums)
+	 * @return Number of relations removed
+	 *
+	 * @throws database_error if any error occurs in the database
+	 */
+	template<Relations relation>
+	int deleteRelations(std::span<const int> photos, std::span<const int> collections);
+
+	/**
+	 * Get the photos in a 'collection' as a bitmap.
+	 *
+	 * The bitmaps of all 'collections' are kept in memory; they are built
+	 * from the relations tables when the object is created and kept up to
+	 * date by the methods adding or removing relations. Set operations can
+	 * be done with the operators of Support::RoaringBitmap (&: AND, |: OR,
+	 * -: AND NOT) and counted with Support::RoaringBitmap::cardinality(),
+	 * e.g. the photos in album 'a' with keyword 'k' but without keyword 'l':
+	 * \code
+	 * auto photos = backend.getEntriesBitmap<Relations::PHOTOS_ALBUMS>(a)
+	 * 		& backend.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k)
+	 * 		- backend.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(l);
+	 * \endcode
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param collection Id of the 'collection' (e.g. keyword or album)
+	 * @return Copy of the bitmap of the ids of all photos in the
+	 * 		'collection' (empty if the 'collection' doesn't exist)
+	 *
+	 * @throws database_error if the bitmaps need to be rebuilt and the
+	 * 		database returns an error
+	 */
+	template<Relations relation>
+	Support::RoaringBitmap getEntriesBitmap(int collection);
+
+	/**
+	 * Get the photos in all of several 'collections' (AND).
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param collections Ids of the 'collections' (e.g. keywords or albums)
+	 * @return Bitmap of the ids of all photos contained in every one of
+	 * 		'collections' (empty if 'collections' is empty)
+	 *
+	 * @throws database_error if the bitmaps need to be rebuilt and the
+	 * 		database returns an error
+	 */
+	template<Relations relation>
+	Support::RoaringBitmap getEntriesInAll(std::span<const int> collections);
+
+	/**
+	 * Get the photos in any of several 'collections' (OR).
+	 *
+	 * @tparam relation Enumerator for the relations table
+	 * @param collections Ids of the 'collections' (e.g. keywords or albums)
+	 * @return Bitmap of the ids of all photos contained in at least one of
+	 * 		'collections'
+	 *
+	 * @throws database_error if the bitmaps need to be rebuilt and the
+	 * 		database returns an error
+	 */
+	template<Relations relation>
+	Support::RoaringBitmap getEntriesInAny(std::span<const int> collections);
+
+	/**
+	 * Get the photos matching a filter expression.
+	 *
+	 * The expression (see PhotoFilter for the syntax) is translated into a
+	 * single parameterised SQL querry. Directories, albums, and keywords are
+	 * resolved by subqueries on the relations and closure tables.
+	 *
+	 * @param expression the filter expression
+	 * @return Ids of all photos matching 'expression' sorted by id
+	 *
+	 * @throws filter_error if 'expression' isn't a valid filter expression
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<int> filterPhotos(std::string_view expression);
+
+	/**
+	 * Add a new smart album.
+	 *
+	 * The photos in a smart album are defined by a rule, a filter
+	 * expression (see PhotoFilter). The photos matching the rule are stored
+	 * as relations of the album like those of a regular album, so opening
+	 * a smart album costs the same as opening a regular one. The relations
+	 * are kept up to date when photos or their relations change (only the
+	 * changed photos are evaluated) and when directories, albums, or
+	 * keywords change (only the rules referring to the changed entry or its
+	 * ancestors are evaluated, for the photos in its subtree).
+	 *
+	 * Photos added to a smart album with newRelation() or newRelations()
+	 * stay in it even if they don't match its rule.
+	 *
+	 * Smart albums whose rules refer to other smart albums are evaluated
+	 * after those albums; rules referring to each other in a cycle are
+	 * rejected. A cycle created later by renaming or moving albums is
+	 * evaluated in the order of the ids.
+	 *
+	 * @param album the new album; RecordClasses::AlbumRecord::Options::SMART_ALBUM
+	 * 		is added to its options
+	 * @param rule filter expression defining the photos in the album
+	 * @return Id of the new album
+	 *
+	 * @throws filter_error if 'rule' isn't a valid filter expression or
+	 * 		refers to the album itself directly or through other smart
+	 * 		albums (no album is added)
+	 * @throws constraint_error If adding the album fails due to constraint
+	 * 		violation
+	 * @throws database_error If any other error occurs in the database
+	 */
+	int newSmartAlbum(const RecordClasses::AlbumRecord& album, std::string_view rule);
+
+	/**
+	 * Change the rule of a smart album.
+	 *
+	 * @param album Id of the smart album
+	 * @param rule new filter expression defining the photos in the album
+	 *
+	 * @throws filter_error if 'rule' isn't a valid filter expression or
+	 * 		refers to the album itself directly or through other smart
+	 * 		albums (the rule isn't changed)
+	 * @throws missing_entry if 'album' isn't a smart album
+	 * @throws database_error If any other error occurs in the database
+	 */
+	void setSmartAlbumRule(int album, std::string_view rule);
+
+	/**
+	 * Get the rule of a smart album.
+	 *
+	 * @param album Id of the smart album
+	 * @return filter expression defining the photos in the album
+	 *
+	 * @throws missing_entry if 'album' isn't a smart album
+	 */
+	std::string getSmartAlbumRule(int album);
+
+	/**
+	 * Get the number of photos in a directory, album, or keyword.
+	 *
+	 * The numbers are kept up to date by triggers in the database, so
+	 * reading them doesn't depend on the number of photos or the depth
+	 * of the hierarchy.
+	 *
+	 * If 'include_descendants' is set the photos of all descendants are
+	 * included. For albums and keywords a photo assigned to more than one
+	 * descendant is counted once for every descendant.
+	 *
+	 * @tparam RecordType DirectoryRecord, AlbumRecord, or KeywordRecord
+	 * @param id Id of the directory, album, or keyword
+	 * @param include_descendants Whether to include the photos of all
+	 * 		descendants
+	 * @return Number of photos in 'id' (0 if 'id' doesn't exist)
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<typename RecordType>
+	int getNumberPhotos(int id, bool include_descendants=true);
+
+	/**
+	 * Get the years, the months of a year, or the days of a month with photos.
+	 *
+	 * The numbers of photos are maintained by the database whenever photos
+	 * are added, changed, or deleted, so this doesn't look at the photos.
+	 * Dates are in UTC like in filterPhotos(). Photos without a date
+	 * ('datetime' 0) are not counted.
+	 *
+	 * @param year 0 for the years, the year for its months or days
+	 * @param month 0 for the months of 'year', the month for its days
+	 * @return the periods with at least one photo in chronological order
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<TimelinePeriod> getTimeline(int year = 0, int month = 0);
+
+	/**
+	 * Get the photos taken in a year, month, or day (UTC).
+	 * The photos are looked up through an index on the date. Photos
+	 * without a date ('datetime' 0) aren't returned.
+	 *
+	 * @param year year
+	 * @param month month (1 to 12), 0 for the whole year
+	 * @param day day (1 to 31), 0 for the whole month
+	 * @param order Order of the photos
+	 * @param descending true to reverse 'order'
+	 * @return ids of the photos taken in the period
+	 *
+	 * @throws std::invalid_argument if the date is invalid
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<int> getPhotosTaken(int year, int month = 0, int day = 0, PhotoOrder order = PhotoOrder::DATETIME,
+			bool descending = false);
+
+	/**
+	 * Search keywords by name, synonym, or the names of their ancestors.
+	 *
+	 * Every word of 'text' has to match the beginning of a word in the
+	 * keyword, its synonyms, or its path (the names of its ancestors), so
+	 * the search can be run on every keystroke. Matching is case and
+	 * diacritics insensitive. The keywords are looked up in a full-text
+	 * index kept up to date by the database.
+	 *
+	 * @param text words to search for
+	 * @param limit maximum number of keywords to return (negative for all)
+	 * @return ids of the matching keywords, best matches (on the keyword
+	 * 		itself, then on its synonyms, then on its path) first; empty if
+	 * 		'text' contains no words
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<int> searchKeywords(std::string_view text, int limit = 100);
+
+	/**
+	 * Get the ancestors of entries, e.g. to show search results in the tree.
+	 * Needs a single querry regardless of the number of entries.
+	 *
+	 * @tparam RecordType Record based class for the table (see
+	 * 		AccessTables' class documentation for more information)
+	 * @param ids ids of the entries
+	 * @return ids of all ancestors of the entries in 'ids' (without the
+	 * 		roots) in ascending order, each id once
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<typename RecordType>
+	std::vector<int> getAncestors(std::span<const int> ids);
+
+	/**
+	 * Get the descendants of an entry.
+	 * Needs a single index range scan of the closure table of the hierarchy.
+	 *
+	 * @tparam RecordType Record based class for the table (see
+	 * 		AccessTables' class documentation for more information)
+	 * @param id id of the entry
+	 * @return ids of all descendants of 'id' (without 'id') in ascending
+	 * 		order
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<typename RecordType>
+	std::vector<int> getDescendants(int id);
+
+	/**
+	 * Check whether an entry is an ancestor of another one.
+	 * Needs a single index lookup in the closure table of the hierarchy.
+	 *
+	 * @tparam RecordType Record based class for the table (see
+	 * 		AccessTables' class documentation for more information)
+	 * @param ancestor id of the possible ancestor
+	 * @param id id of the entry
+	 * @retval true if 'ancestor' is the parent of 'id' or one of its
+	 * 		ancestors (including the roots)
+	 * @retval false otherwise, also if 'ancestor' is 'id'
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	template<typename RecordType>
+	bool isAncestor(int ancestor, int id);
+
+	/**
+	 * Check the photo counts.
+	 * Compares the photo counts maintained by the database (see
+	 * getNumberPhotos(int,bool) and getTimeline()) with freshly computed ones.
+	 *
+	 * @retval true if all photo counts are correct
+	 * @retval false otherwise
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	bool checkPhotoCounts();
+
+	/**
+	 * Recompute the photo counts.
+	 * Recomputes all photo counts maintained by the database (see
+	 * getNumberPhotos(int,bool) and getTimeline()) from scratch.
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	void rebuildPhotoCounts();
+
 	/**
 	 * Retrieve the value of a main window property.
 	 *
@@ -273,11 +1094,38 @@ public:
 	/**
 	 * Save the value of a main window property.
 	 *
+	 * Only the value in memory is changed, so this can be called on every
+	 * resize; saveWindowProperties() writes the changed values to the
+	 * database.
+	 *
 	 * @param property Property for which the value should be saved
 	 * @param value New value of 'property'
 	 */
 	void setWindowProperty(WindowProperties property, int value);
 
+	/**
+	 * Write the changed window properties to the database.
+	 *
+	 * The changes are written with a single queued write (see queueWrite()),
+	 * however many times the properties were set before. Nothing is written
+	 * if nothing changed or if the last change is less than 'quiet' ago,
+	 * so calling this regularly with 'quiet' > 0 writes once after a series
+	 * of changes (e.g. while the window is resized) has ended.
+	 *
+	 * @param quiet time without changes before they are written
+	 * @return true if the changes were queued
+	 */
+	bool saveWindowProperties(std::chrono::milliseconds quiet = std::chrono::milliseconds::zero());
+
+	/**
+	 * Load the window properties from the database.
+	 * Properties without a saved value get their default value, changes
+	 * not saved yet are discarded. Called by the constructor.
+	 *
+	 * @throws database_error if the database returns an error
+	 */
+	void loadWindowProperties();
+
 	/**
 	 * Get the width of the central pane.
 	 *
@@ -285,18 +1133,204 @@ public:
 	 */
 	int getCentreWidth() const;
 
+	/**
+	 * Register a function to be called after each Change.
+	 *
+	 * Observers are called synchronously in the thread making the change,
+	 * in the order they were added, while the connection is locked for
+	 * that thread, so an observer may read the changed entries but must
+	 * not wait for another thread using the BackendFactory. Exceptions
+	 * thrown by an observer are passed on to the caller of the changing
+	 * function; the change itself is kept. Observers may be added and
+	 * removed in any thread, but not by an observer.
+	 *
+	 * @param observer function to call
+	 * @return id of the observer for removeChangeObserver()
+	 */
+	int addChangeObserver(ChangeObserver observer);
+
+	/**
+	 * Unregister a function added with addChangeObserver().
+	 * Removing an unknown id has no effect.
+	 *
+	 * @param observer id returned by addChangeObserver()
+	 */
+	void removeChangeObserver(int observer) noexcept;
+
+	/**
+	 * Queue a write to be run later in a writer thread.
+	 *
+	 * Meant for changes made in the GUI that don't need an answer (e.g.
+	 * setOptionBits()), so the main loop doesn't wait for the disk. The
+	 * writes queued at the same time are run in a single transaction (group
+	 * commit), each in its own savepoint: a failing write is rolled back
+	 * and its exception passed to the handler set with
+	 * setWriteErrorHandler(), the others are kept. The other threads wait
+	 * while a group is run, so they neither write into its transaction nor
+	 * read its uncommitted changes, but not while a database file is synced
+	 * to disk afterwards. The change observers are called after the commit
+	 * and only for the writes that weren't rolled back.
+	 *
+	 * Every function of BackendFactory waits for the writes queued by the
+	 * calling thread before it accesses the database, so a thread always
+	 * reads its own writes. flushWrites() waits for the writes of all
+	 * threads; the queue is flushed when the BackendFactory is destroyed.
+	 *
+	 * 'write' must not queue writes itself or call the functions using
+	 * their own transaction (newPhotos(), updatePhotoFiles(),
+	 * rebuildPhotoCounts()).
+	 *
+	 * @param write function called with this BackendFactory in the writer
+	 * 		thread
+	 */
+	void queueWrite(std::function<void(BackendFactory&)> write);
+
+	/**
+	 * Wait until all writes queued with queueWrite() have been run.
+	 */
+	void flushWrites();
+
+	/**
+	 * Set the function called with the exceptions of failed queued writes.
+	 * The function is called in the writer thread. Without a handler the
+	 * errors are written to std::cerr.
+	 *
+	 * @param handler function to call with the exception of a failed write
+	 */
+	void setWriteErrorHandler(std::function<void(std::exception_ptr)> handler);
+
 private:
 	std::unique_ptr<SQLiteAdapter::Database> db;
+	/// connection of the writer thread syncing the database file to disk (see runWriteGroup())
+	std::unique_ptr<SQLiteAdapter::Database> checkpoint_db;
 	std::unique_ptr<PhotoLibrary::DatabaseInterface::AccessTables<Glib::ustring>> tables_interface;
 	std::unique_ptr<PhotoLibrary::DatabaseInterface::RelationsTable> relations_interface;
-	std::unordered_map<WindowProperties,int> window_properties;
+	static constexpr std::size_t n_window_properties = static_cast<std::size_t>(WindowProperties::N_THREADS) + 1;
+	/// names of the WindowProperties in the table Settings
+	static inline const std::array<const std::string,n_window_properties> window_property_keys {
+		"window_width", "window_height", "left_pane_width", "right_pane_width", "tile_width", "n_threads"
+	};
+	std::array<int,n_window_properties> window_properties;
+	/// properties changed since the last saveWindowProperties()
+	std::array<bool,n_window_properties> window_properties_changed {};
+	std::chrono::steady_clock::time_point last_window_property_change;
+	mutable std::mutex window_properties_mutex;
+	/// bitmaps of the photos in every 'collection' (see getEntriesBitmap())
+	std::array<std::unordered_map<int,Support::RoaringBitmap>,2> relations_index;
+	std::array<bool,2> relations_index_valid {false, false};
+	/// rules of the smart albums (see newSmartAlbum())
+	std::map<int,std::pair<std::string,PhotoFilter>> smart_albums;
+	/// smart albums in the order they are evaluated (see orderSmartAlbums())
+	std::vector<int> smart_album_order;
+	/// smart albums whose rules refer to each smart album
+	std::map<int,std::vector<int>> smart_album_dependents;
+	bool smart_album_order_valid = false;
+	/// functions to call after each change (see addChangeObserver())
+	std::map<int,ChangeObserver> change_observers;
+	int next_change_observer = 1;
+	/// changes made by the queued writes, reported after their commit
+	std::vector<Change> deferred_changes;
+	bool deferring_changes = false;
+	/// held by the thread using the connection (see DatabaseLock)
+	std::mutex database_mutex;
+	std::atomic<std::thread::id> database_owner;
+	int database_lock_depth = 0;
+	std::function<void(std::exception_ptr)> write_error_handler;
+	std::mutex write_error_mutex;
 	static inline const std::array<const std::array<const std::string,3>,2> relations_tables {
 		std::array<const std::string,3>{"PhotosAlbumsRelations", "albumId", "photoId"},
 		{"PhotosKeywordsRelations", "keywordId", "photoId"}
 	};
+	/**
+	 * Tables with photo counts: the hierarchy table, the table
+	 * containing the photos, and the column referring to the hierarchy
+	 */
+	static inline const std::array<const std::array<const std::string,3>,3> photo_count_tables {
+		std::array<const std::string,3>{"Directories", "Photos", "directory"},
+		{"Albums", "PhotosAlbumsRelations", "albumId"},
+		{"Keywords", "PhotosKeywordsRelations", "keywordId"}
+	};
 
+	bool hasTables();
 	void createTables();
+	std::unordered_map<int,Support::RoaringBitmap>& getRelationsIndex(Relations relation);
+	void buildRelationsIndex(Relations relation);
+	inline void invalidateRelationsIndex() noexcept;
+	inline void addToRelationsIndex(Relations relation, std::span<const int> photos, std::span<const int> collections);
+	inline void removeFromRelationsIndex(Relations relation, std::span<const int> photos, std::span<const int> collections);
+	void removePhotosFromRelationsIndex(std::span<const int> photos);
+	void removeDeletedFromRelationsIndex(const std::string& table, int id);
+	int getNumberPhotos(const std::string& table, int id, bool include_descendants);
+	void setOptionBits(const std::string& table, const std::string& column, std::span<const int> ids, int mask,
+			bool value);
+	static std::string createPhotoCountTable(const std::array<const std::string,3>& table);
+	std::vector<int> getSortedPhotos(const std::string& sql, const std::vector<PhotoFilter::Parameter>& parameters);
+	static std::string photoOrderBy(PhotoOrder order, bool descending);
+	static std::string expectedPhotoCounts(const std::array<const std::string,3>& table);
+	static std::string createTimelineTable();
+	static std::string expectedTimeline();
+	static std::string createKeywordSearchTable();
+	std::vector<int> getAncestors(const std::string& table, std::span<const int> ids);
+	std::vector<int> getDescendants(const std::string& table, int id);
+	bool isAncestor(const std::string& table, int ancestor, int id);
+	static std::string createClosureTable(const std::string& hierarchy);
+	void setHashes(const char* column, std::span<const int> ids, std::span<const std::uint64_t> hashes);
+	void setHashesFailed(const char* column, std::span<const int> ids);
+	Support::HammingIndex getHammingIndex();
+	std::string getDirectoryPath(int directory);
+	PhotoFilter::CompiledPredicate compilePredicate(const PhotoFilter::Predicate& predicate);
+	std::vector<int> filterPhotos(const PhotoFilter& filter, std::optional<std::span<const int>> photos);
+	void loadSmartAlbums();
+	void orderSmartAlbums(bool reject_cycles);
+	std::vector<int> getSmartAlbumsMatching(const std::string& table, int id);
+	std::vector<int> getPhotosInSubtree(const std::string& table, int id);
+	Support::RoaringBitmap updateSmartAlbum(int album, const PhotoFilter& rule,
+			const std::optional<Support::RoaringBitmap>& photos);
+	void updateSmartAlbums(std::map<int,std::optional<Support::RoaringBitmap>> photos);
+	void updateSmartAlbums(std::span<const int> photos);
+	void markManualRelations(std::span<const int> photos, std::span<const int> albums);
+	/// state before a change of a directory, album, or keyword (see beginHierarchyChange())
+	struct HierarchyChange {
+		std::string table;
+		int id;
+		bool deleting;
+		std::vector<int> smart_albums;	/**< smart albums whose rules refer to the entry */
+		std::vector<int> photos;		/**< photos in the subtree of a deleted entry */
+	};
+	HierarchyChange beginHierarchyChange(const std::string& table, int id, bool deleting);
+	void endHierarchyChange(const HierarchyChange& change);
+	template<typename RecordType, typename Function>
+	void changeEntry(int id, bool deleting, Function change);
+	static std::string matchingCollectionsSQL(const PhotoFilter::Predicate& predicate,
+			std::vector<PhotoFilter::Parameter>& parameters);
+	std::vector<int> getMatchingCollections(const PhotoFilter::Predicate& predicate);
+	void notifyChange(const Change& change);
+	std::unordered_map<int,int> getPhotoDirectories(std::span<const int> photos);
+	void notifyPhotosChanged(const std::set<int>& directories);
+	void runWriteGroup(std::vector<Support::WriteBehindQueue::Write>& writes);
+	void reportWriteError(std::exception_ptr error);
+	/**
+	 * Exclusive use of the connection while the lock exists.
+	 *
+	 * Every function accessing the database holds one, so no thread joins
+	 * or reads the open transaction of the queued writes (see
+	 * runWriteGroup()) or of another function. The first lock taken by a
+	 * thread waits for the writes it queued (read your own writes, see
+	 * queueWrite()); nested locks of the same thread don't wait or block.
+	 */
+	class DatabaseLock {
+	public:
+		explicit DatabaseLock(BackendFactory& backend);
+		~DatabaseLock();
+		DatabaseLock(const DatabaseLock&) = delete;
+		DatabaseLock& operator=(const DatabaseLock&) = delete;
+	private:
+		BackendFactory& backend;
+	};
 
+
+	// last member: flushed and stopped before the other members are destroyed
+	Support::WriteBehindQueue write_queue;
 	//prevent copying and copy construction
 	BackendFactory(const BackendFactory &other) = delete;
 	BackendFactory(BackendFactory &&other) = delete;
@@ -306,62 +1340,139 @@ private:
 
 template<typename RecordType>
 RecordType BackendFactory::getEntry(int id) {
+	DatabaseLock lck {*this};
 	return tables_interface->getEntry<RecordType>(id);
 }
 
 template<typename RecordType>
 std::vector<int> BackendFactory::getChildren(int parent) {
+	DatabaseLock lck {*this};
 	return tables_interface->getChildren<RecordType>(parent);
 }
 
 template<typename RecordType>
 int BackendFactory::getNumberChildren(int parent) {
+	DatabaseLock lck {*this};
 	return tables_interface->getNumberChildren<RecordType>(parent);
 }
 
+template<typename RecordType>
+std::vector<std::pair<int,bool>> BackendFactory::getChildNodes(int parent) {
+	DatabaseLock lck {*this};
+	return tables_interface->getChildNodes<RecordType>(parent);
+}
+
 template<typename RecordType>
 void BackendFactory::newEntry(const RecordType& entry) {
-	return tables_interface->newEntry<RecordType>(entry);
+	DatabaseLock lck {*this};
+	tables_interface->newEntry<RecordType>(entry);
+	constexpr bool is_photo = std::derived_from<RecordType, RecordClasses::PhotoRecord>;
+	if((is_photo && !smart_albums.empty()) || !change_observers.empty()) {
+		int id = getID(entry);
+		if constexpr(is_photo)
+			if(!smart_albums.empty())
+				updateSmartAlbums(std::span<const int>(&id, 1));
+		notifyChange({Change::Type::ADDED, RecordType::table.raw(), id, entry.template access<0>()});
+	}
 }
 
 template<typename RecordType>
 void BackendFactory::updateEntry(int id, const RecordType& entry) {
-	return tables_interface->updateEntry<RecordType>(id, entry);
+	DatabaseLock lck {*this};
+	changeEntry<RecordType>(id, false, [this, id, &entry]() { tables_interface->updateEntry<RecordType>(id, entry); });
+	notifyChange({Change::Type::UPDATED, RecordType::table.raw(), id, entry.template access<0>()});
 }
 
 template<typename RecordType>
 void BackendFactory::setParent(int child_id, int new_parent_id) {
-	return tables_interface->setParent<RecordType>(child_id, new_parent_id);
+	DatabaseLock lck {*this};
+	changeEntry<RecordType>(child_id, false, [this, child_id, new_parent_id]() {
+		tables_interface->setParent<RecordType>(child_id, new_parent_id);
+	});
+	notifyChange({Change::Type::MOVED, RecordType::table.raw(), child_id, new_parent_id});
+}
+
+template<typename RecordType>
+	requires (!std::derived_from<RecordType, RecordClasses::PhotoRecord>)
+void BackendFactory::setOptionBits(std::span<const int> ids, RecordClasses::RecordOptions::Options mask, bool value) {
+	DatabaseLock lck {*this};
+	setOptionBits(RecordType::table, RecordType::fields[1], ids, mask, value);
 }
 
 template<typename RecordType>
 int BackendFactory::getID(const RecordType& entry) {
+	DatabaseLock lck {*this};
 	return tables_interface->getID<RecordType>(entry);
 }
 
 template<typename RecordType>
 void BackendFactory::deleteEntry(int id) {
-	return tables_interface->deleteEntry<RecordType>(id);
+	DatabaseLock lck {*this};
+	// deleting entries may delete relations through foreign keys
+	removeDeletedFromRelationsIndex(RecordType::table.raw(), id);
+	try {
+		changeEntry<RecordType>(id, true, [this, id]() {
+			tables_interface->deleteEntry<RecordType>(id);
+			if constexpr(std::derived_from<RecordType, RecordClasses::AlbumRecord>)
+				loadSmartAlbums();
+		});
+	}
+	catch (...) {
+		invalidateRelationsIndex();
+		throw;
+	}
+	notifyChange({Change::Type::DELETED, RecordType::table.raw(), id, 0});
 }
 
 template<BackendFactory::Relations relation>
 std::vector<int> BackendFactory::getEntries(int collection) {
+	DatabaseLock lck {*this};
 	return relations_interface->getEntries(
 			collection,
 			relations_tables[static_cast<int>(relation)]
 			);
 }
 
+template<BackendFactory::Relations relation>
+std::vector<int> BackendFactory::getEntries(int collection, PhotoOrder order, bool descending) {
+	DatabaseLock lck {*this};
+	const auto& [table, collection_column, photo_column] = relations_tables[static_cast<int>(relation)];
+	return getSortedPhotos("SELECT Photos.id FROM " + table + " JOIN Photos ON Photos.id = " + table + "." + photo_column
+			+ " WHERE " + table + "." + collection_column + " = ?" + photoOrderBy(order, descending), {collection});
+}
+
+template<BackendFactory::Relations relation>
+std::vector<int> BackendFactory::getEntriesInSubtree(int collection, PhotoOrder order, bool descending) {
+	DatabaseLock lck {*this};
+	const auto& [table, collection_column, photo_column] = relations_tables[static_cast<int>(relation)];
+	// the hierarchies of the relations follow the directories in photo_count_tables
+	const std::string& hierarchy = photo_count_tables[static_cast<int>(relation) + 1][0];
+	return getSortedPhotos("SELECT Photos.id FROM Photos WHERE Photos.id IN (SELECT r." + photo_column + " FROM "
+			+ hierarchy + "Closure AS c JOIN " + table + " AS r ON r." + collection_column + " = c.descendant"
+			" WHERE c.ancestor = ?)" + photoOrderBy(order, descending), {collection});
+}
+
 template<BackendFactory::Relations relation>
 int BackendFactory::getNumberEntries(int collection) {
+	DatabaseLock lck {*this};
 	return relations_interface->getNumberEntries(
 			collection,
 			relations_tables[static_cast<int>(relation)]
 			);
 }
 
+template<BackendFactory::Relations relation>
+std::unordered_map<int,int> BackendFactory::getNumberEntriesPerCollection(std::span<const int> photos) {
+	DatabaseLock lck {*this};
+	return relations_interface->getNumberEntriesPerCollection(
+			photos,
+			relations_tables[static_cast<int>(relation)]
+			);
+}
+
 template<BackendFactory::Relations relation>
 std::vector<int> BackendFactory::getCollections(int entry) {
+	DatabaseLock lck {*this};
 	return relations_interface->getCollections(
 			entry,
 			relations_tables[static_cast<int>(relation)]
@@ -370,6 +1481,7 @@ std::vector<int> BackendFactory::getCollections(int entry) {
 
 template<BackendFactory::Relations relation>
 int BackendFactory::getNumberCollections(int entry) {
+	DatabaseLock lck {*this};
 	return relations_interface->getNumberCollections(
 			entry,
 			relations_tables[static_cast<int>(relation)]
@@ -378,20 +1490,192 @@ int BackendFactory::getNumberCollections(int entry) {
 
 template<BackendFactory::Relations relation>
 void BackendFactory::newRelation(int entry, int collection) {
-	return relations_interface->newRelation(
+	DatabaseLock lck {*this};
+	relations_interface->newRelation(
 			entry,
 			collection,
 			relations_tables[static_cast<int>(relation)]
 			);
+	addToRelationsIndex(relation, std::span<const int>(&entry, 1), std::span<const int>(&collection, 1));
+	if constexpr(relation == Relations::PHOTOS_ALBUMS)
+		markManualRelations(std::span<const int>(&entry, 1), std::span<const int>(&collection, 1));
+	updateSmartAlbums(std::span<const int>(&entry, 1));
 }
 
 template<BackendFactory::Relations relation>
 void BackendFactory::deleteRelation(int entry, int collection) {
-	return relations_interface->deleteRelation(
+	DatabaseLock lck {*this};
+	relations_interface->deleteRelation(
 			entry,
 			collection,
 			relations_tables[static_cast<int>(relation)]
 			);
+	removeFromRelationsIndex(relation, std::span<const int>(&entry, 1), std::span<const int>(&collection, 1));
+	updateSmartAlbums(std::span<const int>(&entry, 1));
+}
+
+template<BackendFactory::Relations relation>
+int BackendFactory::newRelations(std::span<const int> photos, int collection) {
+	DatabaseLock lck {*this};
+	int n = relations_interface->newRelations(
+			photos,
+			collection,
+			relations_tables[static_cast<int>(relation)]
+			);
+	addToRelationsIndex(relation, photos, std::span<const int>(&collection, 1));
+	if constexpr(relation == Relations::PHOTOS_ALBUMS)
+		markManualRelations(photos, std::span<const int>(&collection, 1));
+	updateSmartAlbums(photos);
+	return n;
+}
+
+template<BackendFactory::Relations relation>
+int BackendFactory::newRelations(std::span<const int> photos, std::span<const int> collections) {
+	DatabaseLock lck {*this};
+	int n = relations_interface->newRelations(
+			photos,
+			collections,
+			relations_tables[static_cast<int>(relation)]
+			);
+	addToRelationsIndex(relation, photos, collections);
+	if constexpr(relation == Relations::PHOTOS_ALBUMS)
+		markManualRelations(photos, collections);
+	updateSmartAlbums(photos);
+	return n;
+}
+
+template<BackendFactory::Relations relation>
+int BackendFactory::deleteRelations(std::span<const int> photos, int collection) {
+	DatabaseLock lck {*this};
+	int n = relations_interface->deleteRelations(
+			photos,
+			collection,
+			relations_tables[static_cast<int>(relation)]
+			);
+	removeFromRelationsIndex(relation, photos, std::span<const int>(&collection, 1));
+	updateSmartAlbums(photos);
+	return n;
+}
+
+template<BackendFactory::Relations relation>
+int BackendFactory::deleteRelations(std::span<const int> photos, std::span<const int> collections) {
+	DatabaseLock lck {*this};
+	int n = relations_interface->deleteRelations(
+			photos,
+			collections,
+			relations_tables[static_cast<int>(relation)]
+			);
+	removeFromRelationsIndex(relation, photos, collections);
+	updateSmartAlbums(photos);
+	return n;
+}
+
+template<BackendFactory::Relations relation>
+Support::RoaringBitmap BackendFactory::getEntriesBitmap(int collection) {
+	DatabaseLock lck {*this};
+	auto& index = getRelationsIndex(relation);
+	auto bitmap = index.find(collection);
+	return bitmap != index.end() ? bitmap->second : Support::RoaringBitmap();
+}
+
+template<BackendFactory::Relations relation>
+Support::RoaringBitmap BackendFactory::getEntriesInAll(std::span<const int> collections) {
+	DatabaseLock lck {*this};
+	if(collections.empty())
+		return Support::RoaringBitmap();
+	Support::RoaringBitmap result = getEntriesBitmap<relation>(collections.front());
+	auto& index = getRelationsIndex(relation);
+	for(int collection : collections.subspan(1)) {
+		auto bitmap = index.find(collection);
+		if(bitmap == index.end())
+			return Support::RoaringBitmap();
+		if(result.empty())
+			break;
+		result &= bitmap->second;
+	}
+	return result;
+}
+
+template<BackendFactory::Relations relation>
+Support::RoaringBitmap BackendFactory::getEntriesInAny(std::span<const int> collections) {
+	DatabaseLock lck {*this};
+	Support::RoaringBitmap result;
+	auto& index = getRelationsIndex(relation);
+	for(int collection : collections) {
+		auto bitmap = index.find(collection);
+		if(bitmap != index.end())
+			result |= bitmap->second;
+	}
+	return result;
+}
+
+template<typename RecordType>
+int BackendFactory::getNumberPhotos(int id, bool include_descendants) {
+	DatabaseLock lck {*this};
+	return getNumberPhotos(RecordType::table, id, include_descendants);
+}
+
+template<typename RecordType>
+std::vector<int> BackendFactory::getAncestors(std::span<const int> ids) {
+	DatabaseLock lck {*this};
+	return getAncestors(RecordType::table, ids);
+}
+
+template<typename RecordType>
+std::vector<int> BackendFactory::getDescendants(int id) {
+	DatabaseLock lck {*this};
+	return getDescendants(RecordType::table, id);
+}
+
+template<typename RecordType>
+bool BackendFactory::isAncestor(int ancestor, int id) {
+	DatabaseLock lck {*this};
+	return isAncestor(RecordType::table, ancestor, id);
+}
+
+/*
+ * Runs 'change' of the entry 'id' and updates the smart albums: a changed
+ * photo only needs to be evaluated itself (the relations of a deleted photo
+ * are deleted with it), see beginHierarchyChange() for the other entries.
+ */
+template<typename RecordType, typename Function>
+void BackendFactory::changeEntry(int id, bool deleting, Function change) {
+	if constexpr(std::derived_from<RecordType, RecordClasses::PhotoRecord>) {
+		change();
+		if(!deleting)
+			updateSmartAlbums(std::span<const int>(&id, 1));
+	}
+	else {
+		HierarchyChange hierarchy_change = beginHierarchyChange(RecordType::table.raw(), id, deleting);
+		change();
+		endHierarchyChange(hierarchy_change);
+	}
+}
+
+void BackendFactory::invalidateRelationsIndex() noexcept {
+	relations_index_valid.fill(false);
+}
+
+// a relation missing from an invalid index is added when it is rebuilt
+void BackendFactory::addToRelationsIndex(Relations relation, std::span<const int> photos, std::span<const int> collections) {
+	if(!relations_index_valid[static_cast<int>(relation)])
+		return;
+	auto& index = relations_index[static_cast<int>(relation)];
+	for(int collection : collections) {
+		Support::RoaringBitmap& bitmap = index[collection];
+		for(int photo : photos)
+			bitmap.add(photo);
+	}
+}
+
+void BackendFactory::removeFromRelationsIndex(Relations relation, std::span<const int> photos, std::span<const int> collections) {
+	if(!relations_index_valid[static_cast<int>(relation)])
+		return;
+	auto& index = relations_index[static_cast<int>(relation)];
+	for(int collection : collections)
+		if(auto bitmap = index.find(collection); bitmap != index.end())
+			for(int photo : photos)
+				bitmap->second.remove(photo);
 }
 
 } /* namespace Backend */
@@ -0,0 +1,151 @@
+/*
+ * ContentHasher.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ContentHasher.h"
+#include "../Support/ContentHash.h"
+#include <cerrno>
+#include <iterator>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+namespace {
+
+/*
+ * Closes the file descriptor when leaving the scope.
+ */
+class FileDescriptor {
+public:
+	explicit FileDescriptor(int fd) noexcept : fd(fd) {}
+	~FileDescriptor() { if(fd >= 0) ::close(fd); }
+	FileDescriptor(const FileDescriptor&) = delete;
+	FileDescriptor& operator=(const FileDescriptor&) = delete;
+	operator int() const noexcept { return fd; }
+private:
+	int fd;
+};
+
+}
+
+ContentHasher::ContentHasher(BackendFactory& backend, unsigned int n_threads) :
+		backend(backend),
+		n_threads(n_threads ? n_threads : 1) {
+}
+
+ContentHasher::~ContentHasher() noexcept {
+	stop();
+}
+
+/*
+ * The hashes queued by the previous run are flushed first, otherwise
+ * their photos would be read (and hashed) again.
+ */
+void ContentHasher::start() {
+	stop();
+	backend.flushWrites();
+	photos.clear();
+	for(int after = 0;;) {
+		auto page = backend.getContentHashCandidates(after, page_size);
+		if(page.empty())
+			break;
+		after = page.back().id;
+		photos.insert(photos.end(), std::make_move_iterator(page.begin()), std::make_move_iterator(page.end()));
+	}
+
+	next = 0;
+	n_errors = 0;
+	stopping = false;
+	if(photos.empty())
+		return;
+	for(unsigned int i = 0; i < n_threads; ++i)
+		threads.emplace_back(&ContentHasher::hashFiles, this);
+}
+
+void ContentHasher::stop() noexcept {
+	stopping = true;
+	wait();
+}
+
+void ContentHasher::wait() noexcept {
+	for(auto& thread : threads)
+		if(thread.joinable())
+			thread.join();
+	threads.clear();
+}
+
+std::uint64_t ContentHasher::hashFile(const std::filesystem::path& file, std::span<unsigned char> buffer) {
+	FileDescriptor fd(::open(file.c_str(), O_RDONLY | O_CLOEXEC));
+	if(fd < 0)
+		throw(std::system_error(errno, std::generic_category(), "Error opening " + file.string()));
+	::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	Support::ContentHash hash;
+	for(;;) {
+		ssize_t n;
+		do
+			n = ::read(fd, buffer.data(), buffer.size());
+		while(n < 0 && errno == EINTR);
+		if(n < 0)
+			throw(std::system_error(errno, std::generic_category(), "Error reading " + file.string()));
+		if(n == 0)
+			break;
+		hash.update(buffer.data(), static_cast<std::size_t>(n));
+	}
+	::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+	return hash.digest();
+}
+
+void ContentHasher::hashFiles() {
+	std::vector<unsigned char> buffer(buffer_size);
+	std::vector<int> ids;
+	std::vector<std::uint64_t> hashes;
+	std::vector<int> failed;
+	auto flush = [&]() {
+		if(ids.empty() && failed.empty())
+			return;
+		backend.queueWrite([ids = std::move(ids), hashes = std::move(hashes), failed = std::move(failed)](
+				BackendFactory& backend) {
+			backend.setContentHashes(ids, hashes);
+			backend.setContentHashesFailed(failed);
+		});
+		ids.clear();
+		hashes.clear();
+		failed.clear();
+	};
+
+	for(std::size_t i; !stopping && (i = next++) < photos.size();) {
+		try {
+			hashes.push_back(hashFile(photos[i].path, buffer));
+			ids.push_back(photos[i].id);
+		}
+		catch (const std::system_error&) {
+			failed.push_back(photos[i].id);
+			++n_errors;
+		}
+		if(ids.size() + failed.size() >= batch_size)
+			flush();
+	}
+	flush();
+}
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
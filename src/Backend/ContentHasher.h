@@ -0,0 +1,142 @@
+/*
+ * ContentHasher.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_BACKEND_CONTENTHASHER_H_
+#define SRC_BACKEND_CONTENTHASHER_H_
+
+#include "BackendFactory.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+/**
+ * Background job computing the content hashes of the photos for finding
+ * identical files (see BackendFactory::findDuplicatePhotos()).
+ *
+ * start() reads the photos needing a hash (see
+ * BackendFactory::getContentHashCandidates(), only files sharing their
+ * size with another file) and hashes their files in worker threads. The
+ * files are read sequentially in large blocks; several files are read at
+ * the same time, which keeps a network drive or a RAID busy. The hashes
+ * are stored in batches with queued writes, so the job only accesses the
+ * database in the thread calling start() and doesn't block it.
+ *
+ * Only photos added or changed since the last run are hashed, because the
+ * backend removes the hash of a photo whose file changed. Files that can't
+ * be read are marked as failed (see BackendFactory::setContentHashesFailed())
+ * and only read again once they change.
+ */
+class ContentHasher {
+public:
+	/**
+	 * No file is hashed before start() is called.
+	 *
+	 * @param backend the library whose photos are hashed
+	 * @param n_threads number of files read at the same time (at least 1)
+	 */
+	ContentHasher(BackendFactory& backend, unsigned int n_threads);
+
+	/**
+	 * Stops the worker threads; the hashes computed so far are queued.
+	 */
+	~ContentHasher() noexcept;
+
+	//no copying or moving
+	ContentHasher(const ContentHasher&) = delete;
+	ContentHasher(ContentHasher&&) = delete;
+	ContentHasher& operator=(const ContentHasher&) = delete;
+	ContentHasher& operator=(ContentHasher&&) = delete;
+
+	/**
+	 * Hash all files needing a hash.
+	 *
+	 * Call after photos were added or changed; a running job is stopped
+	 * and restarted with the current photos. Returns once the worker
+	 * threads are started.
+	 *
+	 * @throws database_error if reading the photos fails
+	 */
+	void start();
+
+	/**
+	 * Stop the worker threads.
+	 * Waits for the files currently being read.
+	 */
+	void stop() noexcept;
+
+	/**
+	 * Wait until all files of the last start() are hashed and their
+	 * hashes queued.
+	 */
+	void wait() noexcept;
+
+	/**
+	 * Number of files of the last start() that couldn't be read.
+	 *
+	 * @return number of files without a hash because of an error
+	 */
+	std::size_t getErrors() const noexcept { return n_errors; }
+
+	/**
+	 * Hash the content of a file.
+	 *
+	 * The file is read from start to end with reads of the size of
+	 * 'buffer'. The kernel is told that the file is read sequentially (so
+	 * it reads ahead) and that the data won't be needed again (so hashing
+	 * many files doesn't evict the page cache of the other programs).
+	 *
+	 * @param file path to the file
+	 * @param buffer buffer for the reads
+	 * @return the hash (see Support::ContentHash)
+	 *
+	 * @throws std::system_error if the file can't be read
+	 */
+	static std::uint64_t hashFile(const std::filesystem::path& file, std::span<unsigned char> buffer);
+
+private:
+	/// size of the reads, large enough for sequential reads at full speed
+	static constexpr std::size_t buffer_size = 1 << 20;
+	/// number of hashes stored with one queued write
+	static constexpr std::size_t batch_size = 64;
+	/// number of photos read with one query
+	static constexpr int page_size = 1000;
+
+	BackendFactory& backend;
+	const unsigned int n_threads;
+	std::vector<BackendFactory::UnhashedPhoto> photos;
+	/// index of the next photo to hash
+	std::atomic<std::size_t> next {0};
+	std::atomic<bool> stopping {false};
+	std::atomic<std::size_t> n_errors {0};
+	std::vector<std::thread> threads;
+
+	void hashFiles();
+};
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_BACKEND_CONTENTHASHER_H_ */
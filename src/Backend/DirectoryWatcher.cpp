@@ -0,0 +1,218 @@
+/*
+ * DirectoryWatcher.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "DirectoryWatcher.h"
+#include "PhotoImporter.h"
+#include "Record/DirectoryRecord.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+namespace {
+
+constexpr std::uint32_t watch_mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+		IN_CLOSE_WRITE | IN_ATTRIB | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+}
+
+DirectoryWatcher::DirectoryWatcher(BackendFactory& backend, std::function<void()> notify, unsigned int n_threads,
+		std::chrono::milliseconds debounce, std::chrono::milliseconds max_delay) :
+		backend(backend),
+		notify(std::move(notify)),
+		n_threads(n_threads),
+		debounce(debounce),
+		max_delay(max_delay) {
+	inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(inotify_fd < 0)
+		throw(std::system_error(errno, std::generic_category(), "Error initialising inotify"));
+	if(pipe2(stop_pipe, O_CLOEXEC)) {
+		int error = errno;
+		close(inotify_fd);
+		throw(std::system_error(error, std::generic_category(), "Error creating pipe"));
+	}
+	thread = std::thread(&DirectoryWatcher::run, this);
+}
+
+DirectoryWatcher::~DirectoryWatcher() noexcept {
+	char stop = 0;
+	[[maybe_unused]] auto written = write(stop_pipe[1], &stop, 1);
+	thread.join();
+	close(stop_pipe[0]);
+	close(stop_pipe[1]);
+	close(inotify_fd);
+}
+
+int DirectoryWatcher::watch() {
+	failed = 0;
+	// top level directories hold their absolute path
+	for(int id : backend.getChildren<RecordClasses::DirectoryRecord>(0))
+		watchTree(id, backend.getEntry<RecordClasses::DirectoryRecord>(id).getFullDirectory().raw(), false);
+	return failed;
+}
+
+/*
+ * New directories are always in unwatched directories' subtrees or direct
+ * children of a changed directory, so watched subtrees only need to be
+ * descended into after a change.
+ */
+void DirectoryWatcher::watchTree(int id, const std::filesystem::path& path, bool descend_watched) {
+	if(!watched_ids.contains(id)) {
+		int wd = inotify_add_watch(inotify_fd, path.c_str(), watch_mask);
+		if(wd < 0)
+			++failed;
+		else {
+			// a renamed directory is still watched under its old id
+			auto [watch, added] = watches.try_emplace(wd, Watch{id, path});
+			if(!added) {
+				watched_ids.erase(watch->second.id);
+				watch->second = Watch{id, path};
+			}
+			watched_ids.insert(id);
+		}
+	}
+	else if(!descend_watched)
+		return;
+	for(int child : backend.getChildren<RecordClasses::DirectoryRecord>(id))
+		if(!watched_ids.contains(child))
+			watchTree(child, path / backend.getEntry<RecordClasses::DirectoryRecord>(child).getFullDirectory().raw(), false);
+}
+
+std::vector<int> DirectoryWatcher::processChanges() {
+	std::unordered_set<int> changed_watches;
+	bool all = false;
+	{
+		std::lock_guard<std::mutex> lck {changes_mutex};
+		std::swap(changed_watches, changed);
+		std::swap(all, overflow);
+		for(int wd : removed) {
+			if(auto watch = watches.find(wd); watch != watches.end()) {
+				watched_ids.erase(watch->second.id);
+				watches.erase(watch);
+			}
+		}
+		removed.clear();
+	}
+
+	std::vector<std::pair<int,std::filesystem::path>> directories;
+	for(auto watch = watches.begin(); watch != watches.end(); ) {
+		if(all || changed_watches.contains(watch->first)) {
+			// directories moved out of the library are removed but still watched
+			try {
+				backend.getEntry<RecordClasses::DirectoryRecord>(watch->second.id);
+			}
+			catch (DatabaseInterface::missing_entry&) {
+				inotify_rm_watch(inotify_fd, watch->first);
+				watched_ids.erase(watch->second.id);
+				watch = watches.erase(watch);
+				continue;
+			}
+			directories.emplace_back(watch->second.id, watch->second.path);
+		}
+		++watch;
+	}
+	if(directories.empty())
+		return {};
+	std::sort(directories.begin(), directories.end());
+
+	PhotoImporter(backend, n_threads).syncDirectories(directories);
+
+	std::vector<int> ids;
+	failed = 0;
+	for(const auto& [id, path] : directories) {
+		ids.push_back(id);
+		// the directory may have been removed by the synchronisation
+		if(watched_ids.contains(id))
+			watchTree(id, path, true);
+	}
+	return ids;
+}
+
+void DirectoryWatcher::run() {
+	using clock = std::chrono::steady_clock;
+	std::array<pollfd,2> fds {{{inotify_fd, POLLIN, 0}, {stop_pipe[0], POLLIN, 0}}};
+	bool pending = false;
+	clock::time_point first, last;
+
+	while(true) {
+		int timeout = -1;
+		if(pending) {
+			auto deadline = std::min(last + debounce, first + max_delay);
+			timeout = std::max<int>(0,
+					std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count());
+		}
+		int n = poll(fds.data(), fds.size(), timeout);
+		if(n < 0 && errno != EINTR)
+			return;
+		if(fds[1].revents)
+			return;
+		if(n > 0 && (fds[0].revents & POLLIN) && readEvents()) {
+			last = clock::now();
+			if(!pending)
+				first = last;
+			pending = true;
+		}
+		if(pending && clock::now() >= std::min(last + debounce, first + max_delay)) {
+			pending = false;
+			notify();
+		}
+	}
+}
+
+/*
+ * Returns whether any relevant event was read.
+ */
+bool DirectoryWatcher::readEvents() {
+	alignas(inotify_event) std::array<char,65536> buffer;
+	bool relevant = false;
+	ssize_t length;
+	while((length = read(inotify_fd, buffer.data(), buffer.size())) > 0) {
+		std::lock_guard<std::mutex> lck {changes_mutex};
+		for(ssize_t i = 0; i < length; ) {
+			const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + i);
+			i += sizeof(inotify_event) + event->len;
+
+			if(event->mask & IN_Q_OVERFLOW) {
+				overflow = true;
+				relevant = true;
+			}
+			else if(event->mask & IN_IGNORED)
+				removed.push_back(event->wd);
+			else if((event->mask & IN_ISDIR) ||
+					(event->len && PhotoImporter::isPhoto(std::string_view(event->name)))) {
+				changed.insert(event->wd);
+				relevant = true;
+			}
+		}
+	}
+	return relevant;
+}
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,148 @@
+/*
+ * DirectoryWatcher.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_BACKEND_DIRECTORYWATCHER_H_
+#define SRC_BACKEND_DIRECTORYWATCHER_H_
+
+#include "BackendFactory.h"
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+/**
+ * Keeps the catalogued directories in sync with the file system.
+ *
+ * Every catalogued directory is watched with inotify. A background thread
+ * collects the events; once no event arrived for 'debounce' (or 'max_delay'
+ * after the first event at the latest) it calls 'notify'. The owner then
+ * calls processChanges(), which synchronises all changed directories at
+ * once (see PhotoImporter::syncDirectories()). watch() and
+ * processChanges() may be called in any thread, e.g. in a worker thread
+ * so the synchronisation doesn't block the GUI, but not at the same time.
+ *
+ * Events for files without a photo extension are ignored. If the kernel's
+ * event queue overflows, all watched directories are synchronised.
+ *
+ * A file renamed or moved between watched directories reports a change in
+ * both, which are synchronised together, so its photo is moved and keeps
+ * its ratings, keywords, and albums (see PhotoImporter). A renamed
+ * directory keeps its watch, which is handed over to the directory added
+ * for the new name; watches of directories moved out of the library are
+ * removed when they report a change.
+ */
+class DirectoryWatcher {
+public:
+	/**
+	 * Starts the background thread; no directory is watched before
+	 * watch() is called.
+	 *
+	 * @param backend the library to keep in sync
+	 * @param notify called from the background thread when changes are
+	 * 		ready to be processed; must be thread safe and must not access
+	 * 		'backend'
+	 * @param n_threads number of threads used by processChanges()
+	 * @param debounce time without events before 'notify' is called
+	 * @param max_delay maximum time between the first event and calling
+	 * 		'notify'
+	 *
+	 * @throws std::system_error if inotify can't be initialised
+	 */
+	DirectoryWatcher(BackendFactory& backend, std::function<void()> notify, unsigned int n_threads,
+			std::chrono::milliseconds debounce=std::chrono::milliseconds(200),
+			std::chrono::milliseconds max_delay=std::chrono::milliseconds(1000));
+
+	/**
+	 * Stops the background thread.
+	 */
+	~DirectoryWatcher() noexcept;
+
+	//no copying or moving
+	DirectoryWatcher(const DirectoryWatcher&) = delete;
+	DirectoryWatcher(DirectoryWatcher&&) = delete;
+	DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+	DirectoryWatcher& operator=(DirectoryWatcher&&) = delete;
+
+	/**
+	 * Watch all catalogued directories not watched yet.
+	 *
+	 * Call after directories were added to the library by other means
+	 * than processChanges().
+	 *
+	 * @return number of directories that couldn't be watched (e.g. if
+	 * 		they don't exist or the inotify watch limit is reached)
+	 */
+	int watch();
+
+	/**
+	 * Apply the changes reported since the last call.
+	 *
+	 * Synchronises the changed directories with the file system and
+	 * watches new subdirectories.
+	 *
+	 * @return ids of the synchronised directories
+	 *
+	 * @throws constraint_error, database_error if writing to the
+	 * 		database fails
+	 */
+	std::vector<int> processChanges();
+
+private:
+	struct Watch {
+		int id;
+		std::filesystem::path path;
+	};
+
+	BackendFactory& backend;
+	const std::function<void()> notify;
+	const unsigned int n_threads;
+	const std::chrono::milliseconds debounce;
+	const std::chrono::milliseconds max_delay;
+
+	int inotify_fd = -1;
+	int stop_pipe[2] = {-1, -1};
+	std::thread thread;
+
+	/// only used by watch() and processChanges()
+	std::unordered_map<int,Watch> watches;
+	std::unordered_set<int> watched_ids;
+	int failed = 0;
+
+	/// filled by the background thread
+	std::mutex changes_mutex;
+	std::unordered_set<int> changed;
+	std::vector<int> removed;
+	bool overflow = false;
+
+	void watchTree(int id, const std::filesystem::path& path, bool descend_watched);
+	void run();
+	bool readEvents();
+};
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_BACKEND_DIRECTORYWATCHER_H_ */
@@ -0,0 +1,38 @@
+/*
+ * FileFingerprint.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "FileFingerprint.h"
+#include <sys/stat.h>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+std::optional<FileFingerprint> getFileFingerprint(const std::filesystem::path& file) {
+	struct stat status;
+	if(::stat(file.c_str(), &status))
+		return std::nullopt;
+	return FileFingerprint{
+		static_cast<std::int64_t>(status.st_size),
+		static_cast<std::int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec,
+		static_cast<std::int64_t>(status.st_ino)
+	};
+}
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
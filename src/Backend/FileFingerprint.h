@@ -0,0 +1,55 @@
+/*
+ * FileFingerprint.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_BACKEND_FILEFINGERPRINT_H_
+#define SRC_BACKEND_FILEFINGERPRINT_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+/**
+ * Cheap fingerprint of a file.
+ *
+ * A file whose fingerprint is unchanged is assumed to be unchanged, so a
+ * rescan doesn't need to read it (see PhotoImporter).
+ */
+struct FileFingerprint {
+	std::int64_t size = 0;	/**< size in bytes */
+	std::int64_t mtime = 0;	/**< modification time in nanoseconds since the epoch */
+	std::int64_t inode = 0;	/**< inode number */
+
+	bool operator==(const FileFingerprint&) const = default;
+};
+
+/**
+ * Get the fingerprint of a file (follows symlinks).
+ *
+ * @param file path to the file
+ * @return the fingerprint, std::nullopt if the file can't be stat'ed
+ */
+std::optional<FileFingerprint> getFileFingerprint(const std::filesystem::path& file);
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_BACKEND_FILEFINGERPRINT_H_ */
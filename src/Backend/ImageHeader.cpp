@@ -0,0 +1,461 @@
+/*
+ * ImageHeader.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ImageHeader.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+namespace {
+
+/*
+ * Reads parts of a file through a buffer on the stack.
+ *
+ * Each call to read() which isn't served from the buffer refills it with
+ * one pread() starting at the requested offset. The number of refills is
+ * limited, so that a corrupt file can't make the parser read the whole file.
+ */
+class Reader {
+public:
+	Reader(int fd, std::uint64_t size) noexcept : fd(fd), size(size) {}
+
+	/*
+	 * Returns a pointer to 'length' bytes at 'offset', valid until the next
+	 * call, or nullptr if they can't be read.
+	 */
+	const unsigned char* read(std::uint64_t offset, std::size_t length) noexcept {
+		if(length > buffer.size() || offset > size || length > size - offset)
+			return nullptr;
+		if(offset >= buffer_offset && offset + length <= buffer_offset + buffer_length)
+			return buffer.data() + (offset - buffer_offset);
+		if(reads == max_reads)
+			return nullptr;
+		++reads;
+		ssize_t n;
+		do
+			n = ::pread(fd, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+		while(n < 0 && errno == EINTR);
+		buffer_offset = offset;
+		buffer_length = n < 0 ? 0 : static_cast<std::size_t>(n);
+		return buffer_length >= length ? buffer.data() : nullptr;
+	}
+
+	std::uint64_t getSize() const noexcept { return size; }
+
+private:
+	static constexpr int max_reads = 32;
+	int fd;
+	std::uint64_t size;
+	std::array<unsigned char,4096> buffer;
+	std::uint64_t buffer_offset = 0;
+	std::size_t buffer_length = 0;
+	int reads = 0;
+};
+
+/*
+ * Closes the file descriptor when leaving the scope.
+ */
+class FileDescriptor {
+public:
+	explicit FileDescriptor(int fd) noexcept : fd(fd) {}
+	~FileDescriptor() { if(fd >= 0) ::close(fd); }
+	FileDescriptor(const FileDescriptor&) = delete;
+	FileDescriptor& operator=(const FileDescriptor&) = delete;
+	operator int() const noexcept { return fd; }
+private:
+	int fd;
+};
+
+std::uint32_t readUInt(const unsigned char* data, int size, bool big_endian) noexcept {
+	std::uint32_t value = 0;
+	for(int i = 0; i < size; ++i)
+		value |= static_cast<std::uint32_t>(data[big_endian ? i : size - 1 - i]) << (8 * (size - 1 - i));
+	return value;
+}
+
+constexpr std::uint32_t fourCC(const char (&code)[5]) noexcept {
+	return static_cast<std::uint32_t>(static_cast<unsigned char>(code[0])) << 24 |
+			static_cast<std::uint32_t>(static_cast<unsigned char>(code[1])) << 16 |
+			static_cast<std::uint32_t>(static_cast<unsigned char>(code[2])) << 8 |
+			static_cast<std::uint32_t>(static_cast<unsigned char>(code[3]));
+}
+
+/*
+ * Parse "YYYY:MM:DD HH:MM:SS".
+ */
+std::int64_t parseExifDatetime(std::string_view text) noexcept {
+	using namespace std::chrono;
+	if(text.size() < 19)
+		return 0;
+	auto number = [text](std::size_t position, std::size_t length) {
+		int value = 0;
+		for(std::size_t i = position; i < position + length; ++i) {
+			if(text[i] < '0' || text[i] > '9')
+				return -1;
+			value = value * 10 + (text[i] - '0');
+		}
+		return value;
+	};
+	int year = number(0, 4), month = number(5, 2), day = number(8, 2);
+	int hour = number(11, 2), minute = number(14, 2), second = number(17, 2);
+	if(year < 0 || month < 0 || day < 0 || hour < 0 || minute < 0 || second < 0)
+		return 0;
+	year_month_day date {std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
+	if(!date.ok())
+		return 0;
+	return duration_cast<seconds>(sys_days(date).time_since_epoch()).count() +
+			hour * 3600 + minute * 60 + second;
+}
+
+/*
+ * A TIFF structure starting at 'base' in the file and extending at most
+ * 'limit' bytes, either a TIFF file or the Exif data in a JPEG.
+ */
+class TIFF {
+public:
+	/*
+	 * Values of the tags of one IFD this parser is interested in.
+	 */
+	struct IFD {
+		static constexpr std::size_t max_subifds = 8;
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::uint32_t subfile_type = 0;
+		std::uint32_t orientation = 0;
+		std::int64_t datetime = 0;
+		std::int64_t datetime_original = 0;
+		std::uint32_t exif_ifd = 0;
+		std::array<std::uint32_t,max_subifds> subifds {};
+		std::size_t n_subifds = 0;
+	};
+
+	TIFF(Reader& reader, std::uint64_t base, std::uint64_t limit) noexcept :
+		reader(reader), base(base), limit(limit) {}
+
+	/*
+	 * Reads the header, returns the offset of IFD0 or 0 if this isn't TIFF.
+	 */
+	std::uint32_t readHeader() noexcept {
+		const unsigned char* data = read(0, 8);
+		if(!data)
+			return 0;
+		if(data[0] == 'M' && data[1] == 'M')
+			big_endian = true;
+		else if(data[0] == 'I' && data[1] == 'I')
+			big_endian = false;
+		else
+			return 0;
+		if(readUInt(data + 2, 2, big_endian) != 42)
+			return 0;
+		return readUInt(data + 4, 4, big_endian);
+	}
+
+	/*
+	 * Reads the IFD at 'offset', returns false if it can't be read.
+	 */
+	bool readIFD(std::uint32_t offset, IFD& ifd) noexcept {
+		// a lot more than any image has; only limits the damage of corrupt files
+		constexpr std::uint32_t max_entries = 512;
+		const unsigned char* data = read(offset, 2);
+		if(!data)
+			return false;
+		std::uint32_t n = readUInt(data, 2, big_endian);
+		if(n > max_entries)
+			return false;
+		for(std::uint32_t i = 0; i < n; ++i) {
+			std::uint64_t entry = offset + 2 + 12ull * i;
+			if(!(data = read(entry, 12)))
+				return false;
+			std::uint32_t tag = readUInt(data, 2, big_endian);
+			std::uint32_t type = readUInt(data + 2, 2, big_endian);
+			std::uint32_t count = readUInt(data + 4, 4, big_endian);
+			// SHORT values are left-aligned in the value field
+			std::uint32_t value = type == 3 ? readUInt(data + 8, 2, big_endian) : readUInt(data + 8, 4, big_endian);
+			switch(tag) {
+			case 0x00FE: ifd.subfile_type = value; break;
+			case 0x0100: ifd.width = value; break;
+			case 0x0101: ifd.height = value; break;
+			case 0x0112: ifd.orientation = value; break;
+			case 0x0132: ifd.datetime = readDatetime(value); break;
+			case 0x8769: ifd.exif_ifd = value; break;
+			case 0x9003: ifd.datetime_original = readDatetime(value); break;
+			case 0x014A:
+				ifd.n_subifds = std::min<std::size_t>(count, IFD::max_subifds);
+				if(count == 1)
+					ifd.subifds[0] = value;
+				else
+					for(std::size_t j = 0; j < ifd.n_subifds; ++j) {
+						const unsigned char* subifd = read(value + 4 * j, 4);
+						if(!subifd)
+							return false;
+						ifd.subifds[j] = readUInt(subifd, 4, big_endian);
+					}
+				break;
+			}
+		}
+		return true;
+	}
+
+	/*
+	 * Reads dimensions, orientation, and capture time into 'header'.
+	 * Only dimensions found are set.
+	 */
+	void parse(ImageHeader& header) noexcept {
+		std::uint32_t offset = readHeader();
+		IFD ifd0;
+		if(!offset || !readIFD(offset, ifd0))
+			return;
+		if(ifd0.orientation >= 1 && ifd0.orientation <= 8)
+			header.orientation = ifd0.orientation;
+		header.datetime = ifd0.datetime_original ? ifd0.datetime_original : ifd0.datetime;
+		IFD exif;
+		if(ifd0.exif_ifd && readIFD(ifd0.exif_ifd, exif) && exif.datetime_original)
+			header.datetime = exif.datetime_original;
+
+		std::uint64_t width = ifd0.width, height = ifd0.height;
+		// raw files (e.g. DNG) often have a preview in IFD0 and the full image in a SubIFD
+		if(ifd0.subfile_type & 1)
+			for(std::size_t i = 0; i < ifd0.n_subifds; ++i) {
+				IFD subifd;
+				if(readIFD(ifd0.subifds[i], subifd) && !(subifd.subfile_type & 1) &&
+						std::uint64_t{subifd.width} * subifd.height > width * height) {
+					width = subifd.width;
+					height = subifd.height;
+				}
+			}
+		if(width && height && width <= INT32_MAX && height <= INT32_MAX) {
+			header.width = static_cast<int>(width);
+			header.height = static_cast<int>(height);
+		}
+	}
+
+private:
+	Reader& reader;
+	std::uint64_t base;
+	std::uint64_t limit;
+	bool big_endian = false;
+
+	const unsigned char* read(std::uint64_t offset, std::size_t length) noexcept {
+		if(offset > limit || length > limit - offset)
+			return nullptr;
+		return reader.read(base + offset, length);
+	}
+
+	std::int64_t readDatetime(std::uint32_t offset) noexcept {
+		const unsigned char* data = read(offset, 19);
+		return data ? parseExifDatetime(std::string_view(reinterpret_cast<const char*>(data), 19)) : 0;
+	}
+};
+
+void parseJPEG(Reader& reader, ImageHeader& header) noexcept {
+	constexpr std::string_view exif_id {"Exif\0\0", 6};
+	constexpr int max_segments = 64;
+	bool exif_read = false;
+	std::uint64_t offset = 2;
+	for(int i = 0; i < max_segments; ++i) {
+		const unsigned char* data = reader.read(offset, 4);
+		if(!data || data[0] != 0xFF)
+			break;
+		unsigned char type = data[1];
+		// fill byte
+		if(type == 0xFF) {
+			++offset;
+			continue;
+		}
+		// markers without a segment
+		if(type == 0x01 || (type >= 0xD0 && type <= 0xD7)) {
+			offset += 2;
+			continue;
+		}
+		std::uint32_t length = readUInt(data + 2, 2, true);
+		// start of scan: no more headers
+		if(length < 2 || type == 0xDA)
+			break;
+		if(type >= 0xC0 && type <= 0xCF && type != 0xC4 && type != 0xC8 && type != 0xCC) {
+			if((data = reader.read(offset + 4, 5))) {
+				header.height = static_cast<int>(readUInt(data + 1, 2, true));
+				header.width = static_cast<int>(readUInt(data + 3, 2, true));
+			}
+			// the Exif segment comes before the frame
+			break;
+		}
+		if(type == 0xE1 && !exif_read && length > 2 + exif_id.size() &&
+				(data = reader.read(offset + 4, exif_id.size())) &&
+				std::string_view(reinterpret_cast<const char*>(data), exif_id.size()) == exif_id) {
+			// Exif doesn't set the dimensions of the JPEG frame, SOF overwrites them anyway
+			ImageHeader exif;
+			TIFF(reader, offset + 4 + exif_id.size(), length - 2 - exif_id.size()).parse(exif);
+			header.orientation = exif.orientation;
+			header.datetime = exif.datetime;
+			exif_read = true;
+		}
+		offset += 2 + length;
+	}
+}
+
+bool parsePNG(Reader& reader, ImageHeader& header) noexcept {
+	// signature, length and type of the first chunk (IHDR), width, height
+	const unsigned char* data = reader.read(0, 24);
+	if(!data || std::string_view(reinterpret_cast<const char*>(data + 12), 4) != "IHDR")
+		return false;
+	header.width = static_cast<int>(readUInt(data + 16, 4, true));
+	header.height = static_cast<int>(readUInt(data + 20, 4, true));
+	return true;
+}
+
+/*
+ * Box of the ISO base media file format; 'begin' is the offset of the
+ * payload, 'end' the offset after the box.
+ */
+struct Box {
+	std::uint32_t type;
+	std::uint64_t begin;
+	std::uint64_t end;
+};
+
+/*
+ * Reads the header of the box at 'offset' in a container ending at 'end'.
+ */
+bool readBox(Reader& reader, std::uint64_t offset, std::uint64_t end, Box& box) noexcept {
+	const unsigned char* data = reader.read(offset, 8);
+	if(!data || end - offset < 8)
+		return false;
+	std::uint64_t size = readUInt(data, 4, true);
+	box.type = readUInt(data + 4, 4, true);
+	box.begin = offset + 8;
+	if(size == 1) {
+		if(!(data = reader.read(offset + 8, 8)))
+			return false;
+		size = std::uint64_t{readUInt(data, 4, true)} << 32 | readUInt(data + 4, 4, true);
+		box.begin += 8;
+	} else if(size == 0)
+		size = end - offset;
+	if(size < box.begin - offset || size > end - offset)
+		return false;
+	box.end = offset + size;
+	return true;
+}
+
+/*
+ * Finds the first box of 'type' in the container [begin; end).
+ */
+bool findBox(Reader& reader, std::uint64_t begin, std::uint64_t end, std::uint32_t type, Box& box) noexcept {
+	constexpr int max_boxes = 64;
+	for(int i = 0; i < max_boxes && readBox(reader, begin, end, box); ++i) {
+		if(box.type == type)
+			return true;
+		begin = box.end;
+	}
+	return false;
+}
+
+bool parseHEIF(Reader& reader, ImageHeader& header) noexcept {
+	Box ftyp;
+	if(!readBox(reader, 0, reader.getSize(), ftyp) || ftyp.type != fourCC("ftyp"))
+		return false;
+	// major brand, minor version, compatible brands
+	bool is_heif = false;
+	for(std::uint64_t offset = ftyp.begin; offset + 4 <= ftyp.end && offset < ftyp.begin + 64; offset += 4) {
+		const unsigned char* data = reader.read(offset, 4);
+		if(!data)
+			return false;
+		std::uint32_t brand = readUInt(data, 4, true);
+		if(brand == fourCC("mif1") || brand == fourCC("heic") || brand == fourCC("heix") ||
+				brand == fourCC("msf1") || brand == fourCC("hevc"))
+			is_heif = true;
+		// skip minor version
+		if(offset == ftyp.begin)
+			offset += 4;
+	}
+	if(!is_heif)
+		return false;
+
+	// meta and ispe are full boxes, payload starts after version and flags
+	Box meta, iprp, ipco;
+	if(!findBox(reader, ftyp.end, reader.getSize(), fourCC("meta"), meta) ||
+			!findBox(reader, meta.begin + 4, meta.end, fourCC("iprp"), iprp) ||
+			!findBox(reader, iprp.begin, iprp.end, fourCC("ipco"), ipco))
+		return true;
+	// there is an 'ispe' for each image (e.g. tiles and thumbnails), the largest is the full image
+	std::uint64_t area = 0;
+	Box box;
+	for(std::uint64_t offset = ipco.begin; readBox(reader, offset, ipco.end, box); offset = box.end) {
+		if(box.type == fourCC("ispe")) {
+			const unsigned char* data = reader.read(box.begin + 4, 8);
+			if(!data)
+				break;
+			std::uint32_t width = readUInt(data, 4, true), height = readUInt(data + 4, 4, true);
+			if(std::uint64_t{width} * height > area && width <= INT32_MAX && height <= INT32_MAX) {
+				area = std::uint64_t{width} * height;
+				header.width = static_cast<int>(width);
+				header.height = static_cast<int>(height);
+			}
+		} else if(box.type == fourCC("irot")) {
+			// counter-clockwise rotation in steps of 90 degrees
+			const unsigned char* data = reader.read(box.begin, 1);
+			if(!data)
+				break;
+			constexpr std::array<int,4> orientations {1, 8, 3, 6};
+			header.orientation = orientations[data[0] & 3];
+		}
+	}
+	return true;
+}
+
+}
+
+std::optional<ImageHeader> readImageHeader(const std::filesystem::path& file) noexcept {
+	FileDescriptor fd(::open(file.c_str(), O_RDONLY | O_CLOEXEC));
+	struct stat status;
+	if(fd < 0 || ::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode))
+		return std::nullopt;
+	Reader reader(fd, static_cast<std::uint64_t>(status.st_size));
+	const unsigned char* magic = reader.read(0, 12);
+	if(!magic)
+		return std::nullopt;
+
+	ImageHeader header;
+	if(magic[0] == 0xFF && magic[1] == 0xD8) {
+		parseJPEG(reader, header);
+		return header;
+	}
+	if(magic[0] == 0x89 && magic[1] == 'P' && magic[2] == 'N' && magic[3] == 'G')
+		return parsePNG(reader, header) ? std::optional(header) : std::nullopt;
+	if((magic[0] == 'I' && magic[1] == 'I' && magic[2] == 42 && magic[3] == 0) ||
+			(magic[0] == 'M' && magic[1] == 'M' && magic[2] == 0 && magic[3] == 42)) {
+		TIFF(reader, 0, reader.getSize()).parse(header);
+		return header;
+	}
+	if(std::string_view(reinterpret_cast<const char*>(magic + 4), 4) == "ftyp")
+		return parseHEIF(reader, header) ? std::optional(header) : std::nullopt;
+	return std::nullopt;
+}
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,70 @@
+/*
+ * ImageHeader.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_BACKEND_IMAGEHEADER_H_
+#define SRC_BACKEND_IMAGEHEADER_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+/**
+ * Attributes read from the header of an image file.
+ */
+struct ImageHeader {
+	int width = 0;	/**< width in pixel as stored (before applying 'orientation'), 0 if unknown */
+	int height = 0;	/**< height in pixel as stored (before applying 'orientation'), 0 if unknown */
+	int orientation = 1;	/**< Exif orientation (1 to 8), 1 if unknown */
+	std::int64_t datetime = 0;	/**< time the photo was taken (unix time), 0 if unknown */
+};
+
+/**
+ * Read the dimensions, orientation, and capture time of an image without
+ * decoding it.
+ *
+ * Supported formats:
+ * - JPEG: dimensions from the SOF segment, orientation and capture time
+ * 		from the Exif segment (APP1)
+ * - PNG: dimensions from the IHDR chunk
+ * - TIFF and TIFF based raw formats (e.g. DNG): dimensions of the full
+ * 		resolution image (IFD0 or, if IFD0 holds a preview, the SubIFDs),
+ * 		orientation and capture time from the IFDs
+ * - HEIF/HEIC: dimensions from the largest \c ispe property, orientation
+ * 		from the \c irot property; the capture time is not read
+ *
+ * The capture time is Exif DateTimeOriginal or, if missing, DateTime. Exif
+ * times carry no time zone; they are interpreted as UTC.
+ *
+ * The file is read with pread() through a small buffer on the stack,
+ * following the offsets in the headers instead of reading the file
+ * sequentially; usually only a few KB are read. No memory is allocated.
+ *
+ * @param file path to the image file
+ * @return the attributes found, std::nullopt if the file can't be read or
+ * 		has none of the supported formats
+ */
+std::optional<ImageHeader> readImageHeader(const std::filesystem::path& file) noexcept;
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_BACKEND_IMAGEHEADER_H_ */
@@ -0,0 +1,362 @@
+/*
+ * PhotoFilter.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PhotoFilter.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <utility>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+namespace {
+
+using Field = PhotoFilter::Field;
+using Comparison = PhotoFilter::Comparison;
+using Node = PhotoFilter::Node;
+
+struct Token {
+	enum class Kind { WORD, STRING, LEFT_PARENTHESIS, RIGHT_PARENTHESIS, OPERATOR, END } kind;
+	std::string text;
+	Comparison comparison = Comparison::EQUAL;
+	std::size_t position = 0;
+};
+
+std::string toLower(std::string text) {
+	std::transform(text.begin(), text.end(), text.begin(),
+			[](unsigned char c) { return std::tolower(c); });
+	return text;
+}
+
+bool isWordCharacter(char c) {
+	return !std::isspace(static_cast<unsigned char>(c)) &&
+			std::string_view("()\"=!<>:").find(c) == std::string_view::npos;
+}
+
+std::vector<Token> tokenise(std::string_view expression) {
+	std::vector<Token> tokens;
+	for(std::size_t i = 0; i < expression.size();) {
+		char c = expression[i];
+		if(std::isspace(static_cast<unsigned char>(c))) {
+			++i;
+			continue;
+		}
+
+		Token token {Token::Kind::WORD, {}, Comparison::EQUAL, i};
+		if(c == '(' || c == ')') {
+			token.kind = c == '(' ? Token::Kind::LEFT_PARENTHESIS : Token::Kind::RIGHT_PARENTHESIS;
+			token.text = c;
+			++i;
+		}
+		else if(c == '"') {
+			token.kind = Token::Kind::STRING;
+			for(++i; i < expression.size() && expression[i] != '"'; ++i) {
+				if(expression[i] == '\\' && i + 1 < expression.size())
+					++i;
+				token.text += expression[i];
+			}
+			if(i == expression.size())
+				throw filter_error("Missing closing quotation mark for string at position " +
+						std::to_string(token.position));
+			++i;
+		}
+		else if(std::string_view("=!<>:").find(c) != std::string_view::npos) {
+			token.kind = Token::Kind::OPERATOR;
+			bool followed_by_equal = i + 1 < expression.size() && expression[i + 1] == '=';
+			switch(c) {
+			case '=':
+			case ':':
+				token.comparison = Comparison::EQUAL;
+				break;
+			case '!':
+				if(!followed_by_equal)
+					throw filter_error("Unexpected '!' at position " + std::to_string(i));
+				token.comparison = Comparison::NOT_EQUAL;
+				break;
+			case '<':
+				token.comparison = followed_by_equal ? Comparison::LESS_EQUAL : Comparison::LESS;
+				break;
+			case '>':
+				token.comparison = followed_by_equal ? Comparison::GREATER_EQUAL : Comparison::GREATER;
+				break;
+			}
+			std::size_t length = (followed_by_equal && c != ':') ? 2 : 1;
+			token.text = expression.substr(i, length);
+			i += length;
+		}
+		else {
+			for(; i < expression.size() && isWordCharacter(expression[i]); ++i)
+				token.text += expression[i];
+		}
+		tokens.push_back(std::move(token));
+	}
+	tokens.push_back(Token{Token::Kind::END, {}, Comparison::EQUAL, expression.size()});
+	return tokens;
+}
+
+std::int64_t parseNumber(const std::string& text) {
+	std::int64_t number;
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+	if(error != std::errc() || end != text.data() + text.size())
+		throw filter_error("'" + text + "' is not a number");
+	return number;
+}
+
+/**
+ * Parses YYYY, YYYY-MM, or YYYY-MM-DD into the range of seconds
+ * since the epoch (UTC) it covers.
+ */
+std::pair<std::int64_t,std::int64_t> parseDate(const std::string& text) {
+	using namespace std::chrono;
+	std::vector<std::int64_t> parts;
+	std::size_t start = 0;
+	for(std::size_t end; (end = text.find('-', start)) != std::string::npos; start = end + 1)
+		parts.push_back(parseNumber(text.substr(start, end - start)));
+	parts.push_back(parseNumber(text.substr(start)));
+	if(text.empty() || text.front() == '-' || parts.size() > 3)
+		throw filter_error("'" + text + "' is not a date (YYYY, YYYY-MM, or YYYY-MM-DD)");
+
+	year_month_day first {
+		year(static_cast<int>(parts[0])),
+		month(parts.size() > 1 ? static_cast<unsigned>(parts[1]) : 1),
+		day(parts.size() > 2 ? static_cast<unsigned>(parts[2]) : 1)
+	};
+	if(!first.ok())
+		throw filter_error("'" + text + "' is not a valid date");
+
+	sys_days last;
+	if(parts.size() == 3)
+		last = sys_days(first) + days(1);
+	else if(parts.size() == 2)
+		last = sys_days(year_month_day(first.year() / first.month() / 1) + months(1));
+	else
+		last = sys_days((first.year() + years(1)) / January / 1);
+
+	return {
+		duration_cast<seconds>(sys_days(first).time_since_epoch()).count(),
+		duration_cast<seconds>(last.time_since_epoch()).count()
+	};
+}
+
+class Parser {
+public:
+	explicit Parser(std::string_view expression) : tokens(tokenise(expression)) {}
+
+	Node parse() {
+		if(peek().kind == Token::Kind::END)
+			return Node{Node::Type::AND, {}, {}};
+		Node node = parseOr();
+		if(peek().kind != Token::Kind::END)
+			unexpected(peek());
+		return node;
+	}
+
+private:
+	std::vector<Token> tokens;
+	std::size_t current = 0;
+
+	const Token& peek() const { return tokens[current]; }
+	const Token& next() { return tokens[current++]; }
+
+	bool isKeyword(const Token& token, std::string_view keyword) const {
+		return token.kind == Token::Kind::WORD && toLower(token.text) == keyword;
+	}
+
+	[[noreturn]] static void unexpected(const Token& token) {
+		if(token.kind == Token::Kind::END)
+			throw filter_error("Unexpected end of filter expression");
+		throw filter_error("Unexpected '" + token.text + "' at position " + std::to_string(token.position));
+	}
+
+	static Node combine(Node::Type type, std::vector<Node>&& children) {
+		if(children.size() == 1)
+			return std::move(children.front());
+		return Node{type, {}, std::move(children)};
+	}
+
+	Node parseOr() {
+		std::vector<Node> children;
+		children.push_back(parseAnd());
+		while(isKeyword(peek(), "or")) {
+			next();
+			children.push_back(parseAnd());
+		}
+		return combine(Node::Type::OR, std::move(children));
+	}
+
+	// AND is implied between two operands without an operator
+	Node parseAnd() {
+		std::vector<Node> children;
+		children.push_back(parseNot());
+		for(;;) {
+			if(isKeyword(peek(), "and"))
+				next();
+			else if(!(peek().kind == Token::Kind::LEFT_PARENTHESIS ||
+					peek().kind == Token::Kind::STRING ||
+					(peek().kind == Token::Kind::WORD && !isKeyword(peek(), "or"))))
+				break;
+			children.push_back(parseNot());
+		}
+		return combine(Node::Type::AND, std::move(children));
+	}
+
+	Node parseNot() {
+		if(isKeyword(peek(), "not")) {
+			next();
+			return Node{Node::Type::NOT, {}, {parseNot()}};
+		}
+		return parsePrimary();
+	}
+
+	Node parsePrimary() {
+		if(peek().kind == Token::Kind::LEFT_PARENTHESIS) {
+			next();
+			Node node = parseOr();
+			if(peek().kind != Token::Kind::RIGHT_PARENTHESIS)
+				unexpected(peek());
+			next();
+			return node;
+		}
+		if(peek().kind != Token::Kind::WORD)
+			unexpected(peek());
+		return parsePredicate();
+	}
+
+	Node parsePredicate() {
+		const Token& field_token = next();
+		const Token& operator_token = next();
+		if(operator_token.kind != Token::Kind::OPERATOR)
+			unexpected(operator_token);
+		const Token& value_token = next();
+		if(value_token.kind != Token::Kind::WORD && value_token.kind != Token::Kind::STRING)
+			unexpected(value_token);
+
+		PhotoFilter::Predicate predicate {Field::RATING, operator_token.comparison, 0, 0, value_token.text};
+		std::string field = toLower(field_token.text);
+		if(field == "rating" || field == "width" || field == "height") {
+			predicate.field = field == "rating" ? Field::RATING : field == "width" ? Field::WIDTH : Field::HEIGHT;
+			predicate.lower = parseNumber(predicate.text);
+			predicate.upper = predicate.lower + 1;
+		}
+		else if(field == "date" || field == "datetime") {
+			predicate.field = Field::DATETIME;
+			std::tie(predicate.lower, predicate.upper) = parseDate(predicate.text);
+		}
+		else if(field == "directory" || field == "dir" || field == "folder" ||
+				field == "album" || field == "keyword" || field == "tag") {
+			predicate.field = field == "album" ? Field::ALBUM :
+					(field == "keyword" || field == "tag") ? Field::KEYWORD : Field::DIRECTORY;
+			if(predicate.comparison != Comparison::EQUAL && predicate.comparison != Comparison::NOT_EQUAL)
+				throw filter_error("Operator '" + operator_token.text + "' cannot be used with '" +
+						field_token.text + "' (use '=' or '!=')");
+			if(predicate.comparison == Comparison::NOT_EQUAL) {
+				predicate.comparison = Comparison::EQUAL;
+				return Node{Node::Type::NOT, {}, {Node{Node::Type::PREDICATE, std::move(predicate), {}}}};
+			}
+		}
+		else
+			throw filter_error("Unknown field '" + field_token.text + "' at position " +
+					std::to_string(field_token.position));
+
+		return Node{Node::Type::PREDICATE, std::move(predicate), {}};
+	}
+};
+
+struct CompiledNode {
+	std::string sql;
+	std::vector<PhotoFilter::Parameter> parameters;
+};
+
+CompiledNode compileNode(const Node& node, const PhotoFilter::CompilePredicate& compile_predicate) {
+	switch(node.type) {
+	case Node::Type::PREDICATE: {
+		auto compiled = compile_predicate(node.predicate);
+		return {"(" + compiled.sql + ")", std::move(compiled.parameters)};
+	}
+	case Node::Type::NOT: {
+		CompiledNode child = compileNode(node.children.front(), compile_predicate);
+		return {"NOT " + child.sql, std::move(child.parameters)};
+	}
+	case Node::Type::AND:
+	case Node::Type::OR: {
+		bool is_and = node.type == Node::Type::AND;
+		if(node.children.empty())
+			return {is_and ? "1" : "0", {}};
+
+		CompiledNode result {"(", {}};
+		for(std::size_t i = 0; i < node.children.size(); ++i) {
+			CompiledNode child = compileNode(node.children[i], compile_predicate);
+			if(i)
+				result.sql += is_and ? " AND " : " OR ";
+			result.sql += child.sql;
+			result.parameters.insert(result.parameters.end(),
+					std::make_move_iterator(child.parameters.begin()),
+					std::make_move_iterator(child.parameters.end()));
+		}
+		result.sql += ")";
+		return result;
+	}
+	}
+	return {"0", {}};
+}
+
+std::string toString(const Node& node) {
+	static const char* fields[] {"rating", "date", "width", "height", "directory", "album", "keyword"};
+	static const char* comparisons[] {"=", "!=", "<", "<=", ">", ">="};
+
+	switch(node.type) {
+	case Node::Type::PREDICATE: {
+		const auto& predicate = node.predicate;
+		std::string value = predicate.field >= Field::DIRECTORY ? "\"" + predicate.text + "\"" : predicate.text;
+		return std::string(fields[static_cast<int>(predicate.field)]) +
+				comparisons[static_cast<int>(predicate.comparison)] + value;
+	}
+	case Node::Type::NOT:
+		return "NOT " + toString(node.children.front());
+	case Node::Type::AND:
+	case Node::Type::OR: {
+		std::string text;
+		for(const Node& child : node.children)
+			text += (text.empty() ? "" : node.type == Node::Type::AND ? " AND " : " OR ") + toString(child);
+		return node.children.size() > 1 ? "(" + text + ")" : text;
+	}
+	}
+	return {};
+}
+
+} /* namespace */
+
+PhotoFilter::PhotoFilter(std::string_view expression) : root(Parser(expression).parse()) {}
+
+std::string PhotoFilter::compile(const CompilePredicate& compile_predicate, std::vector<Parameter>& parameters) const {
+	CompiledNode compiled = compileNode(root, compile_predicate);
+	parameters.insert(parameters.end(),
+			std::make_move_iterator(compiled.parameters.begin()),
+			std::make_move_iterator(compiled.parameters.end()));
+	return compiled.sql;
+}
+
+std::string PhotoFilter::toString() const {
+	return Backend::toString(root);
+}
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,182 @@
+/*
+ * PhotoFilter.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_BACKEND_PHOTOFILTER_H_
+#define SRC_BACKEND_PHOTOFILTER_H_
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+/**
+ * Thrown if a filter expression cannot be parsed.
+ */
+class filter_error : public std::invalid_argument {
+public:
+	using std::invalid_argument::invalid_argument;
+};
+
+/**
+ * Boolean filter expression over the attributes of photos.
+ *
+ * An expression consists of predicates of the form
+ * <tt>field operator value</tt> combined with \c AND, \c OR, \c NOT,
+ * and parentheses. Predicates next to each other without an operator
+ * are combined with \c AND; \c AND binds stronger than \c OR.
+ * Keywords and field names are case insensitive, values containing
+ * spaces or special characters can be put in double quotes.
+ *
+ * Fields:
+ * - \c rating, \c width, \c height: integer, all comparison operators
+ * - \c date: \c YYYY, \c YYYY-MM, or \c YYYY-MM-DD (UTC), all comparison
+ * 		operators; e.g. <tt>date=2021-05</tt> matches all of May 2021
+ * - \c directory, \c album, \c keyword: name, only \c = (or \c :) and
+ * 		\c != ; matches the directory, album, or keyword and all its
+ * 		descendants, keywords also match their synonyms
+ *
+ * Operators: \c = \c : \c != \c < \c <= \c > \c >=
+ *
+ * Example: <tt>keyword:Venice AND rating>=3 AND NOT album:"Best of"</tt>
+ *
+ * The expression is parsed on construction. compile(CompilePredicate,
+ * std::vector<Parameter>&) translates it into an SQL expression; the
+ * translation of the predicates is done by the caller, who knows the
+ * database schema.
+ */
+class PhotoFilter {
+public:
+	/**
+	 * Attributes that can be used in predicates.
+	 */
+	enum class Field {
+		RATING,		/**< Rating of the photo */
+		DATETIME,	/**< Date and time the photo was taken */
+		WIDTH,		/**< Width of the photo */
+		HEIGHT,		/**< Height of the photo */
+		DIRECTORY,	/**< Directory (including subdirectories) */
+		ALBUM,		/**< Album (including albums in a set) */
+		KEYWORD		/**< Keyword (including child keywords and synonyms) */
+	};
+
+	/**
+	 * Comparison operators.
+	 */
+	enum class Comparison {
+		EQUAL, NOT_EQUAL, LESS, LESS_EQUAL, GREATER, GREATER_EQUAL
+	};
+
+	/**
+	 * A single predicate.
+	 *
+	 * For numeric fields (including DATETIME) the value is the half-open
+	 * range ['lower', 'upper'): a number 'n' is [n, n+1), a date all
+	 * seconds of the day, month, or year. For DIRECTORY, ALBUM, and KEYWORD
+	 * 'comparison' is always EQUAL ('!=' is parsed as NOT) and the name
+	 * is stored in 'text'.
+	 */
+	struct Predicate {
+		Field field;
+		Comparison comparison;
+		std::int64_t lower = 0;
+		std::int64_t upper = 0;
+		std::string text;
+	};
+
+	/**
+	 * Node of the expression tree.
+	 * An AND node without children is true, an OR node without children
+	 * is false.
+	 */
+	struct Node {
+		enum class Type { AND, OR, NOT, PREDICATE } type;
+		Predicate predicate;
+		std::vector<Node> children;
+	};
+
+	/**
+	 * Value to bind to a parameter of the compiled SQL expression.
+	 */
+	using Parameter = std::variant<std::int64_t, std::string>;
+
+	/**
+	 * Result of the translation of a Predicate into SQL.
+	 */
+	struct CompiledPredicate {
+		std::string sql;	/**< SQL expression with '?' for all parameters */
+		std::vector<Parameter> parameters;	/**< values for the parameters in order */
+	};
+
+	/**
+	 * Function translating a Predicate into SQL.
+	 */
+	using CompilePredicate = std::function<CompiledPredicate(const Predicate&)>;
+
+	/**
+	 * Parses a filter expression.
+	 * An empty expression matches all photos.
+	 *
+	 * @param expression the filter expression
+	 *
+	 * @throws filter_error if 'expression' is not a valid filter expression
+	 */
+	explicit PhotoFilter(std::string_view expression);
+
+	/**
+	 * Get the root of the expression tree.
+	 *
+	 * @return root of the expression tree
+	 */
+	const Node& getRoot() const noexcept { return root; }
+
+	/**
+	 * Translate the expression into an SQL expression.
+	 *
+	 * The predicates are translated by 'compile_predicate'; the operands
+	 * keep the order of the expression.
+	 *
+	 * @param compile_predicate function translating the predicates
+	 * @param[out] parameters the values to bind to the parameters of the
+	 * 		SQL expression are appended in order
+	 * @return SQL expression (for a WHERE clause)
+	 */
+	std::string compile(const CompilePredicate& compile_predicate, std::vector<Parameter>& parameters) const;
+
+	/**
+	 * Get a normalised representation of the expression.
+	 * Mainly useful for debugging and testing.
+	 *
+	 * @return the expression with all operators and parentheses explicit
+	 */
+	std::string toString() const;
+
+private:
+	Node root;
+};
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_BACKEND_PHOTOFILTER_H_ */
@@ -0,0 +1,417 @@
+/*
+ * PhotoImporter.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PhotoImporter.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/PhotoRecord.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+PhotoImporter::PhotoImporter(BackendFactory& backend, unsigned int n_threads, std::size_t batch_size) :
+		backend(backend),
+		n_threads(n_threads ? n_threads : 1),
+		batch_size(batch_size ? batch_size : 1) {}
+
+bool PhotoImporter::isPhoto(const std::filesystem::path& file) {
+	static const std::array<std::string_view,8> extensions {
+		".jpg", ".jpeg", ".png", ".tif", ".tiff", ".dng", ".heic", ".heif"};
+	std::string extension = file.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+			[](unsigned char c) { return std::tolower(c); });
+	return std::find(extensions.begin(), extensions.end(), extension) != extensions.end();
+}
+
+PhotoImporter::Statistics PhotoImporter::getProgress() const noexcept {
+	Statistics statistics;
+	statistics.directories = n_directories;
+	statistics.files = n_files;
+	statistics.photos_unchanged = n_unchanged;
+	statistics.errors = n_errors;
+	return statistics;
+}
+
+void PhotoImporter::cancel() noexcept {
+	cancelled = true;
+}
+
+PhotoImporter::Statistics PhotoImporter::importDirectory(const std::filesystem::path& root) {
+	return run(root, false);
+}
+
+PhotoImporter::Statistics PhotoImporter::rescanDirectory(const std::filesystem::path& root) {
+	return run(root, true);
+}
+
+/*
+ * The directories themselves and their children are catalogued, but only
+ * the photos of the directories themselves are loaded.
+ */
+PhotoImporter::Statistics PhotoImporter::syncDirectories(
+		const std::vector<std::pair<int,std::filesystem::path>>& directories) {
+	if(cancelled)
+		return {};
+	remove_vanished = true;
+	shallow = true;
+	roots = directories;
+
+	catalogue.clear();
+	for(const auto& [id, path] : roots)
+		catalogue.insert_or_assign(path.string(), CataloguedDirectory{
+			id, backend.getEntry<RecordClasses::DirectoryRecord>(id).getParent(), backend.getCataloguedPhotos(id)});
+	for(const auto& [id, path] : roots)
+		for(int child : backend.getChildren<RecordClasses::DirectoryRecord>(id))
+			catalogue.try_emplace(
+					(path / backend.getEntry<RecordClasses::DirectoryRecord>(child).getFullDirectory().raw()).string(),
+					CataloguedDirectory{child, id, {}});
+
+	return run();
+}
+
+PhotoImporter::Statistics PhotoImporter::run(const std::filesystem::path& root, bool remove_vanished) {
+	std::error_code error;
+	std::filesystem::path absolute = std::filesystem::canonical(root, error);
+	if(error || !std::filesystem::is_directory(absolute, error))
+		throw(std::invalid_argument("Not a directory: " + root.string()));
+	if(cancelled)
+		return {};
+
+	this->remove_vanished = remove_vanished;
+	shallow = false;
+
+	std::string name = absolute.filename().string();
+	int root_id = backend.getOrAddDirectory(RecordClasses::DirectoryRecord(
+			0, RecordClasses::DirectoryRecord::Options::NONE, name.empty() ? absolute.string() : name, absolute.string()));
+	roots = {{root_id, absolute}};
+	catalogue.clear();
+	loadCatalogue(root_id, 0, absolute);
+
+	return run();
+}
+
+/*
+ * Each stage closes the queue to the next stage when its last thread
+ * finishes: the walkers when no directory is pending, the parsers when
+ * the walkers are done and the file queue is empty. After cancel() the
+ * walkers and parsers close their input queues, so no thread is left
+ * waiting for them. A walker stops early when it cannot push to a closed
+ * queue; it closes the directory queue so the other walkers stop as well.
+ */
+PhotoImporter::Statistics PhotoImporter::run() {
+	n_directories = 0;
+	n_files = 0;
+	n_unchanged = 0;
+	n_errors = 0;
+	n_added = 0;
+	n_updated = 0;
+	n_moved = 0;
+	n_removed = 0;
+	n_directories_removed = 0;
+
+	const std::size_t capacity = 4 * batch_size;
+	Support::BoundedQueue<DirectoryJob> directories(std::numeric_limits<std::size_t>::max());
+	Support::BoundedQueue<PhotoItem> files(capacity);
+	Support::BoundedQueue<WriteItem> items(capacity);
+	std::atomic<std::size_t> pending {roots.size()};
+	std::atomic<std::size_t> next_key {roots.size()};
+	for(std::size_t key = 0; key < roots.size(); ++key)
+		directories.push(DirectoryJob{key, roots[key].second});
+	if(roots.empty())
+		directories.close();
+
+	std::atomic<unsigned int> active_walkers {n_threads};
+	std::atomic<unsigned int> active_parsers {n_threads};
+	std::vector<std::thread> threads;
+	threads.reserve(2 * n_threads);
+	for(unsigned int i = 0; i < n_threads; ++i) {
+		threads.emplace_back([&]() {
+			walk(directories, files, items, pending, next_key);
+			directories.close();
+			if(--active_walkers == 0)
+				files.close();
+		});
+		threads.emplace_back([&]() {
+			parse(files, items);
+			if(--active_parsers == 0)
+				items.close();
+		});
+	}
+
+	try {
+		write(items);
+	}
+	catch(...) {
+		// stop all stages; the threads see the closed queues and finish
+		directories.close();
+		files.close();
+		items.close();
+		for(auto& thread : threads)
+			thread.join();
+		catalogue.clear();
+		roots.clear();
+		throw;
+	}
+	for(auto& thread : threads)
+		thread.join();
+	catalogue.clear();
+	roots.clear();
+
+	return {n_directories, n_files, n_unchanged, n_added, n_updated, n_moved, n_removed, n_directories_removed, n_errors};
+}
+
+void PhotoImporter::loadCatalogue(int id, int parent, const std::filesystem::path& path) {
+	catalogue.emplace(path.string(), CataloguedDirectory{id, parent, backend.getCataloguedPhotos(id)});
+	for(int child : backend.getChildren<RecordClasses::DirectoryRecord>(id))
+		loadCatalogue(child, id,
+				path / backend.getEntry<RecordClasses::DirectoryRecord>(child).getFullDirectory().raw());
+}
+
+/*
+ * The files of a directory are sorted by name and merged with the
+ * catalogued photos of the directory (also sorted by name). Vanished files
+ * are only reported if the directory could be read completely.
+ */
+void PhotoImporter::walk(Support::BoundedQueue<DirectoryJob>& directories, Support::BoundedQueue<PhotoItem>& files,
+		Support::BoundedQueue<WriteItem>& items, std::atomic<std::size_t>& pending,
+		std::atomic<std::size_t>& next_key) {
+	std::vector<std::pair<std::string,FileFingerprint>> listing;
+	while(auto job = directories.pop()) {
+		if(cancelled) {
+			directories.close();
+			return;
+		}
+		++n_directories;
+		listing.clear();
+		bool complete = true;
+
+		std::error_code error;
+		std::filesystem::directory_iterator iterator(job->path, error);
+		for(; !error && iterator != std::filesystem::directory_iterator(); iterator.increment(error)) {
+			const auto& entry = *iterator;
+			std::error_code entry_error;
+			if(entry.is_directory(entry_error) && !entry.is_symlink(entry_error)) {
+				// the directory is added to the database before any of its content
+				std::size_t key = next_key++;
+				std::string name = entry.path().filename().string();
+				if(!items.push(DirectoryItem{key, job->key, name, name}))
+					return;
+				if(!shallow || !catalogue.contains(entry.path().string())) {
+					++pending;
+					directories.push(DirectoryJob{key, entry.path()});
+				}
+			}
+			else if(entry.is_regular_file(entry_error) && isPhoto(entry.path())) {
+				if(auto fingerprint = getFileFingerprint(entry.path()))
+					listing.emplace_back(entry.path().filename().string(), *fingerprint);
+				else
+					entry_error = std::make_error_code(std::errc::io_error);
+			}
+			if(entry_error) {
+				++n_errors;
+				complete = false;
+			}
+		}
+		if(error) {
+			++n_errors;
+			complete = false;
+		}
+		if(!complete && !items.push(SkippedDirectory{job->key}))
+			return;
+
+		std::sort(listing.begin(), listing.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		n_files += listing.size();
+		auto catalogued = catalogue.find(job->path.string());
+		static const std::vector<BackendFactory::CataloguedPhoto> none;
+		const auto& photos = catalogued != catalogue.end() ? catalogued->second.photos : none;
+
+		RemovedPhotos removed;
+		auto photo = photos.begin();
+		for(const auto& [name, fingerprint] : listing) {
+			for(; photo != photos.end() && photo->filename < name; ++photo)
+				removed.ids.push_back(photo->id);
+			int id = 0;
+			if(photo != photos.end() && photo->filename == name) {
+				bool unchanged = photo->fingerprint == fingerprint;
+				id = (photo++)->id;
+				if(unchanged) {
+					++n_unchanged;
+					continue;
+				}
+			}
+			if(!files.push(PhotoItem{job->key, job->path / name, fingerprint, id, {}}))
+				return;
+		}
+		for(; photo != photos.end(); ++photo)
+			removed.ids.push_back(photo->id);
+		if(remove_vanished && complete && !removed.ids.empty() && !items.push(std::move(removed)))
+			return;
+
+		if(--pending == 0)
+			directories.close();
+	}
+}
+
+void PhotoImporter::parse(Support::BoundedQueue<PhotoItem>& files, Support::BoundedQueue<WriteItem>& items) {
+	while(auto file = files.pop()) {
+		if(cancelled) {
+			files.close();
+			return;
+		}
+		if(auto header = readImageHeader(file->path))
+			file->header = *header;
+		// without a capture time use the modification time
+		if(!file->header.datetime)
+			file->header.datetime = file->fingerprint.mtime / 1000000000;
+		if(!items.push(std::move(*file)))
+			return;
+	}
+}
+
+/*
+ * A new file whose fingerprint is stored for a photo whose file no longer
+ * has it was moved there. Vanished photos are removed at the end, when
+ * all moved files have been matched. A catalogued directory that wasn't
+ * found is removed if its parent was read completely; removing it removes
+ * all its descendants (the photos moved out of it are kept).
+ */
+void PhotoImporter::write(Support::BoundedQueue<WriteItem>& items) {
+	std::unordered_map<std::size_t,int> directory_ids;
+	std::unordered_set<int> seen;
+	std::unordered_set<int> skipped;
+	for(std::size_t key = 0; key < roots.size(); ++key) {
+		directory_ids[key] = roots[key].first;
+		seen.insert(roots[key].first);
+	}
+
+	std::vector<RecordClasses::PhotoRecord> new_photos;
+	std::vector<FileFingerprint> new_fingerprints;
+	std::vector<int> changed_ids;
+	std::vector<RecordClasses::PhotoRecord> changed_photos;
+	std::vector<FileFingerprint> changed_fingerprints;
+	std::vector<int> removed_ids;
+	std::unordered_set<int> moved;
+	auto flushNew = [&]() {
+		std::unordered_multimap<std::int64_t,BackendFactory::PhotoFile> candidates;
+		for(auto& candidate : backend.getPhotosWithFingerprints(new_fingerprints))
+			candidates.emplace(candidate.fingerprint.inode, std::move(candidate));
+
+		std::vector<int> moved_ids;
+		std::vector<RecordClasses::PhotoRecord> moved_photos;
+		std::vector<FileFingerprint> moved_fingerprints;
+		std::size_t n = 0;
+		for(std::size_t j = 0; j < new_photos.size(); ++j) {
+			auto [begin, end] = candidates.equal_range(new_fingerprints[j].inode);
+			auto candidate = std::find_if(begin, end, [&](const auto& candidate) {
+				return candidate.second.fingerprint == new_fingerprints[j] && !moved.contains(candidate.second.id) &&
+						getFileFingerprint(candidate.second.path) != new_fingerprints[j];
+			});
+			if(candidate != end) {
+				moved.insert(candidate->second.id);
+				moved_ids.push_back(candidate->second.id);
+				moved_photos.push_back(std::move(new_photos[j]));
+				moved_fingerprints.push_back(new_fingerprints[j]);
+			}
+			else if(n++ != j) {
+				new_photos[n - 1] = std::move(new_photos[j]);
+				new_fingerprints[n - 1] = new_fingerprints[j];
+			}
+		}
+		new_photos.erase(new_photos.begin() + n, new_photos.end());
+		new_fingerprints.erase(new_fingerprints.begin() + n, new_fingerprints.end());
+
+		backend.updatePhotoFiles(moved_ids, moved_photos, moved_fingerprints);
+		n_moved += moved_ids.size();
+		n_added += backend.newPhotos(new_photos, new_fingerprints);
+		new_photos.clear();
+		new_fingerprints.clear();
+	};
+	auto flushChanged = [&]() {
+		backend.updatePhotoFiles(changed_ids, changed_photos, changed_fingerprints);
+		n_updated += changed_ids.size();
+		changed_ids.clear();
+		changed_photos.clear();
+		changed_fingerprints.clear();
+	};
+	auto flushRemoved = [&]() {
+		std::erase_if(removed_ids, [&](int id) { return moved.contains(id); });
+		n_removed += backend.deletePhotos(removed_ids);
+		removed_ids.clear();
+	};
+
+	while(auto item = items.pop()) {
+		if(auto directory = std::get_if<DirectoryItem>(&*item)) {
+			int id = backend.getOrAddDirectory(RecordClasses::DirectoryRecord(directory_ids.at(directory->parent_key),
+					RecordClasses::DirectoryRecord::Options::NONE, directory->name, directory->fullname));
+			directory_ids[directory->key] = id;
+			seen.insert(id);
+		}
+		else if(auto directory = std::get_if<SkippedDirectory>(&*item))
+			skipped.insert(directory_ids.at(directory->key));
+		else if(auto photo = std::get_if<PhotoItem>(&*item)) {
+			RecordClasses::PhotoRecord record(directory_ids.at(photo->directory_key), photo->path.filename().string(),
+					0, photo->header.datetime, photo->header.width, photo->header.height, photo->header.orientation);
+			if(photo->id) {
+				changed_ids.push_back(photo->id);
+				changed_photos.push_back(std::move(record));
+				changed_fingerprints.push_back(photo->fingerprint);
+				if(changed_ids.size() >= batch_size)
+					flushChanged();
+			}
+			else {
+				new_photos.push_back(std::move(record));
+				new_fingerprints.push_back(photo->fingerprint);
+				if(new_photos.size() >= batch_size)
+					flushNew();
+			}
+		}
+		else {
+			auto& removed = std::get<RemovedPhotos>(*item);
+			removed_ids.insert(removed_ids.end(), removed.ids.begin(), removed.ids.end());
+		}
+	}
+	flushNew();
+	flushChanged();
+	// the walk of a cancelled import is incomplete
+	if(cancelled)
+		return;
+	flushRemoved();
+
+	if(!remove_vanished)
+		return;
+	for(const auto& [path, directory] : catalogue)
+		if(!seen.contains(directory.id) && seen.contains(directory.parent) && !skipped.contains(directory.parent)) {
+			n_removed += backend.getNumberPhotos<RecordClasses::DirectoryRecord>(directory.id, true);
+			backend.deleteEntry<RecordClasses::DirectoryRecord>(directory.id);
+			++n_directories_removed;
+		}
+}
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,249 @@
+/*
+ * PhotoImporter.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_BACKEND_PHOTOIMPORTER_H_
+#define SRC_BACKEND_PHOTOIMPORTER_H_
+
+#include "BackendFactory.h"
+#include "FileFingerprint.h"
+#include "ImageHeader.h"
+#include "../Support/BoundedQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+
+/**
+ * Imports directory trees into the library and keeps them up to date.
+ *
+ * The import is a pipeline of three stages connected by
+ * Support::BoundedQueue s:
+ * -# walker threads traverse the directories in parallel, stat the files
+ * 		with a photo extension, and compare them with the catalogue,
+ * -# parser threads read the headers of new and changed files (see
+ * 		readImageHeader()),
+ * -# the calling thread is the only one writing to the database; it adds
+ * 		directories as they are found and the photos in batches (see
+ * 		BackendFactory::newPhotos()).
+ *
+ * The queues are bounded, so the walkers can't run away from the parsers
+ * and the parsers not from the writer. Only the queue of directories
+ * still to be walked is unbounded: walkers fill it themselves, so bounding
+ * it could block all of them.
+ *
+ * The photos of every directory are stored with a FileFingerprint. Before
+ * walking, the catalogued photos of the tree are loaded sorted by file
+ * name; the walkers sort the files they find the same way and merge both
+ * lists. Files with an unchanged fingerprint are not read again, so
+ * rescanning an unchanged tree only costs the directory listings and a
+ * stat per file.
+ *
+ * A renamed or moved file keeps its fingerprint. Before new files are
+ * added, the library is searched for photos with the same fingerprint
+ * whose files no longer exist (see
+ * BackendFactory::getPhotosWithFingerprints()); these photos are moved to
+ * the new files instead, so they keep their ratings, keywords, and albums.
+ * Vanished photos are only removed after all new files were matched. A
+ * renamed directory is added again and the photos are moved into it
+ * before the old directory is removed.
+ *
+ * Directory symlinks are not followed.
+ */
+class PhotoImporter {
+public:
+	/**
+	 * Result of an import.
+	 */
+	struct Statistics {
+		int directories = 0;	/**< number of directories walked */
+		int files = 0;	/**< number of photo files found */
+		int photos_unchanged = 0;	/**< number of files with an unchanged fingerprint */
+		int photos_added = 0;	/**< number of photos added to the library */
+		int photos_updated = 0;	/**< number of photos whose files changed */
+		int photos_moved = 0;	/**< number of photos whose files were renamed or moved */
+		int photos_removed = 0;	/**< number of photos removed (only rescanDirectory()) */
+		int directories_removed = 0;	/**< number of directories removed (only rescanDirectory()) */
+		int errors = 0;	/**< number of files and directories that couldn't be read */
+	};
+
+	/**
+	 * @param backend the library to import into
+	 * @param n_threads number of walker and of parser threads
+	 * @param batch_size number of photos added in one transaction
+	 */
+	PhotoImporter(BackendFactory& backend, unsigned int n_threads, std::size_t batch_size=1000);
+	~PhotoImporter() = default;
+
+	//no copying or moving
+	PhotoImporter(const PhotoImporter&) = delete;
+	PhotoImporter(PhotoImporter&&) = delete;
+	PhotoImporter& operator=(const PhotoImporter&) = delete;
+	PhotoImporter& operator=(PhotoImporter&&) = delete;
+
+	/**
+	 * Import a directory tree.
+	 *
+	 * 'root' is added as a top level directory with its absolute path as
+	 * full name, its subdirectories are added as its descendants. New files
+	 * are added, changed files are read again; photos whose files vanished
+	 * are kept.
+	 *
+	 * @param root the directory to import
+	 * @return statistics of the import
+	 *
+	 * @throws std::invalid_argument if 'root' isn't a directory
+	 * @throws constraint_error, database_error if writing to the database
+	 * 		fails (the photos of the current batch aren't added)
+	 */
+	Statistics importDirectory(const std::filesystem::path& root);
+
+	/**
+	 * Synchronise a directory tree with the file system.
+	 *
+	 * Like importDirectory(), but photos and directories which no longer
+	 * exist are removed from the library. The content of directories that
+	 * can't be read completely is kept.
+	 *
+	 * \copydetails importDirectory()
+	 */
+	Statistics rescanDirectory(const std::filesystem::path& root);
+
+	/**
+	 * Synchronise several catalogued directories with the file system.
+	 *
+	 * Like rescanDirectory(), but catalogued subdirectories are not
+	 * descended into: only the photos and the subdirectories directly in
+	 * 'directories' are compared. New subdirectories are imported
+	 * completely. Used to apply changes reported by DirectoryWatcher.
+	 *
+	 * @param directories ids and paths of the directories
+	 * @return statistics of the synchronisation
+	 *
+	 * @throws constraint_error, database_error if writing to the database
+	 * 		fails (the photos of the current batch aren't added)
+	 */
+	Statistics syncDirectories(const std::vector<std::pair<int,std::filesystem::path>>& directories);
+
+	/**
+	 * Get the progress of a running import.
+	 * May be called in any thread while another one imports.
+	 *
+	 * @return the statistics so far; only the numbers of directories
+	 * 		walked, files found, unchanged files, and errors are set
+	 */
+	Statistics getProgress() const noexcept;
+
+	/**
+	 * Stop the running import and all later ones.
+	 * May be called in any thread while another one imports. The walkers
+	 * stop at the next directory, the photos already read are still
+	 * added, but nothing is removed since the walk is incomplete. Later
+	 * imports return at once with empty statistics.
+	 */
+	void cancel() noexcept;
+
+	/**
+	 * Whether a file is imported as a photo (checks the extension only).
+	 *
+	 * @param file path to the file
+	 * @retval true if the file has the extension of a photo
+	 * @retval false otherwise
+	 */
+	static bool isPhoto(const std::filesystem::path& file);
+
+private:
+	/// a directory in the library before the import
+	struct CataloguedDirectory {
+		int id;
+		int parent;
+		std::vector<BackendFactory::CataloguedPhoto> photos;	/**< sorted by file name */
+	};
+	/// a directory to walk, 'key' identifies it until it has an id
+	struct DirectoryJob {
+		std::size_t key;
+		std::filesystem::path path;
+	};
+	/// a directory to add to the database
+	struct DirectoryItem {
+		std::size_t key;
+		std::size_t parent_key;
+		std::string name;
+		std::string fullname;
+	};
+	/// a directory that couldn't be read completely
+	struct SkippedDirectory {
+		std::size_t key;
+	};
+	/// a photo file to parse and add (id 0) or update in the database
+	struct PhotoItem {
+		std::size_t directory_key;
+		std::filesystem::path path;
+		FileFingerprint fingerprint;
+		int id;
+		ImageHeader header;
+	};
+	/// photos whose files vanished
+	struct RemovedPhotos {
+		std::vector<int> ids;
+	};
+	using WriteItem = std::variant<DirectoryItem,SkippedDirectory,PhotoItem,RemovedPhotos>;
+
+	BackendFactory& backend;
+	const unsigned int n_threads;
+	const std::size_t batch_size;
+
+	/// the directories in the tree before the import by path
+	std::unordered_map<std::string,CataloguedDirectory> catalogue;
+	/// the directories to walk, their keys are their indices
+	std::vector<std::pair<int,std::filesystem::path>> roots;
+	bool remove_vanished = false;
+	bool shallow = false;
+	std::atomic<bool> cancelled {false};
+
+	Statistics run(const std::filesystem::path& root, bool remove_vanished);
+	Statistics run();
+	void loadCatalogue(int id, int parent, const std::filesystem::path& path);
+	void walk(Support::BoundedQueue<DirectoryJob>& directories, Support::BoundedQueue<PhotoItem>& files,
+			Support::BoundedQueue<WriteItem>& items, std::atomic<std::size_t>& pending,
+			std::atomic<std::size_t>& next_key);
+	void parse(Support::BoundedQueue<PhotoItem>& files, Support::BoundedQueue<WriteItem>& items);
+	void write(Support::BoundedQueue<WriteItem>& items);
+
+	std::atomic<int> n_directories {0};
+	std::atomic<int> n_files {0};
+	std::atomic<int> n_unchanged {0};
+	std::atomic<int> n_errors {0};
+	int n_added = 0;
+	int n_updated = 0;
+	int n_moved = 0;
+	int n_removed = 0;
+	int n_directories_removed = 0;
+};
+
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_BACKEND_PHOTOIMPORTER_H_ */
@@ -33,7 +33,8 @@ enum Options {
 	PRIVATE = 2, /**< For keywords: whether the keyword is private. */
 	INCLUDE_ON_EXPORT = 4, /**< For keywords: if not set a keyword can't be included on exported */
 	INCLUDE_SYNONYMS_ON_EXPORT = 8, /**< For keywords: if not set the synonyms of a keyword are not exportet */
-	ALBUM_IS_SET = 16 /**< For albums: the album is a set */
+	ALBUM_IS_SET = 16, /**< For albums: the album is a set */
+	SMART_ALBUM = 32 /**< For albums: the photos in the album are defined by a rule */
 };
 
 /**
@@ -28,7 +28,7 @@ namespace PhotoLibrary {
 namespace Backend {
 namespace RecordClasses {
 
-using PhotoTuple = std::tuple<int,Glib::ustring,int,int_least64_t,int,int>;
+using PhotoTuple = std::tuple<int,Glib::ustring,int,int_least64_t,int,int,int>;
 
 /**
  * Class to hold a photo entry.
@@ -46,6 +46,7 @@ public:
 	 * @param datetime date and time when the photo was taken (unix time)
 	 * @param width width of the photo in pixel
 	 * @param height height of the photo in pixel
+	 * @param orientation Exif orientation of the photo (1 to 8)
 	 */
 	PhotoRecord(
 			int directory=0,
@@ -53,12 +54,13 @@ public:
 			int rating=0,
 			int_least64_t datetime=0,
 			int width=0,
-			int height=0
+			int height=0,
+			int orientation=1
 			) :
-		Record<PhotoTuple>(directory, filename, rating, datetime, width, height) {}
+		Record<PhotoTuple>(directory, filename, rating, datetime, width, height, orientation) {}
 
 	/**
-	* \copydoc PhotoRecord(int,Glib::ustring&&,int,int_least64_t,int,int)
+	* \copydoc PhotoRecord(int,Glib::ustring&&,int,int_least64_t,int,int,int)
 	*/
 	PhotoRecord(
 			int directory,
@@ -66,9 +68,10 @@ public:
 			int rating=0,
 			int_least64_t datetime=0,
 			int width=0,
-			int height=0
+			int height=0,
+			int orientation=1
 			) :
-		Record<PhotoTuple>(directory, std::move(filename), rating, datetime, width, height) {}
+		Record<PhotoTuple>(directory, std::move(filename), rating, datetime, width, height, orientation) {}
 
 	/**
 	 * Set the directory.
@@ -160,8 +163,25 @@ public:
 	 */
 	int getHeight() const noexcept { return access<5>(); }
 
-	static inline const std::array<const Glib::ustring,7>
-		fields {"directory", "filename", "rating", "datetime", "width", "height", "Photos"};
+	/**
+	 * Set the orientation.
+	 * Returns a reference to the Exif orientation (1 to 8). Width and height
+	 * are those of the stored image, orientations 5 to 8 swap them when
+	 * displayed.
+	 *
+	 * @return reference to the orientation
+	 */
+	int& setOrientation() noexcept { return access<6>(); }
+
+	/**
+	 * Get the orientation.
+	 *
+	 * @return value of the Exif orientation
+	 */
+	int getOrientation() const noexcept { return access<6>(); }
+
+	static inline const std::array<const Glib::ustring,8>
+		fields {"directory", "filename", "rating", "datetime", "width", "height", "orientation", "Photos"};
 	static inline const Glib::ustring table { "Photos" };
 };
 
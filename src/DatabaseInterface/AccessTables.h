@@ -25,6 +25,7 @@
 #include <Database.h>
 #include <Concepts.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace PhotoLibrary {
@@ -89,7 +90,7 @@ public:
 	/**
 	 * Get the children of a entry.
 	 * Returns the ids of all entries where the column RecordType::fileds[0]
-	 * equals the value handed to the method.
+	 * equals the value handed to the method, ordered by id.
 	 *
 	 * @param parent id of the entry of which the children should be returned
 	 * @tparam RecordType Record based class for the table (see AccessTables'
@@ -116,6 +117,22 @@ public:
 	template<typename RecordType>
 	int getNumberChildren(int parent) const;
 
+	/**
+	 * Get the children of a entry and whether they have children.
+	 * Like getChildren(), but also tells for every child whether it has
+	 * children itself, all in a single querry.
+	 *
+	 * @param parent id of the entry of which the children should be returned
+	 * @tparam RecordType Record based class for the table (see AccessTables'
+	 * 		class documentation for more information)
+	 * @return vector of pairs of the id of a child of 'parent' and whether
+	 * 		the child has children
+	 *
+	 * @throws database_error if any error occurs trying to get the children
+	 */
+	template<typename RecordType>
+	std::vector<std::pair<int,bool>> getChildNodes(int parent) const;
+
 	/**
 	 * Add new record.
 	 *
@@ -233,7 +250,9 @@ template<typename RecordType>
 std::vector<int> AccessTables<String>::getChildren(int parent) const {
 	const String& table = RecordType::table;
 
-	String sql = "SELECT id FROM " + table + " WHERE " + RecordType::fields[0] + " IS '" + std::to_string(parent) + "'";
+	// without ORDER BY the order would depend on the index SQLite picks
+	String sql = "SELECT id FROM " + table + " WHERE " + RecordType::fields[0] + " IS '" + std::to_string(parent) + "'"
+			" ORDER BY id";
 	SQLiteAdapter::SQLQuerry querry(db, sql.c_str());
 
 	std::vector<int> ids;
@@ -257,6 +276,26 @@ int AccessTables<String>::getNumberChildren(int parent) const {
 	return querry.getColumnInt(0);
 }
 
+template<String_type String>
+template<typename RecordType>
+std::vector<std::pair<int,bool>> AccessTables<String>::getChildNodes(int parent) const {
+	const String& table = RecordType::table;
+	const String& parent_column = RecordType::fields[0];
+	String sql = "SELECT id, EXISTS (SELECT 1 FROM " + table + " AS child WHERE child." + parent_column
+			+ " IS " + table + ".id) FROM " + table + " WHERE (" + parent_column + " IS "
+			+ std::to_string(parent) + " AND id IS NOT 0);";
+	SQLiteAdapter::SQLQuerry querry(db, sql.c_str());
+
+	std::vector<std::pair<int,bool>> children;
+	int result;
+	while ((result = querry.nextRow()) == SQLITE_ROW)
+		children.emplace_back(querry.getColumnInt(0), querry.getColumnInt(1));
+	if(result != SQLITE_DONE)
+		throw(database_error("Error getting children: " + std::to_string(result)));
+
+	return children;
+}
+
 /**
  * Template loop used by AccessTables::newEntry
  */
@@ -36,6 +36,44 @@ int RelationsTable::getNumberEntries(int collection, const std::array<const std:
 	return getNumber(collection, table[1], table[2], table[0]);
 }
 
+std::unordered_map<int,int> RelationsTable::getNumberEntriesPerCollection(
+		std::span<const int> entries,
+		const std::array<const std::string,3>& table
+		) const {
+	std::unordered_map<int,int> numbers;
+	if(entries.empty())
+		return numbers;
+
+	std::string sql = "SELECT " + table[1] + ", COUNT(*) FROM " + table[0] +
+			" WHERE " + table[2] + " IN (SELECT value FROM json_each(?1))"
+			" GROUP BY " + table[1] + ";";
+	SQLiteAdapter::SQLQuerry querry(db, sql.c_str());
+	querry.bind(1, toJSONArray(entries));
+
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		numbers.emplace(querry.getColumnInt(0), querry.getColumnInt(1));
+	if(i != SQLITE_DONE)
+		throw(database_error("Error counting relations (error code: " + std::to_string(i) + ")"));
+
+	return numbers;
+}
+
+std::vector<std::pair<int,int>> RelationsTable::getRelations(const std::array<const std::string,3>& table) const {
+	std::string sql = "SELECT " + table[1] + ", " + table[2] + " FROM " + table[0] +
+			" ORDER BY " + table[1] + ", " + table[2] + ";";
+	SQLiteAdapter::SQLQuerry querry(db, sql.c_str());
+
+	std::vector<std::pair<int,int>> relations;
+	int i;
+	while((i = querry.nextRow()) == SQLITE_ROW)
+		relations.emplace_back(querry.getColumnInt(0), querry.getColumnInt(1));
+	if(i != SQLITE_DONE)
+		throw(database_error("Error reading " + table[0] + " (error code: " + std::to_string(i) + ")"));
+
+	return relations;
+}
+
 std::vector<int> RelationsTable::getCollections(int entry, const std::array<const std::string,3>& table) const {
 	return getVector(entry, table[2], table[1], table[0]);
 }
@@ -64,6 +102,55 @@ void RelationsTable::deleteRelation(int entry, int collection, const std::array<
 		throw(database_error("Error deleting relation."));
 }
 
+int RelationsTable::newRelations(std::span<const int> entries, int collection, const std::array<const std::string,3>& table) {
+	return newRelations(entries, std::span<const int>(&collection, 1), table);
+}
+
+int RelationsTable::newRelations(
+		std::span<const int> entries,
+		std::span<const int> collections,
+		const std::array<const std::string,3>& table
+		) {
+	std::string sql = "INSERT OR IGNORE INTO " + table[0] + " (" + table[2] + ", " + table[1] + ")"
+			" SELECT e.value, c.value FROM json_each(?1) AS e, json_each(?2) AS c;";
+	return changeRelations(sql, entries, collections);
+}
+
+int RelationsTable::deleteRelations(std::span<const int> entries, int collection, const std::array<const std::string,3>& table) {
+	return deleteRelations(entries, std::span<const int>(&collection, 1), table);
+}
+
+int RelationsTable::deleteRelations(
+		std::span<const int> entries,
+		std::span<const int> collections,
+		const std::array<const std::string,3>& table
+		) {
+	std::string sql = "DELETE FROM " + table[0] +
+			" WHERE " + table[2] + " IN (SELECT value FROM json_each(?1))"
+			" AND " + table[1] + " IN (SELECT value FROM json_each(?2));";
+	return changeRelations(sql, entries, collections);
+}
+
+int RelationsTable::changeRelations(
+		const std::string& sql,
+		std::span<const int> entries,
+		std::span<const int> collections
+		) {
+	if(entries.empty() || collections.empty())
+		return 0;
+
+	SQLiteAdapter::SQLQuerry querry(db, sql.c_str());
+	querry.bind(1, toJSONArray(entries));
+	querry.bind(2, toJSONArray(collections));
+
+	if(int i = querry.nextRow(); i == SQLITE_CONSTRAINT)
+		throw(constraint_error("Constraint Error changing relations"));
+	else if(i != SQLITE_DONE)
+		throw(database_error("Error changing relations (error code: " + std::to_string(i) + ")"));
+
+	return db.changes();
+}
+
 std::vector<int> RelationsTable::getVector(
 		int id,
 		const std::string& reference_id,
@@ -22,6 +22,9 @@
 
 #include <Database.h>
 #include <array>
+#include <span>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace PhotoLibrary {
@@ -80,6 +83,42 @@ public:
 	 */
 	int getNumberEntries(int collection, const std::array<const std::string,3>& table) const;
 
+	/**
+	 * Get the number of 'entries' out of a list in every 'collection'.
+	 *
+	 * Counts for every 'collection' how many of 'entries' are associated
+	 * with it using a single grouped SQL querry.
+	 *
+	 * @param entries Ids of the 'entries' to count
+	 * @param table Name of the relations table and the columns (see
+	 * 		RelationsTable class' description)
+	 * @return Map from the ids of the 'collections' to the number of
+	 * 		'entries' associated with them; 'collections' not associated
+	 * 		with any of 'entries' are omitted
+	 *
+	 * @throws std::runtime_error if doesn't hold the correct strings
+	 * 		for a table
+	 * @throws database_error if the database returns an error
+	 */
+	std::unordered_map<int,int> getNumberEntriesPerCollection(
+			std::span<const int> entries,
+			const std::array<const std::string,3>& table
+			) const;
+
+	/**
+	 * Get all relations of a table.
+	 *
+	 * @param table Name of the relations table and the columns (see
+	 * 		RelationsTable class' description)
+	 * @return Vector of pairs of 'collection' and 'entry' ids, sorted by
+	 * 		'collection' and 'entry'
+	 *
+	 * @throws std::runtime_error if doesn't hold the correct strings
+	 * 		for a table
+	 * @throws database_error if the database returns an error
+	 */
+	std::vector<std::pair<int,int>> getRelations(const std::array<const std::string,3>& table) const;
+
 	/**
 	 * Get a vector of 'collections' associated with 'entry' id.
 	 *
@@ -144,6 +183,92 @@ public:
 	 */
 	void deleteRelation(int entry, int collection, const std::array<const std::string,3>& table);
 
+	/**
+	 * Add several 'entries' to a 'collection'.
+	 *
+	 * All relations are added with a single SQL statement. Adding existing
+	 * relations has no effect.
+	 *
+	 * @param entries Ids of the 'entries'
+	 * @param collection Id of the 'collection'
+	 * @param table Name of the relations table and the columns (see
+	 * 		RelationsTable class' description)
+	 * @return Number of relations added
+	 *
+	 * @throws std::runtime_error if doesn't hold the correct strings
+	 * 		for a table
+	 * @throws constraint_error if adding the new relations fails due to
+	 * 		a constraint violation (no relation is added in that case)
+	 * @throws database_error if any error occurs in the database
+	 */
+	int newRelations(std::span<const int> entries, int collection, const std::array<const std::string,3>& table);
+
+	/**
+	 * Add all 'entries' to all 'collections'.
+	 *
+	 * Adds the relations for the cross product of 'entries' and
+	 * 'collections' with a single SQL statement. Adding existing relations
+	 * has no effect.
+	 *
+	 * @param entries Ids of the 'entries'
+	 * @param collections Ids of the 'collections'
+	 * @param table Name of the relations table and the columns (see
+	 * 		RelationsTable class' description)
+	 * @return Number of relations added
+	 *
+	 * @throws std::runtime_error if doesn't hold the correct strings
+	 * 		for a table
+	 * @throws constraint_error if adding the new relations fails due to
+	 * 		a constraint violation (no relation is added in that case)
+	 * @throws database_error if any error occurs in the database
+	 */
+	int newRelations(
+			std::span<const int> entries,
+			std::span<const int> collections,
+			const std::array<const std::string,3>& table
+			);
+
+	/**
+	 * Remove several 'entries' from a 'collection'.
+	 *
+	 * All relations are removed with a single SQL statement. Deleting
+	 * non-existing relations has no effect.
+	 *
+	 * @param entries Ids of the 'entries'
+	 * @param collection Id of the 'collection'
+	 * @param table Name of the relations table and the columns (see
+	 * 		RelationsTable class' description)
+	 * @return Number of relations removed
+	 *
+	 * @throws std::runtime_error if doesn't hold the correct strings
+	 * 		for a table
+	 * @throws database_error if any error occurs in the database
+	 */
+	int deleteRelations(std::span<const int> entries, int collection, const std::array<const std::string,3>& table);
+
+	/**
+	 * Remove all 'entries' from all 'collections'.
+	 *
+	 * Removes the relations for the cross product of 'entries' and
+	 * 'collections' with a single SQL statement. Deleting non-existing
+	 * relations has no effect.
+	 *
+	 * @param entries Ids of the 'entries'
+	 * @param collections Ids of the 'collections'
+	 * @param table Name of the relations table and the columns (see
+	 * 		RelationsTable class' description)
+	 * @return Number of relations removed
+	 *
+	 * @throws std::runtime_error if doesn't hold the correct strings
+	 * 		for a table
+	 * @throws database_error if any error occurs in the database
+	 */
+	int deleteRelations(
+			std::span<const int> entries,
+			std::span<const int> collections,
+			const std::array<const std::string,3>& table
+			);
+
 private:
 	SQLiteAdapter::Database& db;
 
@@ -159,6 +284,11 @@ private:
 			const std::string& return_id, 
 			const std::string& table
 			) const;
+	int changeRelations(
+			const std::string& sql,
+			std::span<const int> entries,
+			std::span<const int> collections
+			);
 };
 
 } /* namespace DatabaseInterface */
@@ -21,7 +21,9 @@
 #define SRC_SUPPPORT_H_
 
 #include <Concepts.h>
+#include <span>
 #include <stdexcept>
+#include <string>
 
 namespace PhotoLibrary {
 namespace DatabaseInterface {
@@ -120,6 +122,27 @@ void appendFieldNamesReverse(String &sql) {
 	}
 }
 
+/**
+ * Creates a JSON array from a list of integers.
+ * Used to hand a list of ids to an SQL statement in a single parameter
+ * (to be used with SQLite's json_each table-valued function).
+ *
+ * @param values the integers to put into the array
+ * @return the JSON array as string (e.g. "[1,2,3]")
+ */
+inline std::string toJSONArray(std::span<const int> values) {
+	std::string json = "[";
+	for(int value : values) {
+		json += std::to_string(value);
+		json += ',';
+	}
+	if(json.size() > 1)
+		json.back() = ']';
+	else
+		json += ']';
+	return json;
+}
+
 } /* namespace DatabaseInterface */
 } /* namespace PhotoLibrary */
 
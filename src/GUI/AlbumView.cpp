@@ -19,6 +19,7 @@
 
 #include "AlbumView.h"
 #include "NewAlbumDialogue.h"
+#include "NewSmartAlbumDialogue.h"
 #include <gtkmm/messagedialog.h>
 #include <iostream>
 
@@ -55,7 +56,6 @@ void AlbumView::addNewAlbum(Backend::RecordClasses::AlbumRecord::Options options
 	while(dialogue.run() == Gtk::RESPONSE_OK) {
 		try {
 			getBackend().newEntry(new_album);
-			reloadTreeStore();
 			return;
 		}
 		catch (DatabaseInterface::constraint_error& e) {
@@ -84,8 +84,7 @@ bool AlbumView::on_button_press_event(GdkEventButton* button_event) {
 
 		//grey out new albums if selection is not an album set
 		menu_item_new_album.set_sensitive(!iter || (*iter)[getTreeStore()->getColumns().album_is_set]);
-		/// \todo uncomment when smart albums are implemented
-//		menu_item_new_smart_album.set_sensitive(!iter || (*iter)[getTreeStore()->getColumns().album_is_set]);
+		menu_item_new_smart_album.set_sensitive(!iter || (*iter)[getTreeStore()->getColumns().album_is_set]);
 		menu_item_new_album_set.set_sensitive(!iter || (*iter)[getTreeStore()->getColumns().album_is_set]);
 
 		popup_menu.popup_at_pointer((GdkEvent*) button_event);
@@ -97,8 +96,6 @@ bool AlbumView::on_button_press_event(GdkEventButton* button_event) {
 void AlbumView::fillPopupMenu() {
 	addPopupMenuEntry("_New Album", &AlbumView::onMenuAddNewAlbum, &menu_item_new_album);
 	addPopupMenuEntry("New S_mart Album", &AlbumView::onMenuAddNewSmartAlbum, &menu_item_new_smart_album);
-	/// \todo remove when smart albums are implemented
-	menu_item_new_smart_album.set_sensitive(false);
 	addPopupMenuEntry("New Album _Set", &AlbumView::onMenuAddNewSet, &menu_item_new_album_set);
 	addPopupMenuEntry("_Rename Album", &AlbumView::onMenuRenameAlbum, &menu_item_rename_album);
 	addPopupMenuEntry("_Delete Album", &AlbumView::onMenuDeleteAlbum, &menu_item_delete_album);
@@ -118,7 +115,36 @@ void AlbumView::onMenuAddNewAlbum() {
 }
 
 void AlbumView::onMenuAddNewSmartAlbum() {
-	// \todo implment
+	auto refSelection = get_selection();
+	Gtk::TreeModel::iterator iter(nullptr);
+	if (refSelection)
+		iter = refSelection->get_selected();
+
+	int				parent_id			= iter?(*iter)[getTreeStore()->getColumns().id]:0;
+	Glib::ustring	parent_album_name	= iter?(*iter)[getTreeStore()->getColumns().album_name]:Glib::ustring();
+	Backend::RecordClasses::NewAlbumRecord new_album(parent_id, Backend::RecordClasses::AlbumRecord::Options::SMART_ALBUM);
+	Glib::ustring rule;
+
+	NewSmartAlbumDialogue dialogue(&new_album, &rule, parent_album_name);
+	while(dialogue.run() == Gtk::RESPONSE_OK) {
+		try {
+			getBackend().newSmartAlbum(new_album, rule.raw());
+			return;
+		}
+		catch (DatabaseInterface::constraint_error& e) {
+			/// \todo prepare for internationalisation
+			/// \todo improve text
+			Gtk::MessageDialog message_dialogue("Album could not be added");
+			message_dialogue.set_secondary_text("Albums in the same set may not have the same name.");
+			message_dialogue.run();
+		}
+		catch (Backend::filter_error& e) {
+			/// \todo prepare for internationalisation
+			Gtk::MessageDialog message_dialogue("Album could not be added");
+			message_dialogue.set_secondary_text(std::string("The rule is not valid: ") + e.what());
+			message_dialogue.run();
+		}
+	}
 }
 
 void AlbumView::onMenuAddNewSet() {
@@ -140,7 +166,6 @@ void AlbumView::onMenuRenameAlbum() {
 	while (dialogue.run() == Gtk::RESPONSE_OK) {
 		try {
 			getBackend().updateEntry((*iter)[getTreeStore()->getColumns().id], album);
-			reloadTreeStore();
 			return;
 		}
 		catch (DatabaseInterface::constraint_error &e) {
@@ -173,7 +198,6 @@ void AlbumView::onMenuDeleteAlbum() {
 			"You cannot undo the action.");
 	if(delete_dialogue.run() == Gtk::RESPONSE_OK) {
 		getBackend().deleteEntry<Backend::RecordClasses::AlbumRecord>((*iter)[getTreeStore()->getColumns().id]);
-		reloadTreeStore();
 	}
 }
 
@@ -48,7 +48,6 @@ private:
 
 	bool on_button_press_event(GdkEventButton* button_event) override;
 	void onMenuAddNewAlbum();
-	/// \todo implement smart albums
 	void onMenuAddNewSmartAlbum();
 	void onMenuAddNewSet();
 	void onMenuRenameAlbum();
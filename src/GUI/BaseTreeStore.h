@@ -20,7 +20,14 @@
 #ifndef SRC_GUI_BASETREESTORE_H_
 #define SRC_GUI_BASETREESTORE_H_
 
+#include <glibmm/dispatcher.h>
 #include <gtkmm/treestore.h>
+#include <mutex>
+#include <set>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "../Backend/BackendFactory.h"
 
@@ -36,6 +43,23 @@ namespace GUI {
  * When used with a BaseTreeStore based class the TModelColumns must also
  * contain a field 'id' with the id of the entry.
  *
+ * The TreeStore follows the changes made through the backend
+ * (see Backend::BackendFactory::addChangeObserver()): added, updated,
+ * moved, and deleted entries and directories whose photos changed only
+ * change the rows concerned and their ancestors, the TreeStore is not
+ * reloaded. Changes made in other threads (e.g. by an import running in
+ * the background) are queued and applied in the GUI thread by the main
+ * loop; if an entry was deleted before its change is applied, the
+ * TreeStore is reload()ed instead.
+ *
+ * Children are loaded lazily: only the children of expanded rows are
+ * loaded, a collapsed row with children gets a single placeholder child
+ * (with id 0) instead, so the TreeView shows an expander. The children
+ * are loaded by loadChildren() when the row is expanded.
+ *
+ * The TreeStore can be filtered with setFilter(), e.g. to show the results
+ * of a search: only the matching entries and their ancestors are shown.
+ *
  * \see https://developer.gnome.org/gtkmm/stable/classGtk_1_1TreeStore.html
  *
  * @tparam TModelColumns Gtk::TreeModel::ColumnRecord based class
@@ -49,7 +73,7 @@ class BaseTreeStore : public Gtk::TreeStore {
 public:
 	using ModelColumns = TModelColumns;
 
-	virtual ~BaseTreeStore() = default;
+	inline virtual ~BaseTreeStore();
 
 	/**
 	 * Returns reference to the ModelColumns used by the TreeStore.
@@ -71,12 +95,69 @@ public:
 	 */
 	inline void reload();
 
+	/**
+	 * Bring the TreeStore up to date after rows were dropped.
+	 * Has to be called at the end of a drag and drop operation, after
+	 * Gtk::TreeStore removed the dragged rows. Only the ancestors of moved
+	 * rows are refilled; if a drop could not be saved to the backend the
+	 * TreeStore is reload()ed instead.
+	 */
+	inline void updateAfterDrop();
+
+	/**
+	 * Load the children of a row.
+	 * Replaces the placeholder of a row whose children haven't been
+	 * loaded yet by its children (and the children of expanded children).
+	 * Has to be called when a row is expanded, preferably before it is.
+	 *
+	 * @param iter the row to load the children of
+	 */
+	inline void loadChildren(const Gtk::TreeModel::iterator& iter);
+
+	/**
+	 * Set the 'expanded' column of a row.
+	 * The change is not passed on to onRowChanged(); saving it in the
+	 * backend is up to the caller.
+	 *
+	 * @param iter the row to change
+	 * @param expanded whether the row is expanded
+	 */
+	inline void setExpanded(const Gtk::TreeModel::iterator& iter, bool expanded);
+
+	/**
+	 * Show only some entries and their ancestors.
+	 * The TreeStore is reloaded with only 'matches' and 'ancestors' below
+	 * the root and the ancestors. The ancestors are loaded at once and
+	 * marked as expanded (see signalExpandRow()), without changing the
+	 * backend; the descendants of the matches are loaded as usual.
+	 *
+	 * @param matches ids of the entries to show
+	 * @param ancestors ids of all ancestors of 'matches' (see
+	 * 		Backend::BackendFactory::getAncestors())
+	 */
+	inline void setFilter(std::span<const int> matches, std::span<const int> ancestors);
+
+	/**
+	 * Show all entries again.
+	 * Reloads the TreeStore if it is filtered (see setFilter()).
+	 */
+	inline void clearFilter();
+
+	/**
+	 * Whether the TreeStore is filtered (see setFilter()).
+	 *
+	 * @return true if only some entries are shown
+	 */
+	inline bool isFiltered() const noexcept { return filtered; }
+
 	/**
 	 * Signal emitted when a row should be expanded.
 	 * Signal emitted during initialise()ation or reload()ing if a row on the
 	 * first level shoud be expanded. It is called for a Row after all its
 	 * children have been added so the TreeView can handle the expansion of
 	 * child Row|s appropriately.
+	 * It is also emitted for rows added or moved by a change in the
+	 * backend if they and their parent should be expanded.
 	 *
 	 * @return sigc::signal; use connect() to connect a signal handler
 	 * @see https://developer.gnome.org/libsigc++/stable/group__signal.html
@@ -111,7 +192,8 @@ protected:
 	/**
 	 * Fills a Row of the TreeStore.
 	 * The method is called by initialise() and reload() for every record
-	 * retrieved from the backend.
+	 * retrieved from the backend and after changes for the rows concerned
+	 * and their ancestors.
 	 * It needs to be implemented by derived classes.
 	 *
 	 * @param[in] id id of the record
@@ -124,12 +206,26 @@ protected:
 	 * Is called everytime a row changes.
 	 *
 	 * \attention Should be overridden - unless drag and drop is deactivated -
-	 * to handle drops appropriately.
+	 * to handle drops appropriately. A dropped row is only kept if the
+	 * change is saved to the backend, otherwise the TreeStore is reloaded
+	 * by updateAfterDrop().
 	 *
 	 * \see https://developer.gnome.org/gtkmm/stable/classGtk_1_1TreeModel.html#a68bcb8a4563a498b504a4e5f0fb2a731
 	 */
 	virtual void onRowChanged(const TreeModel::Path& path, const TreeModel::iterator& iter) {};
 
+	/**
+	 * Connect onRowChanged() to Gtk::TreeStore::signal_row_changed().
+	 */
+	inline void connectRowSignalChanged();
+
+	/**
+	 * Disconnect onRowChanged() from Gtk::TreeStore::signal_row_changed().
+	 * Should be called before changing rows without a change in the
+	 * backend (e.g. columns only used for display).
+	 */
+	inline void disconnectRowSignalChanged();
+
 private:
 	Backend::BackendFactory& backend;
 	ModelColumns columns;
@@ -137,17 +233,62 @@ private:
 	sigc::signal<bool, const Gtk::TreeModel::Path&,bool> signal_expand_row;
 	using SignalExpandRow = sigc::signal<bool, const TreeModel::Path&, bool>;
 
+	int change_observer;
+	const std::thread::id gui_thread;
+	/// changes made in other threads, applied by applyQueuedChanges()
+	std::vector<Backend::BackendFactory::Change> queued_changes;
+	std::mutex queued_changes_mutex;
+	Glib::Dispatcher queued_changes_dispatcher;
+	/// rows by id; the iterators of a Gtk::TreeStore stay valid as long as the row exists
+	std::unordered_map<int,Gtk::TreeModel::iterator> rows;
+
+	// state of a drag and drop operation (see rowChanged() and updateAfterDrop())
+	bool in_row_changed = false;
+	Gtk::TreeModel::iterator changed_row;
+	bool change_reported = false;
+	bool rows_stale = false;
+	bool reload_needed = false;
+	std::set<int> stale_ancestors;
+	std::vector<int> dropped;
+
+	// see setFilter()
+	bool filtered = false;
+	std::set<int> filter_matches;
+	std::set<int> filter_ancestors;
+
 	void fillStore(int parent=0, Gtk::TreeModel::Row* parentRow=nullptr);
-	inline void connectRowSignalChanged();
-	inline void disconnectRowSignalChanged();
+	void fillChildren(int id, Gtk::TreeModel::Row& row, bool has_children);
+	bool hasPlaceholder(const Gtk::TreeModel::iterator& iter);
+	void rowChanged(const TreeModel::Path& path, const TreeModel::iterator& iter);
+	void onChange(const Backend::BackendFactory::Change& change);
+	void applyQueuedChanges();
+	void applyChange(const Backend::BackendFactory::Change& change);
+	void addRow(int id, int parent);
+	void updateRow(int id, int parent);
+	void moveRow(int id, int parent);
+	void removeRow(int id);
+	void refillRow(int id, int parent);
+	void forgetRows(const Gtk::TreeModel::iterator& iter);
+	void refillAncestors(Gtk::TreeModel::iterator iter);
+	void expandIfNeeded(const Gtk::TreeModel::iterator& iter);
+	int parentID(const Gtk::TreeModel::iterator& iter);
 };
 
 
 //implementation
 template<class TModelColumns, class RecordType>
 BaseTreeStore<TModelColumns,RecordType>::BaseTreeStore(Backend::BackendFactory& backend) : 
-		backend(backend) {
+		backend(backend),
+		gui_thread(std::this_thread::get_id()) {
 	set_column_types(columns);
+	queued_changes_dispatcher.connect(sigc::mem_fun(*this, &BaseTreeStore::applyQueuedChanges));
+	change_observer = backend.addChangeObserver(
+			[this](const Backend::BackendFactory::Change& change) { onChange(change); });
+}
+
+template<class TModelColumns, class RecordType>
+BaseTreeStore<TModelColumns,RecordType>::~BaseTreeStore() {
+	backend.removeChangeObserver(change_observer);
 }
 
 template<class TModelColumns, class RecordType>
@@ -170,10 +311,84 @@ void BaseTreeStore<TModelColumns,RecordType>::initialise() {
 template<class TModelColumns, class RecordType>
 void BaseTreeStore<TModelColumns,RecordType>::reload() {
 	disconnectRowSignalChanged();
+	rows.clear();
 	clear();
 	initialise();
 }
 
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::updateAfterDrop() {
+	if(reload_needed)
+		reload();
+	else if(rows_stale) {
+		// the dropped rows are copies of the dragged ones, which are gone now
+		rows.clear();
+		foreach_iter([this](const Gtk::TreeModel::iterator& iter) {
+			if(int id = (*iter)[getColumns().id])
+				rows.insert_or_assign(id, iter);
+			return false;
+		});
+
+		disconnectRowSignalChanged();
+		for(int id : stale_ancestors)
+			if(auto row = rows.find(id); row != rows.end()) {
+				Gtk::TreeModel::Row ancestor = *(row->second);
+				fillRow(id, ancestor);
+			}
+		for(int id : dropped)
+			if(auto row = rows.find(id); row != rows.end())
+				refillAncestors(row->second->parent());
+		connectRowSignalChanged();
+		for(int id : dropped)
+			if(auto row = rows.find(id); row != rows.end())
+				expandIfNeeded(row->second);
+	}
+
+	rows_stale = false;
+	reload_needed = false;
+	stale_ancestors.clear();
+	dropped.clear();
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::loadChildren(const Gtk::TreeModel::iterator& iter) {
+	if(!iter || !hasPlaceholder(iter))
+		return;
+	Gtk::TreeModel::iterator placeholder = iter->children().begin();
+	Gtk::TreeModel::Row row = *iter;
+
+	bool blocked = row_changed_connection.block();
+	fillStore(row[getColumns().id], &row);
+	//remove the placeholder last, a row without children would be collapsed
+	erase(placeholder);
+	row_changed_connection.block(blocked);
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::setExpanded(const Gtk::TreeModel::iterator& iter, bool expanded) {
+	bool blocked = row_changed_connection.block();
+	(*iter)[getColumns().expanded] = expanded;
+	row_changed_connection.block(blocked);
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::setFilter(std::span<const int> matches, std::span<const int> ancestors) {
+	filtered = true;
+	filter_matches = std::set<int>(matches.begin(), matches.end());
+	filter_ancestors = std::set<int>(ancestors.begin(), ancestors.end());
+	reload();
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::clearFilter() {
+	if(!filtered)
+		return;
+	filtered = false;
+	filter_matches.clear();
+	filter_ancestors.clear();
+	reload();
+}
+
 template<class TModelColumns, class RecordType>
 sigc::signal<bool, const Gtk::TreeModel::Path&,bool> BaseTreeStore<TModelColumns,RecordType>::signalExpandRow() {
 	return signal_expand_row;
@@ -181,7 +396,7 @@ sigc::signal<bool, const Gtk::TreeModel::Path&,bool> BaseTreeStore<TModelColumns
 
 template<class TModelColumns, class RecordType>
 void BaseTreeStore<TModelColumns,RecordType>::connectRowSignalChanged() {
-	row_changed_connection = signal_row_changed().connect(sigc::mem_fun(*this, &BaseTreeStore::onRowChanged));
+	row_changed_connection = signal_row_changed().connect(sigc::mem_fun(*this, &BaseTreeStore::rowChanged));
 }
 
 template<class TModelColumns, class RecordType>
@@ -191,18 +406,272 @@ void BaseTreeStore<TModelColumns,RecordType>::disconnectRowSignalChanged() {
 
 template<class TModelColumns, class RecordType>
 void BaseTreeStore<TModelColumns,RecordType>::fillStore(int parent, Gtk::TreeModel::Row* parentRow) {
-	for(int child_id : backend.getChildren<RecordType>(parent)){
-		RecordType record(backend.getEntry<RecordType>(child_id));
-		Gtk::TreeModel::Row row = parentRow?*(append(parentRow->children())):*(append());
+	//while filtered, the root and the ancestors only show the matches and ancestors
+	bool filter_children = filtered && (!parentRow || filter_ancestors.contains(parent));
+	for(auto [child_id, has_children] : backend.getChildNodes<RecordType>(parent)){
+		bool ancestor = filter_children && filter_ancestors.contains(child_id);
+		if(filter_children && !ancestor && !filter_matches.contains(child_id))
+			continue;
+		Gtk::TreeModel::iterator iter = parentRow?append(parentRow->children()):append();
+		Gtk::TreeModel::Row row = *iter;
 		fillRow(child_id, row);
+		rows.insert_or_assign(child_id, iter);
 
-		fillStore(child_id, &row);
+		if(ancestor) {
+			row[getColumns().expanded] = true;
+			fillStore(child_id, &row);
+		}
+		else
+			fillChildren(child_id, row, has_children);
 		if(row[getColumns().expanded] && !parentRow) {
 			signalExpandRow().emit(get_path(row), false);
 		}
 	}
 }
 
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::fillChildren(int id, Gtk::TreeModel::Row& row, bool has_children) {
+	if(!has_children)
+		return;
+	if(row[getColumns().expanded])
+		fillStore(id, &row);
+	else
+		append(row.children());
+}
+
+template<class TModelColumns, class RecordType>
+bool BaseTreeStore<TModelColumns,RecordType>::hasPlaceholder(const Gtk::TreeModel::iterator& iter) {
+	Gtk::TreeModel::iterator child = iter->children().begin();
+	return child && (*child)[getColumns().id] == 0;
+}
+
+/*
+ * A drop inserts a copy of the dragged row (and its children) at the
+ * destination and sets its values, which emits row_changed. The copy is
+ * recognised by not being the row stored for its id. The TreeStore must
+ * not be changed until the drag and drop operation is finished, so changes
+ * reported meanwhile are only recorded for updateAfterDrop().
+ */
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::rowChanged(const TreeModel::Path& path, const TreeModel::iterator& iter) {
+	int id = (*iter)[getColumns().id];
+	//copies of placeholders have no entry in the backend
+	if(!id)
+		return;
+
+	in_row_changed = true;
+	changed_row = iter;
+	change_reported = false;
+	try {
+		onRowChanged(path, iter);
+	}
+	catch (...) {
+		in_row_changed = false;
+		throw;
+	}
+	in_row_changed = false;
+
+	auto row = rows.find(id);
+	if(row == rows.end() || row->second != iter) {
+		rows_stale = true;
+		if(!change_reported)
+			reload_needed = true;
+	}
+}
+
+/*
+ * The dispatcher is only emitted for the first change queued, the others
+ * are applied with it.
+ */
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::onChange(const Backend::BackendFactory::Change& change) {
+	if(!change.template concerns<RecordType>())
+		return;
+	if(std::this_thread::get_id() == gui_thread) {
+		applyChange(change);
+		return;
+	}
+
+	bool first;
+	{
+		std::lock_guard<std::mutex> lck {queued_changes_mutex};
+		first = queued_changes.empty();
+		queued_changes.push_back(change);
+	}
+	if(first)
+		queued_changes_dispatcher.emit();
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::applyQueuedChanges() {
+	std::vector<Backend::BackendFactory::Change> changes;
+	{
+		std::lock_guard<std::mutex> lck {queued_changes_mutex};
+		changes.swap(queued_changes);
+	}
+	try {
+		for(const auto& change : changes)
+			applyChange(change);
+	}
+	catch (const DatabaseInterface::missing_entry&) {
+		reload();
+	}
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::applyChange(const Backend::BackendFactory::Change& change) {
+	using Type = Backend::BackendFactory::Change::Type;
+	if(in_row_changed) {
+		if(change.id == (*changed_row)[getColumns().id])
+			change_reported = true;
+		if(change.type == Type::MOVED)
+			if(auto row = rows.find(change.id); row != rows.end() && parentID(row->second) != change.parent) {
+				for(auto ancestor = row->second->parent(); ancestor; ancestor = ancestor->parent()) {
+					int ancestor_id = (*ancestor)[getColumns().id];
+					stale_ancestors.insert(ancestor_id);
+				}
+				dropped.push_back(change.id);
+			}
+		return;
+	}
+
+	switch(change.type) {
+	case Type::ADDED:
+		addRow(change.id, change.parent);
+		break;
+	case Type::UPDATED:
+		updateRow(change.id, change.parent);
+		break;
+	case Type::MOVED:
+		moveRow(change.id, change.parent);
+		break;
+	case Type::DELETED:
+		removeRow(change.id);
+		break;
+	case Type::PHOTOS_CHANGED:
+		refillRow(change.id, change.parent);
+		break;
+	}
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::addRow(int id, int parent) {
+	if(rows.contains(id))
+		return;
+	Gtk::TreeModel::iterator parent_iter;
+	if(parent) {
+		auto parent_row = rows.find(parent);
+		if(parent_row == rows.end())
+			return;
+		parent_iter = parent_row->second;
+	}
+
+	disconnectRowSignalChanged();
+	Gtk::TreeModel::iterator iter;
+	//if the children of the parent aren't loaded yet, the entry is loaded with them
+	if(!parent_iter || !hasPlaceholder(parent_iter)) {
+		iter = parent_iter ? append(parent_iter->children()) : append();
+		Gtk::TreeModel::Row row = *iter;
+		fillRow(id, row);
+		rows.insert_or_assign(id, iter);
+		// a moved entry keeps its descendants
+		fillChildren(id, row, backend.getNumberChildren<RecordType>(id) > 0);
+	}
+	refillAncestors(parent_iter);
+	connectRowSignalChanged();
+	if(iter)
+		expandIfNeeded(iter);
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::updateRow(int id, int parent) {
+	auto row = rows.find(id);
+	if(row == rows.end())
+		return;
+	if(parentID(row->second) != parent) {
+		moveRow(id, parent);
+		return;
+	}
+	disconnectRowSignalChanged();
+	Gtk::TreeModel::Row updated = *(row->second);
+	fillRow(id, updated);
+	connectRowSignalChanged();
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::moveRow(int id, int parent) {
+	auto row = rows.find(id);
+	if(row == rows.end() || parentID(row->second) == parent)
+		return;
+	removeRow(id);
+	addRow(id, parent);
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::removeRow(int id) {
+	auto row = rows.find(id);
+	if(row == rows.end())
+		return;
+	Gtk::TreeModel::iterator iter = row->second;
+	Gtk::TreeModel::iterator parent = iter->parent();
+	forgetRows(iter);
+
+	disconnectRowSignalChanged();
+	erase(iter);
+	refillAncestors(parent);
+	connectRowSignalChanged();
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::forgetRows(const Gtk::TreeModel::iterator& iter) {
+	int id = (*iter)[getColumns().id];
+	rows.erase(id);
+	for(Gtk::TreeModel::iterator child_iter = iter->children().begin(); child_iter; child_iter++)
+		forgetRows(child_iter);
+}
+
+/*
+ * The photo counts of the ancestors change too; if the row isn't loaded,
+ * the closest loaded ancestor is refilled.
+ */
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::refillRow(int id, int parent) {
+	auto row = rows.find(id);
+	while(row == rows.end() && parent) {
+		row = rows.find(parent);
+		if(row == rows.end())
+			parent = backend.template getEntry<RecordType>(parent).template access<0>();
+	}
+	if(row == rows.end())
+		return;
+
+	disconnectRowSignalChanged();
+	refillAncestors(row->second);
+	connectRowSignalChanged();
+}
+
+//the ancestors may show numbers including their descendants
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::refillAncestors(Gtk::TreeModel::iterator iter) {
+	for(; iter; iter = iter->parent()) {
+		Gtk::TreeModel::Row row = *iter;
+		fillRow(row[getColumns().id], row);
+	}
+}
+
+template<class TModelColumns, class RecordType>
+void BaseTreeStore<TModelColumns,RecordType>::expandIfNeeded(const Gtk::TreeModel::iterator& iter) {
+	auto parent = iter->parent();
+	if((*iter)[getColumns().expanded] && (!parent || (*parent)[getColumns().expanded]))
+		signalExpandRow().emit(get_path(iter), false);
+}
+
+template<class TModelColumns, class RecordType>
+int BaseTreeStore<TModelColumns,RecordType>::parentID(const Gtk::TreeModel::iterator& iter) {
+	auto parent = iter->parent();
+	return parent ? (*parent)[getColumns().id] : 0;
+}
+
 } /* namespace GUI */
 } /* namespace PhotoLibrary */
 
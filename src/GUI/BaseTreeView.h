@@ -22,7 +22,14 @@
 
 #include "BackendFactory.h"
 #include "Record/Options.h"
+#include <glibmm/main.h>
 #include <gtkmm/treeview.h>
+#include <exception>
+#include <iostream>
+#include <set>
+#include <span>
+#include <utility>
+#include <vector>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -30,6 +37,10 @@ namespace GUI {
 /**
  * Abstract base class for the TreeView|s in the left and right pane
  *
+ * Expanding and collapsing rows is saved in the backend when the main loop
+ * is idle, with one update for all rows changed in the meantime (e.g. a row
+ * and all its expanded descendants).
+ *
  * @see https://developer.gnome.org/gtkmm/stable/classGtk_1_1TreeView.html
  *
  * @tparam TStore BaseTreeStore based class to display in the TreeView
@@ -43,7 +54,7 @@ public:
 	 */
 	BaseTreeView(Backend::BackendFactory& backend);
 
-	virtual ~BaseTreeView() = default;
+	virtual ~BaseTreeView();
 
 	/**
 	 * Signal emitted when the selected row changed.
@@ -85,10 +96,28 @@ protected:
 
 	/**
 	 * Reload the TreeStore.
-	 * Reloads the TreeStore to apply changes
+	 * Reloads the TreeStore to apply changes the TreeStore does not follow
+	 * by itself, i.e. changes the backend doesn't report (see
+	 * Backend::BackendFactory::Change).
 	 */
 	void reloadTreeStore();
 
+	/**
+	 * Show only some entries and their ancestors, e.g. search results.
+	 * The ancestors are expanded (see BaseTreeStore::setFilter()).
+	 * Rows expanded or collapsed while the TreeStore is filtered are not
+	 * saved in the backend.
+	 *
+	 * @param matches ids of the entries to show
+	 * @param ancestors ids of all ancestors of 'matches'
+	 */
+	void filterTreeStore(std::span<const int> matches, std::span<const int> ancestors);
+
+	/**
+	 * Show all entries again (see filterTreeStore()).
+	 */
+	void unfilterTreeStore();
+
 	/**
 	 * Creates the TreeView.
 	 * Appends the columns to the TreeView.
@@ -104,11 +133,16 @@ private:
 	sigc::connection signal_row_collapsed_connection;
 	sigc::signal<void,int> signal_selection_changed;
 	int selection_id;
+	/// expansion changes not saved yet (see saveExpansionState())
+	std::set<int> expanded_rows;
+	std::set<int> collapsed_rows;
+	sigc::connection save_expansion_connection;
 
 	void onRowExpandedOrCollapsed(const Gtk::TreeModel::iterator& iter, const Gtk::TreeModel::Path& path);
 	void connectOnRowExpandedOrCollapsed();
 	void disconnectOnRowExpandedOrCollapsed();
 	void onRowExpanded(const Gtk::TreeModel::iterator& iter, const Gtk::TreeModel::Path& path);
+	bool saveExpansionState();
 	void expandChildren(const Gtk::TreeModel::iterator &iter);
 	bool onSignalExpandRow(const Gtk::TreeModel::Path& path, bool open_all);
 	void onDragBegin(const Glib::RefPtr<Gdk::DragContext>& context);
@@ -125,6 +159,17 @@ BaseTreeView<TStore,RecordType>::BaseTreeView(Backend::BackendFactory& backend)
 	initialise();
 }
 
+template<class TStore, class RecordType>
+BaseTreeView<TStore,RecordType>::~BaseTreeView() {
+	save_expansion_connection.disconnect();
+	try {
+		saveExpansionState();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Expansion state could not be saved: " << e.what() << '\n';
+	}
+}
+
 template<class TStore, class RecordType>
 void BaseTreeView<TStore, RecordType>::initialise() {
 	set_model(treeStore);
@@ -163,6 +208,7 @@ void BaseTreeView<TStore,RecordType>::disconnectOnRowExpandedOrCollapsed() {
 template<class TStore, class RecordType>
 void BaseTreeView<TStore,RecordType>::onRowExpanded(const Gtk::TreeModel::iterator& iter, const Gtk::TreeModel::Path& path) {
 	disconnectOnRowExpandedOrCollapsed();
+	getTreeStore()->loadChildren(iter);
 	expandChildren (iter);
 	connectOnRowExpandedOrCollapsed();
 	onRowExpandedOrCollapsed(iter, path);
@@ -170,12 +216,37 @@ void BaseTreeView<TStore,RecordType>::onRowExpanded(const Gtk::TreeModel::iterat
 
 template<class TStore, class RecordType>
 void BaseTreeView<TStore,RecordType>::onRowExpandedOrCollapsed(const Gtk::TreeModel::iterator& iter, const Gtk::TreeModel::Path& path) {
-	RecordType entry(getBackend().template getEntry<RecordType>((*iter)[getTreeStore()->getColumns().id]));
+	//the expansion of rows shown by a filter is only temporary
+	if(getTreeStore()->isFiltered())
+		return;
+	//rows expanded because the TreeStore asked for it are already marked as expanded
+	bool expanded = row_expanded(path);
+	if(expanded == static_cast<bool>((*iter)[getTreeStore()->getColumns().expanded]))
+		return;
+	getTreeStore()->setExpanded(iter, expanded);
+
+	int id = (*iter)[getTreeStore()->getColumns().id];
+	(expanded ? collapsed_rows : expanded_rows).erase(id);
+	(expanded ? expanded_rows : collapsed_rows).insert(id);
+	if(!save_expansion_connection.connected())
+		save_expansion_connection = Glib::signal_idle().connect(
+				sigc::mem_fun(*this, &BaseTreeView::saveExpansionState));
+}
 
-	(*iter)[getTreeStore()->getColumns().expanded] = !(*iter)[getTreeStore()->getColumns().expanded];
-	//change the ROW_EXPANDED bit for the entry and save change
-	entry.setOptions() ^= Backend::RecordClasses::RecordOptions::Options::ROW_EXPANDED;
-	getBackend().template updateEntry<RecordType>((*iter)[getTreeStore()->getColumns().id], entry);
+template<class TStore, class RecordType>
+bool BaseTreeView<TStore,RecordType>::saveExpansionState() {
+	using Backend::RecordClasses::RecordOptions::Options;
+	std::vector<int> expanded(expanded_rows.begin(), expanded_rows.end());
+	std::vector<int> collapsed(collapsed_rows.begin(), collapsed_rows.end());
+	expanded_rows.clear();
+	collapsed_rows.clear();
+	//the writes are queued, a drag or a rename must not wait for them
+	getBackend().queueWrite([expanded = std::move(expanded), collapsed = std::move(collapsed)]
+			(Backend::BackendFactory& backend) {
+		backend.template setOptionBits<RecordType>(expanded, Options::ROW_EXPANDED, true);
+		backend.template setOptionBits<RecordType>(collapsed, Options::ROW_EXPANDED, false);
+	});
+	return false;
 }
 
 template<class TStore, class RecordType>
@@ -187,6 +258,7 @@ void BaseTreeView<TStore,RecordType>::expandChildren(const Gtk::TreeModel::itera
 
 template<class TStore, class RecordType>
 bool BaseTreeView<TStore,RecordType>::onSignalExpandRow(const Gtk::TreeModel::Path& path, bool open_all) {
+	getTreeStore()->loadChildren(getTreeStore()->get_iter(path));
 	bool successful = expand_row(path, open_all);
 	expandChildren(getTreeStore()->get_iter(path));
 	return successful;
@@ -199,7 +271,7 @@ void BaseTreeView<TStore,RecordType>::onDragBegin(const Glib::RefPtr<Gdk::DragCo
 
 template<class TStore, class RecordType>
 void BaseTreeView<TStore,RecordType>::onDragEnd(const Glib::RefPtr<Gdk::DragContext>& context) {
-	getTreeStore()->reload();
+	getTreeStore()->updateAfterDrop();
 	connectOnRowExpandedOrCollapsed();
 }
 
@@ -210,6 +282,20 @@ void BaseTreeView<TStore,RecordType>::reloadTreeStore() {
 	connectOnRowExpandedOrCollapsed();
 }
 
+template<class TStore, class RecordType>
+void BaseTreeView<TStore,RecordType>::filterTreeStore(std::span<const int> matches, std::span<const int> ancestors) {
+	disconnectOnRowExpandedOrCollapsed();
+	getTreeStore()->setFilter(matches, ancestors);
+	connectOnRowExpandedOrCollapsed();
+}
+
+template<class TStore, class RecordType>
+void BaseTreeView<TStore,RecordType>::unfilterTreeStore() {
+	disconnectOnRowExpandedOrCollapsed();
+	getTreeStore()->clearFilter();
+	connectOnRowExpandedOrCollapsed();
+}
+
 template<class TStore, class RecordType>
 sigc::signal<void,int> BaseTreeView<TStore,RecordType>::signalSelectionChanged() {
 	return signal_selection_changed;
@@ -18,10 +18,12 @@
  */
 
 #include "CentrePane.h"
+#include "Thumbnail.h"
 #include <giomm/resource.h>
 #include <filesystem>
 #include <iostream>
 #include <typeinfo>
+#include <vector>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -34,7 +36,9 @@ CentrePane::CentrePane(Backend::BackendFactory* backend) :
 		tiles_per_row(0) {
 	flowbox.set_homogeneous(true);
 	flowbox.set_activate_on_single_click(true);
+	flowbox.set_selection_mode(Gtk::SELECTION_MULTIPLE);
 	flowbox.set_column_spacing(0);
+	flowbox.signal_selected_children_changed().connect(sigc::mem_fun(*this, &CentrePane::onSelectedChildrenChanged));
 
 	//put the flowbox inside a box so that the child widgets aren't expanded vertically
 	add(box);
@@ -77,6 +81,8 @@ void CentrePane::fillGrid(std::vector<int> photos) {
 	dispatcher_connection.disconnect();
 
 	abortThreads();
+	// emit the (empty) selection once instead of once per removed tile
+	flowbox.unselect_all();
 	for(auto& tile : tiles)
 		flowbox.remove(*(tile.second));
 	tiles.clear();
@@ -103,16 +109,25 @@ void CentrePane::onSizeAllocate(Gdk::Rectangle& allocation) {
 	calculateTilePerRow();
 }
 
+void CentrePane::onSelectedChildrenChanged() {
+	std::vector<int> photos;
+	for(Gtk::FlowBoxChild* child : flowbox.get_selected_children())
+		if(auto tile = dynamic_cast<PhotoTile*>(child->get_child()))
+			photos.push_back(tile->getPhotoId());
+	signalSelectionChanged().emit(photos);
+}
+
 void CentrePane::loadPhotos(CentrePane* object) {
 	for(int photo_id; object->tiles_to_update.pop(photo_id);) try {
 		Glib::ustring filename = object->tiles.at(photo_id)->getFilename();
 		if(std::filesystem::exists(filename.c_str())) { // @suppress("Invalid arguments")
 			try {
 				int size = object->backend->getWindowProperty(BackendFactory::WindowProperties::TILE_WIDTH);
-				auto photo_image = Gdk::Pixbuf::create_from_file(filename, size, size, true);
-				/// \todo use emplace?
-				object->loaded_images.push(std::make_pair(photo_id, photo_image));
-				object->image_dispatcher.emit();
+				if(auto photo_image = loadThumbnail(filename, size)) {
+					/// \todo use emplace?
+					object->loaded_images.push(std::make_pair(photo_id, photo_image));
+					object->image_dispatcher.emit();
+				}
 			}
 			catch (const Gio::ResourceError &e) {
 				std::cerr << "ResourceError: " << e.what() << std::endl;
@@ -120,13 +135,16 @@ void CentrePane::loadPhotos(CentrePane* object) {
 			catch (const Gdk::PixbufError &e) {
 				std::cerr << "PixbufError: " << e.what() << std::endl;
 			}
+			catch (const Glib::FileError &e) {
+				std::cerr << "FileError: " << e.what() << std::endl;
+			}
 		}
 	}
 	catch (std::out_of_range&) {}
 }
 
 void CentrePane::updateDisplayedImage() try {
-	if(std::pair<int,Glib::RefPtr<Gdk::Pixbuf>> image; loaded_images.pop(image))
+	if(std::pair<int,Cairo::RefPtr<Cairo::ImageSurface>> image; loaded_images.pop(image))
 		tiles.at(image.first)->setPhoto(image.second);
 }
 catch (std::out_of_range&) {}
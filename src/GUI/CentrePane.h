@@ -37,7 +37,6 @@ namespace GUI {
  * Grid view for the pane in the centre of the window.
  *
  * \todo move to GridView class and implement other display styles
- * \todo research memory usage of Gdk::Pixbuf and consider different implementation
  */
 class CentrePane: public Gtk::ScrolledWindow {
 public:
@@ -56,27 +55,47 @@ public:
 	 */
 	void fillGrid(std::vector<int> photos);
 
+	/**
+	 * Signal emitted when the selection of photos changed.
+	 *
+	 * @return sigc::signal; use connect() to connect a signal handler
+	 * @see https://developer.gnome.org/libsigc++/stable/group__signal.html
+	 *
+	 * \par Prototype
+	 * void onSelectionChanged(const std::vector<int>& photos)
+	 * @param photos ids of the selected photos (empty if no photo is selected)
+	 */
+	inline sigc::signal<void,const std::vector<int>&> signalSelectionChanged();
+
 private:
 	Backend::BackendFactory* backend;
 	Gtk::VBox box;
 	Gtk::FlowBox flowbox;
 	std::unordered_map<int,std::unique_ptr<PhotoTile>> tiles;
 	Support::ThreadSafeQueue<int> tiles_to_update;
-	Support::ThreadSafeQueue<std::pair<int,Glib::RefPtr<Gdk::Pixbuf>>> loaded_images;
+	Support::ThreadSafeQueue<std::pair<int,Cairo::RefPtr<Cairo::ImageSurface>>> loaded_images;
 	Glib::Dispatcher image_dispatcher;
 	std::vector<std::thread> threads;
 	int tiles_per_row;
 
 	sigc::connection size_allocation_connection;
 	sigc::connection dispatcher_connection;
+	sigc::signal<void,const std::vector<int>&> signal_selection_changed;
 
 	void onSizeAllocate(Gdk::Rectangle& allocation);
+	void onSelectedChildrenChanged();
 	void calculateTilePerRow();
 	static void loadPhotos(CentrePane* object);
 	void abortThreads();
 	void updateDisplayedImage();
 };
 
+
+//implementation
+sigc::signal<void,const std::vector<int>&> CentrePane::signalSelectionChanged() {
+	return signal_selection_changed;
+}
+
 } /* namespace GUI */
 } /* namespace PhotoLibrary */
 
@@ -29,8 +29,6 @@ namespace GUI {
  * The TreeModel::ColumnRecord for the directory TreeView
  *
  * @see https://developer.gnome.org/gtkmm/stable/classGtk_1_1TreeModelColumnRecord.html
- *
- * \todo add number of photos
  */
 class DirectoryModelColumns : public Gtk::TreeModel::ColumnRecord {
 public:
@@ -46,8 +44,7 @@ public:
 	Gtk::TreeModelColumn<int> id;	/**< The id of the directory */
 	Gtk::TreeModelColumn<Glib::ustring> name;	/**< The (short) name of the directory */
 	Gtk::TreeModelColumn<bool> expanded;	/**< Whether subdierectories should be shown in the TreeView */
-	/// \todo include subdirectories
-	Gtk::TreeModelColumn<int> photo_count;	/**< Number of photos in the directory */
+	Gtk::TreeModelColumn<int> photo_count;	/**< Number of photos in the directory including subdirectories */
 };
 
 } /* namespace GUI */
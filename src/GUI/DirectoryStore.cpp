@@ -19,7 +19,6 @@
 
 #include "DirectoryStore.h"
 #include "Record/DirectoryRecord.h"
-#include "Record/PhotoRecord.h"
 #include <gtkmm/messagedialog.h>
 
 namespace PhotoLibrary {
@@ -42,7 +41,7 @@ void DirectoryStore::fillRow(int id, Gtk::TreeModel::Row &row) {
 	row[getColumns().id] = id;
 	row[getColumns().name] = directory.getDirectory();
 	row[getColumns().expanded] = directory.getOptions() & DirectoryRecord::Options::ROW_EXPANDED;
-	row[getColumns().photo_count] = getBackend().getNumberChildren<Backend::RecordClasses::PhotoRecord>(id);
+	row[getColumns().photo_count] = getBackend().getNumberPhotos<DirectoryRecord>(id);
 }
 
 } /* namespace GUI */
@@ -18,6 +18,10 @@
  */
 
 #include "DirectoryView.h"
+#include <glibmm/main.h>
+#include <gtkmm/filechooserdialog.h>
+#include <gtkmm/messagedialog.h>
+#include <exception>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -28,12 +32,30 @@ DirectoryView::DirectoryView(Backend::BackendFactory* backend) :
 	unset_rows_drag_dest();
 
 	createView();
+
+	menu_item_import_directory = Gtk::MenuItem("_Import Directory...", true);
+	menu_item_import_directory.signal_activate().connect(sigc::mem_fun(*this, &DirectoryView::onMenuImportDirectory));
+	popup_menu.append(menu_item_import_directory);
+	menu_item_rescan_directories = Gtk::MenuItem("_Rescan Directories", true);
+	menu_item_rescan_directories.signal_activate().connect(sigc::mem_fun(*this, &DirectoryView::onMenuRescanDirectories));
+	popup_menu.append(menu_item_rescan_directories);
+	popup_menu.accelerate(*this);
+	popup_menu.show_all();
+	import_finished_dispatcher.connect(sigc::mem_fun(*this, &DirectoryView::onImportFinished));
 //	getTreeStore()->signalExpandRow().connect(sigc::mem_fun(*this, &DirectoryView::onSignalExpandRow));
 //	getTreeStore()->initialise();
 
 //	connectOnRowExpandedOrCollapsed();
 }
 
+DirectoryView::~DirectoryView() {
+	import_progress_connection.disconnect();
+	if(import_thread.joinable()) {
+		importer->cancel();
+		import_thread.join();
+	}
+}
+
 void DirectoryView::createView() {
 	DirectoryStore::ModelColumns& columns = getTreeStore()->getColumns();
 	//Add the TreeView's view columns:
@@ -42,5 +64,115 @@ void DirectoryView::createView() {
 	get_column_cell_renderer(col_count-1)->set_alignment(1, .5);
 }
 
+bool DirectoryView::on_button_press_event(GdkEventButton* button_event) {
+	bool return_value = TreeView::on_button_press_event(button_event);
+
+	if (button_event->type == GDK_BUTTON_PRESS && button_event->button == 3)
+		popup_menu.popup_at_pointer((GdkEvent*) button_event);
+
+	return return_value;
+}
+
+void DirectoryView::onMenuImportDirectory() {
+	/// \todo prepare for internationalisation
+	Gtk::FileChooserDialog dialogue("Import directory", Gtk::FILE_CHOOSER_ACTION_SELECT_FOLDER);
+	dialogue.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+	dialogue.add_button("_Import", Gtk::RESPONSE_OK);
+	if(dialogue.run() != Gtk::RESPONSE_OK)
+		return;
+	dialogue.hide();
+
+	startImport({dialogue.get_filename()}, false);
+}
+
+/*
+ * Reading the top level directories is cheap, the rescan itself runs in
+ * the background.
+ */
+void DirectoryView::onMenuRescanDirectories() {
+	using Backend::RecordClasses::DirectoryRecord;
+	std::vector<std::string> roots;
+	// top level directories hold their absolute path
+	for(int id : getBackend().getChildren<DirectoryRecord>(0))
+		roots.push_back(getBackend().getEntry<DirectoryRecord>(id).getFullDirectory().raw());
+	startImport(std::move(roots), true);
+}
+
+/*
+ * The importer writes in 'import_thread'; the TreeStore follows the
+ * directories it adds and removes through the changes reported by the
+ * backend. Only one import runs at a time, the menu items are disabled
+ * meanwhile.
+ */
+void DirectoryView::startImport(std::vector<std::string> roots, bool rescan) {
+	menu_item_import_directory.set_sensitive(false);
+	menu_item_rescan_directories.set_sensitive(false);
+	rescanning = rescan;
+	import_added = 0;
+	import_errors = 0;
+	import_failures.clear();
+	importer = std::make_unique<Backend::PhotoImporter>(getBackend(),
+			getBackend().getWindowProperty(Backend::BackendFactory::WindowProperties::N_THREADS));
+
+	import_thread = std::thread([this, roots = std::move(roots), rescan]() {
+		for(const auto& root : roots) {
+			try {
+				auto statistics = rescan ? importer->rescanDirectory(root) : importer->importDirectory(root);
+				import_added += statistics.photos_added;
+				import_errors += statistics.errors;
+			}
+			catch (std::exception& e) {
+				import_failures.emplace_back(root, e.what());
+			}
+		}
+		import_finished_dispatcher.emit();
+	});
+	import_progress_connection = Glib::signal_timeout().connect(
+			sigc::mem_fun(*this, &DirectoryView::onImportProgress), 250);
+	onImportProgress();
+}
+
+bool DirectoryView::onImportProgress() {
+	auto progress = importer->getProgress();
+	/// \todo prepare for internationalisation
+	signal_import_progress.emit(std::string(rescanning ? "Rescanning: " : "Importing: ") +
+			std::to_string(progress.directories) + " directories, " + std::to_string(progress.files) + " photos");
+	return true;
+}
+
+void DirectoryView::onImportFinished() {
+	import_thread.join();
+	import_progress_connection.disconnect();
+	importer.reset();
+	menu_item_import_directory.set_sensitive(true);
+	menu_item_rescan_directories.set_sensitive(true);
+	signal_import_progress.emit("");
+	signal_directories_imported.emit();
+
+	/// \todo prepare for internationalisation
+	if(rescanning) {
+		if(import_failures.empty() && !import_errors)
+			return;
+		std::string failed;
+		for(const auto& [root, message] : import_failures)
+			failed += "\n" + root;
+		Gtk::MessageDialog message_dialogue("Some directories could not be rescanned");
+		message_dialogue.set_secondary_text(std::to_string(import_errors) + " files or directories could not be read." +
+				(failed.empty() ? "" : "\nNot found:" + failed));
+		message_dialogue.run();
+	}
+	else if(!import_failures.empty()) {
+		Gtk::MessageDialog message_dialogue("Directory could not be imported");
+		message_dialogue.set_secondary_text(import_failures.front().second);
+		message_dialogue.run();
+	}
+	else if(import_errors) {
+		Gtk::MessageDialog message_dialogue("Some files could not be read");
+		message_dialogue.set_secondary_text(std::to_string(import_added) + " photos were added, " +
+				std::to_string(import_errors) + " files or directories could not be read.");
+		message_dialogue.run();
+	}
+}
+
 } /* namespace GUI */
 } /* namespace PhotoLibrary */
@@ -22,6 +22,14 @@
 
 #include "BaseTreeView.h"
 #include "DirectoryStore.h"
+#include "PhotoImporter.h"
+#include <glibmm/dispatcher.h>
+#include <gtkmm/menu.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -36,10 +44,63 @@ public:
 	 * @param backend the backend interface factory object
 	 */
 	DirectoryView(Backend::BackendFactory* backend);
-	virtual ~DirectoryView() = default;
+
+	/**
+	 * Cancels an import running in the background and waits for it.
+	 */
+	virtual ~DirectoryView();
+
+	/**
+	 * Signal emitted after directories were imported or rescanned.
+	 *
+	 * @return sigc::signal; use connect() to connect a signal handler
+	 *
+	 * \par Prototype
+	 * void onDirectoriesImported()
+	 */
+	inline sigc::signal<void> signalDirectoriesImported() { return signal_directories_imported; }
+
+	/**
+	 * Signal emitted while directories are imported or rescanned.
+	 * Imports run in the background; the signal is emitted regularly
+	 * while they run and once they finished.
+	 *
+	 * @return sigc::signal; use connect() to connect a signal handler
+	 *
+	 * \par Prototype
+	 * void onImportProgress(const Glib::ustring& text)
+	 * @param text description of the progress, empty once the import
+	 * 		finished
+	 */
+	inline sigc::signal<void,const Glib::ustring&> signalImportProgress() { return signal_import_progress; }
 
 private:
 	void createView() override;
+
+	bool on_button_press_event(GdkEventButton* button_event) override;
+	void onMenuImportDirectory();
+	void onMenuRescanDirectories();
+	void startImport(std::vector<std::string> roots, bool rescan);
+	bool onImportProgress();
+	void onImportFinished();
+
+	Gtk::Menu popup_menu;
+	Gtk::MenuItem menu_item_import_directory;
+	Gtk::MenuItem menu_item_rescan_directories;
+	sigc::signal<void> signal_directories_imported;
+	sigc::signal<void,const Glib::ustring&> signal_import_progress;
+
+	/// import running in the background (see startImport())
+	std::unique_ptr<Backend::PhotoImporter> importer;
+	std::thread import_thread;
+	Glib::Dispatcher import_finished_dispatcher;
+	sigc::connection import_progress_connection;
+	bool rescanning = false;
+	/// results of the import, written by 'import_thread'
+	int import_added = 0;
+	int import_errors = 0;
+	/// roots that couldn't be imported with the error messages
+	std::vector<std::pair<std::string,std::string>> import_failures;
 };
 
 } /* namespace GUI */
@@ -28,7 +28,9 @@ namespace GUI {
 
 using Backend::RecordClasses::KeywordRecord;
 
-KeywordsStore::KeywordsStore(Backend::BackendFactory& backend) : BaseTreeStore(backend) {}
+KeywordsStore::KeywordsStore(Backend::BackendFactory& backend) :
+		BaseTreeStore(backend),
+		n_selected_photos(0) {}
 
 Glib::RefPtr<KeywordsStore> KeywordsStore::create(Backend::BackendFactory* db) {
 	return Glib::RefPtr<KeywordsStore>(new KeywordsStore(*db));
@@ -52,10 +54,36 @@ void KeywordsStore::fillRow(int id, Gtk::TreeModel::Row &row) {
 	KeywordRecord keyword(getBackend().getEntry<KeywordRecord>(id));
 	row[getColumns().id] = id;
 	row[getColumns().keyword] = keyword.getKeyword();
-	row[getColumns().assigned] = false; /// \todo connect to selected photos
-	row[getColumns().inconsistent] = false;
+	fillAssigned(id, row);
 	row[getColumns().expanded] = keyword.getOptions() & KeywordRecord::Options::ROW_EXPANDED;
 }
 
+void KeywordsStore::fillAssigned(int id, Gtk::TreeModel::Row &row) {
+	auto number = selected_photos_per_keyword.find(id);
+	std::size_t n_photos = number != selected_photos_per_keyword.end() ? number->second : 0;
+	bool assigned = n_photos && n_photos == n_selected_photos;
+	bool inconsistent = n_photos && n_photos < n_selected_photos;
+	// only touch rows that actually change to avoid needless redraws
+	if(row[getColumns().assigned] != assigned)
+		row[getColumns().assigned] = assigned;
+	if(row[getColumns().inconsistent] != inconsistent)
+		row[getColumns().inconsistent] = inconsistent;
+}
+
+void KeywordsStore::setSelectedPhotos(const std::vector<int>& photos) {
+	selected_photos_per_keyword =
+			getBackend().getNumberEntriesPerCollection<Backend::BackendFactory::Relations::PHOTOS_KEYWORDS>(photos);
+	n_selected_photos = photos.size();
+
+	// the columns are for display only, don't write them back to the backend
+	disconnectRowSignalChanged();
+	foreach_iter([this](const Gtk::TreeModel::iterator& iter) {
+		Gtk::TreeModel::Row row = *iter;
+		fillAssigned(row[getColumns().id], row);
+		return false;
+	});
+	connectRowSignalChanged();
+}
+
 } /* namespace Backend */
 } /* namespace PhotoLibrary */
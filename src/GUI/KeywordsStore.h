@@ -25,6 +25,8 @@
 #include "BackendFactory.h"
 #include "Record/KeywordRecord.h"
 #include <gtkmm/treestore.h>
+#include <unordered_map>
+#include <vector>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -45,6 +47,18 @@ public:
 	 */
 	static Glib::RefPtr<KeywordsStore> create(Backend::BackendFactory* db);
 
+	/**
+	 * Set the photos selected in the grid view.
+	 * Updates the 'assigned' and 'inconsistent' columns of all rows:
+	 * a keyword is 'assigned' if it is assigned to all selected photos
+	 * and 'inconsistent' if it is assigned to some, but not all, of them.
+	 * The number of selected photos per keyword is retrieved with a
+	 * single querry and all rows are updated in one pass.
+	 *
+	 * @param photos Ids of the selected photos
+	 */
+	void setSelectedPhotos(const std::vector<int>& photos);
+
 	//no copying or moving
 	KeywordsStore(const KeywordsStore &other) = delete;
 	KeywordsStore(KeywordsStore &&other) = delete;
@@ -52,9 +66,13 @@ public:
 	KeywordsStore& operator=(KeywordsStore &&other) = delete;
 
 private:
+	std::unordered_map<int,int> selected_photos_per_keyword;
+	std::size_t n_selected_photos;
+
 	KeywordsStore(Backend::BackendFactory& backend);
 
 	void fillRow(int id, Gtk::TreeModel::Row &row) override;
+	void fillAssigned(int id, Gtk::TreeModel::Row &row);
 
 	/// \todo discriminate between drag'n'drop and expansion/collapsing of a row
 	void onRowChanged(const TreeModel::Path& path, const TreeModel::iterator& iter) override;
@@ -54,6 +54,14 @@ void KeywordsView::createView() {
 	append_column("Keyword", columns.keyword);
 }
 
+void KeywordsView::setFilter(const Glib::ustring& text) {
+	if(text.find_first_not_of(" \t\n") == Glib::ustring::npos) {
+		unfilterTreeStore();
+		return;
+	}
+	std::vector<int> matches = getBackend().searchKeywords(text.raw());
+	filterTreeStore(matches, getBackend().getAncestors<KeywordRecord>(matches));
+}
 
 bool KeywordsView::on_button_press_event(GdkEventButton* button_event) {
 	//Call base class, to allow normal handling,
@@ -104,7 +112,6 @@ void KeywordsView::onMenuAddNewKeyword() {
 	while(dialogue.run() == Gtk::RESPONSE_OK) {
 		try {
 			getBackend().newEntry(new_keyword);
-			reloadTreeStore();
 			return;
 		}
 		catch (DatabaseInterface::constraint_error& e) {
@@ -130,7 +137,6 @@ void KeywordsView::onMenuEditKeyword() {
 	while (dialogue.run() == Gtk::RESPONSE_OK) {
 		try {
 			getBackend().updateEntry((*iter)[getTreeStore()->getColumns().id], keyword);
-			reloadTreeStore();
 			return;
 		}
 		catch (DatabaseInterface::constraint_error &e) {
@@ -164,7 +170,6 @@ void KeywordsView::onMenuDeleteKeyword() {
 			"You cannot undo the action.");
 	if(delete_dialogue.run() == Gtk::RESPONSE_OK) {
 		getBackend().template deleteEntry<KeywordRecord>((*iter)[getTreeStore()->getColumns().id]);
-		reloadTreeStore();
 	}
 }
 
@@ -39,6 +39,24 @@ public:
 	KeywordsView(Backend::BackendFactory* backend);
 	~KeywordsView() = default;
 
+	/**
+	 * Set the photos selected in the grid view.
+	 * Shows which keywords are assigned to all or only some of the
+	 * selected photos.
+	 *
+	 * @param photos Ids of the selected photos
+	 */
+	inline void setSelectedPhotos(const std::vector<int>& photos);
+
+	/**
+	 * Show only the keywords matching a search and their ancestors.
+	 * Fast enough to be called on every keystroke
+	 * (see Backend::BackendFactory::searchKeywords()).
+	 *
+	 * @param text words to search for; empty to show all keywords
+	 */
+	void setFilter(const Glib::ustring& text);
+
 private:
 	void createView() override;
 	void fillPopupMenu();
@@ -51,6 +69,12 @@ private:
 	Gtk::Menu popup_menu;
 };
 
+
+//implementation
+void KeywordsView::setSelectedPhotos(const std::vector<int>& photos) {
+	getTreeStore()->setSelectedPhotos(photos);
+}
+
 } /* namespace GUI */
 } /* namespace PhotoLibrary */
 
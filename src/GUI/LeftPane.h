@@ -25,6 +25,7 @@
 #include "../Backend/BackendFactory.h"
 #include "DirectoryView.h"
 #include "AlbumView.h"
+#include "TimelineView.h"
 #include "SidePaneElement.h"
 
 namespace PhotoLibrary {
@@ -69,18 +70,63 @@ public:
 	 */
 	inline sigc::signal<void,int> signaleNewAlbumSelected();
 
+	/**
+	 * Signal emitted when a new period is selected in the TimelineView.
+	 *
+	 * @return sigc::signal; use connect() to connect a signal handler
+	 *
+	 * \par Prototype
+	 * void onNewDateSelected(int year, int month, int day)
+	 * @param year the selected year
+	 * @param month the selected month, 0 for a whole year
+	 * @param day the selected day, 0 for a whole year or month
+	 */
+	inline sigc::signal<void,int,int,int> signalNewDateSelected();
+
+	/**
+	 * Signal emitted after directories were imported or rescanned.
+	 *
+	 * @return sigc::signal; use connect() to connect a signal handler
+	 *
+	 * \par Prototype
+	 * void onDirectoriesImported()
+	 */
+	inline sigc::signal<void> signalDirectoriesImported();
+
+	/**
+	 * Signal emitted while directories are imported or rescanned in the
+	 * background (see DirectoryView::signalImportProgress()).
+	 *
+	 * @return sigc::signal; use connect() to connect a signal handler
+	 *
+	 * \par Prototype
+	 * void onImportProgress(const Glib::ustring& text)
+	 * @param text description of the progress, empty once the import
+	 * 		finished
+	 */
+	inline sigc::signal<void,const Glib::ustring&> signalImportProgress();
+
+	/**
+	 * Reload the timeline after photos were added or removed in the
+	 * backend; the directories follow the changes themselves.
+	 */
+	inline void reloadTimeline();
+
 private:
 	Backend::BackendFactory* backend;
 
 	Gtk::Box left_box;
 	SidePaneElement<DirectoryView> directories;
 	SidePaneElement<AlbumView> albums;
+	SidePaneElement<TimelineView> timeline;
 	sigc::signal<void,int> signal_new_directory_selected;
 	sigc::signal<void,int> signal_new_album_selected;
+	sigc::signal<void,int,int,int> signal_new_date_selected;
 
 	inline void onSizeAllocate(Gdk::Rectangle& allocation);
 	inline void onDirectorySelectionChanged(int id);
 	inline void onAlbumsSelectionChanged(int id);
+	inline void onTimelineSelectionChanged(int year, int month, int day);
 };
 
 //implementation
@@ -88,17 +134,20 @@ LeftPane::LeftPane(Backend::BackendFactory* backend) :
 		Gtk::ScrolledWindow(),
 		backend(backend),
 		directories("Directories", backend),
-		albums("Albums", backend) {
+		albums("Albums", backend),
+		timeline("Timeline", backend) {
 	add(left_box);
 	left_box.set_orientation(Gtk::ORIENTATION_VERTICAL);
 
 	left_box.add(directories);
 	left_box.add(albums);
+	left_box.add(timeline);
 
 	signal_size_allocate().connect(sigc::mem_fun(*this, &LeftPane::onSizeAllocate));
 
 	directories.getContent()->signalSelectionChanged().connect(sigc::mem_fun(*this, &LeftPane::onDirectorySelectionChanged));
 	albums.getContent()->signalSelectionChanged().connect(sigc::mem_fun(*this, &LeftPane::onAlbumsSelectionChanged));
+	timeline.getContent()->signalSelectionChanged().connect(sigc::mem_fun(*this, &LeftPane::onTimelineSelectionChanged));
 }
 
 /// \todo find a solution that isn't called every time any child widget changes
@@ -109,6 +158,7 @@ void LeftPane::onSizeAllocate(Gdk::Rectangle& allocation) {
 void LeftPane::onDirectorySelectionChanged(int id) {
 	if(id) {
 		albums.getContent()->unselectAll();
+		timeline.getContent()->unselectAll();
 		signaleNewDirectorySelected().emit(id);
 	}
 }
@@ -116,10 +166,19 @@ void LeftPane::onDirectorySelectionChanged(int id) {
 void LeftPane::onAlbumsSelectionChanged(int id) {
 	if(id) {
 		directories.getContent()->unselectAll();
+		timeline.getContent()->unselectAll();
 		signaleNewAlbumSelected().emit(id);
 	}
 }
 
+void LeftPane::onTimelineSelectionChanged(int year, int month, int day) {
+	if(year) {
+		directories.getContent()->unselectAll();
+		albums.getContent()->unselectAll();
+		signalNewDateSelected().emit(year, month, day);
+	}
+}
+
 sigc::signal<void,int> LeftPane::signaleNewDirectorySelected() {
 	return signal_new_directory_selected;
 }
@@ -128,6 +187,22 @@ sigc::signal<void,int> LeftPane::signaleNewAlbumSelected() {
 	return signal_new_album_selected;
 }
 
+sigc::signal<void,int,int,int> LeftPane::signalNewDateSelected() {
+	return signal_new_date_selected;
+}
+
+sigc::signal<void> LeftPane::signalDirectoriesImported() {
+	return directories.getContent()->signalDirectoriesImported();
+}
+
+sigc::signal<void,const Glib::ustring&> LeftPane::signalImportProgress() {
+	return directories.getContent()->signalImportProgress();
+}
+
+void LeftPane::reloadTimeline() {
+	timeline.getContent()->reload();
+}
+
 } /* namespace GUI */
 } /* namespace PhotoLibrary */
 
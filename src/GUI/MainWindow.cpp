@@ -18,7 +18,11 @@
  */
 
 #include "MainWindow.h"
-#include "Record/PhotoRecord.h"
+#include <glibmm/main.h>
+#include <gtkmm/messagedialog.h>
+#include <algorithm>
+#include <chrono>
+#include <utility>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -32,7 +36,11 @@ MainWindow::MainWindow(Backend::BackendFactory* backend) :
 		rightPane(Gtk::ORIENTATION_HORIZONTAL),
 		rightPaneBox(backend),
 		leftPaneBox(backend),
-		centrePaneBox(backend) {
+		centrePaneBox(backend),
+		watcher(*backend, [this]() { watcher_dispatcher.emit(); },
+				backend->getWindowProperty(Backend::BackendFactory::WindowProperties::N_THREADS)),
+		hasher(*backend, backend->getWindowProperty(Backend::BackendFactory::WindowProperties::N_THREADS)),
+		content_hasher(*backend, backend->getWindowProperty(Backend::BackendFactory::WindowProperties::N_THREADS)) {
 //	set_hide_titlebar_when_maximized(true);
 //	set_mnemonics_visible(true);
 	set_title("Photo Library");
@@ -47,8 +55,31 @@ MainWindow::MainWindow(Backend::BackendFactory* backend) :
 	show_all_children();
 
 	signal_check_resize().connect(sigc::mem_fun(*this,&MainWindow::onWindowResize));
+	Glib::signal_timeout().connect(sigc::mem_fun(*this, &MainWindow::onSaveSettingsTimeout), 500);
 	leftPaneBox.signaleNewDirectorySelected().connect(sigc::mem_fun(*this, &MainWindow::onNewDirectorySelected));
 	leftPaneBox.signaleNewAlbumSelected().connect(sigc::mem_fun(*this, &MainWindow::onNewAlbumSelected));
+	leftPaneBox.signalNewDateSelected().connect(sigc::mem_fun(*this, &MainWindow::onNewDateSelected));
+	centrePaneBox.signalSelectionChanged().connect(sigc::mem_fun(rightPaneBox, &RightPane::setSelectedPhotos));
+	filter_entry.signal_activate().connect(sigc::mem_fun(*this, &MainWindow::onFilterActivated));
+	duplicates_button.signal_clicked().connect(sigc::mem_fun(*this, &MainWindow::onFindDuplicates));
+	similar_button.signal_clicked().connect(sigc::mem_fun(*this, &MainWindow::onFindSimilar));
+	sort_combo.signal_changed().connect(sigc::mem_fun(*this, &MainWindow::onSortChanged));
+	sort_descending.signal_toggled().connect(sigc::mem_fun(*this, &MainWindow::onSortChanged));
+	watcher_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::onDirectoriesChanged));
+	sync_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::onSyncFinished));
+	write_error_dispatcher.connect(sigc::mem_fun(*this, &MainWindow::showWriteErrors));
+	backend->setWriteErrorHandler([this](std::exception_ptr error) { onWriteError(error); });
+	leftPaneBox.signalDirectoriesImported().connect(sigc::mem_fun(*this, &MainWindow::onDirectoriesImported));
+	leftPaneBox.signalImportProgress().connect(sigc::mem_fun(*this, &MainWindow::onImportProgress));
+	watch_pending = true;
+	startSync();
+}
+
+MainWindow::~MainWindow() {
+	if(sync_thread.joinable())
+		sync_thread.join();
+	// waits for a handler running in the writer thread
+	backend->setWriteErrorHandler(nullptr);
 }
 
 void MainWindow::fillWindow() {
@@ -66,6 +97,40 @@ void MainWindow::fillWindow() {
 	rightPane.pack1(centrePaneBox, true, false);
 	rightPane.pack2(rightPaneBox, false, false);
 
+	topPaneBox.add(top_bar);
+	top_bar.set_spacing(6);
+	top_bar.pack_start(import_progress, false, false);
+	top_bar.pack_end(filter_entry, false, false);
+	top_bar.pack_end(similar_button, false, false);
+	top_bar.pack_end(duplicates_button, false, false);
+	top_bar.pack_end(sort_descending, false, false);
+	top_bar.pack_end(sort_combo, false, false);
+	filter_entry.set_valign(Gtk::ALIGN_CENTER);
+	duplicates_button.set_valign(Gtk::ALIGN_CENTER);
+	similar_button.set_valign(Gtk::ALIGN_CENTER);
+	sort_descending.set_valign(Gtk::ALIGN_CENTER);
+	sort_combo.set_valign(Gtk::ALIGN_CENTER);
+	import_progress.set_valign(Gtk::ALIGN_CENTER);
+	import_progress.set_show_text(true);
+	import_progress.set_no_show_all(true);
+	/// \todo prepare for internationalisation
+	sort_combo.append("datetime", "Date taken");
+	sort_combo.append("rating", "Rating");
+	sort_combo.append("filename", "File name");
+	sort_combo.append("dimensions", "Size");
+	sort_combo.append("id", "Date added");
+	sort_combo.set_active_id("datetime");
+	sort_descending.set_image_from_icon_name("view-sort-descending");
+	sort_descending.set_tooltip_text("Descending order");
+	filter_entry.set_width_chars(50);
+	/// \todo prepare for internationalisation
+	filter_entry.set_placeholder_text("Filter, e.g. keyword:Venice AND rating>=3");
+	/// \todo prepare for internationalisation
+	duplicates_button.set_label("Find duplicates");
+	duplicates_button.set_tooltip_text("Show groups of identical files");
+	similar_button.set_label("Find similar");
+	similar_button.set_tooltip_text("Show groups of identical or very similar photos");
+
 	topPaneBox.set_size_request(-1, 50);
 	buttomPaneBox.set_size_request(-1, 150);
 	leftPaneBox.set_size_request(150, -1);
@@ -85,14 +150,238 @@ void MainWindow::onWindowResize() {
 	backend->setWindowProperty(Backend::BackendFactory::WindowProperties::WINDOW_HEIGHT, get_height());
 }
 
+/*
+ * Resizing the window or the panes changes the properties many times a
+ * second, they are saved once the changes stopped for a second.
+ */
+bool MainWindow::onSaveSettingsTimeout() {
+	backend->saveWindowProperties(std::chrono::seconds(1));
+	return true;
+}
+
 void MainWindow::onNewDirectorySelected(int id) {
-	centrePaneBox.fillGrid(backend->getChildren<Backend::RecordClasses::PhotoRecord>(id));
+	selected_directory = id;
+	selected_album = 0;
+	selected_year = 0;
+	showing_duplicates = false;
+	centrePaneBox.fillGrid(backend->getPhotos(id, getPhotoOrder(), sort_descending.get_active()));
 }
 
 void MainWindow::onNewAlbumSelected(int id) {
-	centrePaneBox.fillGrid(backend->getEntries<Backend::BackendFactory::Relations::PHOTOS_ALBUMS>(id));
+	selected_directory = 0;
+	selected_album = id;
+	selected_year = 0;
+	showing_duplicates = false;
+	centrePaneBox.fillGrid(backend->getEntries<Backend::BackendFactory::Relations::PHOTOS_ALBUMS>(
+			id, getPhotoOrder(), sort_descending.get_active()));
+}
+
+void MainWindow::onNewDateSelected(int year, int month, int day) {
+	selected_directory = 0;
+	selected_album = 0;
+	selected_year = year;
+	selected_month = month;
+	selected_day = day;
+	showing_duplicates = false;
+	centrePaneBox.fillGrid(backend->getPhotosTaken(year, month, day, getPhotoOrder(), sort_descending.get_active()));
+}
+
+void MainWindow::onFilterActivated() {
+	if(filter_entry.get_text().empty())
+		return;
+	try {
+		filtered_photos = backend->filterPhotos(filter_entry.get_text().raw());
+		selected_directory = 0;
+		selected_album = 0;
+		selected_year = 0;
+		showing_duplicates = false;
+		centrePaneBox.fillGrid(backend->sortPhotos(filtered_photos, getPhotoOrder(), sort_descending.get_active()));
+		filter_entry.get_style_context()->remove_class("error");
+		filter_entry.set_tooltip_text("");
+	}
+	catch (const Backend::filter_error& e) {
+		filter_entry.get_style_context()->add_class("error");
+		filter_entry.set_tooltip_text(e.what());
+	}
+}
+
+/*
+ * The hashes computed so far are queued by the threads of the hashers,
+ * they are flushed so that all of them are searched.
+ */
+void MainWindow::onFindDuplicates() {
+	backend->flushWrites();
+	showPhotoGroups(backend->findDuplicatePhotos());
+}
+
+void MainWindow::onFindSimilar() {
+	backend->flushWrites();
+	showPhotoGroups(backend->findSimilarPhotos());
+}
+
+void MainWindow::showPhotoGroups(const std::vector<std::vector<int>>& groups) {
+	filtered_photos.clear();
+	for(const auto& group : groups)
+		filtered_photos.insert(filtered_photos.end(), group.begin(), group.end());
+	selected_directory = 0;
+	selected_album = 0;
+	selected_year = 0;
+	showing_duplicates = true;
+	centrePaneBox.fillGrid(filtered_photos);
+}
+
+void MainWindow::onSortChanged() {
+	if(selected_directory)
+		onNewDirectorySelected(selected_directory);
+	else if(selected_album)
+		onNewAlbumSelected(selected_album);
+	else if(selected_year)
+		onNewDateSelected(selected_year, selected_month, selected_day);
+	else if(showing_duplicates)
+		centrePaneBox.fillGrid(filtered_photos);
+	else
+		centrePaneBox.fillGrid(backend->sortPhotos(filtered_photos, getPhotoOrder(), sort_descending.get_active()));
+}
+
+Backend::BackendFactory::PhotoOrder MainWindow::getPhotoOrder() {
+	using PhotoOrder = Backend::BackendFactory::PhotoOrder;
+	Glib::ustring order = sort_combo.get_active_id();
+	if(order == "rating")
+		return PhotoOrder::RATING;
+	if(order == "filename")
+		return PhotoOrder::FILENAME;
+	if(order == "dimensions")
+		return PhotoOrder::DIMENSIONS;
+	if(order == "id")
+		return PhotoOrder::ID;
+	return PhotoOrder::DATETIME;
+}
+
+/*
+ * Changes reported while a synchronisation runs are applied by the next
+ * one, which is started when it finished.
+ */
+void MainWindow::onDirectoriesChanged() {
+	if(sync_thread.joinable())
+		sync_pending = true;
+	else
+		startSync();
+}
+
+void MainWindow::onDirectoriesImported() {
+	watch_pending = true;
+	leftPaneBox.reloadTimeline();
+	onDirectoriesChanged();
+}
+
+/*
+ * The watcher is only used in 'sync_thread'. The hashers are restarted
+ * there too, since starting them waits for their running threads and the
+ * queued writes and reads all photos without a hash.
+ */
+void MainWindow::startSync() {
+	bool watch = std::exchange(watch_pending, false);
+	sync_thread = std::thread([this, watch]() {
+		try {
+			if(watch)
+				watcher.watch();
+			synced = watcher.processChanges();
+			if(watch || !synced.empty()) {
+				hasher.start();
+				content_hasher.start();
+			}
+		}
+		catch (...) {
+			sync_error = std::current_exception();
+		}
+		sync_dispatcher.emit();
+	});
+}
+
+/*
+ * The directories follow the changes made by the synchronisation through
+ * the changes reported by the backend (see BaseTreeStore).
+ */
+void MainWindow::onSyncFinished() {
+	sync_thread.join();
+	std::vector<int> changed = std::exchange(synced, {});
+	std::exception_ptr error = std::exchange(sync_error, nullptr);
+	if(std::exchange(sync_pending, false))
+		startSync();
+
+	if(!changed.empty()) {
+		leftPaneBox.reloadTimeline();
+		if(std::find(changed.begin(), changed.end(), selected_directory) != changed.end())
+			onNewDirectorySelected(selected_directory);
+	}
+	if(!error)
+		return;
+	std::string message;
+	try {
+		std::rethrow_exception(error);
+	}
+	catch (const std::exception& e) {
+		message = e.what();
+	}
+	catch (...) {
+		/// \todo prepare for internationalisation
+		message = "unknown error";
+	}
+	/// \todo prepare for internationalisation
+	Gtk::MessageDialog message_dialogue(*this, "Directories could not be synchronised", false, Gtk::MESSAGE_ERROR);
+	message_dialogue.set_secondary_text(message);
+	message_dialogue.run();
+}
+
+/*
+ * The number of photos isn't known before the walk is finished, so the
+ * progress bar only pulses.
+ */
+void MainWindow::onImportProgress(const Glib::ustring& text) {
+	import_progress.set_visible(!text.empty());
+	import_progress.set_text(text);
+	import_progress.pulse();
 }
 
+/*
+ * Called in the writer thread, the errors are shown by the GUI thread.
+ */
+void MainWindow::onWriteError(std::exception_ptr error) {
+	std::string message;
+	try {
+		std::rethrow_exception(error);
+	}
+	catch (const std::exception& e) {
+		message = e.what();
+	}
+	catch (...) {
+		/// \todo prepare for internationalisation
+		message = "unknown error";
+	}
+	{
+		std::lock_guard<std::mutex> lck {write_errors_mutex};
+		write_errors.push_back(std::move(message));
+	}
+	write_error_dispatcher.emit();
+}
+
+void MainWindow::showWriteErrors() {
+	std::vector<std::string> errors;
+	{
+		std::lock_guard<std::mutex> lck {write_errors_mutex};
+		errors.swap(write_errors);
+	}
+	if(errors.empty())
+		return;
+
+	std::string text;
+	for(const auto& error : errors)
+		text += error + "\n";
+	/// \todo prepare for internationalisation
+	Gtk::MessageDialog message_dialogue(*this, "Changes could not be saved", false, Gtk::MESSAGE_ERROR);
+	message_dialogue.set_secondary_text(text);
+	message_dialogue.run();
+}
 
 } /* namespace GUI */
 } /* namespace PhotoLibrary */
@@ -25,9 +25,23 @@
 #include <gtkmm/scrolledwindow.h>
 #include <gtkmm/box.h>
 #include <gtkmm/frame.h>
+#include <gtkmm/button.h>
+#include <gtkmm/searchentry.h>
+#include <gtkmm/comboboxtext.h>
+#include <gtkmm/togglebutton.h>
+#include <gtkmm/progressbar.h>
+#include <glibmm/dispatcher.h>
+#include "ContentHasher.h"
+#include "DirectoryWatcher.h"
 #include "RightPane.h"
 #include "LeftPane.h"
 #include "CentrePane.h"
+#include "PhotoHasher.h"
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -41,7 +55,12 @@ public:
 	 * @param backend Pointer to the backend factory object
 	 */
 	MainWindow(Backend::BackendFactory* backend);
-	~MainWindow() = default;
+
+	/**
+	 * Waits for a running synchronisation of the watched directories and
+	 * removes the handler of failed queued writes.
+	 */
+	~MainWindow();
 
 private:
 	Backend::BackendFactory* backend;
@@ -59,11 +78,63 @@ private:
 	Gtk::Frame topPaneBox;
 	Gtk::Frame buttomPaneBox;
 //	Gtk::Frame centerPaneBox;
+	Gtk::Box top_bar;
+	Gtk::ComboBoxText sort_combo;
+	Gtk::ToggleButton sort_descending;
+	Gtk::SearchEntry filter_entry;
+	Gtk::Button duplicates_button;
+	Gtk::Button similar_button;
+	/// shown while directories are imported in the background
+	Gtk::ProgressBar import_progress;
+
+	/// wakes the GUI thread when the watcher has changes
+	Glib::Dispatcher watcher_dispatcher;
+	Backend::DirectoryWatcher watcher;
+	PhotoHasher hasher;
+	Backend::ContentHasher content_hasher;
+	/// synchronises the watched directories and restarts the hashers (see startSync())
+	std::thread sync_thread;
+	Glib::Dispatcher sync_dispatcher;
+	/// changes reported while 'sync_thread' runs
+	bool sync_pending = false;
+	/// directories were imported, they are watched by the next synchronisation
+	bool watch_pending = false;
+	/// results of the synchronisation, written by 'sync_thread'
+	std::vector<int> synced;
+	std::exception_ptr sync_error;
+	/// wakes the GUI thread when queued writes failed
+	Glib::Dispatcher write_error_dispatcher;
+	/// messages of the failed queued writes not shown yet
+	std::vector<std::string> write_errors;
+	std::mutex write_errors_mutex;
+	int selected_directory = 0;
+	int selected_album = 0;
+	/// period selected in the timeline, year 0 if none
+	int selected_year = 0, selected_month = 0, selected_day = 0;
+	/// photos matching the last filter, shown if no directory or album is selected
+	std::vector<int> filtered_photos;
+	/// 'filtered_photos' holds groups of identical or similar photos, which are not sorted
+	bool showing_duplicates = false;
 
 	void fillWindow();
 	void onWindowResize();
+	bool onSaveSettingsTimeout();
 	void onNewDirectorySelected(int id);
 	void onNewAlbumSelected(int id);
+	void onNewDateSelected(int year, int month, int day);
+	void onFilterActivated();
+	void onFindDuplicates();
+	void onFindSimilar();
+	void showPhotoGroups(const std::vector<std::vector<int>>& groups);
+	void onSortChanged();
+	Backend::BackendFactory::PhotoOrder getPhotoOrder();
+	void onDirectoriesChanged();
+	void onDirectoriesImported();
+	void startSync();
+	void onSyncFinished();
+	void onImportProgress(const Glib::ustring& text);
+	void onWriteError(std::exception_ptr error);
+	void showWriteErrors();
 };
 
 } /* namespace GUI */
@@ -0,0 +1,69 @@
+/*
+ * NewSmartAlbumDialogue.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "NewSmartAlbumDialogue.h"
+
+namespace PhotoLibrary {
+namespace GUI {
+
+using Backend::RecordClasses::NewAlbumRecord;
+
+NewSmartAlbumDialogue::NewSmartAlbumDialogue(NewAlbumRecord* album, Glib::ustring* rule, const Glib::ustring& parent_album_name) :
+		RenameAlbumDialogue(album),
+		rule(rule),
+		rule_label("Rule:") {
+	set_title("New smart album");
+
+	//Set the values of the widgets
+	rule_entry.set_text(*rule);
+	rule_entry.set_placeholder_text("e.g. keyword:Venice rating>=3");
+	rule_entry.set_tooltip_text(
+			"Combine predicates like rating>=3, date=2021-05, keyword:Venice, "
+			"album:\"Best of\", or directory:2021 with AND, OR, NOT, and parentheses");
+
+	//Fill the window with widgets
+	rule_label.set_xalign(0);
+	rule_entry.set_activates_default();
+
+	Gtk::Box* content_box = get_content_area();
+
+	content_box->add(rule_label);
+	content_box->add(rule_entry);
+	if(album->new_parent_id_backup) {
+		check_button_add_as_child.set_label("Add in '" + parent_album_name + "'");
+		check_button_add_as_child.set_active(album->getParent());
+		content_box->add(check_button_add_as_child);
+	}
+	content_box->show_all_children(true);
+
+	//Connect the signal handlers
+	rule_entry.signal_changed().connect(sigc::mem_fun(*this, &NewSmartAlbumDialogue::updateRule));
+	check_button_add_as_child.signal_clicked().connect(sigc::mem_fun(*this, &NewSmartAlbumDialogue::onAddAsChildClicked));
+}
+
+void NewSmartAlbumDialogue::updateRule() {
+	*rule = rule_entry.get_text();
+}
+
+void NewSmartAlbumDialogue::onAddAsChildClicked() {
+	album->setParent() = check_button_add_as_child.get_active()?static_cast<NewAlbumRecord*>(album)->new_parent_id_backup:0;
+}
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,59 @@
+/*
+ * NewSmartAlbumDialogue.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_GUI_NEWSMARTALBUMDIALOGUE_H_
+#define SRC_GUI_NEWSMARTALBUMDIALOGUE_H_
+
+#include "RenameAlbumDialogue.h"
+#include <gtkmm/checkbutton.h>
+
+namespace PhotoLibrary {
+namespace GUI {
+
+/**
+ * The Dialogue to add new smart albums.
+ *
+ * Asks for the name and the rule (a filter expression, see
+ * Backend::PhotoFilter) of the album.
+ */
+class NewSmartAlbumDialogue: public RenameAlbumDialogue {
+public:
+	/**
+	 * @param[out] album Pointer to the Backend::NewAlbumRecord object to save the to
+	 * @param[out] rule Pointer to the string to save the rule to
+	 * @param[in] parent_album_name The parent album set
+	 */
+	NewSmartAlbumDialogue(Backend::RecordClasses::NewAlbumRecord* album, Glib::ustring* rule,
+			const Glib::ustring& parent_album_name="");
+	~NewSmartAlbumDialogue() = default;
+
+private:
+	Glib::ustring* rule;
+	Gtk::Label rule_label;
+	Gtk::Entry rule_entry;
+	Gtk::CheckButton check_button_add_as_child;
+
+	void updateRule();
+	void onAddAsChildClicked();
+};
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_GUI_NEWSMARTALBUMDIALOGUE_H_ */
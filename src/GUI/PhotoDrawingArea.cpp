@@ -18,54 +18,60 @@
  */
 
 #include "PhotoDrawingArea.h"
-#include <giomm/resource.h>
-#include <gdkmm/general.h> // set_source_pixbuf()
-#include <iostream>
-#include <filesystem>
+#include <algorithm>
 
 namespace PhotoLibrary {
 namespace GUI {
 
-PhotoDrawingArea::PhotoDrawingArea(int tile_size, int width, int height) {
-	try {
-		photo_image = Gdk::Pixbuf::create_from_resource("/image/grey_pixel.png",
-				width >= height ? 250 : 250 * width / height,
-				height >= width ? 250 : 250 * height / width,
-				false);
-	}
-	catch (const Gio::ResourceError &e) {
-		std::cerr << "ResourceError: " << e.what() << std::endl;
-	}
-	catch (const Gdk::PixbufError &e) {
-		std::cerr << "PixbufError: " << e.what() << std::endl;
-	}
-
+PhotoDrawingArea::PhotoDrawingArea(int tile_size, int width, int height, int orientation) :
+		// the placeholder has the size of the thumbnail, so nothing moves when it is loaded
+		placeholder_size(thumbnailSize(tile_size, width, height, orientation)) {
 	set_size_request(tile_size, tile_size);
 }
 
 PhotoDrawingArea::PhotoDrawingArea(PhotoDrawingArea&& a) noexcept :
 		Gtk::DrawingArea(std::move(a)),
-		photo_image(a.photo_image) {
+		photo_surface(std::move(a.photo_surface)),
+		placeholder_size(a.placeholder_size) {
 }
 
 bool PhotoDrawingArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr) {
-	if (photo_image) {
-		Gtk::Allocation allocation = get_allocation();
-		const int width = allocation.get_width();
-		const int height = allocation.get_height();
+	Gtk::Allocation allocation = get_allocation();
+	const int width = allocation.get_width();
+	const int height = allocation.get_height();
 
+	if (photo_surface) {
 		// Draw the image in the middle of the drawing area, or (if the image is
 		// larger than the drawing area) draw the middle part of the image.
-		Gdk::Cairo::set_source_pixbuf(cr, photo_image,
-				(width - photo_image->get_width()) / 2, (height - photo_image->get_height()) / 2);
+		cr->set_source(photo_surface,
+				(width - photo_surface->get_width()) / 2, (height - photo_surface->get_height()) / 2);
 		cr->paint();
 	}
+	else {
+		// grey placeholder until the thumbnail is loaded
+		auto [placeholder_width, placeholder_height] = placeholder_size;
+		cr->set_source_rgb(placeholder_grey, placeholder_grey, placeholder_grey);
+		cr->rectangle((width - placeholder_width) / 2, (height - placeholder_height) / 2,
+				placeholder_width, placeholder_height);
+		cr->fill();
+	}
 
 	return false;
 }
 
-void PhotoDrawingArea::setPhoto(Glib::RefPtr<Gdk::Pixbuf> image) {
-	photo_image = image;
+std::pair<int,int> PhotoDrawingArea::thumbnailSize(int tile_size, int width, int height, int orientation) noexcept {
+	// orientations 5 to 8 rotate the photo by 90 degrees
+	if(orientation >= 5 && orientation <= 8)
+		std::swap(width, height);
+	if(width <= 0 || height <= 0)
+		return {tile_size, tile_size};
+	if(width >= height)
+		return {tile_size, std::max(1, static_cast<int>(static_cast<long long>(tile_size) * height / width))};
+	return {std::max(1, static_cast<int>(static_cast<long long>(tile_size) * width / height)), tile_size};
+}
+
+void PhotoDrawingArea::setPhoto(Cairo::RefPtr<Cairo::ImageSurface> image) {
+	photo_surface = image;
 	queue_draw();
 }
 
@@ -21,6 +21,7 @@
 #define SRC_GUI_PHOTODRAWINGAREA_H_
 
 #include <gtkmm/drawingarea.h>
+#include <utility>
 
 namespace PhotoLibrary {
 namespace GUI {
@@ -35,20 +36,37 @@ public:
 	/**
 	 * @param tile_size width and height of the area in the tile
 	 * 		reserved for the thumbnail
-	 * @param width width of the photo in pixel
-	 * @param height height of the photo in pixel
+	 * @param width width of the photo in pixel (as stored)
+	 * @param height height of the photo in pixel (as stored)
+	 * @param orientation Exif orientation of the photo
 	 */
-	PhotoDrawingArea(int tile_size, int width, int height);
+	PhotoDrawingArea(int tile_size, int width, int height, int orientation = 1);
 	PhotoDrawingArea(PhotoDrawingArea&&) noexcept;
 	virtual ~PhotoDrawingArea() = default;
 
 	/**
 	 * Set the thumbnail.
-	 * Set the thumbnail to be displayed in the DreawingArea
+	 * Set the thumbnail to be displayed in the DreawingArea.
+	 * The thumbnail is already in Cairo's pixel format, so drawing it
+	 * (e.g. while scrolling) only copies pixels.
 	 *
-	 * @param image Refptr to the Pixbuf containing the thumbnail
+	 * @param image Refptr to the ARGB32 surface containing the thumbnail
 	 */
-	void setPhoto(Glib::RefPtr<Gdk::Pixbuf> image);
+	void setPhoto(Cairo::RefPtr<Cairo::ImageSurface> image);
+
+	/**
+	 * Get the size of the thumbnail of a photo.
+	 * The photo is scaled to fit into a square of 'tile_size', keeping its
+	 * aspect ratio as displayed, i.e. after applying 'orientation'. Photos
+	 * of unknown size fill the square.
+	 *
+	 * @param tile_size width and height of the area reserved for the thumbnail
+	 * @param width width of the photo in pixel (as stored)
+	 * @param height height of the photo in pixel (as stored)
+	 * @param orientation Exif orientation of the photo
+	 * @return width and height of the thumbnail
+	 */
+	static std::pair<int,int> thumbnailSize(int tile_size, int width, int height, int orientation) noexcept;
 
 protected:
 	/**
@@ -57,7 +75,13 @@ protected:
 	bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
 
 private:
-	Glib::RefPtr<Gdk::Pixbuf> photo_image;
+	/**
+	 * Grey value of the placeholder drawn while no thumbnail is set.
+	 */
+	static constexpr double placeholder_grey = 1. / 3.;
+
+	Cairo::RefPtr<Cairo::ImageSurface> photo_surface;
+	std::pair<int,int> placeholder_size;
 };
 
 } /* namespace GUI */
@@ -0,0 +1,116 @@
+/*
+ * PhotoHasher.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PhotoHasher.h"
+#include "Thumbnail.h"
+#include "../Support/PerceptualHash.h"
+#include <glibmm/error.h>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+
+namespace PhotoLibrary {
+namespace GUI {
+
+PhotoHasher::PhotoHasher(Backend::BackendFactory& backend, unsigned int n_threads) :
+		backend(backend),
+		n_threads(n_threads ? n_threads : 1) {
+}
+
+PhotoHasher::~PhotoHasher() noexcept {
+	stop();
+}
+
+/*
+ * The hashes queued by the previous run are flushed first, otherwise
+ * their photos would be read (and hashed) again.
+ */
+void PhotoHasher::start() {
+	stop();
+	backend.flushWrites();
+	photos.clear();
+	for(int after = 0;;) {
+		auto page = backend.getUnhashedPhotos(after, page_size);
+		if(page.empty())
+			break;
+		after = page.back().id;
+		photos.insert(photos.end(), std::make_move_iterator(page.begin()), std::make_move_iterator(page.end()));
+	}
+	if(photos.empty())
+		return;
+
+	next = 0;
+	stopping = false;
+	for(unsigned int i = 0; i < n_threads; ++i)
+		threads.emplace_back(&PhotoHasher::hashPhotos, this);
+}
+
+void PhotoHasher::stop() noexcept {
+	stopping = true;
+	for(auto& thread : threads)
+		if(thread.joinable())
+			thread.join();
+	threads.clear();
+}
+
+void PhotoHasher::hashPhotos() {
+	std::vector<int> ids;
+	std::vector<std::uint64_t> hashes;
+	std::vector<int> failed;
+	auto flush = [&]() {
+		if(ids.empty() && failed.empty())
+			return;
+		backend.queueWrite([ids = std::move(ids), hashes = std::move(hashes), failed = std::move(failed)](
+				Backend::BackendFactory& backend) {
+			backend.setPerceptualHashes(ids, hashes);
+			backend.setPerceptualHashesFailed(failed);
+		});
+		ids.clear();
+		hashes.clear();
+		failed.clear();
+	};
+
+	for(std::size_t i; !stopping && (i = next++) < photos.size();) {
+		const auto& photo = photos[i];
+		bool hashed = false;
+		try {
+			if(auto thumbnail = loadThumbnail(photo.path, thumbnail_size)) {
+				thumbnail->flush();
+				hashes.push_back(Support::PerceptualHash::differenceHash(thumbnail->get_data(),
+						thumbnail->get_width(), thumbnail->get_height(), thumbnail->get_stride()));
+				ids.push_back(photo.id);
+				hashed = true;
+			}
+		}
+		catch (const Glib::Error& e) {
+			std::cerr << "Error hashing " << photo.path << ": " << e.what() << std::endl;
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Error hashing " << photo.path << ": " << e.what() << std::endl;
+		}
+		if(!hashed)
+			failed.push_back(photo.id);
+		if(ids.size() + failed.size() >= batch_size)
+			flush();
+	}
+	flush();
+}
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
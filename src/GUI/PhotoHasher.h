@@ -0,0 +1,107 @@
+/*
+ * PhotoHasher.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_GUI_PHOTOHASHER_H_
+#define SRC_GUI_PHOTOHASHER_H_
+
+#include "../Backend/BackendFactory.h"
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace GUI {
+
+/**
+ * Background job computing the perceptual hashes of the photos.
+ *
+ * start() reads the photos without a hash (see
+ * BackendFactory::getUnhashedPhotos()) and hashes them in worker threads:
+ * each photo is loaded with loadThumbnail() at a small size and hashed
+ * with Support::PerceptualHash::differenceHash(). The hashes are stored
+ * in batches with queued writes, so the job only touches the database in
+ * the thread calling start().
+ *
+ * Only photos added or changed since the last run are hashed, because
+ * the backend resets the hash of a photo whose file changed. Photos
+ * that can't be loaded are marked as failed (see
+ * BackendFactory::setPerceptualHashesFailed()), so they are only tried
+ * again once their file changes.
+ */
+class PhotoHasher {
+public:
+	/**
+	 * No photo is hashed before start() is called.
+	 *
+	 * @param backend the library whose photos are hashed
+	 * @param n_threads number of worker threads (at least 1)
+	 */
+	PhotoHasher(Backend::BackendFactory& backend, unsigned int n_threads);
+
+	/**
+	 * Stops the worker threads; the hashes computed so far are queued.
+	 */
+	~PhotoHasher() noexcept;
+
+	//no copying or moving
+	PhotoHasher(const PhotoHasher&) = delete;
+	PhotoHasher(PhotoHasher&&) = delete;
+	PhotoHasher& operator=(const PhotoHasher&) = delete;
+	PhotoHasher& operator=(PhotoHasher&&) = delete;
+
+	/**
+	 * Hash all photos without a hash.
+	 *
+	 * Call after photos were added or changed; a running job is stopped
+	 * and restarted with the current photos.
+	 *
+	 * @throws database_error if reading the photos fails
+	 */
+	void start();
+
+	/**
+	 * Stop the worker threads.
+	 * Waits for the photos currently being loaded.
+	 */
+	void stop() noexcept;
+
+private:
+	/// size of the thumbnail the hash is computed from
+	static constexpr int thumbnail_size = 64;
+	/// number of hashes stored with one queued write
+	static constexpr std::size_t batch_size = 64;
+	/// number of photos read with one query
+	static constexpr int page_size = 1000;
+
+	Backend::BackendFactory& backend;
+	const unsigned int n_threads;
+	std::vector<Backend::BackendFactory::UnhashedPhoto> photos;
+	/// index of the next photo to hash
+	std::atomic<std::size_t> next {0};
+	std::atomic<bool> stopping {false};
+	std::vector<std::thread> threads;
+
+	void hashPhotos();
+};
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_GUI_PHOTOHASHER_H_ */
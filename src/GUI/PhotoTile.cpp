@@ -30,9 +30,10 @@ using Backend::RecordClasses::DirectoryRecord;
 
 PhotoTile::PhotoTile(Backend::BackendFactory* backend, int photo_id) :
 		backend(backend),
+		photo_id(photo_id),
 		photo_record(backend->getEntry<Backend::RecordClasses::PhotoRecord>(photo_id)),
 		photo_image(backend->getWindowProperty(BackendFactory::WindowProperties::TILE_WIDTH),
-				photo_record.getWidth(), photo_record.getHeight()) {
+				photo_record.getWidth(), photo_record.getHeight(), photo_record.getOrientation()) {
 
 	pack_start(photo_image);
 }
@@ -40,6 +41,7 @@ PhotoTile::PhotoTile(Backend::BackendFactory* backend, int photo_id) :
 PhotoTile::PhotoTile(PhotoTile&& a) noexcept :
 		Gtk::VBox(std::move(a)),
 		backend(a.backend),
+		photo_id(a.photo_id),
 		photo_record(std::move(a.photo_record)),
 		photo_image(std::move(a.photo_image)) {
 }
@@ -33,7 +33,7 @@ namespace GUI {
  *
  * For performance reasons PhotoTile's constructor doesn't load
  * the tumbnail to be displayed in the tile, it needs to be
- * loaded externally and set with setPhoto(Glib::RefPtr<Gdk::Pixbuf>).
+ * loaded externally and set with setPhoto(Cairo::RefPtr<Cairo::ImageSurface>).
  *
  * \todo display information about the photos
  */
@@ -42,7 +42,7 @@ public:
 	/**
 	 * Constructor.
 	 * The constructor does not load the thumbnail, it needs
-	 * to be set with setPhoto(Glib::RefPtr<Gdk::Pixbuf>)
+	 * to be set with setPhoto(Cairo::RefPtr<Cairo::ImageSurface>)
 	 *
 	 * @param backend pointer to the BackendFactory object
 	 *
@@ -59,7 +59,7 @@ public:
 	 * @param image RefPtr to the tumbnail to be displayed
 	 * 		in the tile
 	 */
-	inline void setPhoto(Glib::RefPtr<Gdk::Pixbuf> image);
+	inline void setPhoto(Cairo::RefPtr<Cairo::ImageSurface> image);
 
 	/**
 	 * Get the filename of the image.
@@ -72,8 +72,16 @@ public:
 	 */
 	Glib::ustring getFilename();
 
+	/**
+	 * Get the id of the photo displayed in the tile.
+	 *
+	 * @return id of the photo
+	 */
+	inline int getPhotoId() const;
+
 private:
 	Backend::BackendFactory* backend;
+	int photo_id;
 	Backend::RecordClasses::PhotoRecord photo_record;
 	PhotoDrawingArea photo_image;
 
@@ -83,10 +91,14 @@ private:
 
 
 //implementation
-void PhotoTile::setPhoto(Glib::RefPtr<Gdk::Pixbuf> image) {
+void PhotoTile::setPhoto(Cairo::RefPtr<Cairo::ImageSurface> image) {
 	photo_image.setPhoto(image);
 }
 
+int PhotoTile::getPhotoId() const {
+	return photo_id;
+}
+
 } /* namespace Backend */
 } /* namespace PhotoLibrary */
 
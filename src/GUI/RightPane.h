@@ -22,6 +22,7 @@
 
 #include <gtkmm/scrolledwindow.h>
 #include <gtkmm/box.h>
+#include <gtkmm/searchentry.h>
 #include "KeywordsView.h"
 #include "../Backend/BackendFactory.h"
 #include "SidePaneElement.h"
@@ -42,12 +43,21 @@ public:
 	inline RightPane(Backend::BackendFactory* backend);
 	~RightPane() = default;
 
+	/**
+	 * Set the photos selected in the grid view.
+	 *
+	 * @param photos Ids of the selected photos
+	 */
+	inline void setSelectedPhotos(const std::vector<int>& photos);
+
 private:
 	Backend::BackendFactory* backend;
 
 	Gtk::Box right_box;
+	Gtk::SearchEntry keyword_search;
 	SidePaneElement<KeywordsView> keywords;
 
+	inline void onKeywordSearchChanged();
 	inline void onSizeAllocate(Gdk::Rectangle& allocation);
 };
 
@@ -60,11 +70,23 @@ RightPane::RightPane(Backend::BackendFactory* backend) :
 	add(right_box);
 	right_box.set_orientation(Gtk::ORIENTATION_VERTICAL);
 
+	/// \todo prepare for internationalisation
+	keyword_search.set_placeholder_text("Search keywords");
+	keyword_search.signal_search_changed().connect(sigc::mem_fun(*this, &RightPane::onKeywordSearchChanged));
+	right_box.add(keyword_search);
 	right_box.add(keywords);
 
 	signal_size_allocate().connect(sigc::mem_fun(*this, &RightPane::onSizeAllocate));
 }
 
+void RightPane::setSelectedPhotos(const std::vector<int>& photos) {
+	keywords.getContent()->setSelectedPhotos(photos);
+}
+
+void RightPane::onKeywordSearchChanged() {
+	keywords.getContent()->setFilter(keyword_search.get_text());
+}
+
 /// \todo find a solution that isn't called every time any child widget changes
 void RightPane::onSizeAllocate(Gdk::Rectangle& allocation) {
 	backend->setWindowProperty(Backend::BackendFactory::WindowProperties::RIGHT_PANE_WIDTH, allocation.get_width());
@@ -0,0 +1,86 @@
+/*
+ * Thumbnail.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Thumbnail.h"
+#include "PhotoDrawingArea.h"
+#include "../Support/PixelConversion.h"
+#include <gdkmm/pixbufloader.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace GUI {
+
+Cairo::RefPtr<Cairo::ImageSurface> loadThumbnail(const std::string& filename, int size) {
+	auto loader = Gdk::PixbufLoader::create();
+	loader->signal_size_prepared().connect([loader = loader.get(), size](int width, int height) {
+		int scale = 1;
+		while(scale < 8 && std::max(width, height) / (2 * scale) >= size)
+			scale *= 2;
+		loader->set_size((width + scale - 1) / scale, (height + scale - 1) / scale);
+	});
+	std::ifstream file(filename, std::ios::binary);
+	std::array<char,65536> buffer;
+	while(file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+		loader->write(reinterpret_cast<const guint8*>(buffer.data()), file.gcount());
+	loader->close();
+	Glib::RefPtr<Gdk::Pixbuf> image = loader->get_pixbuf();
+	if(!image)
+		return {};
+	// match the placeholder, which is sized with the orientation applied
+	if(auto rotated = image->apply_embedded_orientation())
+		image = rotated;
+
+	const int width = image->get_width();
+	const int height = image->get_height();
+	auto [thumbnail_width, thumbnail_height] = PhotoDrawingArea::thumbnailSize(size, width, height, 1);
+	// don't enlarge small images
+	if(thumbnail_width > width || thumbnail_height > height) {
+		thumbnail_width = width;
+		thumbnail_height = height;
+	}
+
+	auto thumbnail = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, thumbnail_width, thumbnail_height);
+	thumbnail->flush();
+	const bool scale = thumbnail_width != width || thumbnail_height != height;
+	// convert into the thumbnail directly if it has the size of the image
+	std::vector<std::uint32_t> pixels(scale ? static_cast<std::size_t>(width) * height : 0);
+	const guint8* source = image->get_pixels();
+	for(int y = 0; y < height; ++y) {
+		const guint8* row = source + static_cast<std::size_t>(y) * image->get_rowstride();
+		std::uint32_t* destination = scale ? pixels.data() + static_cast<std::size_t>(y) * width :
+				reinterpret_cast<std::uint32_t*>(thumbnail->get_data() + y * thumbnail->get_stride());
+		if(image->get_has_alpha())
+			Support::PixelConversion::rgbaToARGB32(row, destination, width);
+		else
+			Support::PixelConversion::rgbToARGB32(row, destination, width);
+	}
+	if(scale)
+		Support::PixelConversion::downscale(reinterpret_cast<const unsigned char*>(pixels.data()),
+				width, height, 4 * static_cast<std::size_t>(width),
+				thumbnail->get_data(), thumbnail_width, thumbnail_height, thumbnail->get_stride());
+	thumbnail->mark_dirty();
+	return thumbnail;
+}
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,53 @@
+/*
+ * Thumbnail.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_GUI_THUMBNAIL_H_
+#define SRC_GUI_THUMBNAIL_H_
+
+#include <cairomm/surface.h>
+#include <string>
+
+namespace PhotoLibrary {
+namespace GUI {
+
+/**
+ * Load the thumbnail of an image, fitting into a square of 'size'.
+ *
+ * The image is decoded at its size divided by the largest power of two
+ * (up to 8) that keeps it at least as large as the thumbnail; JPEGs are
+ * decoded directly at that size. The conversion to ARGB32 and the box
+ * filter down to the size of the thumbnail use PixelConversion, so all
+ * per pixel work is done in the calling thread. The embedded orientation
+ * is applied; small images are not enlarged.
+ *
+ * Thread safe, used by the threads loading the grid and by PhotoHasher.
+ *
+ * @param filename path of the image
+ * @param size width and height of the square
+ * @return the thumbnail, an empty RefPtr if the image couldn't be decoded
+ *
+ * @throws Glib::Error (e.g. Gdk::PixbufError) if the file can't be read
+ * 		or isn't an image
+ */
+Cairo::RefPtr<Cairo::ImageSurface> loadThumbnail(const std::string& filename, int size);
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_GUI_THUMBNAIL_H_ */
@@ -0,0 +1,107 @@
+/*
+ * TimelineView.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TimelineView.h"
+#include <array>
+#include <string>
+
+namespace PhotoLibrary {
+namespace GUI {
+
+TimelineView::TimelineView(Backend::BackendFactory* backend) :
+		backend(backend),
+		store(Gtk::TreeStore::create(columns)) {
+	set_model(store);
+	set_headers_visible(false);
+	append_column("Date", columns.name);
+	int col_count = append_column("", columns.photo_count);
+	get_column_cell_renderer(col_count-1)->set_alignment(1, .5);
+
+	reload();
+
+	signal_test_expand_row().connect(sigc::mem_fun(*this, &TimelineView::onTestExpandRow), false);
+	get_selection()->signal_changed().connect(sigc::mem_fun(*this, &TimelineView::onSelectionChanged));
+}
+
+sigc::signal<void,int,int,int> TimelineView::signalSelectionChanged() {
+	return signal_selection_changed;
+}
+
+void TimelineView::unselectAll() {
+	get_selection()->unselect_all();
+}
+
+void TimelineView::reload() {
+	store->clear();
+	appendPeriods(Gtk::TreeModel::iterator(), 0, 0);
+}
+
+/*
+ * Appends the years (year = 0), the months of 'year' (month = 0), or the
+ * days of 'month'. Years and months get a placeholder child, so they can
+ * be expanded before their children are loaded.
+ */
+void TimelineView::appendPeriods(const Gtk::TreeModel::iterator& parent, int year, int month) {
+	/// \todo prepare for internationalisation
+	static const std::array<const char*,12> month_names {"January", "February", "March", "April", "May", "June",
+		"July", "August", "September", "October", "November", "December"};
+
+	for(const auto& period : backend->getTimeline(year, month)) {
+		Gtk::TreeModel::Row row = *(parent ? store->append(parent->children()) : store->append());
+		row[columns.year] = period.year;
+		row[columns.month] = period.month;
+		row[columns.day] = period.day;
+		row[columns.photo_count] = period.photos;
+		if(period.day)
+			row[columns.name] = std::to_string(period.day);
+		else if(period.month)
+			row[columns.name] = month_names.at(period.month - 1);
+		else
+			row[columns.name] = std::to_string(period.year);
+		if(!period.day)
+			(*store->append(row.children()))[columns.year] = 0;
+	}
+}
+
+bool TimelineView::onTestExpandRow(const Gtk::TreeModel::iterator& iter, const Gtk::TreeModel::Path& path) {
+	auto placeholder = iter->children().begin();
+	if(placeholder && static_cast<int>((*placeholder)[columns.year]) == 0) {
+		int year = (*iter)[columns.year];
+		int month = (*iter)[columns.month];
+		appendPeriods(iter, year, month);
+		store->erase(placeholder);
+	}
+	// allow the expansion
+	return false;
+}
+
+void TimelineView::onSelectionChanged() {
+	auto selection = get_selection()->get_selected();
+	if(!selection) {
+		signal_selection_changed.emit(0, 0, 0);
+		return;
+	}
+	int year = (*selection)[columns.year];
+	int month = (*selection)[columns.month];
+	int day = (*selection)[columns.day];
+	signal_selection_changed.emit(year, month, day);
+}
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,103 @@
+/*
+ * TimelineView.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2020-2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_GUI_TIMELINEVIEW_H_
+#define SRC_GUI_TIMELINEVIEW_H_
+
+#include <gtkmm/treestore.h>
+#include <gtkmm/treeview.h>
+#include "../Backend/BackendFactory.h"
+
+namespace PhotoLibrary {
+namespace GUI {
+
+/**
+ * TreeView of the years, months, and days with photos.
+ *
+ * Shows the number of photos in every period as maintained by the
+ * backend (see Backend::BackendFactory::getTimeline()). Only the years are
+ * loaded at first, the months and days when a row is expanded.
+ */
+class TimelineView: public Gtk::TreeView {
+public:
+	/**
+	 * @param backend the backend interface factory object
+	 */
+	TimelineView(Backend::BackendFactory* backend);
+	~TimelineView() = default;
+
+	/**
+	 * Signal emitted when a new period is selected.
+	 *
+	 * @return sigc::signal; use connect() to connect a signal handler
+	 *
+	 * \par Prototype
+	 * void onSelectionChanged(int year, int month, int day)
+	 * @param year the selected year, 0 if nothing is selected
+	 * @param month the selected month, 0 for a whole year
+	 * @param day the selected day, 0 for a whole year or month
+	 */
+	sigc::signal<void,int,int,int> signalSelectionChanged();
+
+	/**
+	 * Unselects all rows in the TreeView.
+	 */
+	void unselectAll();
+
+	/**
+	 * Reload the timeline after photos were added, changed, or deleted.
+	 */
+	void reload();
+
+private:
+	/**
+	 * The TreeModel::ColumnRecord for the timeline.
+	 * A row with 'year' 0 is the placeholder of the children not loaded yet.
+	 */
+	class ModelColumns : public Gtk::TreeModel::ColumnRecord {
+	public:
+		ModelColumns() {
+			add(name);
+			add(photo_count);
+			add(year);
+			add(month);
+			add(day);
+		}
+
+		Gtk::TreeModelColumn<Glib::ustring> name;
+		Gtk::TreeModelColumn<int> photo_count;
+		Gtk::TreeModelColumn<int> year;
+		Gtk::TreeModelColumn<int> month;
+		Gtk::TreeModelColumn<int> day;
+	};
+
+	Backend::BackendFactory* backend;
+	ModelColumns columns;
+	Glib::RefPtr<Gtk::TreeStore> store;
+	sigc::signal<void,int,int,int> signal_selection_changed;
+
+	void appendPeriods(const Gtk::TreeModel::iterator& parent, int year, int month);
+	bool onTestExpandRow(const Gtk::TreeModel::iterator& iter, const Gtk::TreeModel::Path& path);
+	void onSelectionChanged();
+};
+
+} /* namespace GUI */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_GUI_TIMELINEVIEW_H_ */
@@ -24,15 +24,15 @@
 namespace PhotoLibrary {
 namespace SQLiteAdapter {
 
-Database::Database(const char*, bool) :
+Database::Database(const char* filename, bool create) :
 	db(nullptr) {
-	/// \todo Add support for persistence
-	const char* filename = ":memory:";
-
-	if(int rc = sqlite3_open(filename, &db)) { /// \todo add more expressive error messages
+	// URI filenames allow in-memory databases shared between connections ("file:/name?vfs=memdb")
+	int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_URI | (create ? SQLITE_OPEN_CREATE : 0);
+	if(int rc = sqlite3_open_v2(filename, &db, flags, nullptr)) { /// \todo add more expressive error messages
+		std::string error_msg = db ? sqlite3_errmsg(db) : sqlite3_errstr(rc);
 		sqlite3_close(db);
 		throw(std::runtime_error(std::string("Database ") + filename +
-				" couldn't be opened: error code " + std::to_string(rc))); /// \todo prepare for internationalisation
+				" couldn't be opened: " + error_msg + " (error code " + std::to_string(rc) + ")")); /// \todo prepare for internationalisation
 	}
 }
 
@@ -53,11 +53,41 @@ int Database::querryNoThrow(const char* sql, int (*callback)(void*,int,char**,ch
 	char* zErrMsg = nullptr;
 	int return_value = sqlite3_exec(db, sql, callback, data, &zErrMsg);
 	if(return_value) {
-		error_msg = *zErrMsg;
+		error_msg = zErrMsg;
 		sqlite3_free(zErrMsg);
 	}
 	return return_value;
 }
 
+int Database::changes() noexcept {
+	return sqlite3_changes(db);
+}
+
+namespace {
+
+using Compare = int (*)(std::string_view, std::string_view) noexcept;
+
+int callCompare(void* compare, int size_a, const void* a, int size_b, const void* b) {
+	return (*static_cast<Compare*>(compare))(
+			std::string_view(static_cast<const char*>(a), size_a),
+			std::string_view(static_cast<const char*>(b), size_b));
+}
+
+void deleteCompare(void* compare) {
+	delete static_cast<Compare*>(compare);
+}
+
+}
+
+void Database::createCollation(const char* name, Compare compare) {
+	Compare* data = new Compare(compare);
+	// unlike other interfaces SQLite doesn't delete 'data' if this fails
+	if(int rc = sqlite3_create_collation_v2(db, name, SQLITE_UTF8, data, callCompare, deleteCompare)) {
+		delete data;
+		throw(std::runtime_error(std::string("Collation ") + name +
+				" couldn't be added: error code " + std::to_string(rc)));
+	}
+}
+
 } /* namespace SQLiteAdapter */
 } /* namespace PhotoLibrary */
@@ -22,6 +22,7 @@
 
 #include "SQLQuerry.h"
 #include <sqlite3.h>
+#include <string_view>
 
 namespace PhotoLibrary {
 namespace SQLiteAdapter {
@@ -33,11 +34,13 @@ namespace SQLiteAdapter {
 class Database {
 public:
 	/**
-	 * @param filename filename of the SQLite database
+	 * @param filename filename of the SQLite database, ":memory:" for a
+	 * 		private in-memory database; URI filenames are accepted
+	 * @param create create the database if it doesn't exist yet
 	 *
 	 * @throws std::runtime_error if database can't be opened
 	 */
-	Database(const char* filename, bool =true);
+	Database(const char* filename, bool create =true);
 	~Database() noexcept;
 
 	//prevent copy-construction and copying
@@ -71,6 +74,32 @@ public:
 	 */
 	int querryNoThrow(const char* sql, int (*callback)(void*,int,char**,char**), void* data, std::string& error_msg);
 
+	/**
+	 * Get the number of rows changed by the last statement.
+	 * Returns the number of rows inserted, updated, or deleted by the
+	 * most recently completed statement (not counting changes made by
+	 * triggers or foreign key actions).
+	 * @see https://sqlite.org/c3ref/changes.html
+	 *
+	 * @return number of rows changed
+	 */
+	int changes() noexcept;
+
+	/**
+	 * Add a collating sequence to the database.
+	 * The collation can then be used in COLLATE clauses and indexes; it has
+	 * to be added again every time the database is opened.
+	 * @see https://sqlite.org/c3ref/create_collation.html
+	 *
+	 * @param name name of the collation
+	 * @param compare function returning a negative value, 0, or a positive
+	 * 		value if the first string is smaller than, equal to, or larger
+	 * 		than the second one (UTF-8)
+	 *
+	 * @throw std::runtime_error if the collation can't be added
+	 */
+	void createCollation(const char* name, int (*compare)(std::string_view, std::string_view) noexcept);
+
 private:
 	sqlite3* db;
 
@@ -48,6 +48,20 @@ int SQLQuerry::columnCount() noexcept {
 	return sqlite3_column_count(sqlStmt);
 }
 
+void SQLQuerry::bind(int index, const std::string& value) {
+	checkBind(sqlite3_bind_text(sqlStmt, index, value.c_str(), value.size(), SQLITE_TRANSIENT));
+}
+
+void SQLQuerry::reset() noexcept {
+	sqlite3_reset(sqlStmt);
+	sqlite3_clear_bindings(sqlStmt);
+}
+
+void SQLQuerry::checkBind(int return_code) {
+	if(return_code != SQLITE_OK)
+		throw(std::runtime_error("Error binding value to SQL statement. (Error Code " + std::to_string(return_code) + ")"));
+}
+
 void SQLQuerry::nextStatement() {
 	sqlite3_finalize(sqlStmt);
 	sqlStmt = nullptr;
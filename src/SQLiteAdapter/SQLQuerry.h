@@ -114,6 +114,39 @@ public:
 	template<Integral_or_enum I>
 	I getColumn(int colNum, I ={}) noexcept;
 
+	/**
+	 * Bind an integral value to a parameter of the SQL statement.
+	 * @see https://sqlite.org/c3ref/bind_blob.html
+	 *
+	 * @tparam I Integral type or enum of the value
+	 * @param index Index of the parameter (the leftmost parameter has the index 1)
+	 * @param value Value to bind to the parameter
+	 *
+	 * @throws std::runtime_error if binding the value fails
+	 */
+	template<Integral_or_enum I>
+	void bind(int index, I value);
+
+	/**
+	 * Bind a string to a parameter of the SQL statement.
+	 * The string is copied by SQLite.
+	 * @see https://sqlite.org/c3ref/bind_blob.html
+	 *
+	 * @param index Index of the parameter (the leftmost parameter has the index 1)
+	 * @param value utf8 string to bind to the parameter
+	 *
+	 * @throws std::runtime_error if binding the value fails
+	 */
+	void bind(int index, const std::string& value);
+
+	/**
+	 * Reset the SQL statement.
+	 * Resets the current statement so that it can be evaluated again
+	 * and clears all bindings.
+	 * @see https://sqlite.org/c3ref/reset.html
+	 */
+	void reset() noexcept;
+
 	/**
 	 * Prepare the next SQL querry.
 	 * Prepare the next SQL querry from the list handed to the constructor.
@@ -127,6 +160,7 @@ private:
 	const char* nextStmt;
 
 	void prepareStmt();
+	void checkBind(int return_code);
 	friend Database;	//is there another solution to make (private) prepareStmt a friend of Database?
 };
 
@@ -153,6 +187,11 @@ I SQLQuerry::getColumnInt(int colNum) noexcept {
 	return sqlite3_column_int64(sqlStmt, colNum);
 }
 
+template<Integral_or_enum I>
+void SQLQuerry::bind(int index, I value) {
+	checkBind(sqlite3_bind_int64(sqlStmt, index, static_cast<sqlite3_int64>(value)));
+}
+
 } /* namespace SQLiteAdapter */
 } /* namespace PhotoLibrary */
 
@@ -0,0 +1,51 @@
+/*
+ * Transaction.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Transaction.h"
+#include "Database.h"
+
+namespace PhotoLibrary {
+namespace SQLiteAdapter {
+
+Transaction::Transaction(Database& db, const char* savepoint) :
+		db(db),
+		savepoint(savepoint ? savepoint : "") {
+	db.querry(this->savepoint.empty() ? "BEGIN;" : ("SAVEPOINT " + this->savepoint + ";").c_str(), nullptr, nullptr);
+}
+
+Transaction::~Transaction() noexcept {
+	if(!open)
+		return;
+	std::string error_msg;
+	try {
+		// a savepoint has to be released after rolling back to it
+		db.querryNoThrow(savepoint.empty() ? "ROLLBACK;" : ("ROLLBACK TO " + savepoint + "; RELEASE " + savepoint + ";").c_str(),
+				nullptr, nullptr, error_msg);
+	}
+	catch (...) {
+	}
+}
+
+void Transaction::commit() {
+	db.querry(savepoint.empty() ? "COMMIT;" : ("RELEASE " + savepoint + ";").c_str(), nullptr, nullptr);
+	open = false;
+}
+
+} /* namespace SQLiteAdapter */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,75 @@
+/*
+ * Transaction.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SQLITEADAPTER_TRANSACTION_H_
+#define SRC_SQLITEADAPTER_TRANSACTION_H_
+
+#include <string>
+
+namespace PhotoLibrary {
+namespace SQLiteAdapter {
+
+class Database;
+
+/**
+ * Transaction rolled back unless it is committed.
+ * The transaction begins when the object is constructed; if commit()
+ * isn't called before it is destroyed, e.g. because an exception was
+ * thrown, its changes are rolled back.
+ *
+ * With a name a savepoint is used instead, which can be nested in a
+ * transaction or another savepoint.
+ * @see https://sqlite.org/lang_savepoint.html
+ */
+class Transaction {
+public:
+	/**
+	 * @param db database to begin the transaction in
+	 * @param savepoint name of the savepoint, nullptr for a transaction
+	 *
+	 * @throws std::runtime_error if the transaction can't be begun
+	 */
+	explicit Transaction(Database& db, const char* savepoint = nullptr);
+
+	/**
+	 * Rolls the transaction back if it hasn't been committed.
+	 */
+	~Transaction() noexcept;
+
+	Transaction(const Transaction&) = delete;
+	Transaction& operator=(const Transaction&) = delete;
+
+	/**
+	 * Commit the transaction (release the savepoint).
+	 *
+	 * @throws std::runtime_error if committing fails, the transaction is
+	 * 		rolled back when the object is destroyed
+	 */
+	void commit();
+
+private:
+	Database& db;
+	std::string savepoint;
+	bool open = true;
+};
+
+} /* namespace SQLiteAdapter */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SQLITEADAPTER_TRANSACTION_H_ */
@@ -0,0 +1,158 @@
+/*
+ * BoundedQueue.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_BOUNDEDQUEUE_H_
+#define SRC_SUPPORT_BOUNDEDQUEUE_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <utility>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * Blocking queue with a maximum size connecting the stages of a pipeline.
+ *
+ * push() blocks while the queue is full, so a fast producer is slowed
+ * down to the speed of its consumers (backpressure). pop() blocks while
+ * the queue is empty. After close() no elements can be added; pop()
+ * returns the remaining elements and then std::nullopt.
+ *
+ * @tparam T type of the Elements; \c T needs to be MoveConstructible
+ *
+ * @throws std::system_error Any method not marked as noexcept
+ * 		may throw a std::system_error if the mutex cannot be locked.
+ */
+template<typename T>
+class BoundedQueue {
+public:
+	using size_type = typename std::queue<T>::size_type;
+
+	/**
+	 * Creates an empty queue.
+	 *
+	 * @param capacity maximum number of elements in the queue (at least 1)
+	 */
+	explicit BoundedQueue(size_type capacity) : capacity(capacity ? capacity : 1) {}
+
+	~BoundedQueue() = default;
+
+	//no moving or copying (not thread safe)
+	BoundedQueue(const BoundedQueue&) = delete;
+	BoundedQueue(BoundedQueue&&) = delete;
+	BoundedQueue& operator=(const BoundedQueue&) = delete;
+	BoundedQueue& operator=(BoundedQueue&&) = delete;
+
+	/**
+	 * Add an element to the queue.
+	 *
+	 * Blocks until there is space in the queue or the queue is closed.
+	 *
+	 * @param t item to move to the end of the queue
+	 * @retval true if the element was added
+	 * @retval false if the queue is closed ('t' is not moved from)
+	 *
+	 * @throws Any exception thrown during allocation or moving T
+	 */
+	bool push(T&& t);
+
+	/**
+	 * Retrieve the first element from the queue.
+	 *
+	 * Blocks until the queue holds an element or is closed and empty.
+	 *
+	 * @return the first element, std::nullopt if the queue is closed and empty
+	 */
+	std::optional<T> pop();
+
+	/**
+	 * Close the queue.
+	 *
+	 * Wakes all blocked threads; no more elements can be added.
+	 */
+	void close();
+
+	/**
+	 * Whether the queue is closed.
+	 *
+	 * @retval true if close() has been called
+	 * @retval false otherwise
+	 */
+	bool closed() const;
+
+private:
+	const size_type capacity;
+	std::queue<T> queue;
+	bool is_closed = false;
+	mutable std::mutex queue_mutex;
+	std::condition_variable not_full;
+	std::condition_variable not_empty;
+};
+
+
+//implementation
+template<typename T>
+bool BoundedQueue<T>::push(T&& t) {
+	std::unique_lock<std::mutex> lck {queue_mutex};
+	not_full.wait(lck, [this]() { return is_closed || queue.size() < capacity; });
+	if(is_closed)
+		return false;
+	queue.push(std::move(t));
+	lck.unlock();
+	not_empty.notify_one();
+	return true;
+}
+
+template<typename T>
+std::optional<T> BoundedQueue<T>::pop() {
+	std::unique_lock<std::mutex> lck {queue_mutex};
+	not_empty.wait(lck, [this]() { return is_closed || !queue.empty(); });
+	if(queue.empty())
+		return std::nullopt;
+	std::optional<T> t {std::move(queue.front())};
+	queue.pop();
+	lck.unlock();
+	not_full.notify_one();
+	return t;
+}
+
+template<typename T>
+void BoundedQueue<T>::close() {
+	{
+		std::unique_lock<std::mutex> lck {queue_mutex};
+		is_closed = true;
+	}
+	not_full.notify_all();
+	not_empty.notify_all();
+}
+
+template<typename T>
+bool BoundedQueue<T>::closed() const {
+	std::unique_lock<std::mutex> lck {queue_mutex};
+	return is_closed;
+}
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_BOUNDEDQUEUE_H_ */
@@ -0,0 +1,135 @@
+/*
+ * ContentHash.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ContentHash.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace {
+
+constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87;
+constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4F;
+constexpr std::uint64_t prime3 = 0x165667B19E3779F9;
+constexpr std::uint64_t prime4 = 0x85EBCA77C2B2AE63;
+constexpr std::uint64_t prime5 = 0x27D4EB2F165667C5;
+
+// the input is read as little endian on all platforms
+std::uint64_t read64(const unsigned char* data) noexcept {
+	std::uint64_t value;
+	std::memcpy(&value, data, sizeof(value));
+	if constexpr(std::endian::native == std::endian::big)
+		value = __builtin_bswap64(value);
+	return value;
+}
+
+std::uint32_t read32(const unsigned char* data) noexcept {
+	std::uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	if constexpr(std::endian::native == std::endian::big)
+		value = __builtin_bswap32(value);
+	return value;
+}
+
+std::uint64_t round(std::uint64_t accumulator, std::uint64_t input) noexcept {
+	return std::rotl(accumulator + input * prime2, 31) * prime1;
+}
+
+std::uint64_t mergeRound(std::uint64_t hash, std::uint64_t accumulator) noexcept {
+	return (hash ^ round(0, accumulator)) * prime1 + prime4;
+}
+
+void processStripe(std::array<std::uint64_t,4>& accumulators, const unsigned char* stripe) noexcept {
+	for(std::size_t i = 0; i < accumulators.size(); ++i)
+		accumulators[i] = round(accumulators[i], read64(stripe + 8 * i));
+}
+
+}
+
+ContentHash::ContentHash(std::uint64_t seed) noexcept :
+		seed(seed),
+		accumulators{seed + prime1 + prime2, seed + prime2, seed, seed - prime1} {
+}
+
+void ContentHash::update(const void* data, std::size_t length) noexcept {
+	auto input = static_cast<const unsigned char*>(data);
+	total_length += length;
+	if(buffered) {
+		std::size_t n = std::min(length, stripe_size - buffered);
+		std::memcpy(buffer.data() + buffered, input, n);
+		buffered += n;
+		input += n;
+		length -= n;
+		if(buffered < stripe_size)
+			return;
+		processStripe(accumulators, buffer.data());
+		buffered = 0;
+	}
+	for(; length >= stripe_size; input += stripe_size, length -= stripe_size)
+		processStripe(accumulators, input);
+	std::memcpy(buffer.data(), input, length);
+	buffered = length;
+}
+
+/*
+ * Inputs shorter than a stripe don't use the accumulators.
+ */
+std::uint64_t ContentHash::digest() const noexcept {
+	std::uint64_t hash;
+	if(total_length >= stripe_size) {
+		hash = std::rotl(accumulators[0], 1) + std::rotl(accumulators[1], 7)
+				+ std::rotl(accumulators[2], 12) + std::rotl(accumulators[3], 18);
+		for(std::uint64_t accumulator : accumulators)
+			hash = mergeRound(hash, accumulator);
+	}
+	else
+		hash = seed + prime5;
+	hash += total_length;
+
+	const unsigned char* input = buffer.data();
+	std::size_t length = buffered;
+	for(; length >= 8; input += 8, length -= 8)
+		hash = std::rotl(hash ^ round(0, read64(input)), 27) * prime1 + prime4;
+	if(length >= 4) {
+		hash = std::rotl(hash ^ (read32(input) * prime1), 23) * prime2 + prime3;
+		input += 4;
+		length -= 4;
+	}
+	for(; length > 0; ++input, --length)
+		hash = std::rotl(hash ^ (*input * prime5), 11) * prime1;
+
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+std::uint64_t ContentHash::hash(const void* data, std::size_t length, std::uint64_t seed) noexcept {
+	ContentHash hash(seed);
+	hash.update(data, length);
+	return hash.digest();
+}
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,93 @@
+/*
+ * ContentHash.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_CONTENTHASH_H_
+#define SRC_SUPPORT_CONTENTHASH_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * 64 bit hash of the content of files for finding identical files.
+ *
+ * Implements XXH64 of the xxHash family: the results are identical to
+ * the reference implementation (e.g. \c xxhsum -H1), so hashes stored in
+ * the catalogue stay comparable. The data can be added in pieces of any
+ * size; the hash only depends on the concatenated data.
+ *
+ * At several GB/s per core the hash is much faster than reading files
+ * from disk, so hashing with a few threads is limited by the disk.
+ *
+ * \see https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+ */
+class ContentHash {
+public:
+	/**
+	 * Starts a new hash.
+	 *
+	 * @param seed seed of the hash
+	 */
+	explicit ContentHash(std::uint64_t seed = 0) noexcept;
+
+	/**
+	 * Add data to the hash.
+	 *
+	 * @param data pointer to the data
+	 * @param length number of bytes
+	 */
+	void update(const void* data, std::size_t length) noexcept;
+
+	/**
+	 * Get the hash of the data added so far.
+	 * More data can be added afterwards.
+	 *
+	 * @return the hash
+	 */
+	std::uint64_t digest() const noexcept;
+
+	/**
+	 * Hash a block of data at once.
+	 *
+	 * @param data pointer to the data
+	 * @param length number of bytes
+	 * @param seed seed of the hash
+	 * @return the hash
+	 */
+	static std::uint64_t hash(const void* data, std::size_t length, std::uint64_t seed = 0) noexcept;
+
+private:
+	/// the input is processed in stripes of four 64 bit lanes
+	static constexpr std::size_t stripe_size = 32;
+
+	std::uint64_t seed;
+	std::array<std::uint64_t,4> accumulators;
+	std::uint64_t total_length = 0;
+	/// start of a stripe that isn't complete yet
+	std::array<unsigned char,stripe_size> buffer;
+	std::size_t buffered = 0;
+};
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_CONTENTHASH_H_ */
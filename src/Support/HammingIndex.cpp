@@ -0,0 +1,87 @@
+/*
+ * HammingIndex.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "HammingIndex.h"
+#include "PerceptualHash.h"
+#include <algorithm>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace {
+
+/*
+ * All 16 bit masks with at most 'bits' bits set (1, 17, or 137 masks).
+ */
+std::vector<std::uint16_t> flipMasks(int bits) {
+	std::vector<std::uint16_t> masks {0};
+	if(bits >= 1)
+		for(int i = 0; i < 16; ++i)
+			masks.push_back(static_cast<std::uint16_t>(1u << i));
+	if(bits >= 2)
+		for(int i = 0; i < 16; ++i)
+			for(int j = i + 1; j < 16; ++j)
+				masks.push_back(static_cast<std::uint16_t>(1u << i | 1u << j));
+	return masks;
+}
+
+}
+
+void HammingIndex::add(int id, value_type hash) {
+	auto position = static_cast<std::uint32_t>(hashes.size());
+	ids.push_back(id);
+	hashes.push_back(hash);
+	for(int i = 0; i < n_chunks; ++i)
+		chunks[i][chunk(hash, i)].push_back(position);
+}
+
+std::vector<HammingIndex::Match> HammingIndex::find(value_type hash, int max_distance) const {
+	std::vector<Match> matches;
+	if(max_distance < 0)
+		return matches;
+
+	if(max_distance > max_indexed_distance) {
+		std::vector<std::uint8_t> distances(hashes.size());
+		PerceptualHash::distances(hash, hashes.data(), distances.data(), hashes.size());
+		for(std::size_t i = 0; i < hashes.size(); ++i)
+			if(distances[i] <= max_distance)
+				matches.push_back({ids[i], distances[i]});
+	}
+	else {
+		std::vector<std::uint32_t> candidates;
+		for(std::uint16_t mask : flipMasks(max_distance / n_chunks))
+			for(int i = 0; i < n_chunks; ++i)
+				if(auto found = chunks[i].find(chunk(hash, i) ^ mask); found != chunks[i].end())
+					candidates.insert(candidates.end(), found->second.begin(), found->second.end());
+		// a hash is found once for every chunk within the distance
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+		for(std::uint32_t position : candidates)
+			if(int distance = PerceptualHash::distance(hash, hashes[position]); distance <= max_distance)
+				matches.push_back({ids[position], distance});
+	}
+
+	std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+		return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+	});
+	return matches;
+}
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,123 @@
+/*
+ * HammingIndex.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_HAMMINGINDEX_H_
+#define SRC_SUPPORT_HAMMINGINDEX_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * Index of 64 bit hashes for finding the hashes within a Hamming distance,
+ * e.g. perceptual hashes of near-duplicate images (see PerceptualHash).
+ *
+ * Multi-index hashing: every hash is split into four 16 bit chunks, each
+ * indexed in its own hash table. If two hashes differ in at most 'd' bits,
+ * at least one of their chunks differs in at most d / 4 bits, so a search
+ * only looks up the chunks of the query and their variants with up to
+ * d / 4 flipped bits, and checks the distance of the hashes found. For
+ * distances above max_indexed_distance the hashes are scanned linearly
+ * (see PerceptualHash::distances()).
+ *
+ * @see M. Norouzi, A. Punjani, D. J. Fleet: Fast Search in Hamming Space
+ * 		with Multi-Index Hashing, CVPR 2012
+ */
+class HammingIndex {
+public:
+	using value_type = std::uint64_t;
+	using size_type = std::size_t;
+
+	/**
+	 * Largest distance searched with the chunk tables.
+	 */
+	static constexpr int max_indexed_distance = 11;
+
+	/**
+	 * A hash found by find().
+	 */
+	struct Match {
+		int id;	/**< id the hash was added with */
+		int distance;	/**< Hamming distance to the query */
+		bool operator==(const Match&) const = default;
+	};
+
+	HammingIndex() = default;
+	~HammingIndex() = default;
+	HammingIndex(const HammingIndex&) = default;
+	HammingIndex(HammingIndex&&) noexcept = default;
+	HammingIndex& operator=(const HammingIndex&) = default;
+	HammingIndex& operator=(HammingIndex&&) noexcept = default;
+
+	/**
+	 * Add a hash.
+	 * The same id can be added more than once.
+	 *
+	 * @param id id returned by find() for 'hash'
+	 * @param hash the hash
+	 */
+	void add(int id, value_type hash);
+
+	/**
+	 * Find the hashes within a Hamming distance.
+	 *
+	 * @param hash the hash to search for
+	 * @param max_distance largest distance to return (0 for equal hashes)
+	 * @return the hashes within 'max_distance' of 'hash', sorted by
+	 * 		distance and id
+	 */
+	std::vector<Match> find(value_type hash, int max_distance) const;
+
+	/**
+	 * Get the number of hashes.
+	 *
+	 * @return number of hashes added
+	 */
+	size_type size() const noexcept { return hashes.size(); }
+
+	/**
+	 * Whether the index is empty.
+	 *
+	 * @return true if no hash was added
+	 */
+	bool empty() const noexcept { return hashes.empty(); }
+
+private:
+	static constexpr int n_chunks = 4;
+	static constexpr int chunk_bits = 16;
+
+	std::vector<int> ids;
+	std::vector<value_type> hashes;
+	/// positions in 'hashes' by the value of a chunk
+	std::array<std::unordered_map<std::uint16_t,std::vector<std::uint32_t>>,n_chunks> chunks;
+
+	static std::uint16_t chunk(value_type hash, int i) noexcept {
+		return static_cast<std::uint16_t>(hash >> (chunk_bits * i));
+	}
+};
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_HAMMINGINDEX_H_ */
@@ -0,0 +1,88 @@
+/*
+ * NaturalOrder.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "NaturalOrder.h"
+#include <cstddef>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace {
+
+bool isDigit(char c) noexcept {
+	return c >= '0' && c <= '9';
+}
+
+char toLower(char c) noexcept {
+	return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+int sign(int value) noexcept {
+	return (value > 0) - (value < 0);
+}
+
+}
+
+int naturalCompare(std::string_view a, std::string_view b) noexcept {
+	// decides between strings equal apart from case and leading zeros
+	int tie = 0;
+	std::size_t i = 0, j = 0;
+	while(i < a.size() && j < b.size()) {
+		if(isDigit(a[i]) && isDigit(b[j])) {
+			std::size_t zeros_a = i, zeros_b = j;
+			while(i < a.size() && a[i] == '0')
+				++i;
+			while(j < b.size() && b[j] == '0')
+				++j;
+			zeros_a = i - zeros_a;
+			zeros_b = j - zeros_b;
+			std::size_t end_a = i, end_b = j;
+			while(end_a < a.size() && isDigit(a[end_a]))
+				++end_a;
+			while(end_b < b.size() && isDigit(b[end_b]))
+				++end_b;
+			// without leading zeros the longer number is the larger one
+			if(end_a - i != end_b - j)
+				return (end_a - i < end_b - j) ? -1 : 1;
+			if(int c = a.substr(i, end_a - i).compare(b.substr(j, end_b - j)))
+				return sign(c);
+			if(!tie && zeros_a != zeros_b)
+				tie = (zeros_a < zeros_b) ? -1 : 1;
+			i = end_a;
+			j = end_b;
+		}
+		else {
+			char lower_a = toLower(a[i]), lower_b = toLower(b[j]);
+			if(lower_a != lower_b)
+				return (static_cast<unsigned char>(lower_a) < static_cast<unsigned char>(lower_b)) ? -1 : 1;
+			if(!tie && a[i] != b[j])
+				tie = (static_cast<unsigned char>(a[i]) < static_cast<unsigned char>(b[j])) ? -1 : 1;
+			++i;
+			++j;
+		}
+	}
+	if(i < a.size())
+		return 1;
+	if(j < b.size())
+		return -1;
+	return tie;
+}
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,47 @@
+/*
+ * NaturalOrder.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_NATURALORDER_H_
+#define SRC_SUPPORT_NATURALORDER_H_
+
+#include <string_view>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * Compare two strings in natural order.
+ *
+ * Runs of digits are compared by their numeric value and everything else
+ * byte by byte ignoring ASCII case, so "IMG_9.jpg" comes before
+ * "img_10.jpg". Strings that are equal this way are ordered by their
+ * leading zeros and then by their bytes, so the order is total and only
+ * equal strings compare equal.
+ *
+ * @param a first string
+ * @param b second string
+ * @return negative if 'a' comes before 'b', positive if it comes after,
+ * 		0 if they are equal
+ */
+int naturalCompare(std::string_view a, std::string_view b) noexcept;
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_NATURALORDER_H_ */
@@ -0,0 +1,171 @@
+/*
+ * PerceptualHash.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PerceptualHash.h"
+#include "PixelConversion.h"
+#include <array>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PERCEPTUALHASH_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#define PERCEPTUALHASH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace PhotoLibrary {
+namespace Support {
+namespace PerceptualHash {
+
+namespace {
+
+constexpr int reduced_width = 9;
+constexpr int reduced_height = 8;
+
+/*
+ * Computes 'n' distances.
+ */
+using DistancesFunction = void (*)(std::uint64_t, const std::uint64_t*, std::uint8_t*, std::size_t) noexcept;
+
+/*
+ * Brightness of a premultiplied ARGB32 pixel (ITU-R BT.601 weights, scaled
+ * by 1000). Alpha isn't considered, transparent pixels are dark.
+ */
+constexpr std::uint32_t brightness(std::uint32_t pixel) noexcept {
+	return 299 * (pixel >> 16 & 0xFF) + 587 * (pixel >> 8 & 0xFF) + 114 * (pixel & 0xFF);
+}
+
+#if defined(PERCEPTUALHASH_X86)
+
+__attribute__((target("popcnt")))
+void distancesPOPCNT(std::uint64_t hash, const std::uint64_t* hashes, std::uint8_t* distances, std::size_t n) noexcept {
+	for(std::size_t i = 0; i < n; ++i)
+		distances[i] = static_cast<std::uint8_t>(__builtin_popcountll(hash ^ hashes[i]));
+}
+
+/*
+ * Counts the bits of each byte with a table lookup per nibble (vpshufb),
+ * then adds the counts of the 8 bytes of each hash (vpsadbw).
+ */
+__attribute__((target("avx2")))
+void distancesAVX2(std::uint64_t hash, const std::uint64_t* hashes, std::uint8_t* distances, std::size_t n) noexcept {
+	const __m256i bits = _mm256_setr_epi8(
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+			0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low_nibbles = _mm256_set1_epi8(0x0F);
+	const __m256i query = _mm256_set1_epi64x(static_cast<long long>(hash));
+	std::size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m256i x = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(hashes + i)), query);
+		__m256i counts = _mm256_add_epi8(
+				_mm256_shuffle_epi8(bits, _mm256_and_si256(x, low_nibbles)),
+				_mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibbles)));
+		__m256i sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+		// the distances are in the lowest byte of each 64 bit lane
+		distances[i] = static_cast<std::uint8_t>(_mm256_extract_epi8(sums, 0));
+		distances[i + 1] = static_cast<std::uint8_t>(_mm256_extract_epi8(sums, 8));
+		distances[i + 2] = static_cast<std::uint8_t>(_mm256_extract_epi8(sums, 16));
+		distances[i + 3] = static_cast<std::uint8_t>(_mm256_extract_epi8(sums, 24));
+	}
+	distancesPOPCNT(hash, hashes + i, distances + i, n - i);
+}
+
+#elif defined(PERCEPTUALHASH_NEON)
+
+void distancesNEON(std::uint64_t hash, const std::uint64_t* hashes, std::uint8_t* distances, std::size_t n) noexcept {
+	const uint64x2_t query = vdupq_n_u64(hash);
+	std::size_t i = 0;
+	for(; i + 2 <= n; i += 2) {
+		uint8x16_t counts = vcntq_u8(vreinterpretq_u8_u64(veorq_u64(vld1q_u64(hashes + i), query)));
+		uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(counts)));
+		distances[i] = static_cast<std::uint8_t>(vgetq_lane_u64(sums, 0));
+		distances[i + 1] = static_cast<std::uint8_t>(vgetq_lane_u64(sums, 1));
+	}
+	Scalar::distances(hash, hashes + i, distances + i, n - i);
+}
+
+#endif
+
+/*
+ * The functions for the instruction set of the CPU.
+ */
+struct Kernels {
+	DistancesFunction distances;
+	const char* instruction_set;
+};
+
+Kernels selectKernels() noexcept {
+#if defined(PERCEPTUALHASH_X86)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+		return {distancesAVX2, "AVX2"};
+	if(__builtin_cpu_supports("popcnt"))
+		return {distancesPOPCNT, "POPCNT"};
+	return {Scalar::distances, "scalar"};
+#elif defined(PERCEPTUALHASH_NEON)
+	return {distancesNEON, "NEON"};
+#else
+	return {Scalar::distances, "scalar"};
+#endif
+}
+
+const Kernels& getKernels() noexcept {
+	static const Kernels kernels = selectKernels();
+	return kernels;
+}
+
+}
+
+std::uint64_t differenceHash(const unsigned char* pixels, int width, int height, std::size_t stride) {
+	if(width <= 0 || height <= 0)
+		throw std::invalid_argument("Cannot hash an empty image");
+
+	std::array<std::uint32_t,reduced_width * reduced_height> reduced;
+	PixelConversion::downscale(pixels, width, height, stride, reinterpret_cast<unsigned char*>(reduced.data()),
+			reduced_width, reduced_height, reduced_width * sizeof(std::uint32_t));
+
+	std::uint64_t hash = 0;
+	for(int y = 0; y < reduced_height; ++y)
+		for(int x = 0; x + 1 < reduced_width; ++x)
+			if(brightness(reduced[y * reduced_width + x]) < brightness(reduced[y * reduced_width + x + 1]))
+				hash |= std::uint64_t{1} << (8 * y + x);
+	return hash;
+}
+
+void distances(std::uint64_t hash, const std::uint64_t* hashes, std::uint8_t* distances, std::size_t n) noexcept {
+	getKernels().distances(hash, hashes, distances, n);
+}
+
+const char* getInstructionSet() noexcept {
+	return getKernels().instruction_set;
+}
+
+namespace Scalar {
+
+void distances(std::uint64_t hash, const std::uint64_t* hashes, std::uint8_t* distances, std::size_t n) noexcept {
+	for(std::size_t i = 0; i < n; ++i)
+		distances[i] = static_cast<std::uint8_t>(PerceptualHash::distance(hash, hashes[i]));
+}
+
+} /* namespace Scalar */
+
+} /* namespace PerceptualHash */
+} /* namespace Support */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,104 @@
+/*
+ * PerceptualHash.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_PERCEPTUALHASH_H_
+#define SRC_SUPPORT_PERCEPTUALHASH_H_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * Perceptual hashes of images for finding duplicates and near-duplicates.
+ *
+ * The hash is a 64 bit difference hash (dHash): the image is reduced to
+ * 9x8 pixels, every bit tells whether the brightness increases from a
+ * pixel to its right neighbour. Scaled, recompressed, or slightly edited
+ * copies of an image get hashes differing in only a few bits, so the
+ * similarity of two images is the Hamming distance of their hashes.
+ *
+ * distances() uses SIMD instructions where available (AVX2 or POPCNT on
+ * x86-64, chosen at runtime, NEON on AArch64); PerceptualHash::Scalar
+ * contains the plain C++ version with identical results.
+ */
+namespace PerceptualHash {
+
+/**
+ * Compute the difference hash of an image.
+ *
+ * @param pixels first row of the image in Cairo's ARGB32 format (see
+ * 		PixelConversion)
+ * @param width width of the image in pixels
+ * @param height height of the image in pixels
+ * @param stride distance between the rows in bytes
+ * @return the hash; bit 8 * y + x is set if pixel (x, y) of the reduced
+ * 		image is darker than pixel (x + 1, y)
+ *
+ * @throws std::invalid_argument if the image is empty
+ */
+std::uint64_t differenceHash(const unsigned char* pixels, int width, int height, std::size_t stride);
+
+/**
+ * Hamming distance of two hashes.
+ *
+ * @param a a hash
+ * @param b another hash
+ * @return number of differing bits (0 to 64)
+ */
+inline int distance(std::uint64_t a, std::uint64_t b) noexcept { return std::popcount(a ^ b); }
+
+/**
+ * Hamming distances of a hash to many hashes.
+ *
+ * @param hash the hash to compare
+ * @param hashes 'n' hashes
+ * @param[out] distances 'n' distances, distances[i] is the distance of
+ * 		'hash' and hashes[i]
+ * @param n number of hashes
+ */
+void distances(std::uint64_t hash, const std::uint64_t* hashes, std::uint8_t* distances, std::size_t n) noexcept;
+
+/**
+ * Get the name of the instruction set used by distances().
+ *
+ * @return "AVX2", "POPCNT", "NEON", or "scalar"
+ */
+const char* getInstructionSet() noexcept;
+
+/**
+ * Scalar versions of the functions using SIMD instructions.
+ */
+namespace Scalar {
+
+/**
+ * \copydoc PerceptualHash::distances()
+ */
+void distances(std::uint64_t hash, const std::uint64_t* hashes, std::uint8_t* distances, std::size_t n) noexcept;
+
+} /* namespace Scalar */
+
+} /* namespace PerceptualHash */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_PERCEPTUALHASH_H_ */
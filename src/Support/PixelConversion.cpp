@@ -0,0 +1,346 @@
+/*
+ * PixelConversion.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PixelConversion.h"
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PIXELCONVERSION_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define PIXELCONVERSION_NEON
+#include <arm_neon.h>
+#endif
+
+namespace PhotoLibrary {
+namespace Support {
+namespace PixelConversion {
+
+namespace {
+
+/*
+ * Converts 'n' pixels.
+ */
+using ConvertFunction = void (*)(const unsigned char*, std::uint32_t*, std::size_t) noexcept;
+
+/*
+ * Adds 'n' bytes to 'n' sums.
+ */
+using AccumulateFunction = void (*)(const unsigned char*, std::uint32_t*, std::size_t) noexcept;
+
+/*
+ * round(c * a / 255) for c, a in [0, 255], without division.
+ */
+constexpr std::uint32_t premultiply(std::uint32_t c, std::uint32_t a) noexcept {
+	std::uint32_t t = c * a + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+void accumulateScalar(const unsigned char* source, std::uint32_t* sums, std::size_t n) noexcept {
+	for(std::size_t i = 0; i < n; ++i)
+		sums[i] += source[i];
+}
+
+/*
+ * Box filter: for each destination row the source rows mapped onto it
+ * are summed up with 'accumulate', then the sums are averaged
+ * horizontally. All but the summation of the rows is scalar.
+ */
+void boxFilter(AccumulateFunction accumulate,
+		const unsigned char* source, int source_width, int source_height, std::size_t source_stride,
+		unsigned char* destination, int width, int height, std::size_t stride) {
+	if(source_width <= 0 || source_height <= 0 || width <= 0 || height <= 0)
+		return;
+	std::vector<std::uint32_t> sums(4 * static_cast<std::size_t>(source_width));
+	auto range = [](int i, int source_size, int size) {
+		int begin = static_cast<int>(static_cast<std::int64_t>(i) * source_size / size);
+		int end = static_cast<int>(static_cast<std::int64_t>(i + 1) * source_size / size);
+		return std::make_pair(begin, std::max(begin + 1, end));
+	};
+	for(int y = 0; y < height; ++y) {
+		auto [y_begin, y_end] = range(y, source_height, height);
+		std::fill(sums.begin(), sums.end(), 0);
+		for(int source_y = y_begin; source_y < y_end; ++source_y)
+			accumulate(source + source_y * source_stride, sums.data(), sums.size());
+
+		unsigned char* row = destination + y * stride;
+		for(int x = 0; x < width; ++x) {
+			auto [x_begin, x_end] = range(x, source_width, width);
+			std::uint64_t count = static_cast<std::uint64_t>(x_end - x_begin) * (y_end - y_begin);
+			std::uint64_t channels[4] {};
+			for(int source_x = x_begin; source_x < x_end; ++source_x)
+				for(int c = 0; c < 4; ++c)
+					channels[c] += sums[4 * source_x + c];
+			for(int c = 0; c < 4; ++c)
+				row[4 * x + c] = static_cast<unsigned char>((channels[c] + count / 2) / count);
+		}
+	}
+}
+
+#if defined(PIXELCONVERSION_X86)
+
+__attribute__((target("ssse3")))
+void rgbToARGB32SSSE3(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	// 4 pixels from 12 bytes: B G R 0 for each pixel, alpha is added
+	const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+	std::size_t i = 0;
+	// 16 bytes are read for 12, stop before reading past the end
+	for(; i + 6 <= n; i += 4) {
+		__m128i rgb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 3 * i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i),
+				_mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+	}
+	Scalar::rgbToARGB32(source + 3 * i, destination + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void rgbToARGB32AVX2(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	// the shuffle works within 128 bit lanes: 4 pixels in each lane
+	const __m256i shuffle = _mm256_setr_epi8(
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+			2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+	const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+	std::size_t i = 0;
+	// the upper lane reads 16 bytes from byte 12
+	for(; i + 10 <= n; i += 8) {
+		__m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 3 * i));
+		__m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 3 * i + 12));
+		__m256i rgb = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i),
+				_mm256_or_si256(_mm256_shuffle_epi8(rgb, shuffle), alpha));
+	}
+	Scalar::rgbToARGB32(source + 3 * i, destination + i, n - i);
+}
+
+/*
+ * Premultiplies 2 pixels widened to 16 bit (R G B A R G B A) and swaps R
+ * and B.
+ */
+inline __m128i premultiplySSE2(__m128i pixels) noexcept {
+	// multiply the colour channels by alpha and alpha by 255
+	const __m128i colour_mask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+	const __m128i alpha_255 = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+	const __m128i rounding = _mm_set1_epi16(128);
+	__m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm_or_si128(_mm_and_si128(alpha, colour_mask), alpha_255);
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha), rounding);
+	t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(t, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+void rgbaToARGB32SSE2(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	const __m128i zero = _mm_setzero_si128();
+	std::size_t i = 0;
+	for(; i + 4 <= n; i += 4) {
+		__m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 4 * i));
+		__m128i low = premultiplySSE2(_mm_unpacklo_epi8(rgba, zero));
+		__m128i high = premultiplySSE2(_mm_unpackhi_epi8(rgba, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16(low, high));
+	}
+	Scalar::rgbaToARGB32(source + 4 * i, destination + i, n - i);
+}
+
+/*
+ * \copydoc premultiplySSE2()
+ * 4 pixels, 2 in each 128 bit lane.
+ */
+__attribute__((target("avx2")))
+inline __m256i premultiplyAVX2(__m256i pixels) noexcept {
+	const __m256i colour_mask = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+	const __m256i alpha_255 = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+	const __m256i rounding = _mm256_set1_epi16(128);
+	__m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	alpha = _mm256_or_si256(_mm256_and_si256(alpha, colour_mask), alpha_255);
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(pixels, alpha), rounding);
+	t = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+	return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(t, _MM_SHUFFLE(3, 0, 1, 2)), _MM_SHUFFLE(3, 0, 1, 2));
+}
+
+__attribute__((target("avx2")))
+void rgbaToARGB32AVX2(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	const __m256i zero = _mm256_setzero_si256();
+	std::size_t i = 0;
+	// unpacking and packing both work within the lanes, so the order is kept
+	for(; i + 8 <= n; i += 8) {
+		__m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 4 * i));
+		__m256i low = premultiplyAVX2(_mm256_unpacklo_epi8(rgba, zero));
+		__m256i high = premultiplyAVX2(_mm256_unpackhi_epi8(rgba, zero));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_packus_epi16(low, high));
+	}
+	Scalar::rgbaToARGB32(source + 4 * i, destination + i, n - i);
+}
+
+void accumulateSSE2(const unsigned char* source, std::uint32_t* sums, std::size_t n) noexcept {
+	const __m128i zero = _mm_setzero_si128();
+	std::size_t i = 0;
+	for(; i + 16 <= n; i += 16) {
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+		__m128i low = _mm_unpacklo_epi8(bytes, zero);
+		__m128i high = _mm_unpackhi_epi8(bytes, zero);
+		__m128i* sum = reinterpret_cast<__m128i*>(sums + i);
+		_mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), _mm_unpacklo_epi16(low, zero)));
+		_mm_storeu_si128(sum + 1, _mm_add_epi32(_mm_loadu_si128(sum + 1), _mm_unpackhi_epi16(low, zero)));
+		_mm_storeu_si128(sum + 2, _mm_add_epi32(_mm_loadu_si128(sum + 2), _mm_unpacklo_epi16(high, zero)));
+		_mm_storeu_si128(sum + 3, _mm_add_epi32(_mm_loadu_si128(sum + 3), _mm_unpackhi_epi16(high, zero)));
+	}
+	accumulateScalar(source + i, sums + i, n - i);
+}
+
+__attribute__((target("avx2")))
+void accumulateAVX2(const unsigned char* source, std::uint32_t* sums, std::size_t n) noexcept {
+	std::size_t i = 0;
+	for(; i + 8 <= n; i += 8) {
+		__m256i bytes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i)));
+		__m256i* sum = reinterpret_cast<__m256i*>(sums + i);
+		_mm256_storeu_si256(sum, _mm256_add_epi32(_mm256_loadu_si256(sum), bytes));
+	}
+	accumulateScalar(source + i, sums + i, n - i);
+}
+
+#elif defined(PIXELCONVERSION_NEON)
+
+void rgbToARGB32NEON(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	std::size_t i = 0;
+	for(; i + 16 <= n; i += 16) {
+		uint8x16x3_t rgb = vld3q_u8(source + 3 * i);
+		uint8x16x4_t bgra {{rgb.val[2], rgb.val[1], rgb.val[0], vdupq_n_u8(0xFF)}};
+		vst4q_u8(reinterpret_cast<std::uint8_t*>(destination + i), bgra);
+	}
+	Scalar::rgbToARGB32(source + 3 * i, destination + i, n - i);
+}
+
+/*
+ * round(c * a / 255) for 16 channels.
+ */
+inline uint8x16_t premultiplyNEON(uint8x16_t c, uint8x16_t a) noexcept {
+	const uint16x8_t rounding = vdupq_n_u16(128);
+	uint16x8_t low = vmlal_u8(rounding, vget_low_u8(c), vget_low_u8(a));
+	uint16x8_t high = vmlal_u8(rounding, vget_high_u8(c), vget_high_u8(a));
+	return vcombine_u8(vshrn_n_u16(vaddq_u16(low, vshrq_n_u16(low, 8)), 8),
+			vshrn_n_u16(vaddq_u16(high, vshrq_n_u16(high, 8)), 8));
+}
+
+void rgbaToARGB32NEON(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	std::size_t i = 0;
+	for(; i + 16 <= n; i += 16) {
+		uint8x16x4_t rgba = vld4q_u8(source + 4 * i);
+		uint8x16x4_t bgra {{
+			premultiplyNEON(rgba.val[2], rgba.val[3]),
+			premultiplyNEON(rgba.val[1], rgba.val[3]),
+			premultiplyNEON(rgba.val[0], rgba.val[3]),
+			rgba.val[3]}};
+		vst4q_u8(reinterpret_cast<std::uint8_t*>(destination + i), bgra);
+	}
+	Scalar::rgbaToARGB32(source + 4 * i, destination + i, n - i);
+}
+
+void accumulateNEON(const unsigned char* source, std::uint32_t* sums, std::size_t n) noexcept {
+	std::size_t i = 0;
+	for(; i + 16 <= n; i += 16) {
+		uint8x16_t bytes = vld1q_u8(source + i);
+		uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+		uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+		vst1q_u32(sums + i, vaddw_u16(vld1q_u32(sums + i), vget_low_u16(low)));
+		vst1q_u32(sums + i + 4, vaddw_u16(vld1q_u32(sums + i + 4), vget_high_u16(low)));
+		vst1q_u32(sums + i + 8, vaddw_u16(vld1q_u32(sums + i + 8), vget_low_u16(high)));
+		vst1q_u32(sums + i + 12, vaddw_u16(vld1q_u32(sums + i + 12), vget_high_u16(high)));
+	}
+	accumulateScalar(source + i, sums + i, n - i);
+}
+
+#endif
+
+/*
+ * The functions for the instruction set of the CPU.
+ */
+struct Kernels {
+	ConvertFunction rgb;
+	ConvertFunction rgba;
+	AccumulateFunction accumulate;
+	const char* instruction_set;
+};
+
+Kernels selectKernels() noexcept {
+#if defined(PIXELCONVERSION_X86)
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return {rgbToARGB32AVX2, rgbaToARGB32AVX2, accumulateAVX2, "AVX2"};
+	// SSE2 is part of x86-64, the RGB shuffle needs SSSE3
+	return {__builtin_cpu_supports("ssse3") ? rgbToARGB32SSSE3 : Scalar::rgbToARGB32,
+			rgbaToARGB32SSE2, accumulateSSE2, "SSE2"};
+#elif defined(PIXELCONVERSION_NEON)
+	return {rgbToARGB32NEON, rgbaToARGB32NEON, accumulateNEON, "NEON"};
+#else
+	return {Scalar::rgbToARGB32, Scalar::rgbaToARGB32, accumulateScalar, "scalar"};
+#endif
+}
+
+const Kernels& getKernels() noexcept {
+	static const Kernels kernels = selectKernels();
+	return kernels;
+}
+
+}
+
+void rgbToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	getKernels().rgb(source, destination, n);
+}
+
+void rgbaToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	getKernels().rgba(source, destination, n);
+}
+
+void downscale(const unsigned char* source, int source_width, int source_height, std::size_t source_stride,
+		unsigned char* destination, int width, int height, std::size_t stride) {
+	boxFilter(getKernels().accumulate,
+			source, source_width, source_height, source_stride, destination, width, height, stride);
+}
+
+const char* getInstructionSet() noexcept {
+	return getKernels().instruction_set;
+}
+
+namespace Scalar {
+
+void rgbToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	for(std::size_t i = 0; i < n; ++i, source += 3)
+		destination[i] = 0xFF000000u | std::uint32_t{source[0]} << 16 | std::uint32_t{source[1]} << 8 | source[2];
+}
+
+void rgbaToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept {
+	for(std::size_t i = 0; i < n; ++i, source += 4) {
+		std::uint32_t alpha = source[3];
+		destination[i] = alpha << 24 | premultiply(source[0], alpha) << 16 |
+				premultiply(source[1], alpha) << 8 | premultiply(source[2], alpha);
+	}
+}
+
+void downscale(const unsigned char* source, int source_width, int source_height, std::size_t source_stride,
+		unsigned char* destination, int width, int height, std::size_t stride) {
+	boxFilter(accumulateScalar,
+			source, source_width, source_height, source_stride, destination, width, height, stride);
+}
+
+} /* namespace Scalar */
+
+} /* namespace PixelConversion */
+} /* namespace Support */
+} /* namespace PhotoLibrary */
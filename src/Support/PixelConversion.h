@@ -0,0 +1,116 @@
+/*
+ * PixelConversion.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_PIXELCONVERSION_H_
+#define SRC_SUPPORT_PIXELCONVERSION_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * Conversion of decoded images into the pixel format of Cairo.
+ *
+ * Cairo's ARGB32 stores each pixel as a native endian 32 bit word
+ * 0xAARRGGBB with the colour channels premultiplied by alpha.
+ *
+ * The functions in this namespace use SIMD instructions where available
+ * (AVX2 or SSE2/SSSE3 on x86-64, chosen at runtime, NEON on AArch64);
+ * the functions in PixelConversion::Scalar are the plain C++ versions
+ * with identical results, used for the remainders and for comparison.
+ */
+namespace PixelConversion {
+
+/**
+ * Convert RGB pixels (3 bytes per pixel, no alpha) into ARGB32.
+ *
+ * @param source 'n' RGB pixels
+ * @param[out] destination 'n' ARGB32 pixels
+ * @param n number of pixels
+ */
+void rgbToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept;
+
+/**
+ * Convert RGBA pixels (4 bytes per pixel, not premultiplied) into ARGB32.
+ * Channels are premultiplied as round(c * a / 255).
+ *
+ * @param source 'n' RGBA pixels
+ * @param[out] destination 'n' ARGB32 pixels
+ * @param n number of pixels
+ */
+void rgbaToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept;
+
+/**
+ * Downscale an image of 4 byte pixels with a box filter.
+ *
+ * Each destination pixel is the rounded average of the source pixels
+ * mapped onto it; all four channels are averaged independently, so the
+ * pixels should be premultiplied (e.g. ARGB32). If the destination is
+ * larger than the source in a dimension, pixels are repeated.
+ *
+ * @param source first row of the source image
+ * @param source_width width of the source image in pixels
+ * @param source_height height of the source image in pixels
+ * @param source_stride distance between the rows of the source in bytes
+ * @param[out] destination first row of the destination image
+ * @param width width of the destination image in pixels
+ * @param height height of the destination image in pixels
+ * @param stride distance between the rows of the destination in bytes
+ */
+void downscale(const unsigned char* source, int source_width, int source_height, std::size_t source_stride,
+		unsigned char* destination, int width, int height, std::size_t stride);
+
+/**
+ * Get the name of the instruction set used.
+ *
+ * @return "AVX2", "SSE2", "NEON", or "scalar"
+ */
+const char* getInstructionSet() noexcept;
+
+/**
+ * Scalar versions of the conversion functions.
+ */
+namespace Scalar {
+
+/**
+ * \copydoc PixelConversion::rgbToARGB32()
+ */
+void rgbToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept;
+
+/**
+ * \copydoc PixelConversion::rgbaToARGB32()
+ */
+void rgbaToARGB32(const unsigned char* source, std::uint32_t* destination, std::size_t n) noexcept;
+
+/**
+ * \copydoc PixelConversion::downscale()
+ */
+void downscale(const unsigned char* source, int source_width, int source_height, std::size_t source_stride,
+		unsigned char* destination, int width, int height, std::size_t stride);
+
+} /* namespace Scalar */
+
+} /* namespace PixelConversion */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_PIXELCONVERSION_H_ */
@@ -0,0 +1,373 @@
+/*
+ * RoaringBitmap.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "RoaringBitmap.h"
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace PhotoLibrary {
+namespace Support {
+
+RoaringBitmap::RoaringBitmap(std::initializer_list<value_type> values) :
+		RoaringBitmap(values.begin(), values.end()) {}
+
+bool RoaringBitmap::add(value_type value) {
+	return addToContainer(getOrInsertContainer(value >> 16), value & 0xFFFF);
+}
+
+bool RoaringBitmap::remove(value_type value) {
+	std::size_t i = findKey(value >> 16);
+	if(i == keys.size() || keys[i] != value >> 16)
+		return false;
+	if(!removeFromContainer(containers[i], value & 0xFFFF))
+		return false;
+	if(!containers[i].cardinality) {
+		keys.erase(keys.begin() + i);
+		containers.erase(containers.begin() + i);
+	}
+	return true;
+}
+
+bool RoaringBitmap::contains(value_type value) const noexcept {
+	std::size_t i = findKey(value >> 16);
+	return i < keys.size() && keys[i] == value >> 16 && containerContains(containers[i], value & 0xFFFF);
+}
+
+RoaringBitmap::size_type RoaringBitmap::cardinality() const noexcept {
+	size_type n = 0;
+	for(const Container& container : containers)
+		n += container.cardinality;
+	return n;
+}
+
+bool RoaringBitmap::empty() const noexcept {
+	return keys.empty();
+}
+
+void RoaringBitmap::clear() noexcept {
+	keys.clear();
+	containers.clear();
+}
+
+RoaringBitmap::size_type RoaringBitmap::andCardinality(const RoaringBitmap& other) const noexcept {
+	size_type n = 0;
+	for(std::size_t i = 0, j = 0; i < keys.size() && j < other.keys.size();) {
+		if(keys[i] < other.keys[j])
+			++i;
+		else if(keys[i] > other.keys[j])
+			++j;
+		else
+			n += intersectCardinality(containers[i++], other.containers[j++]);
+	}
+	return n;
+}
+
+std::vector<RoaringBitmap::value_type> RoaringBitmap::toVector() const {
+	std::vector<value_type> values;
+	values.reserve(cardinality());
+	for(std::size_t i = 0; i < keys.size(); ++i) {
+		value_type high = static_cast<value_type>(keys[i]) << 16;
+		const Container& container = containers[i];
+		if(container.bitmap.empty())
+			for(std::uint16_t low : container.array)
+				values.push_back(high | low);
+		else
+			for(std::size_t w = 0; w < bitmap_words; ++w)
+				for(std::uint64_t word = container.bitmap[w]; word; word &= word - 1)
+					values.push_back(high | static_cast<value_type>(w * 64 + std::countr_zero(word)));
+	}
+	return values;
+}
+
+RoaringBitmap& RoaringBitmap::operator&=(const RoaringBitmap& other) {
+	return *this = *this & other;
+}
+
+RoaringBitmap& RoaringBitmap::operator|=(const RoaringBitmap& other) {
+	return *this = *this | other;
+}
+
+RoaringBitmap& RoaringBitmap::operator-=(const RoaringBitmap& other) {
+	return *this = *this - other;
+}
+
+RoaringBitmap operator&(const RoaringBitmap& a, const RoaringBitmap& b) {
+	RoaringBitmap result;
+	for(std::size_t i = 0, j = 0; i < a.keys.size() && j < b.keys.size();) {
+		if(a.keys[i] < b.keys[j])
+			++i;
+		else if(a.keys[i] > b.keys[j])
+			++j;
+		else {
+			RoaringBitmap::Container container = RoaringBitmap::intersect(a.containers[i], b.containers[j]);
+			if(container.cardinality) {
+				result.keys.push_back(a.keys[i]);
+				result.containers.push_back(std::move(container));
+			}
+			++i;
+			++j;
+		}
+	}
+	return result;
+}
+
+RoaringBitmap operator|(const RoaringBitmap& a, const RoaringBitmap& b) {
+	RoaringBitmap result;
+	std::size_t i = 0, j = 0;
+	while(i < a.keys.size() || j < b.keys.size()) {
+		if(j == b.keys.size() || (i < a.keys.size() && a.keys[i] < b.keys[j])) {
+			result.keys.push_back(a.keys[i]);
+			result.containers.push_back(a.containers[i++]);
+		}
+		else if(i == a.keys.size() || a.keys[i] > b.keys[j]) {
+			result.keys.push_back(b.keys[j]);
+			result.containers.push_back(b.containers[j++]);
+		}
+		else {
+			result.keys.push_back(a.keys[i]);
+			result.containers.push_back(RoaringBitmap::unite(a.containers[i++], b.containers[j++]));
+		}
+	}
+	return result;
+}
+
+RoaringBitmap operator-(const RoaringBitmap& a, const RoaringBitmap& b) {
+	RoaringBitmap result;
+	for(std::size_t i = 0, j = 0; i < a.keys.size(); ++i) {
+		while(j < b.keys.size() && b.keys[j] < a.keys[i])
+			++j;
+		if(j < b.keys.size() && b.keys[j] == a.keys[i]) {
+			RoaringBitmap::Container container = RoaringBitmap::subtract(a.containers[i], b.containers[j]);
+			if(container.cardinality) {
+				result.keys.push_back(a.keys[i]);
+				result.containers.push_back(std::move(container));
+			}
+		}
+		else {
+			result.keys.push_back(a.keys[i]);
+			result.containers.push_back(a.containers[i]);
+		}
+	}
+	return result;
+}
+
+bool operator==(const RoaringBitmap& a, const RoaringBitmap& b) noexcept {
+	// containers are always normalised, so equal sets have equal representations
+	return a.keys == b.keys && a.containers == b.containers;
+}
+
+std::size_t RoaringBitmap::findKey(std::uint16_t key) const noexcept {
+	return std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+}
+
+RoaringBitmap::Container& RoaringBitmap::getOrInsertContainer(std::uint16_t key) {
+	std::size_t i = findKey(key);
+	if(i == keys.size() || keys[i] != key) {
+		keys.insert(keys.begin() + i, key);
+		containers.insert(containers.begin() + i, Container());
+	}
+	return containers[i];
+}
+
+bool RoaringBitmap::addToContainer(Container& container, std::uint16_t value) {
+	if(!container.bitmap.empty()) {
+		std::uint64_t& word = container.bitmap[value >> 6];
+		std::uint64_t bit = std::uint64_t(1) << (value & 63);
+		if(word & bit)
+			return false;
+		word |= bit;
+		++container.cardinality;
+		return true;
+	}
+
+	// appending is the common case when adding sorted values
+	auto position = (container.array.empty() || container.array.back() < value) ?
+			container.array.end() :
+			std::lower_bound(container.array.begin(), container.array.end(), value);
+	if(position != container.array.end() && *position == value)
+		return false;
+	container.array.insert(position, value);
+	++container.cardinality;
+	if(container.cardinality > max_array_size)
+		toBitmapContainer(container);
+	return true;
+}
+
+bool RoaringBitmap::removeFromContainer(Container& container, std::uint16_t value) {
+	if(!container.bitmap.empty()) {
+		std::uint64_t& word = container.bitmap[value >> 6];
+		std::uint64_t bit = std::uint64_t(1) << (value & 63);
+		if(!(word & bit))
+			return false;
+		word &= ~bit;
+		--container.cardinality;
+		if(container.cardinality <= max_array_size)
+			toArrayContainer(container);
+		return true;
+	}
+
+	auto position = std::lower_bound(container.array.begin(), container.array.end(), value);
+	if(position == container.array.end() || *position != value)
+		return false;
+	container.array.erase(position);
+	--container.cardinality;
+	return true;
+}
+
+bool RoaringBitmap::containerContains(const Container& container, std::uint16_t value) noexcept {
+	if(!container.bitmap.empty())
+		return container.bitmap[value >> 6] & (std::uint64_t(1) << (value & 63));
+	return std::binary_search(container.array.begin(), container.array.end(), value);
+}
+
+void RoaringBitmap::toBitmapContainer(Container& container) {
+	container.bitmap.assign(bitmap_words, 0);
+	for(std::uint16_t value : container.array)
+		container.bitmap[value >> 6] |= std::uint64_t(1) << (value & 63);
+	container.array.clear();
+	container.array.shrink_to_fit();
+}
+
+void RoaringBitmap::toArrayContainer(Container& container) {
+	container.array.clear();
+	container.array.reserve(container.cardinality);
+	for(std::size_t w = 0; w < bitmap_words; ++w)
+		for(std::uint64_t word = container.bitmap[w]; word; word &= word - 1)
+			container.array.push_back(static_cast<std::uint16_t>(w * 64 + std::countr_zero(word)));
+	container.bitmap.clear();
+	container.bitmap.shrink_to_fit();
+}
+
+void RoaringBitmap::normalise(Container& container) {
+	if(container.bitmap.empty() && container.cardinality > max_array_size)
+		toBitmapContainer(container);
+	else if(!container.bitmap.empty() && container.cardinality <= max_array_size)
+		toArrayContainer(container);
+}
+
+RoaringBitmap::Container RoaringBitmap::intersect(const Container& a, const Container& b) {
+	Container result;
+	if(!a.bitmap.empty() && !b.bitmap.empty()) {
+		result.bitmap.resize(bitmap_words);
+		for(std::size_t w = 0; w < bitmap_words; ++w) {
+			result.bitmap[w] = a.bitmap[w] & b.bitmap[w];
+			result.cardinality += std::popcount(result.bitmap[w]);
+		}
+	}
+	else if(a.bitmap.empty() && b.bitmap.empty()) {
+		std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+				std::back_inserter(result.array));
+		result.cardinality = result.array.size();
+	}
+	else {
+		const Container& array = a.bitmap.empty() ? a : b;
+		const Container& bitmap = a.bitmap.empty() ? b : a;
+		for(std::uint16_t value : array.array)
+			if(containerContains(bitmap, value))
+				result.array.push_back(value);
+		result.cardinality = result.array.size();
+	}
+	normalise(result);
+	return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::unite(const Container& a, const Container& b) {
+	Container result;
+	if(a.bitmap.empty() && b.bitmap.empty()) {
+		result.array.reserve(a.array.size() + b.array.size());
+		std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+				std::back_inserter(result.array));
+		result.cardinality = result.array.size();
+	}
+	else {
+		if(!a.bitmap.empty() && !b.bitmap.empty()) {
+			result.bitmap.resize(bitmap_words);
+			for(std::size_t w = 0; w < bitmap_words; ++w)
+				result.bitmap[w] = a.bitmap[w] | b.bitmap[w];
+		}
+		else {
+			const Container& array = a.bitmap.empty() ? a : b;
+			const Container& bitmap = a.bitmap.empty() ? b : a;
+			result.bitmap = bitmap.bitmap;
+			for(std::uint16_t value : array.array)
+				result.bitmap[value >> 6] |= std::uint64_t(1) << (value & 63);
+		}
+		for(std::uint64_t word : result.bitmap)
+			result.cardinality += std::popcount(word);
+	}
+	normalise(result);
+	return result;
+}
+
+RoaringBitmap::Container RoaringBitmap::subtract(const Container& a, const Container& b) {
+	Container result;
+	if(a.bitmap.empty()) {
+		if(b.bitmap.empty())
+			std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+					std::back_inserter(result.array));
+		else
+			for(std::uint16_t value : a.array)
+				if(!containerContains(b, value))
+					result.array.push_back(value);
+		result.cardinality = result.array.size();
+	}
+	else {
+		result.bitmap = a.bitmap;
+		if(b.bitmap.empty())
+			for(std::uint16_t value : b.array)
+				result.bitmap[value >> 6] &= ~(std::uint64_t(1) << (value & 63));
+		else
+			for(std::size_t w = 0; w < bitmap_words; ++w)
+				result.bitmap[w] &= ~b.bitmap[w];
+		for(std::uint64_t word : result.bitmap)
+			result.cardinality += std::popcount(word);
+	}
+	normalise(result);
+	return result;
+}
+
+std::uint32_t RoaringBitmap::intersectCardinality(const Container& a, const Container& b) noexcept {
+	std::uint32_t n = 0;
+	if(!a.bitmap.empty() && !b.bitmap.empty())
+		for(std::size_t w = 0; w < bitmap_words; ++w)
+			n += std::popcount(a.bitmap[w] & b.bitmap[w]);
+	else if(a.bitmap.empty() && b.bitmap.empty())
+		for(auto i = a.array.begin(), j = b.array.begin(); i != a.array.end() && j != b.array.end();) {
+			if(*i < *j)
+				++i;
+			else if(*j < *i)
+				++j;
+			else {
+				++n;
+				++i;
+				++j;
+			}
+		}
+	else {
+		const Container& array = a.bitmap.empty() ? a : b;
+		const Container& bitmap = a.bitmap.empty() ? b : a;
+		for(std::uint16_t value : array.array)
+			n += containerContains(bitmap, value);
+	}
+	return n;
+}
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
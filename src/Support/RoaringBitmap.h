@@ -0,0 +1,210 @@
+/*
+ * RoaringBitmap.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_ROARINGBITMAP_H_
+#define SRC_SUPPORT_ROARINGBITMAP_H_
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * Compressed bitmap of 32 bit unsigned integers.
+ *
+ * The values are partitioned into chunks of 2^16 values sharing the
+ * upper 16 bits. Each chunk is stored in a container that is either
+ * a sorted array of the lower 16 bits (up to 4096 values) or a
+ * bitmap of 2^16 bits (more than 4096 values). This keeps sparse sets
+ * small and makes set operations on dense sets a matter of bitwise
+ * operations on 64 bit words.
+ *
+ * @see https://roaringbitmap.org/
+ */
+class RoaringBitmap {
+public:
+	using value_type = std::uint32_t;
+	using size_type = std::uint64_t;
+
+	/**
+	 * Creates an empty bitmap.
+	 */
+	RoaringBitmap() noexcept = default;
+
+	/**
+	 * Creates a bitmap containing 'values'.
+	 *
+	 * @param values values to add to the bitmap
+	 */
+	RoaringBitmap(std::initializer_list<value_type> values);
+
+	/**
+	 * Creates a bitmap containing the values in [first, last).
+	 * Inserting sorted values is faster than inserting unsorted ones.
+	 *
+	 * @tparam InputIt input iterator with a value type convertible
+	 * 		to value_type
+	 * @param first iterator to the first value
+	 * @param last iterator past the last value
+	 */
+	template<typename InputIt>
+	RoaringBitmap(InputIt first, InputIt last);
+
+	~RoaringBitmap() = default;
+	RoaringBitmap(const RoaringBitmap&) = default;
+	RoaringBitmap(RoaringBitmap&&) noexcept = default;
+	RoaringBitmap& operator=(const RoaringBitmap&) = default;
+	RoaringBitmap& operator=(RoaringBitmap&&) noexcept = default;
+
+	/**
+	 * Add a value.
+	 *
+	 * @param value value to add
+	 * @retval true if 'value' was added
+	 * @retval false if 'value' was already in the bitmap
+	 */
+	bool add(value_type value);
+
+	/**
+	 * Remove a value.
+	 *
+	 * @param value value to remove
+	 * @retval true if 'value' was removed
+	 * @retval false if 'value' wasn't in the bitmap
+	 */
+	bool remove(value_type value);
+
+	/**
+	 * Whether the bitmap contains a value.
+	 *
+	 * @param value value to look for
+	 * @retval true if 'value' is in the bitmap
+	 * @retval false otherwise
+	 */
+	bool contains(value_type value) const noexcept;
+
+	/**
+	 * Number of values in the bitmap.
+	 *
+	 * @return number of values in the bitmap
+	 */
+	size_type cardinality() const noexcept;
+
+	/**
+	 * Whether the bitmap is empty.
+	 *
+	 * @retval true if the bitmap is empty
+	 * @retval false otherwise
+	 */
+	bool empty() const noexcept;
+
+	/**
+	 * Remove all values.
+	 */
+	void clear() noexcept;
+
+	/**
+	 * Number of values in both bitmaps.
+	 * Same as (*this & other).cardinality() without creating the
+	 * intersection.
+	 *
+	 * @param other bitmap to intersect with
+	 * @return number of values in both bitmaps
+	 */
+	size_type andCardinality(const RoaringBitmap& other) const noexcept;
+
+	/**
+	 * Get the values in ascending order.
+	 *
+	 * @return sorted vector of all values in the bitmap
+	 */
+	std::vector<value_type> toVector() const;
+
+	/**
+	 * Intersection (AND).
+	 */
+	RoaringBitmap& operator&=(const RoaringBitmap& other);
+
+	/**
+	 * Union (OR).
+	 */
+	RoaringBitmap& operator|=(const RoaringBitmap& other);
+
+	/**
+	 * Difference (AND NOT).
+	 */
+	RoaringBitmap& operator-=(const RoaringBitmap& other);
+
+	friend RoaringBitmap operator&(const RoaringBitmap& a, const RoaringBitmap& b);
+	friend RoaringBitmap operator|(const RoaringBitmap& a, const RoaringBitmap& b);
+	friend RoaringBitmap operator-(const RoaringBitmap& a, const RoaringBitmap& b);
+	friend bool operator==(const RoaringBitmap& a, const RoaringBitmap& b) noexcept;
+
+	/**
+	 * Maximum number of values in an array container.
+	 */
+	static constexpr std::uint32_t max_array_size = 4096;
+
+private:
+	/**
+	 * Values sharing the upper 16 bits.
+	 * Stored as sorted array if 'bitmap' is empty, as bitmap of
+	 * bitmap_words 64 bit words otherwise.
+	 */
+	struct Container {
+		std::vector<std::uint16_t> array;
+		std::vector<std::uint64_t> bitmap;
+		std::uint32_t cardinality = 0;
+
+		bool operator==(const Container&) const = default;
+	};
+	static constexpr std::size_t bitmap_words = 1024;
+
+	std::vector<std::uint16_t> keys;
+	std::vector<Container> containers;
+
+	std::size_t findKey(std::uint16_t key) const noexcept;
+	Container& getOrInsertContainer(std::uint16_t key);
+
+	static bool addToContainer(Container& container, std::uint16_t value);
+	static bool removeFromContainer(Container& container, std::uint16_t value);
+	static bool containerContains(const Container& container, std::uint16_t value) noexcept;
+	static void toBitmapContainer(Container& container);
+	static void toArrayContainer(Container& container);
+	static void normalise(Container& container);
+	static Container intersect(const Container& a, const Container& b);
+	static Container unite(const Container& a, const Container& b);
+	static Container subtract(const Container& a, const Container& b);
+	static std::uint32_t intersectCardinality(const Container& a, const Container& b) noexcept;
+};
+
+
+//implementation
+template<typename InputIt>
+RoaringBitmap::RoaringBitmap(InputIt first, InputIt last) {
+	for(; first != last; ++first)
+		add(static_cast<value_type>(*first));
+}
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_ROARINGBITMAP_H_ */
@@ -0,0 +1,117 @@
+/*
+ * WriteBehindQueue.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WriteBehindQueue.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace PhotoLibrary {
+namespace Support {
+
+WriteBehindQueue::WriteBehindQueue(RunGroup run_group, ErrorHandler on_error, std::size_t max_group_size) :
+		run_group(std::move(run_group)),
+		on_error(std::move(on_error)),
+		max_group_size(max_group_size ? max_group_size : 1) {}
+
+WriteBehindQueue::~WriteBehindQueue() {
+	{
+		std::lock_guard<std::mutex> lck {queue_mutex};
+		stopping = true;
+	}
+	not_empty.notify_all();
+	// the writer thread runs the remaining writes before it stops
+	if(writer.joinable())
+		writer.join();
+}
+
+void WriteBehindQueue::push(Write write) {
+	{
+		std::lock_guard<std::mutex> lck {queue_mutex};
+		if(!writer.joinable())
+			writer = std::thread(&WriteBehindQueue::run, this);
+		queue.push_back(std::move(write));
+		last_tickets.insert_or_assign(std::this_thread::get_id(), next_ticket++);
+		n_pending.fetch_add(1, std::memory_order_release);
+	}
+	not_empty.notify_one();
+}
+
+void WriteBehindQueue::waitForOwnWrites() {
+	if(!pending())
+		return;
+	Ticket ticket;
+	{
+		std::lock_guard<std::mutex> lck {queue_mutex};
+		auto last = last_tickets.find(std::this_thread::get_id());
+		if(last == last_tickets.end())
+			return;
+		ticket = last->second;
+	}
+	waitFor(ticket);
+}
+
+void WriteBehindQueue::flush() {
+	Ticket ticket;
+	{
+		std::lock_guard<std::mutex> lck {queue_mutex};
+		ticket = next_ticket - 1;
+	}
+	waitFor(ticket);
+}
+
+void WriteBehindQueue::waitFor(Ticket ticket) {
+	std::unique_lock<std::mutex> lck {queue_mutex};
+	written.wait(lck, [this, ticket]() { return done >= ticket; });
+	// forget the threads without pending writes
+	std::erase_if(last_tickets, [this](const auto& last) { return last.second <= done; });
+}
+
+void WriteBehindQueue::run() {
+	std::vector<Write> group;
+	std::unique_lock<std::mutex> lck {queue_mutex};
+	while(true) {
+		not_empty.wait(lck, [this]() { return stopping || !queue.empty(); });
+		if(queue.empty())
+			return;
+
+		// everything queued meanwhile goes into the same group
+		std::size_t n = std::min(queue.size(), max_group_size);
+		group.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.begin() + n));
+		queue.erase(queue.begin(), queue.begin() + n);
+		lck.unlock();
+
+		try {
+			run_group(group);
+		}
+		catch (...) {
+			if(on_error)
+				on_error(std::current_exception());
+		}
+		group.clear();
+
+		lck.lock();
+		done += n;
+		n_pending.fetch_sub(n, std::memory_order_release);
+		written.notify_all();
+	}
+}
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
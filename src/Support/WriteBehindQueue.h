@@ -0,0 +1,145 @@
+/*
+ * WriteBehindQueue.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SUPPORT_WRITEBEHINDQUEUE_H_
+#define SRC_SUPPORT_WRITEBEHINDQUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+/**
+ * Queue of writes run by a dedicated writer thread.
+ *
+ * push() returns immediately; the writer thread takes all writes queued
+ * at that time (at most 'max_group_size') and hands them to the
+ * RunGroup function, which runs them together, e.g. in one database
+ * transaction (group commit). The writer thread is started by the first
+ * push().
+ *
+ * Read-your-writes: a thread calling waitForOwnWrites() before reading
+ * sees all writes it pushed before. flush() waits for the writes of all
+ * threads; the destructor flushes the queue and stops the writer thread.
+ *
+ * Writes must not push writes themselves or wait for the queue.
+ *
+ * @throws std::system_error Any method not marked as noexcept
+ * 		may throw a std::system_error if the mutex cannot be locked
+ * 		or the thread cannot be started.
+ */
+class WriteBehindQueue {
+public:
+	using Write = std::function<void()>;
+
+	/**
+	 * Function running a group of writes in the writer thread.
+	 * Exceptions thrown by it are passed to the ErrorHandler.
+	 */
+	using RunGroup = std::function<void(std::vector<Write>& writes)>;
+
+	/**
+	 * Function called in the writer thread with exceptions thrown by the
+	 * RunGroup function.
+	 */
+	using ErrorHandler = std::function<void(std::exception_ptr)>;
+
+	/**
+	 * @param run_group function running a group of writes
+	 * @param on_error function called with exceptions thrown by 'run_group'
+	 * @param max_group_size maximum number of writes in a group (at least 1)
+	 */
+	WriteBehindQueue(RunGroup run_group, ErrorHandler on_error, std::size_t max_group_size=256);
+
+	/**
+	 * Flushes the queue and stops the writer thread.
+	 */
+	~WriteBehindQueue();
+
+	//no moving or copying (not thread safe)
+	WriteBehindQueue(const WriteBehindQueue&) = delete;
+	WriteBehindQueue(WriteBehindQueue&&) = delete;
+	WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+	WriteBehindQueue& operator=(WriteBehindQueue&&) = delete;
+
+	/**
+	 * Queue a write.
+	 *
+	 * @param write function to run in the writer thread
+	 */
+	void push(Write write);
+
+	/**
+	 * Wait until all writes pushed by the calling thread have been run.
+	 * Returns immediately if no writes are pending.
+	 */
+	void waitForOwnWrites();
+
+	/**
+	 * Wait until all writes pushed before the call have been run.
+	 */
+	void flush();
+
+	/**
+	 * Whether there are writes not run yet.
+	 *
+	 * @retval true if writes are queued or being run
+	 * @retval false otherwise
+	 */
+	bool pending() const noexcept { return n_pending.load(std::memory_order_acquire); }
+
+private:
+	using Ticket = std::uint64_t;
+
+	const RunGroup run_group;
+	const ErrorHandler on_error;
+	const std::size_t max_group_size;
+
+	std::deque<Write> queue;
+	/// ticket of the next write pushed; tickets of the writes in 'queue' are consecutive
+	Ticket next_ticket = 1;
+	/// writes with a ticket up to 'done' have been run
+	Ticket done = 0;
+	/// ticket of the last write pushed by each thread with pending writes
+	std::unordered_map<std::thread::id,Ticket> last_tickets;
+	std::atomic<std::size_t> n_pending {0};
+	bool stopping = false;
+	std::mutex queue_mutex;
+	std::condition_variable not_empty;
+	std::condition_variable written;
+	std::thread writer;
+
+	void run();
+	void waitFor(Ticket ticket);
+};
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
+
+#endif /* SRC_SUPPORT_WRITEBEHINDQUEUE_H_ */
@@ -167,18 +167,12 @@ void examplePictures(PhotoLibrary::Backend::BackendFactory& db) {
 				photo_20, photo_21, photo_22, photo_23, photo_24, photo_25, photo_26};
 	std::vector<int> v_letters {photo_a, photo_b, photo_c, photo_d, photo_e, photo_f, photo_g};
 
-	for(int a : v_hex_dig)
-		db.newRelation<Relations::PHOTOS_ALBUMS>(a, a_hex_dig);
-	for(int a : v_dec_dig)
-		db.newRelation<Relations::PHOTOS_ALBUMS>(a, a_dec_dig);
-	for(int a : v_dec_num)
-		db.newRelation<Relations::PHOTOS_ALBUMS>(a, a_dec_num);
-	for(int a : v_oct_dig)
-		db.newRelation<Relations::PHOTOS_ALBUMS>(a, a_oct_dig);
-	for(int a : v_oct_num)
-		db.newRelation<Relations::PHOTOS_ALBUMS>(a, a_oct_num);
-	for(int a : v_letters)
-		db.newRelation<Relations::PHOTOS_ALBUMS>(a, a_letters);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(v_hex_dig, a_hex_dig);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(v_dec_dig, a_dec_dig);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(v_dec_num, a_dec_num);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(v_oct_dig, a_oct_dig);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(v_oct_num, a_oct_num);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(v_letters, a_letters);
 
 	[[maybe_unused]] int k_examples = addEntry(KeywordRecord(0, KeywordRecord::Options::ROW_EXPANDED, "examples"), db);
 	[[maybe_unused]] int k_hex_dig = addEntry(KeywordRecord(k_examples, KeywordRecord::Options::NONE, "Hex digits"), db);
@@ -188,18 +182,12 @@ void examplePictures(PhotoLibrary::Backend::BackendFactory& db) {
 	[[maybe_unused]] int k_oct_num = addEntry(KeywordRecord(k_examples, KeywordRecord::Options::NONE, "Octal numbers"), db);
 	[[maybe_unused]] int k_oct_dig = addEntry(KeywordRecord(k_examples, KeywordRecord::Options::NONE, "Octal digits"), db);
 
-	for(int a : v_hex_dig)
-		db.newRelation<Relations::PHOTOS_KEYWORDS>(a, k_hex_dig);
-	for(int a : v_dec_dig)
-		db.newRelation<Relations::PHOTOS_KEYWORDS>(a, k_dec_dig);
-	for(int a : v_dec_num)
-		db.newRelation<Relations::PHOTOS_KEYWORDS>(a, k_dec_num);
-	for(int a : v_oct_dig)
-		db.newRelation<Relations::PHOTOS_KEYWORDS>(a, k_oct_dig);
-	for(int a : v_oct_num)
-		db.newRelation<Relations::PHOTOS_KEYWORDS>(a, k_oct_num);
-	for(int a : v_letters)
-		db.newRelation<Relations::PHOTOS_KEYWORDS>(a, k_letters);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(v_hex_dig, k_hex_dig);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(v_dec_dig, k_dec_dig);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(v_dec_num, k_dec_num);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(v_oct_dig, k_oct_dig);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(v_oct_num, k_oct_num);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(v_letters, k_letters);
 }
 
 template<class TRecord>
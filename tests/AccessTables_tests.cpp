@@ -19,6 +19,7 @@
 
 #include "AccessTables_tests.h"
 #include <Database.h>
+#include <algorithm>
 #include <functional>
 #include <support.h>
 #include <AccessTables.h>
@@ -222,6 +223,14 @@ void two_ints_get_children(AccessTables<>& interface, const std::vector<std::arr
 		CHECK(number_children == child_vec.size());
 
 		CHECK_THAT(child_vec, Catch::UnorderedEquals(iter->second));
+
+		std::vector<std::pair<int,bool>> nodes;
+		REQUIRE_NOTHROW(nodes = interface.getChildNodes<T>(iter->first));
+		REQUIRE(nodes.size() == child_vec.size());
+		for(auto [id, has_children] : nodes) {
+			CHECK(std::find(child_vec.begin(), child_vec.end(), id) != child_vec.end());
+			CHECK(has_children == !children[id].empty());
+		}
 	}
 
 	//Test invalid id
@@ -231,6 +240,7 @@ void two_ints_get_children(AccessTables<>& interface, const std::vector<std::arr
 	REQUIRE_NOTHROW(number_children = interface.getNumberChildren<T>(invalid_index));
 	CHECK(number_children == 0);
 	CHECK(child_vec.size() == 0);
+	CHECK(interface.getChildNodes<T>(invalid_index).empty());
 }
 
 template<typename T>
@@ -206,6 +206,34 @@ TEST_CASE(
 	}
 }
 
+TEST_CASE("Test setting options of several albums at once", "[album][setOptionBits][backend]") {
+	BackendFactory db { ":memory:" };
+	std::vector<AlbumRecord> albums {
+		AlbumRecord(0, AlbumRecord::Options::ALBUM_IS_SET, "2014"),
+		AlbumRecord(0, AlbumRecord::Options::ROW_EXPANDED | AlbumRecord::Options::ALBUM_IS_SET, "2015"),
+		AlbumRecord(0, AlbumRecord::Options::NONE, "2016")
+	};
+	std::vector<int> ids;
+	for(const auto& album : albums) {
+		db.newEntry(album);
+		ids.push_back(db.getID(album));
+	}
+
+	db.setOptionBits<AlbumRecord>(std::vector<int>{ids[0], ids[1], 1000}, AlbumRecord::Options::ROW_EXPANDED, true);
+	CHECK(db.getEntry<AlbumRecord>(ids[0]).getOptions() == (AlbumRecord::Options::ROW_EXPANDED | AlbumRecord::Options::ALBUM_IS_SET));
+	CHECK(db.getEntry<AlbumRecord>(ids[1]).getOptions() == (AlbumRecord::Options::ROW_EXPANDED | AlbumRecord::Options::ALBUM_IS_SET));
+	CHECK(db.getEntry<AlbumRecord>(ids[2]).getOptions() == AlbumRecord::Options::NONE);
+	CHECK(db.getEntry<AlbumRecord>(ids[0]).getAlbumName() == "2014");
+
+	db.setOptionBits<AlbumRecord>(ids, AlbumRecord::Options::ROW_EXPANDED, false);
+	CHECK(db.getEntry<AlbumRecord>(ids[0]).getOptions() == AlbumRecord::Options::ALBUM_IS_SET);
+	CHECK(db.getEntry<AlbumRecord>(ids[1]).getOptions() == AlbumRecord::Options::ALBUM_IS_SET);
+	CHECK(db.getEntry<AlbumRecord>(ids[2]).getOptions() == AlbumRecord::Options::NONE);
+
+	CHECK_NOTHROW(db.setOptionBits<AlbumRecord>(std::vector<int>{}, AlbumRecord::Options::ROW_EXPANDED, true));
+	CHECK(db.getEntry<AlbumRecord>(ids[2]).getOptions() == AlbumRecord::Options::NONE);
+}
+
 } /* namespace Tests */
 } /* namespace Backend */
 } /* namespace PhotoLibrary */
@@ -0,0 +1,116 @@
+/*
+ * BackendChanges_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "Record/AlbumRecord.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/KeywordRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::AlbumRecord;
+using RecordClasses::DirectoryRecord;
+using RecordClasses::KeywordRecord;
+using RecordClasses::PhotoRecord;
+using Change = BackendFactory::Change;
+
+TEST_CASE("Test reporting changes to observers", "[Changes][backend]") {
+	BackendFactory db { ":memory:" };
+	std::vector<Change> changes;
+	int observer = db.addChangeObserver([&changes](const Change& change) { changes.push_back(change); });
+
+	db.newEntry(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"));
+	int places = db.getID(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"));
+	db.newEntry(KeywordRecord(places, KeywordRecord::Options::NONE, "Italy"));
+	int italy = db.getID(KeywordRecord(places, KeywordRecord::Options::NONE, "Italy"));
+	db.newEntry(KeywordRecord(0, KeywordRecord::Options::NONE, "Countries"));
+	int countries = db.getID(KeywordRecord(0, KeywordRecord::Options::NONE, "Countries"));
+	REQUIRE(changes.size() == 3);
+	CHECK(changes[0] == Change{Change::Type::ADDED, "Keywords", places, 0});
+	CHECK(changes[1] == Change{Change::Type::ADDED, "Keywords", italy, places});
+	CHECK(changes[1].concerns<KeywordRecord>());
+	CHECK_FALSE(changes[1].concerns<AlbumRecord>());
+
+	changes.clear();
+	db.updateEntry(italy, KeywordRecord(places, KeywordRecord::Options::NONE, "Italia"));
+	db.setParent<KeywordRecord>(italy, countries);
+	db.deleteEntry<KeywordRecord>(countries);
+	CHECK(changes == std::vector<Change>{
+		{Change::Type::UPDATED, "Keywords", italy, places},
+		{Change::Type::MOVED, "Keywords", italy, countries},
+		{Change::Type::DELETED, "Keywords", countries, 0}});
+
+	SECTION("Photos and smart albums should be reported, bulk changes per directory") {
+		changes.clear();
+		db.newEntry(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/2021"));
+		int directory = db.getID(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/2021"));
+		db.newEntry(PhotoRecord(directory, "a.jpg"));
+		int photo = db.getID(PhotoRecord(directory, "a.jpg"));
+		int album = db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Best"), "rating>=4");
+		db.newPhotos(std::vector<PhotoRecord>{PhotoRecord(directory, "b.jpg")});
+		int b = db.getID(PhotoRecord(directory, "b.jpg"));
+		CHECK(changes == std::vector<Change>{
+			{Change::Type::ADDED, "Directories", directory, 0},
+			{Change::Type::ADDED, "Photos", photo, directory},
+			{Change::Type::ADDED, "Albums", album, 0},
+			{Change::Type::PHOTOS_CHANGED, "Directories", directory, 0}});
+
+		// photos already in the directory are skipped
+		changes.clear();
+		CHECK(db.newPhotos(std::vector<PhotoRecord>{PhotoRecord(directory, "a.jpg")}) == 0);
+		CHECK(changes.empty());
+
+		db.newEntry(DirectoryRecord(directory, DirectoryRecord::Options::NONE, "May", "May"));
+		int may = db.getID(DirectoryRecord(directory, DirectoryRecord::Options::NONE, "May", "May"));
+		changes.clear();
+		std::vector<int> ids {b};
+		std::vector<FileFingerprint> fingerprints(1);
+		db.updatePhotoFiles(ids, std::vector<PhotoRecord>{PhotoRecord(directory, "b.jpg", 0, 100)}, fingerprints);
+		CHECK(changes.empty());
+		db.updatePhotoFiles(ids, std::vector<PhotoRecord>{PhotoRecord(may, "b.jpg")}, fingerprints);
+		CHECK(changes == std::vector<Change>{
+			{Change::Type::PHOTOS_CHANGED, "Directories", directory, 0},
+			{Change::Type::PHOTOS_CHANGED, "Directories", may, directory}});
+
+		changes.clear();
+		db.deletePhotos(ids);
+		CHECK(changes == std::vector<Change>{{Change::Type::PHOTOS_CHANGED, "Directories", may, directory}});
+	}
+
+	SECTION("Removed observers should not be called") {
+		changes.clear();
+		int second = db.addChangeObserver([&changes](const Change& change) { changes.push_back(change); });
+		CHECK(second != observer);
+		db.removeChangeObserver(observer);
+		db.removeChangeObserver(observer);
+		db.deleteEntry<KeywordRecord>(places);
+		db.removeChangeObserver(second);
+		db.newEntry(KeywordRecord(0, KeywordRecord::Options::NONE, "People"));
+		CHECK(changes == std::vector<Change>{{Change::Type::DELETED, "Keywords", places, 0}});
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,91 @@
+/*
+ * BackendFactory_tests.h
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTS_BACKENDFACTORY_TESTS_H_
+#define TESTS_BACKENDFACTORY_TESTS_H_
+
+#include "BackendFactory.h"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using Bytes = std::vector<unsigned char>;
+
+/**
+ * Add an entry to the database and return the id it was given.
+ */
+template<class TRecord>
+int add(const TRecord& entry, BackendFactory& db) {
+	db.newEntry(entry);
+	return db.getID(entry);
+}
+
+/**
+ * Get the ids of photos returned by the backend (e.g. by
+ * BackendFactory::getUnhashedPhotos()).
+ */
+inline std::vector<int> ids(const std::vector<BackendFactory::UnhashedPhoto>& photos) {
+	std::vector<int> ids;
+	for(const auto& photo : photos)
+		ids.push_back(photo.id);
+	return ids;
+}
+
+/**
+ * Write 'bytes' to a file, replacing its content.
+ */
+inline void writeFile(const std::filesystem::path& path, const Bytes& bytes) {
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+/**
+ * Temporary directory, removed with all its content on destruction.
+ * Every object gets a new directory, also in concurrent or repeated runs.
+ */
+struct TemporaryDirectory {
+	std::filesystem::path path;
+	TemporaryDirectory() {
+		static std::atomic<unsigned int> counter {0};
+		std::random_device random;
+		do
+			path = std::filesystem::temp_directory_path() /
+					("PhotoLibrary_test_" + std::to_string(random()) + "_" + std::to_string(counter++));
+		while(!std::filesystem::create_directory(path));
+	}
+	~TemporaryDirectory() {
+		std::error_code error;
+		std::filesystem::remove_all(path, error);
+	}
+	TemporaryDirectory(const TemporaryDirectory&) = delete;
+	TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+};
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
+
+#endif /* TESTS_BACKENDFACTORY_TESTS_H_ */
@@ -0,0 +1,87 @@
+/*
+ * BoundedQueue_tests.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../src/Support/BoundedQueue.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace BoundedQueue_tests {
+
+TEST_CASE("Test BoundedQueue's basic functionality", "[support][BoundedQueue]") {
+	BoundedQueue<int> queue(3);
+	CHECK(queue.push(1));
+	CHECK(queue.push(2));
+	CHECK(queue.pop() == 1);
+	CHECK_FALSE(queue.closed());
+
+	queue.close();
+	CHECK(queue.closed());
+	CHECK_FALSE(queue.push(3));
+	CHECK(queue.pop() == 2);
+	CHECK_FALSE(queue.pop().has_value());
+}
+
+TEST_CASE("Test BoundedQueue's backpressure and thread safety", "[support][BoundedQueue]") {
+	constexpr int n_values = 100000;
+	constexpr int n_producers = 8;
+	constexpr std::size_t capacity = 16;
+	BoundedQueue<int> queue(capacity);
+	std::atomic<int> active {n_producers};
+
+	std::vector<std::thread> producers;
+	for(int p = 0; p < n_producers; ++p)
+		producers.emplace_back([&queue, &active, p]() {
+			for(int i = p; i < n_values; i += n_producers)
+				queue.push(int(i));
+			if(--active == 0)
+				queue.close();
+		});
+
+	std::vector<int> values;
+	std::vector<std::thread> consumers;
+	std::mutex values_mutex;
+	for(int c = 0; c < 4; ++c)
+		consumers.emplace_back([&]() {
+			while(auto value = queue.pop()) {
+				std::lock_guard<std::mutex> lck {values_mutex};
+				values.push_back(*value);
+			}
+		});
+
+	for(auto& thread : producers)
+		thread.join();
+	for(auto& thread : consumers)
+		thread.join();
+
+	REQUIRE(values.size() == n_values);
+	std::sort(values.begin(), values.end());
+	for(int i = 0; i < n_values; ++i)
+		REQUIRE(values[i] == i);
+}
+
+} /* namespace BoundedQueue_tests */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,170 @@
+/*
+ * Closure_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "Record/AlbumRecord.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/KeywordRecord.h"
+#include "Record/PhotoRecord.h"
+#include "exceptions.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::AlbumRecord;
+using RecordClasses::DirectoryRecord;
+using RecordClasses::KeywordRecord;
+using RecordClasses::PhotoRecord;
+using PhotoLibrary::DatabaseInterface::constraint_error;
+using Relations = BackendFactory::Relations;
+
+namespace {
+
+// descendants found by walking the children
+template<class TRecord>
+std::vector<int> walkDescendants(int id, BackendFactory& db) {
+	std::vector<int> descendants;
+	for(int child : db.getChildren<TRecord>(id)) {
+		descendants.push_back(child);
+		for(int descendant : walkDescendants<TRecord>(child, db))
+			descendants.push_back(descendant);
+	}
+	std::sort(descendants.begin(), descendants.end());
+	return descendants;
+}
+
+}
+
+TEST_CASE("Test the closure tables of the hierarchies", "[getDescendants][isAncestor][backend]") {
+	BackendFactory db { ":memory:" };
+	using V = std::vector<int>;
+
+	int k_animals = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Animals"), db);
+	int k_mammals = add(KeywordRecord(k_animals, KeywordRecord::Options::NONE, "Mammals"), db);
+	int k_cats = add(KeywordRecord(k_mammals, KeywordRecord::Options::NONE, "Cats"), db);
+	int k_lions = add(KeywordRecord(k_cats, KeywordRecord::Options::NONE, "Lions"), db);
+	int k_birds = add(KeywordRecord(k_animals, KeywordRecord::Options::NONE, "Birds"), db);
+	int k_places = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"), db);
+
+	auto check_consistent = [&db]() {
+		for(int id : db.getDescendants<KeywordRecord>(0)) {
+			INFO("keyword " << id);
+			CHECK(db.getDescendants<KeywordRecord>(id) == walkDescendants<KeywordRecord>(id, db));
+		}
+		CHECK(db.getDescendants<KeywordRecord>(0) == walkDescendants<KeywordRecord>(0, db));
+	};
+
+	CHECK(db.getDescendants<KeywordRecord>(k_animals) == V{k_mammals, k_cats, k_lions, k_birds});
+	CHECK(db.getDescendants<KeywordRecord>(k_lions).empty());
+	CHECK(db.getAncestors<KeywordRecord>(V{k_lions}) == V{k_animals, k_mammals, k_cats});
+	CHECK(db.isAncestor<KeywordRecord>(k_animals, k_lions));
+	CHECK(db.isAncestor<KeywordRecord>(0, k_lions));
+	CHECK_FALSE(db.isAncestor<KeywordRecord>(k_lions, k_animals));
+	CHECK_FALSE(db.isAncestor<KeywordRecord>(k_lions, k_lions));
+	CHECK_FALSE(db.isAncestor<KeywordRecord>(k_birds, k_lions));
+	check_consistent();
+
+	SECTION("Moved entries should take their subtree along") {
+		db.setParent<KeywordRecord>(k_cats, k_places);
+		CHECK(db.getDescendants<KeywordRecord>(k_animals) == V{k_mammals, k_birds});
+		CHECK(db.getDescendants<KeywordRecord>(k_places) == V{k_cats, k_lions});
+		CHECK(db.getAncestors<KeywordRecord>(V{k_lions}) == V{k_cats, k_places});
+		CHECK_FALSE(db.isAncestor<KeywordRecord>(k_animals, k_lions));
+		check_consistent();
+
+		db.updateEntry(k_places, KeywordRecord(k_birds, KeywordRecord::Options::NONE, "Places"));
+		CHECK(db.getAncestors<KeywordRecord>(V{k_lions}) == V{k_animals, k_cats, k_birds, k_places});
+		check_consistent();
+	}
+
+	SECTION("Moving an entry into its own subtree should be rejected") {
+		CHECK_THROWS_AS(db.setParent<KeywordRecord>(k_mammals, k_lions), constraint_error);
+		CHECK_THROWS_AS(db.setParent<KeywordRecord>(k_animals, k_mammals), constraint_error);
+		CHECK(db.getEntry<KeywordRecord>(k_mammals).getParent() == k_animals);
+		CHECK(db.getDescendants<KeywordRecord>(k_animals) == V{k_mammals, k_cats, k_lions, k_birds});
+		check_consistent();
+	}
+
+	SECTION("Deleted entries should be removed with their subtree") {
+		db.deleteEntry<KeywordRecord>(k_mammals);
+		CHECK(db.getDescendants<KeywordRecord>(k_animals) == V{k_birds});
+		CHECK(db.getDescendants<KeywordRecord>(k_cats).empty());
+		CHECK_FALSE(db.isAncestor<KeywordRecord>(k_animals, k_lions));
+		check_consistent();
+
+		int k_dogs = add(KeywordRecord(k_birds, KeywordRecord::Options::NONE, "Dogs"), db);
+		CHECK(db.getAncestors<KeywordRecord>(V{k_dogs}) == V{k_animals, k_birds});
+		check_consistent();
+	}
+}
+
+TEST_CASE("Test retrieving the photos of subtrees", "[getPhotosInSubtree][getEntriesInSubtree][backend]") {
+	BackendFactory db { ":memory:" };
+	using V = std::vector<int>;
+
+	int d2020 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2020", "/home/user/Photos/2020"), db);
+	int d2020_05 = add(DirectoryRecord(d2020, DirectoryRecord::Options::NONE, "05", "05"), db);
+	int d2020_05_17 = add(DirectoryRecord(d2020_05, DirectoryRecord::Options::NONE, "17", "17"), db);
+	int d2021 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/Photos/2021"), db);
+
+	int p1 = add(PhotoRecord(d2020, "1.jpg", 1, 1590000000, 1920, 1080), db);
+	int p2 = add(PhotoRecord(d2020_05, "2.jpg", 3, 1590500000, 1080, 1920), db);
+	int p3 = add(PhotoRecord(d2020_05_17, "3.jpg", 5, 1589700000, 4000, 3000), db);
+	int p4 = add(PhotoRecord(d2021, "4.jpg", 4, 1621252800, 1920, 1080), db);
+
+	int k_animals = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Animals"), db);
+	int k_cats = add(KeywordRecord(k_animals, KeywordRecord::Options::NONE, "Cats"), db);
+	int k_lions = add(KeywordRecord(k_cats, KeywordRecord::Options::NONE, "Lions"), db);
+	int k_places = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"), db);
+
+	int a_set = add(AlbumRecord(0, AlbumRecord::Options::ALBUM_IS_SET, "Holidays"), db);
+	int a_best = add(AlbumRecord(a_set, AlbumRecord::Options::NONE, "Best of"), db);
+
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{p1, p3}, k_lions);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{p3, p4}, k_cats);
+	db.newRelation<Relations::PHOTOS_KEYWORDS>(p2, k_places);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(std::vector<int>{p2, p4}, a_best);
+
+	CHECK(db.getPhotosInSubtree(d2020) == V{p1, p2, p3});
+	CHECK(db.getPhotosInSubtree(d2020, BackendFactory::PhotoOrder::DATETIME) == V{p3, p1, p2});
+	CHECK(db.getPhotosInSubtree(d2020_05, BackendFactory::PhotoOrder::RATING, true) == V{p3, p2});
+	CHECK(db.getPhotosInSubtree(d2021) == V{p4});
+
+	CHECK(db.getEntriesInSubtree<Relations::PHOTOS_KEYWORDS>(k_animals) == V{p1, p3, p4});
+	CHECK(db.getEntriesInSubtree<Relations::PHOTOS_KEYWORDS>(k_lions) == V{p1, p3});
+	CHECK(db.getEntriesInSubtree<Relations::PHOTOS_KEYWORDS>(k_places) == V{p2});
+	CHECK(db.getEntriesInSubtree<Relations::PHOTOS_ALBUMS>(a_set, BackendFactory::PhotoOrder::ID, true) == V{p4, p2});
+
+	db.setParent<KeywordRecord>(k_cats, k_places);
+	CHECK(db.getEntriesInSubtree<Relations::PHOTOS_KEYWORDS>(k_animals).empty());
+	CHECK(db.getEntriesInSubtree<Relations::PHOTOS_KEYWORDS>(k_places) == V{p1, p2, p3, p4});
+
+	db.setParent<DirectoryRecord>(d2020_05, d2021);
+	CHECK(db.getPhotosInSubtree(d2020) == V{p1});
+	CHECK(db.getPhotosInSubtree(d2021) == V{p2, p3, p4});
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,76 @@
+/*
+ * ContentHash_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../src/Support/ContentHash.h"
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace ContentHash_tests {
+
+std::vector<unsigned char> data(std::size_t n) {
+	std::vector<unsigned char> bytes(n);
+	for(std::size_t i = 0; i < n; ++i)
+		bytes[i] = static_cast<unsigned char>(i * i * 31 + i * 7 + 3);
+	return bytes;
+}
+
+TEST_CASE("Test computing content hashes", "[Support][ContentHash]") {
+	// reference values computed with the xxHash library (XXH64)
+	const std::vector<std::pair<std::size_t,std::uint64_t>> expected {
+		{0, 0xEF46DB3751D8E999}, {1, 0x1F25C8D0BC1F4BB6}, {3, 0xA020F3294A68C3B2},
+		{4, 0x9A05810A0D610553}, {7, 0x85B3BE277ADA6206}, {8, 0xE400A21C7735E336},
+		{12, 0xFEE2C2B08B6C74E8}, {31, 0x799631C30D7E3922}, {32, 0x6B7EAD39B05FCC7C},
+		{33, 0xB6D285B00D90E573}, {63, 0x765796FDB42CAB38}, {64, 0x7A9871C22557878C},
+		{100, 0xB261BDBAD1498F82}, {1000, 0x0B1FE4B92992ED62}, {100000, 0xCDDF2987274A7E48}
+	};
+	const auto bytes = data(100000);
+	for(auto [n, hash] : expected)
+		CHECK(ContentHash::hash(bytes.data(), n) == hash);
+	CHECK(ContentHash::hash(bytes.data(), 100, 42) == 0xCB9CC7CD31AA6C79);
+	std::string_view abc = "abc";
+	CHECK(ContentHash::hash(abc.data(), abc.size()) == 0x44BC2CF5AD770999);
+
+	SECTION("The hash shouldn't depend on the pieces the data is added in") {
+		for(std::size_t piece : {1, 5, 31, 32, 33, 4096}) {
+			ContentHash hash;
+			for(std::size_t i = 0; i < bytes.size(); i += piece)
+				hash.update(bytes.data() + i, std::min(piece, bytes.size() - i));
+			CHECK(hash.digest() == 0xCDDF2987274A7E48);
+		}
+
+		ContentHash hash;
+		hash.update(bytes.data(), 12);
+		CHECK(hash.digest() == 0xFEE2C2B08B6C74E8);
+		hash.update(bytes.data() + 12, 21);
+		CHECK(hash.digest() == 0xB6D285B00D90E573);
+		hash.update(nullptr, 0);
+		CHECK(hash.digest() == 0xB6D285B00D90E573);
+	}
+}
+
+} /* namespace ContentHash_tests */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
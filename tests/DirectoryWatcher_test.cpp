@@ -0,0 +1,160 @@
+/*
+ * DirectoryWatcher_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "DirectoryWatcher.h"
+#include "PhotoImporter.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::DirectoryRecord;
+using RecordClasses::PhotoRecord;
+
+namespace {
+
+/**
+ * Counts the notifications of a DirectoryWatcher.
+ */
+struct Notifications {
+	std::mutex mutex;
+	std::condition_variable condition;
+	int count = 0;
+
+	void notify() {
+		{
+			std::lock_guard<std::mutex> lck {mutex};
+			++count;
+		}
+		condition.notify_all();
+	}
+
+	/// wait until there was a notification after the last call
+	bool wait() {
+		std::unique_lock<std::mutex> lck {mutex};
+		bool notified = condition.wait_for(lck, std::chrono::seconds(5), [this]() { return count > 0; });
+		count = 0;
+		return notified;
+	}
+};
+
+void touch(const std::filesystem::path& path) {
+	std::ofstream file(path);
+	file << "photo";
+}
+
+}
+
+TEST_CASE("Test watching directories", "[DirectoryWatcher][backend]") {
+	TemporaryDirectory directory;
+	const auto& root = directory.path;
+	std::filesystem::create_directories(root / "sub");
+	touch(root / "a.jpg");
+
+	BackendFactory db { ":memory:" };
+	PhotoImporter(db, 2).importDirectory(root);
+	auto absolute = std::filesystem::canonical(root);
+	int root_id = db.getID(DirectoryRecord(0, DirectoryRecord::Options::NONE,
+			absolute.filename().string(), absolute.string()));
+	int sub = db.getID(DirectoryRecord(root_id, DirectoryRecord::Options::NONE, "sub", "sub"));
+
+	Notifications notifications;
+	DirectoryWatcher watcher(db, [&notifications]() { notifications.notify(); }, 2,
+			std::chrono::milliseconds(50), std::chrono::milliseconds(200));
+	CHECK(watcher.watch() == 0);
+	CHECK(watcher.processChanges().empty());
+
+	SECTION("New and deleted files should be applied") {
+		touch(root / "sub" / "b.jpg");
+		touch(root / "notes.txt");
+		REQUIRE(notifications.wait());
+		CHECK(watcher.processChanges() == std::vector<int>{sub});
+		CHECK(db.getNumberPhotos<DirectoryRecord>(sub, false) == 1);
+
+		std::filesystem::remove(root / "a.jpg");
+		REQUIRE(notifications.wait());
+		CHECK(watcher.processChanges() == std::vector<int>{root_id});
+		CHECK(db.getChildren<PhotoRecord>(root_id).empty());
+	}
+
+	SECTION("New directories should be imported and watched") {
+		std::filesystem::create_directories(root / "new");
+		touch(root / "new" / "c.jpg");
+		REQUIRE(notifications.wait());
+		watcher.processChanges();
+		int added = db.getID(DirectoryRecord(root_id, DirectoryRecord::Options::NONE, "new", "new"));
+		CHECK(db.getNumberPhotos<DirectoryRecord>(added, false) == 1);
+
+		touch(root / "new" / "d.jpg");
+		REQUIRE(notifications.wait());
+		CHECK(watcher.processChanges() == std::vector<int>{added});
+		CHECK(db.getNumberPhotos<DirectoryRecord>(added, false) == 2);
+
+		std::filesystem::remove_all(root / "new");
+		REQUIRE(notifications.wait());
+		watcher.processChanges();
+		CHECK_THROWS_AS(db.getEntry<DirectoryRecord>(added), DatabaseInterface::missing_entry);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(root_id, true) == 1);
+	}
+
+	SECTION("Renamed files and directories should keep their photos") {
+		int a = db.getChildren<PhotoRecord>(root_id).at(0);
+		std::filesystem::rename(root / "a.jpg", root / "sub" / "b.jpg");
+		REQUIRE(notifications.wait());
+		CHECK(watcher.processChanges() == std::vector<int>{root_id, sub});
+		CHECK(db.getChildren<PhotoRecord>(sub) == std::vector<int>{a});
+
+		std::filesystem::rename(root / "sub", root / "renamed");
+		REQUIRE(notifications.wait());
+		watcher.processChanges();
+		int renamed = db.getID(DirectoryRecord(root_id, DirectoryRecord::Options::NONE, "renamed", "renamed"));
+		CHECK(db.getChildren<PhotoRecord>(renamed) == std::vector<int>{a});
+		CHECK_THROWS_AS(db.getEntry<DirectoryRecord>(sub), DatabaseInterface::missing_entry);
+
+		touch(root / "renamed" / "c.jpg");
+		REQUIRE(notifications.wait());
+		CHECK(watcher.processChanges() == std::vector<int>{renamed});
+		CHECK(db.getNumberPhotos<DirectoryRecord>(renamed, false) == 2);
+
+		// moved out of the library: removed, its watch too
+		TemporaryDirectory outside;
+		std::filesystem::rename(root / "renamed", outside.path / "renamed");
+		REQUIRE(notifications.wait());
+		CHECK(watcher.processChanges() == std::vector<int>{root_id});
+		CHECK_THROWS_AS(db.getEntry<DirectoryRecord>(renamed), DatabaseInterface::missing_entry);
+		touch(outside.path / "renamed" / "d.jpg");
+		notifications.wait();
+		CHECK(watcher.processChanges().empty());
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,147 @@
+/*
+ * DuplicatePhotos_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "ContentHasher.h"
+#include "FileFingerprint.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/PhotoRecord.h"
+#include "../src/Support/ContentHash.h"
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::DirectoryRecord;
+using RecordClasses::PhotoRecord;
+
+namespace {
+
+Bytes data(std::size_t n, unsigned char seed) {
+	Bytes bytes(n);
+	for(std::size_t i = 0; i < n; ++i)
+		bytes[i] = static_cast<unsigned char>(i * 7 + seed);
+	return bytes;
+}
+
+}
+
+TEST_CASE("Test hashing files", "[ContentHasher][backend]") {
+	TemporaryDirectory directory;
+	Bytes bytes = data(3 * 1024 * 1024 + 17, 1);
+	writeFile(directory.path / "a.jpg", bytes);
+	writeFile(directory.path / "empty.jpg", {});
+
+	// reads smaller than the file and than a stripe of the hash
+	for(std::size_t size : {7, 4096, 1 << 20}) {
+		Bytes buffer(size);
+		CHECK(ContentHasher::hashFile(directory.path / "a.jpg", buffer) ==
+				Support::ContentHash::hash(bytes.data(), bytes.size()));
+		CHECK(ContentHasher::hashFile(directory.path / "empty.jpg", buffer) ==
+				Support::ContentHash::hash(nullptr, 0));
+	}
+	Bytes buffer(4096);
+	CHECK_THROWS_AS(ContentHasher::hashFile(directory.path / "missing.jpg", buffer), std::system_error);
+	CHECK_THROWS_AS(ContentHasher::hashFile(directory.path, buffer), std::system_error);
+}
+
+TEST_CASE("Test finding identical files", "[findDuplicatePhotos][ContentHasher][backend]") {
+	TemporaryDirectory directory;
+	BackendFactory db { ":memory:" };
+	using V = std::vector<int>;
+
+	db.newEntry(DirectoryRecord(0, DirectoryRecord::Options::NONE, "test", directory.path.string()));
+	int d = db.getID(DirectoryRecord(0, DirectoryRecord::Options::NONE, "test", directory.path.string()));
+
+	// a and b are identical, c has the same size, d a unique size, e is missing
+	writeFile(directory.path / "a.jpg", data(5000, 1));
+	writeFile(directory.path / "b.jpg", data(5000, 1));
+	writeFile(directory.path / "c.jpg", data(5000, 2));
+	writeFile(directory.path / "d.jpg", data(4000, 1));
+	std::vector<PhotoRecord> photos;
+	std::vector<FileFingerprint> fingerprints;
+	for(std::string name : {"a.jpg", "b.jpg", "c.jpg", "d.jpg"}) {
+		photos.emplace_back(d, name);
+		fingerprints.push_back(*getFileFingerprint(directory.path / name));
+	}
+	photos.emplace_back(d, "e.jpg");
+	fingerprints.push_back({5000, 1, 1});
+	// photos without a fingerprint are never hashed
+	photos.emplace_back(d, "f.jpg");
+	fingerprints.push_back({});
+	photos.emplace_back(d, "g.jpg");
+	fingerprints.push_back({});
+	db.newPhotos(photos, fingerprints);
+	int a = db.getID(photos[0]), b = db.getID(photos[1]), c = db.getID(photos[2]), e = db.getID(photos[4]);
+
+	auto candidates = db.getContentHashCandidates(0, 100);
+	CHECK(ids(candidates) == V{a, b, c, e});
+	CHECK(candidates[0].path == (directory.path / "a.jpg").string());
+	CHECK(ids(db.getContentHashCandidates(a, 2)) == V{b, c});
+	CHECK(db.findDuplicatePhotos().empty());
+
+	ContentHasher hasher(db, 2);
+	hasher.start();
+	hasher.wait();
+	CHECK(hasher.getErrors() == 1);
+	db.flushWrites();
+	CHECK(db.findDuplicatePhotos() == std::vector<V>{{a, b}});
+	// the missing file isn't tried again
+	CHECK(db.getContentHashCandidates(0, 100).empty());
+
+	SECTION("New copies should be found by hashing only the new candidates") {
+		writeFile(directory.path / "h.jpg", data(5000, 2));
+		writeFile(directory.path / "i.jpg", data(4000, 1));
+		std::vector<PhotoRecord> new_photos {PhotoRecord(d, "h.jpg"), PhotoRecord(d, "i.jpg")};
+		db.newPhotos(new_photos, std::vector<FileFingerprint>{
+				*getFileFingerprint(directory.path / "h.jpg"), *getFileFingerprint(directory.path / "i.jpg")});
+		int h = db.getID(new_photos[0]), i = db.getID(new_photos[1]);
+		int d_photo = db.getID(photos[3]);
+		CHECK(ids(db.getContentHashCandidates(0, 100)) == V{d_photo, h, i});
+
+		hasher.start();
+		hasher.wait();
+		db.flushWrites();
+		CHECK(db.findDuplicatePhotos() == std::vector<V>{{a, b}, {c, h}, {d_photo, i}});
+	}
+
+	SECTION("Changed files should be hashed again") {
+		writeFile(directory.path / "b.jpg", data(5000, 3));
+		db.updatePhotoFiles(V{b}, std::vector<PhotoRecord>{photos[1]},
+				std::vector<FileFingerprint>{*getFileFingerprint(directory.path / "b.jpg")});
+		CHECK(db.findDuplicatePhotos().empty());
+		CHECK(ids(db.getContentHashCandidates(0, 100)) == V{b});
+
+		db.updatePhotoFiles(V{e}, std::vector<PhotoRecord>{photos[4]}, std::vector<FileFingerprint>{{5000, 2, 2}});
+		CHECK(ids(db.getContentHashCandidates(0, 100)) == V{b, e});
+
+		db.setContentHashes(V{b}, std::vector<std::uint64_t>{Support::ContentHash::hash(data(5000, 2).data(), 5000)});
+		CHECK(db.findDuplicatePhotos() == std::vector<V>{{b, c}});
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
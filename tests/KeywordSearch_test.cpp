@@ -0,0 +1,122 @@
+/*
+ * KeywordSearch_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "Record/KeywordRecord.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::KeywordRecord;
+
+namespace {
+
+std::vector<int> sorted(std::vector<int> ids) {
+	std::sort(ids.begin(), ids.end());
+	return ids;
+}
+
+}
+
+TEST_CASE("Test searching keywords", "[searchKeywords][backend]") {
+	BackendFactory db { ":memory:" };
+	using V = std::vector<int>;
+
+	int k_places = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"), db);
+	int k_italy = add(KeywordRecord(k_places, KeywordRecord::Options::NONE, "Italy", "Italia"), db);
+	int k_venice = add(KeywordRecord(k_italy, KeywordRecord::Options::NONE, "Venice", "Venezia, Venedig"), db);
+	int k_rome = add(KeywordRecord(k_italy, KeywordRecord::Options::NONE, "Rome", "Roma"), db);
+	int k_sao_paulo = add(KeywordRecord(k_places, KeywordRecord::Options::NONE, "São Paulo"), db);
+	int k_people = add(KeywordRecord(0, KeywordRecord::Options::NONE, "People"), db);
+	int k_venus = add(KeywordRecord(k_people, KeywordRecord::Options::NONE, "Venus Williams"), db);
+
+	SECTION("Words should match prefixes of the keyword, its synonyms, and its path") {
+		CHECK(sorted(db.searchKeywords("ven")) == V{k_venice, k_venus});
+		CHECK(db.searchKeywords("venic") == V{k_venice});
+		CHECK(db.searchKeywords("VENEDIG") == V{k_venice});
+		CHECK(db.searchKeywords("will") == V{k_venus});
+		CHECK(db.searchKeywords("ital ven") == V{k_venice});
+		CHECK(db.searchKeywords("paulo sao") == V{k_sao_paulo});
+		CHECK(db.searchKeywords("São") == V{k_sao_paulo});
+		CHECK(db.searchKeywords("unknown").empty());
+	}
+
+	SECTION("Matches in the keyword should be ranked first") {
+		V matches = db.searchKeywords("ital");
+		REQUIRE(matches.size() == 3);
+		CHECK(matches.front() == k_italy);
+		CHECK(sorted(matches) == V{k_italy, k_venice, k_rome});
+		CHECK(db.searchKeywords("ital", 1) == V{k_italy});
+	}
+
+	SECTION("Text without words should match nothing") {
+		CHECK(db.searchKeywords("").empty());
+		CHECK(db.searchKeywords("  ").empty());
+		CHECK(db.searchKeywords("- \" * ( )").empty());
+		CHECK(db.searchKeywords("\"rom") == V{k_rome});
+		CHECK(db.searchKeywords("venice AND") == V{});
+	}
+
+	SECTION("The index should follow changes of the keywords") {
+		db.updateEntry(k_italy, KeywordRecord(k_places, KeywordRecord::Options::NONE, "Italien", "Italia"));
+		CHECK(db.searchKeywords("italy").empty());
+		CHECK(sorted(db.searchKeywords("italien")) == V{k_italy, k_venice, k_rome});
+
+		db.updateEntry(k_rome, KeywordRecord(k_italy, KeywordRecord::Options::NONE, "Rome", "Rom"));
+		CHECK(db.searchKeywords("roma").empty());
+		CHECK(db.searchKeywords("rom") == V{k_rome});
+
+		db.setParent<KeywordRecord>(k_places, k_people);
+		CHECK(sorted(db.searchKeywords("people")) == V{k_places, k_italy, k_venice, k_rome, k_sao_paulo, k_people,
+				k_venus});
+		CHECK(db.searchKeywords("people venez") == V{k_venice});
+
+		db.setParent<KeywordRecord>(k_places, 0);
+		CHECK(sorted(db.searchKeywords("people")) == V{k_people, k_venus});
+
+		db.deleteEntry<KeywordRecord>(k_italy);
+		CHECK(db.searchKeywords("ven") == V{k_venus});
+		CHECK(db.searchKeywords("places") == V{k_places, k_sao_paulo});
+	}
+}
+
+TEST_CASE("Test retrieving the ancestors of keywords", "[getAncestors][backend]") {
+	BackendFactory db { ":memory:" };
+	using V = std::vector<int>;
+
+	int k_places = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"), db);
+	int k_italy = add(KeywordRecord(k_places, KeywordRecord::Options::NONE, "Italy"), db);
+	int k_venice = add(KeywordRecord(k_italy, KeywordRecord::Options::NONE, "Venice"), db);
+	int k_germany = add(KeywordRecord(k_places, KeywordRecord::Options::NONE, "Germany"), db);
+	int k_people = add(KeywordRecord(0, KeywordRecord::Options::NONE, "People"), db);
+
+	CHECK(db.getAncestors<KeywordRecord>(V{}).empty());
+	CHECK(db.getAncestors<KeywordRecord>(V{k_people}).empty());
+	CHECK(db.getAncestors<KeywordRecord>(V{k_venice}) == V{k_places, k_italy});
+	CHECK(db.getAncestors<KeywordRecord>(V{k_venice, k_germany, k_people}) == V{k_places, k_italy});
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
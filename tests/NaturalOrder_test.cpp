@@ -0,0 +1,64 @@
+/*
+ * NaturalOrder_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../src/Support/NaturalOrder.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace NaturalOrder_tests {
+
+TEST_CASE("Test comparing strings in natural order", "[Support][NaturalOrder]") {
+	CHECK(naturalCompare("", "") == 0);
+	CHECK(naturalCompare("IMG_0001.jpg", "IMG_0001.jpg") == 0);
+	CHECK(naturalCompare("", "a") < 0);
+	CHECK(naturalCompare("a", "") > 0);
+	CHECK(naturalCompare("img2.jpg", "img10.jpg") < 0);
+	CHECK(naturalCompare("img10.jpg", "img2.jpg") > 0);
+	CHECK(naturalCompare("IMG_9.jpg", "img_10.jpg") < 0);
+	CHECK(naturalCompare("a99999999999999999999999b", "a100000000000000000000000a") < 0);
+	CHECK(naturalCompare("x2y3", "x2y12") < 0);
+	CHECK(naturalCompare("img", "img1") < 0);
+
+	SECTION("Strings differing only in case or leading zeros should not compare equal") {
+		CHECK(naturalCompare("img01", "img1") > 0);
+		CHECK(naturalCompare("img1", "img01") < 0);
+		CHECK(naturalCompare("img01", "img2") < 0);
+		CHECK(naturalCompare("IMG", "img") < 0);
+		CHECK(naturalCompare("img", "IMG") > 0);
+		CHECK(naturalCompare("IMG1", "img01") != 0);
+	}
+
+	SECTION("Sorting should give the natural order") {
+		std::vector<std::string> names {"img12.jpg", "IMG1.jpg", "img2.jpg", "img1.jpg", "img02.jpg", "a.jpg", "img.jpg"};
+		std::sort(names.begin(), names.end(),
+				[](const std::string& a, const std::string& b) { return naturalCompare(a, b) < 0; });
+		CHECK(names == std::vector<std::string>{
+			"a.jpg", "img.jpg", "IMG1.jpg", "img1.jpg", "img2.jpg", "img02.jpg", "img12.jpg"});
+	}
+}
+
+} /* namespace NaturalOrder_tests */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
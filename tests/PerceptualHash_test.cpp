@@ -0,0 +1,141 @@
+/*
+ * PerceptualHash_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../src/Support/PerceptualHash.h"
+#include "../src/Support/HammingIndex.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace PerceptualHash_tests {
+
+using Pixels = std::vector<std::uint32_t>;
+using Hashes = std::vector<std::uint64_t>;
+
+/**
+ * Grey ARGB32 image with the brightness given by 'f(x, y)' in [0, 1].
+ */
+template<typename F>
+Pixels image(int width, int height, F f) {
+	Pixels pixels(static_cast<std::size_t>(width) * height);
+	for(int y = 0; y < height; ++y)
+		for(int x = 0; x < width; ++x) {
+			auto grey = static_cast<std::uint32_t>(255 * f(static_cast<double>(x) / width, static_cast<double>(y) / height));
+			pixels[y * width + x] = 0xFF000000 | grey << 16 | grey << 8 | grey;
+		}
+	return pixels;
+}
+
+std::uint64_t hash(const Pixels& pixels, int width, int height) {
+	return PerceptualHash::differenceHash(reinterpret_cast<const unsigned char*>(pixels.data()), width, height,
+			4 * static_cast<std::size_t>(width));
+}
+
+Hashes randomHashes(unsigned int seed, std::size_t n) {
+	std::mt19937_64 generator(seed);
+	Hashes hashes(n);
+	for(auto& h : hashes)
+		h = generator();
+	return hashes;
+}
+
+TEST_CASE("Test computing difference hashes", "[Support][PerceptualHash]") {
+	auto increasing = [](double x, double) { return x; };
+	auto decreasing = [](double x, double) { return 1 - x; };
+	CHECK(hash(image(90, 80, increasing), 90, 80) == ~std::uint64_t{0});
+	CHECK(hash(image(90, 80, decreasing), 90, 80) == 0);
+	CHECK(hash(image(90, 80, [](double, double) { return 0.5; }), 90, 80) == 0);
+
+	// scaled copies should get (almost) the same hash
+	auto pattern = [](double x, double y) { return (1 + std::sin(9 * x + 5 * y * y)) / 4 + (x > 0.5 && y < 0.3 ? 0.4 : 0); };
+	std::uint64_t original = hash(image(640, 480, pattern), 640, 480);
+	CHECK(PerceptualHash::distance(original, hash(image(320, 240, pattern), 320, 240)) <= 2);
+	CHECK(PerceptualHash::distance(original, hash(image(100, 75, pattern), 100, 75)) <= 4);
+	CHECK(PerceptualHash::distance(original, hash(image(640, 480, increasing), 640, 480)) > 10);
+
+	// images smaller than the reduced image are stretched
+	CHECK(hash(image(3, 2, increasing), 3, 2) == hash(image(3, 2, increasing), 3, 2));
+	CHECK_THROWS_AS(hash(Pixels(), 0, 0), std::invalid_argument);
+}
+
+TEST_CASE("Test computing Hamming distances", "[Support][PerceptualHash]") {
+	CHECK(PerceptualHash::distance(0, 0) == 0);
+	CHECK(PerceptualHash::distance(0, ~std::uint64_t{0}) == 64);
+	CHECK(PerceptualHash::distance(0b1011, 0b0110) == 3);
+
+	// all lengths around the vector widths, the SIMD versions handle the remainders separately
+	for(std::size_t n = 0; n < 40; ++n) {
+		Hashes hashes = randomHashes(n, n);
+		std::uint64_t query = randomHashes(1000 + n, 1)[0];
+		std::vector<std::uint8_t> expected(n), computed(n);
+		PerceptualHash::Scalar::distances(query, hashes.data(), expected.data(), n);
+		PerceptualHash::distances(query, hashes.data(), computed.data(), n);
+		CHECK(computed == expected);
+		for(std::size_t i = 0; i < n; ++i)
+			CHECK(expected[i] == std::popcount(query ^ hashes[i]));
+	}
+}
+
+TEST_CASE("Test searching hashes by Hamming distance", "[Support][HammingIndex]") {
+	HammingIndex index;
+	CHECK(index.empty());
+	CHECK(index.find(0, 64).empty());
+
+	// random hashes and near copies of some of them
+	Hashes hashes = randomHashes(1, 2000);
+	std::mt19937 generator(2);
+	std::uniform_int_distribution<int> bit(0, 63), flips(0, 14);
+	for(std::size_t i = 0; i < 500; ++i) {
+		std::uint64_t copy = hashes[i];
+		for(int n = flips(generator); n > 0; --n)
+			copy ^= std::uint64_t{1} << bit(generator);
+		hashes.push_back(copy);
+	}
+	for(std::size_t i = 0; i < hashes.size(); ++i)
+		index.add(static_cast<int>(i), hashes[i]);
+	CHECK(index.size() == hashes.size());
+
+	// compared with a linear search for the indexed and the scanned distances
+	for(int max_distance : {0, 3, 4, 8, 11, 12, 20}) {
+		for(std::size_t q = 0; q < hashes.size(); q += 50) {
+			std::vector<HammingIndex::Match> expected;
+			for(std::size_t i = 0; i < hashes.size(); ++i)
+				if(int distance = PerceptualHash::distance(hashes[q], hashes[i]); distance <= max_distance)
+					expected.push_back({static_cast<int>(i), distance});
+			std::sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) {
+				return a.distance < b.distance || (a.distance == b.distance && a.id < b.id);
+			});
+			INFO("max_distance " << max_distance << ", query " << q);
+			CHECK(index.find(hashes[q], max_distance) == expected);
+		}
+	}
+	CHECK(index.find(hashes[0], -1).empty());
+}
+
+} /* namespace PerceptualHash_tests */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
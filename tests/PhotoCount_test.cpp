@@ -0,0 +1,182 @@
+/*
+ * PhotoCount_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "Record/AlbumRecord.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/KeywordRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::AlbumRecord;
+using RecordClasses::DirectoryRecord;
+using RecordClasses::KeywordRecord;
+using RecordClasses::PhotoRecord;
+using Relations = BackendFactory::Relations;
+
+TEST_CASE("Test the photo counts of the directories", "[directory][photo][getNumberPhotos][backend]") {
+	BackendFactory db { ":memory:" };
+
+	int d2020 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2020", "/home/user/Photos/2020"), db);
+	int d2020_01 = add(DirectoryRecord(d2020, DirectoryRecord::Options::NONE, "01", "01"), db);
+	int d2020_01_13 = add(DirectoryRecord(d2020_01, DirectoryRecord::Options::NONE, "13", "13"), db);
+	int d2020_02 = add(DirectoryRecord(d2020, DirectoryRecord::Options::NONE, "02", "02"), db);
+	int d2021 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/Photos/2021"), db);
+
+	CHECK(db.getNumberPhotos<DirectoryRecord>(d2020) == 0);
+	CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 0);
+
+	int p1 = add(PhotoRecord(d2020_01_13, "1.jpg"), db);
+	int p2 = add(PhotoRecord(d2020_01_13, "2.jpg"), db);
+	add(PhotoRecord(d2020_01, "3.jpg"), db);
+	add(PhotoRecord(d2020_02, "4.jpg"), db);
+	add(PhotoRecord(d2021, "5.jpg"), db);
+
+	CHECK(db.getNumberPhotos<DirectoryRecord>(d2020_01_13) == 2);
+	CHECK(db.getNumberPhotos<DirectoryRecord>(d2020_01, false) == 1);
+	CHECK(db.getNumberPhotos<DirectoryRecord>(d2020_01) == 3);
+	CHECK(db.getNumberPhotos<DirectoryRecord>(d2020, false) == 0);
+	CHECK(db.getNumberPhotos<DirectoryRecord>(d2020) == 4);
+	CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 5);
+	CHECK(db.checkPhotoCounts());
+
+	SECTION("Moving a photo should update the counts of both directories") {
+		db.updateEntry(p1, PhotoRecord(d2021, "1.jpg"));
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020_01_13) == 1);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020) == 3);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2021) == 2);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 5);
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Deleting a photo should update the counts") {
+		db.deleteEntry<PhotoRecord>(p2);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020_01_13) == 1);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020) == 3);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 4);
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Moving a directory should update the counts of the old and the new parents") {
+		db.setParent<DirectoryRecord>(d2020_01, d2021);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020) == 1);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2021) == 4);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 5);
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Deleting a directory should remove its photos from the counts") {
+		db.deleteEntry<DirectoryRecord>(d2020_01);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020_01) == 0);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020) == 1);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 2);
+		CHECK(db.checkPhotoCounts());
+
+		db.deleteEntry<DirectoryRecord>(d2020);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 1);
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Rebuilding the counts should not change correct counts") {
+		db.rebuildPhotoCounts();
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020_01) == 3);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(d2020) == 4);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(0) == 5);
+		CHECK(db.checkPhotoCounts());
+	}
+}
+
+TEST_CASE("Test the photo counts of albums and keywords", "[album][keyword][photo][getNumberPhotos][backend]") {
+	BackendFactory db { ":memory:" };
+
+	int holiday = add(AlbumRecord(0, AlbumRecord::Options::ALBUM_IS_SET, "Holiday"), db);
+	int city_trips = add(AlbumRecord(holiday, AlbumRecord::Options::ALBUM_IS_SET, "City Trips"), db);
+	int venice = add(AlbumRecord(city_trips, AlbumRecord::Options::NONE, "Venice"), db);
+	int beach = add(AlbumRecord(holiday, AlbumRecord::Options::NONE, "Beach"), db);
+
+	int animal = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Animal"), db);
+	int spider = add(KeywordRecord(animal, KeywordRecord::Options::NONE, "Spider"), db);
+
+	std::vector<int> photos;
+	for(int i=0; i<5; ++i)
+		photos.push_back(add(PhotoRecord(0, std::to_string(i) + ".jpg"), db));
+
+	for(int i=0; i<3; ++i)
+		db.newRelation<Relations::PHOTOS_ALBUMS>(photos[i], venice);
+	db.newRelation<Relations::PHOTOS_ALBUMS>(photos[2], beach);
+	db.newRelation<Relations::PHOTOS_ALBUMS>(photos[3], beach);
+	//adding an existing relation shouldn't change the counts
+	db.newRelation<Relations::PHOTOS_ALBUMS>(photos[3], beach);
+
+	db.newRelation<Relations::PHOTOS_KEYWORDS>(photos[0], animal);
+	db.newRelation<Relations::PHOTOS_KEYWORDS>(photos[1], spider);
+	db.newRelation<Relations::PHOTOS_KEYWORDS>(photos[2], spider);
+
+	CHECK(db.getNumberPhotos<AlbumRecord>(venice) == 3);
+	CHECK(db.getNumberPhotos<AlbumRecord>(beach) == 2);
+	CHECK(db.getNumberPhotos<AlbumRecord>(city_trips) == 3);
+	CHECK(db.getNumberPhotos<AlbumRecord>(holiday, false) == 0);
+	CHECK(db.getNumberPhotos<AlbumRecord>(holiday) == 5);
+	CHECK(db.getNumberPhotos<KeywordRecord>(animal, false) == 1);
+	CHECK(db.getNumberPhotos<KeywordRecord>(animal) == 3);
+	CHECK(db.checkPhotoCounts());
+
+	SECTION("Removing relations should update the counts") {
+		db.deleteRelation<Relations::PHOTOS_ALBUMS>(photos[0], venice);
+		db.deleteRelation<Relations::PHOTOS_ALBUMS>(photos[4], venice);
+		db.deleteRelation<Relations::PHOTOS_KEYWORDS>(photos[1], spider);
+		CHECK(db.getNumberPhotos<AlbumRecord>(venice) == 2);
+		CHECK(db.getNumberPhotos<AlbumRecord>(holiday) == 4);
+		CHECK(db.getNumberPhotos<KeywordRecord>(animal) == 2);
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Deleting a photo should remove it from the counts of its albums and keywords") {
+		db.deleteEntry<PhotoRecord>(photos[2]);
+		CHECK(db.getNumberPhotos<AlbumRecord>(venice) == 2);
+		CHECK(db.getNumberPhotos<AlbumRecord>(beach) == 1);
+		CHECK(db.getNumberPhotos<AlbumRecord>(holiday) == 3);
+		CHECK(db.getNumberPhotos<KeywordRecord>(spider) == 1);
+		CHECK(db.getNumberPhotos<KeywordRecord>(animal) == 2);
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Moving and deleting albums and keywords should update the counts") {
+		db.setParent<AlbumRecord>(venice, 0);
+		CHECK(db.getNumberPhotos<AlbumRecord>(holiday) == 2);
+		db.setParent<KeywordRecord>(spider, 0);
+		CHECK(db.getNumberPhotos<KeywordRecord>(animal) == 1);
+		CHECK(db.checkPhotoCounts());
+
+		db.setParent<AlbumRecord>(venice, city_trips);
+		db.deleteEntry<AlbumRecord>(city_trips);
+		CHECK(db.getNumberPhotos<AlbumRecord>(holiday) == 2);
+		CHECK(db.getNumberPhotos<AlbumRecord>(venice) == 0);
+		CHECK(db.checkPhotoCounts());
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
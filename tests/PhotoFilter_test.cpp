@@ -0,0 +1,161 @@
+/*
+ * PhotoFilter_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "PhotoFilter.h"
+#include "Record/AlbumRecord.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/KeywordRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::AlbumRecord;
+using RecordClasses::DirectoryRecord;
+using RecordClasses::KeywordRecord;
+using RecordClasses::PhotoRecord;
+using Relations = BackendFactory::Relations;
+
+TEST_CASE("Test parsing filter expressions", "[PhotoFilter][backend]") {
+	CHECK(PhotoFilter("").toString() == "");
+	CHECK(PhotoFilter("rating>=3").toString() == "rating>=3");
+	CHECK(PhotoFilter("RATING >= 3 and Width > 1000").toString() == "(rating>=3 AND width>1000)");
+	CHECK(PhotoFilter("rating=1 rating=2").toString() == "(rating=1 AND rating=2)");
+	CHECK(PhotoFilter("rating=1 OR rating=2 height<5").toString() == "(rating=1 OR (rating=2 AND height<5))");
+	CHECK(PhotoFilter("(rating=1 OR rating=2) height<5").toString() == "((rating=1 OR rating=2) AND height<5)");
+	CHECK(PhotoFilter("NOT NOT rating!=1").toString() == "NOT NOT rating!=1");
+	CHECK(PhotoFilter("keyword:\"New York\" album!=Best").toString() == "(keyword=\"New York\" AND NOT album=\"Best\")");
+	CHECK(PhotoFilter("tag:a dir:b folder:c").toString() == "(keyword=\"a\" AND directory=\"b\" AND directory=\"c\")");
+
+	SECTION("Dates should be parsed into the range they cover") {
+		auto predicate = PhotoFilter("date=2021-05-17").getRoot().predicate;
+		CHECK(predicate.field == PhotoFilter::Field::DATETIME);
+		CHECK(predicate.lower == 1621209600);
+		CHECK(predicate.upper == 1621209600 + 24 * 3600);
+
+		predicate = PhotoFilter("date=2021-12").getRoot().predicate;
+		CHECK(predicate.lower == 1638316800);
+		CHECK(predicate.upper == 1640995200);
+
+		predicate = PhotoFilter("date<2021").getRoot().predicate;
+		CHECK(predicate.comparison == PhotoFilter::Comparison::LESS);
+		CHECK(predicate.lower == 1609459200);
+		CHECK(predicate.upper == 1640995200);
+	}
+
+	SECTION("Invalid expressions should throw a filter_error") {
+		CHECK_THROWS_AS(PhotoFilter("rating"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("rating>"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("rating>three"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("colour=red"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("album>a"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("(rating=1"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("rating=1)"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("rating=1 AND"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("keyword=\"open"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("date=2021-13"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("date=2021-02-30"), filter_error);
+		CHECK_THROWS_AS(PhotoFilter("rating!3"), filter_error);
+	}
+}
+
+TEST_CASE("Test compiling filter expressions", "[PhotoFilter][backend]") {
+	auto compile_predicate = [](const PhotoFilter::Predicate& predicate) {
+		return PhotoFilter::CompiledPredicate{predicate.text, {predicate.lower}};
+	};
+	std::vector<PhotoFilter::Parameter> parameters;
+
+	CHECK(PhotoFilter("").compile(compile_predicate, parameters) == "1");
+	CHECK(parameters.empty());
+
+	CHECK(PhotoFilter("rating=5 rating=1 rating=3").compile(compile_predicate, parameters) == "((5) AND (1) AND (3))");
+	CHECK(parameters == std::vector<PhotoFilter::Parameter>{5, 1, 3});
+
+	parameters.clear();
+	CHECK(PhotoFilter("rating=1 OR rating=5 OR NOT rating=8").compile(compile_predicate, parameters)
+			== "((1) OR (5) OR NOT (8))");
+	CHECK(parameters == std::vector<PhotoFilter::Parameter>{1, 5, 8});
+}
+
+TEST_CASE("Test filtering photos", "[PhotoFilter][filterPhotos][backend]") {
+	BackendFactory db { ":memory:" };
+
+	int d2020 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2020", "/home/user/Photos/2020"), db);
+	int d2020_05 = add(DirectoryRecord(d2020, DirectoryRecord::Options::NONE, "05", "05"), db);
+	int d2021 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/Photos/2021"), db);
+
+	int p1 = add(PhotoRecord(d2020, "1.jpg", 1, 1590000000, 1920, 1080), db);
+	int p2 = add(PhotoRecord(d2020_05, "2.jpg", 3, 1590500000, 1080, 1920), db);
+	int p3 = add(PhotoRecord(d2020_05, "3.jpg", 5, 1590600000, 4000, 3000), db);
+	int p4 = add(PhotoRecord(d2021, "4.jpg", 4, 1621252800, 1920, 1080), db);
+	int p5 = add(PhotoRecord(d2021, "5.jpg", 0, 1622505600, 640, 480), db);
+
+	int k_places = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"), db);
+	int k_italy = add(KeywordRecord(k_places, KeywordRecord::Options::NONE, "Italy", "Italia"), db);
+	int k_venice = add(KeywordRecord(k_italy, KeywordRecord::Options::NONE, "Venice", "Venezia, Venedig"), db);
+	int k_people = add(KeywordRecord(0, KeywordRecord::Options::NONE, "People"), db);
+
+	int a_set = add(AlbumRecord(0, AlbumRecord::Options::ALBUM_IS_SET, "Holidays"), db);
+	int a_best = add(AlbumRecord(a_set, AlbumRecord::Options::NONE, "Best of"), db);
+
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{p1, p2}, k_venice);
+	db.newRelation<Relations::PHOTOS_KEYWORDS>(p3, k_italy);
+	db.newRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{p2, p4}, k_people);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(std::vector<int>{p2, p3, p5}, a_best);
+
+	using V = std::vector<int>;
+	CHECK(db.filterPhotos("") == V{p1, p2, p3, p4, p5});
+	CHECK(db.filterPhotos("rating>=3") == V{p2, p3, p4});
+	CHECK(db.filterPhotos("rating<=3 rating>0") == V{p1, p2});
+	CHECK(db.filterPhotos("rating!=5") == V{p1, p2, p4, p5});
+	CHECK(db.filterPhotos("width>1080") == V{p1, p3, p4});
+
+	CHECK(db.filterPhotos("date=2020-05") == V{p1, p2, p3});
+	CHECK(db.filterPhotos("date=2021-05-17") == V{p4});
+	CHECK(db.filterPhotos("date>=2021-06") == V{p5});
+	CHECK(db.filterPhotos("date<2021") == V{p1, p2, p3});
+
+	CHECK(db.filterPhotos("directory:2020") == V{p1, p2, p3});
+	CHECK(db.filterPhotos("directory=/home/user/Photos/2021") == V{p4, p5});
+	CHECK(db.filterPhotos("directory:05") == V{p2, p3});
+
+	CHECK(db.filterPhotos("keyword:places") == V{p1, p2, p3});
+	CHECK(db.filterPhotos("keyword:Italia") == V{p1, p2, p3});
+	CHECK(db.filterPhotos("keyword:venedig") == V{p1, p2});
+	CHECK(db.filterPhotos("keyword:Venice keyword:People") == V{p2});
+	CHECK(db.filterPhotos("keyword:Venice OR keyword:People") == V{p1, p2, p4});
+	CHECK(db.filterPhotos("keyword:Places AND NOT keyword:Venice") == V{p3});
+	CHECK(db.filterPhotos("keyword:Unknown").empty());
+	CHECK(db.filterPhotos("NOT keyword:Unknown") == V{p1, p2, p3, p4, p5});
+
+	CHECK(db.filterPhotos("album:Holidays") == V{p2, p3, p5});
+	CHECK(db.filterPhotos("album:\"best of\" rating>=4") == V{p3});
+	CHECK(db.filterPhotos("album!=\"Best of\" (keyword:Italy OR rating=0)") == V{p1});
+	CHECK(db.filterPhotos("(album:Holidays OR keyword:People) AND NOT directory:2021") == V{p2, p3});
+
+	CHECK_THROWS_AS(db.filterPhotos("rating=="), filter_error);
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,444 @@
+/*
+ * PhotoImporter_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "ImageHeader.h"
+#include "PhotoImporter.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/PhotoRecord.h"
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::DirectoryRecord;
+using RecordClasses::PhotoRecord;
+
+namespace {
+
+void append16(Bytes& bytes, unsigned int value) {
+	bytes.push_back(value >> 8);
+	bytes.push_back(value & 0xFF);
+}
+
+void append32(Bytes& bytes, unsigned int value) {
+	append16(bytes, value >> 16);
+	append16(bytes, value & 0xFFFF);
+}
+
+/**
+ * Builder for TIFF structures.
+ */
+struct TIFFWriter {
+	bool big_endian;
+	Bytes bytes;
+
+	explicit TIFFWriter(bool big_endian) : big_endian(big_endian) {
+		bytes = big_endian ? Bytes{'M', 'M', 0, 42} : Bytes{'I', 'I', 42, 0};
+		u32(8);
+	}
+	void u16(unsigned int value) {
+		if(big_endian)
+			append16(bytes, value);
+		else
+			bytes.insert(bytes.end(), {static_cast<unsigned char>(value & 0xFF), static_cast<unsigned char>(value >> 8)});
+	}
+	void u32(unsigned int value) {
+		if(big_endian)
+			append32(bytes, value);
+		else {
+			u16(value & 0xFFFF);
+			u16(value >> 16);
+		}
+	}
+	// SHORT values (type 3) are left-aligned in the value field
+	void entry(unsigned int tag, unsigned int type, unsigned int count, unsigned int value) {
+		u16(tag); u16(type); u32(count);
+		if(type == 3) {
+			u16(value);
+			u16(0);
+		} else
+			u32(value);
+	}
+	void text(const std::string& text) {
+		bytes.insert(bytes.end(), text.begin(), text.end());
+		bytes.push_back(0);
+	}
+};
+
+/**
+ * Minimal JPEG header: Exif segment with Orientation and DateTimeOriginal, and SOF0.
+ */
+Bytes jpeg(int width, int height, const std::string& datetime, int orientation = 1) {
+	TIFFWriter tiff(true);
+	// IFD0: Orientation, pointer to the Exif IFD
+	tiff.u16(2);
+	tiff.entry(0x0112, 3, 1, orientation);
+	tiff.entry(0x8769, 4, 1, 38);
+	tiff.u32(0);
+	// Exif IFD: DateTimeOriginal
+	tiff.u16(1);
+	tiff.entry(0x9003, 2, 20, 56);
+	tiff.u32(0);
+	tiff.text(datetime);
+
+	Bytes bytes {0xFF, 0xD8, 0xFF, 0xE1};
+	append16(bytes, 2 + 6 + tiff.bytes.size());
+	for(char c : std::string("Exif\0\0", 6))
+		bytes.push_back(c);
+	bytes.insert(bytes.end(), tiff.bytes.begin(), tiff.bytes.end());
+	bytes.insert(bytes.end(), {0xFF, 0xC0});
+	append16(bytes, 17);
+	bytes.push_back(8);
+	append16(bytes, height);
+	append16(bytes, width);
+	bytes.insert(bytes.end(), {3, 1, 0x22, 0, 2, 0x11, 1, 3, 0x11, 1});
+	bytes.insert(bytes.end(), {0xFF, 0xDA, 0, 2});
+	return bytes;
+}
+
+/**
+ * Minimal DNG: preview in IFD0, full image and a second preview in SubIFDs.
+ */
+Bytes dng(int width, int height, const std::string& datetime, int orientation) {
+	TIFFWriter tiff(false);
+	tiff.u16(6);
+	tiff.entry(0x00FE, 4, 1, 1);
+	tiff.entry(0x0100, 3, 1, 256);
+	tiff.entry(0x0101, 3, 1, 171);
+	tiff.entry(0x0112, 3, 1, orientation);
+	tiff.entry(0x0132, 2, 20, 86);
+	tiff.entry(0x014A, 4, 2, 106);
+	tiff.u32(0);
+	tiff.text(datetime);
+	tiff.u32(156);
+	tiff.u32(114);
+	// SubIFD at 114: full image
+	tiff.u16(3);
+	tiff.entry(0x00FE, 4, 1, 0);
+	tiff.entry(0x0100, 4, 1, width);
+	tiff.entry(0x0101, 4, 1, height);
+	tiff.u32(0);
+	// SubIFD at 156: preview
+	tiff.u16(3);
+	tiff.entry(0x00FE, 4, 1, 1);
+	tiff.entry(0x0100, 4, 1, 1024);
+	tiff.entry(0x0101, 4, 1, 683);
+	tiff.u32(0);
+	return tiff.bytes;
+}
+
+Bytes box(const std::string& type, const Bytes& payload) {
+	Bytes bytes;
+	append32(bytes, 8 + payload.size());
+	bytes.insert(bytes.end(), type.begin(), type.end());
+	bytes.insert(bytes.end(), payload.begin(), payload.end());
+	return bytes;
+}
+
+Bytes operator+(Bytes a, const Bytes& b) {
+	a.insert(a.end(), b.begin(), b.end());
+	return a;
+}
+
+/**
+ * Minimal HEIF: ftyp and meta with image properties for a tile, the
+ * image, and a thumbnail.
+ */
+Bytes heif(const std::string& brand, int width, int height, int rotation) {
+	auto ispe = [](int width, int height) {
+		Bytes payload {0, 0, 0, 0};
+		append32(payload, width);
+		append32(payload, height);
+		return box("ispe", payload);
+	};
+	Bytes ftyp {brand.begin(), brand.end()};
+	append32(ftyp, 0);
+	ftyp.insert(ftyp.end(), brand.begin(), brand.end());
+	Bytes ipco = ispe(512, 512) + ispe(width, height) + box("irot", {static_cast<unsigned char>(rotation)}) +
+			ispe(320, 240);
+	Bytes meta = Bytes{0, 0, 0, 0} + box("hdlr", Bytes(25, 0)) + box("iprp", box("ipco", ipco));
+	return box("ftyp", ftyp) + box("meta", meta) + box("mdat", Bytes(16, 0));
+}
+
+Bytes png(int width, int height) {
+	Bytes bytes {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	append32(bytes, 13);
+	bytes.insert(bytes.end(), {'I', 'H', 'D', 'R'});
+	append32(bytes, width);
+	append32(bytes, height);
+	bytes.insert(bytes.end(), {8, 2, 0, 0, 0});
+	return bytes;
+}
+
+}
+
+TEST_CASE("Test reading image headers", "[ImageHeader][backend]") {
+	TemporaryDirectory directory;
+
+	writeFile(directory.path / "a.jpg", jpeg(4000, 3000, "2021:05:17 12:00:00"));
+	auto header = readImageHeader(directory.path / "a.jpg");
+	REQUIRE(header);
+	CHECK(header->width == 4000);
+	CHECK(header->height == 3000);
+	CHECK(header->orientation == 1);
+	CHECK(header->datetime == 1621252800);
+
+	writeFile(directory.path / "b.png", png(640, 480));
+	header = readImageHeader(directory.path / "b.png");
+	REQUIRE(header);
+	CHECK(header->width == 640);
+	CHECK(header->height == 480);
+	CHECK(header->datetime == 0);
+
+	writeFile(directory.path / "c.jpg", {'n', 'o', 't', ' ', 'a', 'n', ' ', 'i', 'm', 'a', 'g', 'e'});
+	CHECK_FALSE(readImageHeader(directory.path / "c.jpg"));
+	CHECK_FALSE(readImageHeader(directory.path / "missing.jpg"));
+	CHECK_FALSE(readImageHeader(directory.path));
+
+	SECTION("The Exif orientation should be read") {
+		writeFile(directory.path / "d.jpg", jpeg(4000, 3000, "2021:05:17 12:00:00", 6));
+		header = readImageHeader(directory.path / "d.jpg");
+		REQUIRE(header);
+		CHECK(header->width == 4000);
+		CHECK(header->orientation == 6);
+	}
+
+	SECTION("Segments before the Exif segment and padding should be skipped") {
+		Bytes bytes {0xFF, 0xD8, 0xFF, 0xE0};
+		append16(bytes, 5000);
+		bytes.resize(bytes.size() + 4998, 0);
+		bytes.insert(bytes.end(), {0xFF, 0xFF});
+		Bytes image = jpeg(800, 600, "2020:01:01 00:00:00", 8);
+		bytes.insert(bytes.end(), image.begin() + 2, image.end());
+		writeFile(directory.path / "e.jpg", bytes);
+		header = readImageHeader(directory.path / "e.jpg");
+		REQUIRE(header);
+		CHECK(header->width == 800);
+		CHECK(header->height == 600);
+		CHECK(header->orientation == 8);
+		CHECK(header->datetime == 1577836800);
+	}
+
+	SECTION("Truncated files should yield what could be read") {
+		Bytes bytes = jpeg(800, 600, "2020:01:01 00:00:00");
+		bytes.resize(bytes.size() - 20);
+		writeFile(directory.path / "f.jpg", bytes);
+		header = readImageHeader(directory.path / "f.jpg");
+		REQUIRE(header);
+		CHECK(header->width == 0);
+		CHECK(header->datetime == 1577836800);
+	}
+
+	SECTION("The dimensions of the full image in a DNG should be read") {
+		writeFile(directory.path / "g.dng", dng(6000, 4000, "2021:05:17 12:00:00", 3));
+		header = readImageHeader(directory.path / "g.dng");
+		REQUIRE(header);
+		CHECK(header->width == 6000);
+		CHECK(header->height == 4000);
+		CHECK(header->orientation == 3);
+		CHECK(header->datetime == 1621252800);
+	}
+
+	SECTION("Big endian TIFF should be read") {
+		TIFFWriter tiff(true);
+		tiff.u16(2);
+		tiff.entry(0x0100, 4, 1, 70000);
+		tiff.entry(0x0101, 3, 1, 500);
+		tiff.u32(0);
+		writeFile(directory.path / "h.tif", tiff.bytes);
+		header = readImageHeader(directory.path / "h.tif");
+		REQUIRE(header);
+		CHECK(header->width == 70000);
+		CHECK(header->height == 500);
+		CHECK(header->orientation == 1);
+	}
+
+	SECTION("The size of the primary image of a HEIF should be read") {
+		writeFile(directory.path / "i.heic", heif("heic", 4032, 3024, 3));
+		header = readImageHeader(directory.path / "i.heic");
+		REQUIRE(header);
+		CHECK(header->width == 4032);
+		CHECK(header->height == 3024);
+		CHECK(header->orientation == 6);
+
+		writeFile(directory.path / "j.mp4", heif("isom", 4032, 3024, 0));
+		CHECK_FALSE(readImageHeader(directory.path / "j.mp4"));
+	}
+}
+
+TEST_CASE("Test importing directories", "[PhotoImporter][backend]") {
+	TemporaryDirectory directory;
+	std::filesystem::create_directories(directory.path / "sub" / "deeper");
+	std::filesystem::create_directories(directory.path / "empty");
+	writeFile(directory.path / "a.jpg", jpeg(4000, 3000, "2021:05:17 12:00:00", 6));
+	writeFile(directory.path / "sub" / "b.png", png(640, 480));
+	writeFile(directory.path / "sub" / "notes.txt", {'t', 'e', 'x', 't'});
+	writeFile(directory.path / "sub" / "deeper" / "c.JPG", {'b', 'r', 'o', 'k', 'e', 'n'});
+	for(int i = 0; i < 20; ++i)
+		writeFile(directory.path / "sub" / "deeper" / ("p" + std::to_string(i) + ".png"), png(i + 1, 2 * i + 1));
+
+	BackendFactory db { ":memory:" };
+	PhotoImporter importer(db, 3, 4);
+	PhotoImporter::Statistics statistics = importer.importDirectory(directory.path);
+	CHECK(statistics.directories == 4);
+	CHECK(statistics.files == 23);
+	CHECK(statistics.photos_added == 23);
+	CHECK(statistics.errors == 0);
+
+	auto absolute = std::filesystem::canonical(directory.path);
+	int root = db.getID(DirectoryRecord(0, DirectoryRecord::Options::NONE,
+			absolute.filename().string(), absolute.string()));
+	CHECK(db.getNumberChildren<DirectoryRecord>(root) == 2);
+	CHECK(db.getNumberPhotos<DirectoryRecord>(root, true) == 23);
+
+	int a = db.getID(PhotoRecord(root, "a.jpg", 0, 1621252800, 4000, 3000, 6));
+	CHECK(db.getChildren<PhotoRecord>(root) == std::vector<int>{a});
+
+	int sub = db.getID(DirectoryRecord(root, DirectoryRecord::Options::NONE, "sub", "sub"));
+	int deeper = db.getID(DirectoryRecord(sub, DirectoryRecord::Options::NONE, "deeper", "deeper"));
+	CHECK(db.getNumberPhotos<DirectoryRecord>(deeper, false) == 21);
+	PhotoRecord b = db.getEntry<PhotoRecord>(db.getChildren<PhotoRecord>(sub).at(0));
+	CHECK(b.getFilename() == "b.png");
+	CHECK(b.getWidth() == 640);
+	CHECK(b.getHeight() == 480);
+	CHECK(b.getOrientation() == 1);
+	// no capture time in the header: modification time
+	CHECK(b.getDatetime() > 0);
+
+	SECTION("Importing again should not read or add anything") {
+		statistics = PhotoImporter(db, 2, 1000).importDirectory(directory.path);
+		CHECK(statistics.files == 23);
+		CHECK(statistics.photos_unchanged == 23);
+		CHECK(statistics.photos_added == 0);
+		CHECK(statistics.photos_updated == 0);
+		CHECK(db.getNumberChildren<DirectoryRecord>(root) == 2);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(root, true) == 23);
+	}
+
+	SECTION("Rescanning should only read new and changed files and remove vanished ones") {
+		db.updateEntry(db.getChildren<PhotoRecord>(sub).at(0), PhotoRecord(sub, "b.png", 5, b.getDatetime(), 640, 480));
+		auto time = std::filesystem::last_write_time(directory.path / "sub" / "b.png");
+		writeFile(directory.path / "sub" / "b.png", png(800, 600));
+		std::filesystem::last_write_time(directory.path / "sub" / "b.png", time + std::chrono::seconds(1));
+		writeFile(directory.path / "sub" / "e.png", png(10, 10));
+		std::filesystem::remove(directory.path / "a.jpg");
+		std::filesystem::remove_all(directory.path / "sub" / "deeper");
+
+		statistics = PhotoImporter(db, 2, 1000).rescanDirectory(directory.path);
+		CHECK(statistics.files == 2);
+		CHECK(statistics.photos_unchanged == 0);
+		CHECK(statistics.photos_added == 1);
+		CHECK(statistics.photos_updated == 1);
+		CHECK(statistics.photos_removed == 22);
+		CHECK(statistics.directories_removed == 1);
+		CHECK(statistics.errors == 0);
+
+		CHECK(db.getNumberChildren<DirectoryRecord>(root) == 2);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(root, true) == 2);
+		CHECK(db.getChildren<PhotoRecord>(root).empty());
+		CHECK_THROWS_AS(db.getEntry<DirectoryRecord>(deeper), DatabaseInterface::missing_entry);
+		b = db.getEntry<PhotoRecord>(db.getChildren<PhotoRecord>(sub).at(0));
+		CHECK(b.getWidth() == 800);
+		CHECK(b.getHeight() == 600);
+		// attributes not read from the file are kept
+		CHECK(b.getRating() == 5);
+
+		statistics = PhotoImporter(db, 2, 1000).rescanDirectory(directory.path);
+		CHECK(statistics.photos_unchanged == 2);
+		CHECK(statistics.photos_added + statistics.photos_updated + statistics.photos_removed == 0);
+	}
+
+	SECTION("Renamed and moved files and directories should keep their photos") {
+		int b_id = db.getChildren<PhotoRecord>(sub).at(0);
+		db.updateEntry(b_id, PhotoRecord(sub, "b.png", 5, b.getDatetime(), 640, 480));
+		std::filesystem::rename(directory.path / "a.jpg", directory.path / "sub" / "f.jpg");
+		std::filesystem::rename(directory.path / "sub" / "b.png", directory.path / "sub" / "g.png");
+		std::filesystem::rename(directory.path / "sub" / "deeper", directory.path / "moved");
+		auto deeper_photos = db.getChildren<PhotoRecord>(deeper);
+
+		statistics = PhotoImporter(db, 2, 4).rescanDirectory(directory.path);
+		CHECK(statistics.photos_added == 0);
+		CHECK(statistics.photos_moved == 23);
+		CHECK(statistics.photos_removed == 0);
+		CHECK(statistics.directories_removed == 1);
+
+		CHECK(db.getNumberPhotos<DirectoryRecord>(root, true) == 23);
+		CHECK(db.getEntry<PhotoRecord>(a).getDirectory() == sub);
+		CHECK(db.getEntry<PhotoRecord>(a).getFilename() == "f.jpg");
+		PhotoRecord g = db.getEntry<PhotoRecord>(b_id);
+		CHECK(g.getFilename() == "g.png");
+		CHECK(g.getRating() == 5);
+		int moved = db.getID(DirectoryRecord(root, DirectoryRecord::Options::NONE, "moved", "moved"));
+		auto moved_photos = db.getChildren<PhotoRecord>(moved);
+		std::sort(deeper_photos.begin(), deeper_photos.end());
+		std::sort(moved_photos.begin(), moved_photos.end());
+		CHECK(moved_photos == deeper_photos);
+		CHECK_THROWS_AS(db.getEntry<DirectoryRecord>(deeper), DatabaseInterface::missing_entry);
+	}
+
+	SECTION("A cancelled importer should neither add nor remove anything") {
+		std::filesystem::remove(directory.path / "a.jpg");
+		writeFile(directory.path / "sub" / "e.png", png(10, 10));
+		importer.cancel();
+		statistics = importer.rescanDirectory(directory.path);
+		CHECK(statistics.files == 0);
+		CHECK(statistics.photos_added + statistics.photos_removed == 0);
+		CHECK(db.getNumberPhotos<DirectoryRecord>(root, true) == 23);
+	}
+
+	SECTION("Importing something else than a directory should throw") {
+		CHECK_THROWS_AS(importer.importDirectory(directory.path / "a.jpg"), std::invalid_argument);
+		CHECK_THROWS_AS(importer.importDirectory(directory.path / "missing"), std::invalid_argument);
+	}
+}
+
+TEST_CASE("Test cancelling a running import", "[PhotoImporter][backend]") {
+	TemporaryDirectory directory;
+	Bytes image = jpeg(800, 600, "2021:05:17 12:00:00");
+	for(int i = 0; i < 3000; ++i)
+		writeFile(directory.path / ("photo" + std::to_string(i) + ".jpg"), image);
+
+	for(int delay : {0, 1, 2, 5, 10}) {
+		BackendFactory db { ":memory:" };
+		PhotoImporter importer(db, 2, 16);
+		PhotoImporter::Statistics statistics;
+		std::thread import([&]() { statistics = importer.importDirectory(directory.path); });
+		std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+		importer.cancel();
+		import.join();
+		int photos = 0;
+		for(int root : db.getChildren<DirectoryRecord>(0))
+			photos += db.getNumberPhotos<DirectoryRecord>(root, true);
+		CHECK(photos == statistics.photos_added);
+		CHECK(photos <= 3000);
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
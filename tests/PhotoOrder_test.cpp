@@ -0,0 +1,91 @@
+/*
+ * PhotoOrder_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "Database.h"
+#include "Record/AlbumRecord.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+#include <string>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::AlbumRecord;
+using RecordClasses::DirectoryRecord;
+using RecordClasses::PhotoRecord;
+using Relations = BackendFactory::Relations;
+using PhotoOrder = BackendFactory::PhotoOrder;
+
+TEST_CASE("Test sorting photos", "[PhotoOrder][backend]") {
+	BackendFactory db { ":memory:" };
+
+	int dir = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/Photos/2021"), db);
+	int other = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2022", "/home/user/Photos/2022"), db);
+	int p1 = add(PhotoRecord(dir, "IMG_10.jpg", 3, 1620000000, 1920, 1080), db);
+	int p2 = add(PhotoRecord(dir, "img_9.jpg", 5, 1610000000, 4000, 3000), db);
+	int p3 = add(PhotoRecord(dir, "IMG_100.jpg", 3, 1600000000, 640, 480), db);
+	int p4 = add(PhotoRecord(dir, "IMG_09.jpg", 0, 1630000000, 1080, 1920), db);
+	int p5 = add(PhotoRecord(other, "IMG_1.jpg", 5, 1590000000, 100, 100), db);
+
+	int album = add(AlbumRecord(0, AlbumRecord::Options::NONE, "Best of"), db);
+	db.newRelations<Relations::PHOTOS_ALBUMS>(std::vector<int>{p5, p3, p2, p1}, album);
+
+	using V = std::vector<int>;
+	CHECK(db.getPhotos(dir, PhotoOrder::ID) == V{p1, p2, p3, p4});
+	CHECK(db.getPhotos(dir, PhotoOrder::DATETIME) == V{p3, p2, p1, p4});
+	CHECK(db.getPhotos(dir, PhotoOrder::DATETIME, true) == V{p4, p1, p2, p3});
+	CHECK(db.getPhotos(dir, PhotoOrder::RATING) == V{p4, p3, p1, p2});
+	CHECK(db.getPhotos(dir, PhotoOrder::RATING, true) == V{p2, p1, p3, p4});
+	CHECK(db.getPhotos(dir, PhotoOrder::FILENAME) == V{p4, p2, p1, p3});
+	CHECK(db.getPhotos(dir, PhotoOrder::DIMENSIONS) == V{p3, p1, p4, p2});
+	CHECK(db.getPhotos(other, PhotoOrder::FILENAME) == V{p5});
+	CHECK(db.getPhotos(1000, PhotoOrder::DATETIME).empty());
+
+	CHECK(db.getEntries<Relations::PHOTOS_ALBUMS>(album, PhotoOrder::DATETIME) == V{p5, p3, p2, p1});
+	CHECK(db.getEntries<Relations::PHOTOS_ALBUMS>(album, PhotoOrder::RATING, true) == V{p2, p5, p1, p3});
+	CHECK(db.getEntries<Relations::PHOTOS_ALBUMS>(album, PhotoOrder::FILENAME) == V{p5, p2, p1, p3});
+
+	CHECK(db.sortPhotos(V{p4, p5, p1}, PhotoOrder::DATETIME) == V{p5, p1, p4});
+	CHECK(db.sortPhotos(V{p4, 1000, p1}, PhotoOrder::ID, true) == V{p4, p1});
+	CHECK(db.sortPhotos(V{}, PhotoOrder::DATETIME).empty());
+}
+
+TEST_CASE("Test writing photos without the natural order collation", "[PhotoOrder][backend]") {
+	TemporaryDirectory directory;
+	auto filename = directory.path / "library.db";
+	{
+		BackendFactory db { filename.c_str() };
+		add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/Photos/2021"), db);
+	}
+
+	// e.g. the sqlite3 shell, which doesn't know the collation NATURAL_ORDER
+	SQLiteAdapter::Database db { filename.c_str(), false };
+	std::string error_msg;
+	CHECK(db.querryNoThrow("INSERT INTO Photos (directory, filename) SELECT id, 'IMG_1.jpg' FROM Directories"
+			" WHERE fullname = '/home/user/Photos/2021';", nullptr, nullptr, error_msg) == 0);
+	CHECK(error_msg.empty());
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
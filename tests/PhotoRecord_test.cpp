@@ -45,6 +45,12 @@ TEST_CASE("test constructors for class PhotoRecord", "[photos][record]") {
 		Photo photo_moving_fileanem{0, std::move(filename), 0, 2255656663, 2563, 1560};
 
 		CHECK(photo_copying_filename == photo_moving_fileanem);
+
+		// 'filename' has been moved from
+		Photo rotated{0, Glib::ustring("some_name"), 0, 2255656663, 2563, 1560, 6};
+		CHECK(rotated.getFilename() == photo_copying_filename.getFilename());
+		CHECK(rotated.getOrientation() == 6);
+		CHECK(rotated != photo_copying_filename);
 	}
 
 	filename = "";
@@ -64,7 +70,10 @@ TEST_CASE("test constructors for class PhotoRecord", "[photos][record]") {
 		photo_vec.push_back({0, Glib::ustring(filename), 0, 0,0 });
 		photo_vec.push_back({0, filename, 0, 0, 0, 0});
 		photo_vec.push_back({0, Glib::ustring(filename), 0, 0, 0, 0});
+		photo_vec.push_back({0, filename, 0, 0, 0, 0, 1});
+		photo_vec.push_back({0, Glib::ustring(filename), 0, 0, 0, 0, 1});
 
+		CHECK(photo_vec[0].getOrientation() == 1);
 		for(auto& photo : photo_vec) {
 			CHECK(photo == photo_vec[0]);
 		}
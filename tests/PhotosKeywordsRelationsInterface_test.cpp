@@ -306,6 +306,92 @@ TEST_CASE(
 		CHECK_THROWS_AS(db.newRelation<Relations::PHOTOS_KEYWORDS>(i, k_city_trips), constraint_error);
 	}
 
+	SECTION("Several photos should be assigned to and removed from keywords at once.", "[newRelations][deleteRelations]") {
+		std::vector<int> photos {photo_1, photo_2, photo_3, photo_4, photo_5};
+		db.deleteRelations<Relations::PHOTOS_KEYWORDS>(photos, std::vector<int>{k_zoo, k_venice});
+
+		CHECK(db.newRelations<Relations::PHOTOS_KEYWORDS>(photos, k_zoo) == 5);
+		CHECK_THAT(db.getEntries<Relations::PHOTOS_KEYWORDS>(k_zoo), Catch::UnorderedEquals(photos));
+		CHECK(db.newRelations<Relations::PHOTOS_KEYWORDS>(photos, std::vector<int>{k_zoo, k_venice}) == 5);
+		CHECK_THAT(db.getEntries<Relations::PHOTOS_KEYWORDS>(k_venice), Catch::UnorderedEquals(photos));
+
+		CHECK(db.deleteRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{photo_1, photo_2}, k_zoo) == 2);
+		CHECK_THAT(db.getEntries<Relations::PHOTOS_KEYWORDS>(k_zoo),
+				Catch::UnorderedEquals(std::vector<int>{photo_3, photo_4, photo_5}));
+		CHECK(db.deleteRelations<Relations::PHOTOS_KEYWORDS>(photos, std::vector<int>{k_zoo, k_venice}) == 8);
+		CHECK(db.getNumberEntries<Relations::PHOTOS_KEYWORDS>(k_zoo) == 0);
+		CHECK(db.getNumberEntries<Relations::PHOTOS_KEYWORDS>(k_venice) == 0);
+	}
+
+	SECTION("Adding several photos including a non-existing one should not add any relation", "[newRelations]") {
+		int i = 51;
+		while(i == photo_1 || i == photo_2 || i == photo_3 || i == photo_4 || i == photo_5)
+			++i;
+
+		db.deleteRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{photo_1, photo_2}, k_zoo);
+		CHECK_THROWS_AS(
+				db.newRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{photo_1, i, photo_2}, k_zoo),
+				constraint_error
+				);
+		CHECK_THAT(db.getEntries<Relations::PHOTOS_KEYWORDS>(k_zoo), !Catch::Matchers::VectorContains(photo_1));
+		CHECK_THAT(db.getEntries<Relations::PHOTOS_KEYWORDS>(k_zoo), !Catch::Matchers::VectorContains(photo_2));
+	}
+
+	SECTION("The bitmaps of the keywords should reflect the relations.", "[getEntriesBitmap]") {
+		auto photos = [](const Support::RoaringBitmap& bitmap) {
+			std::vector<int> ids;
+			for(auto id : bitmap.toVector())
+				ids.push_back(static_cast<int>(id));
+			return ids;
+		};
+		for(int keyword : {k_holiday, k_zoo, k_city_trips, k_venice})
+			CHECK_THAT(
+					photos(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(keyword)),
+					Catch::UnorderedEquals(db.getEntries<Relations::PHOTOS_KEYWORDS>(keyword))
+					);
+
+		CHECK_THAT(
+				photos(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_holiday)
+						- db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_city_trips)),
+				Catch::UnorderedEquals(std::vector<int>{photo_2, photo_5})
+				);
+		CHECK_THAT(
+				photos(db.getEntriesInAll<Relations::PHOTOS_KEYWORDS>(std::vector<int>{k_city_trips, k_zoo})),
+				Catch::UnorderedEquals(std::vector<int>{photo_1, photo_4})
+				);
+		CHECK(db.getEntriesInAll<Relations::PHOTOS_KEYWORDS>(std::vector<int>{}).empty());
+		CHECK(db.getEntriesInAny<Relations::PHOTOS_KEYWORDS>(std::vector<int>{k_zoo, k_city_trips}).cardinality() == 3);
+
+		db.deleteRelation<Relations::PHOTOS_KEYWORDS>(photo_1, k_zoo);
+		db.newRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{photo_2, photo_3}, k_zoo);
+		CHECK_THAT(
+				photos(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_zoo)),
+				Catch::UnorderedEquals(std::vector<int>{photo_2, photo_3, photo_4})
+				);
+
+		int i = 51;
+		while(i == photo_1 || i == photo_2 || i == photo_3 || i == photo_4 || i == photo_5)
+			++i;
+		CHECK_THROWS_AS(db.newRelation<Relations::PHOTOS_KEYWORDS>(i, k_zoo), constraint_error);
+		CHECK_FALSE(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_zoo).contains(i));
+
+		db.template deleteEntry<PhotoRecord>(photo_4);
+		CHECK_THAT(
+				photos(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_zoo)),
+				Catch::UnorderedEquals(std::vector<int>{photo_2, photo_3})
+				);
+		for(int keyword : {k_holiday, k_city_trips, k_venice})
+			CHECK_FALSE(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(keyword).contains(photo_4));
+		CHECK(db.deletePhotos(std::vector<int>{photo_3}) == 1);
+		CHECK_THAT(
+				photos(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_zoo)),
+				Catch::UnorderedEquals(std::vector<int>{photo_2})
+				);
+		db.template deleteEntry<KeywordRecord>(k_city_trips);
+		CHECK(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_city_trips).empty());
+		CHECK(db.getEntriesBitmap<Relations::PHOTOS_KEYWORDS>(k_venice).empty());
+	}
+
 	SECTION("After deleting a photo all its relations should be removed as well.", "[deleteEntry]") {
 		CHECK_NOFAIL(db.getCollections<Relations::PHOTOS_KEYWORDS>(photo_1).size() != 0);
 		db.template deleteEntry<PhotoRecord>(photo_1);
@@ -0,0 +1,159 @@
+/*
+ * PixelConversion_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../src/Support/PixelConversion.h"
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace PixelConversion_tests {
+
+using Bytes = std::vector<unsigned char>;
+using Pixels = std::vector<std::uint32_t>;
+
+Bytes randomBytes(unsigned int seed, std::size_t n) {
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<int> byte(0, 255);
+	Bytes bytes(n);
+	for(auto& b : bytes)
+		b = static_cast<unsigned char>(byte(generator));
+	return bytes;
+}
+
+TEST_CASE("Test converting RGB to ARGB32", "[Support][PixelConversion]") {
+	Bytes rgb {1, 2, 3, 255, 128, 0};
+	Pixels argb(2);
+	PixelConversion::rgbToARGB32(rgb.data(), argb.data(), 2);
+	CHECK(argb == Pixels{0xFF010203, 0xFFFF8000});
+
+	// all lengths around the vector widths, the SIMD versions handle the remainders separately
+	for(std::size_t n = 0; n < 70; ++n) {
+		Bytes source = randomBytes(n, 3 * n);
+		Pixels expected(n), converted(n);
+		PixelConversion::Scalar::rgbToARGB32(source.data(), expected.data(), n);
+		PixelConversion::rgbToARGB32(source.data(), converted.data(), n);
+		CHECK(converted == expected);
+	}
+}
+
+TEST_CASE("Test converting RGBA to premultiplied ARGB32", "[Support][PixelConversion]") {
+	Bytes rgba {255, 128, 0, 128, 10, 20, 30, 0, 10, 20, 30, 255};
+	Pixels argb(3);
+	PixelConversion::rgbaToARGB32(rgba.data(), argb.data(), 3);
+	CHECK(argb == Pixels{0x80804000, 0x00000000, 0xFF0A141E});
+
+	// all combinations of colour and alpha, compared with exact rounding
+	Bytes source;
+	for(int alpha = 0; alpha < 256; ++alpha)
+		for(int colour = 0; colour < 256; ++colour)
+			source.insert(source.end(), {static_cast<unsigned char>(colour), 0, static_cast<unsigned char>(255 - colour),
+					static_cast<unsigned char>(alpha)});
+	std::size_t n = source.size() / 4;
+	Pixels expected(n), converted(n);
+	PixelConversion::Scalar::rgbaToARGB32(source.data(), expected.data(), n);
+	PixelConversion::rgbaToARGB32(source.data(), converted.data(), n);
+	CHECK(converted == expected);
+	bool exact = true;
+	for(std::size_t i = 0; i < n; ++i) {
+		std::uint32_t alpha = source[4 * i + 3];
+		auto premultiplied = [alpha](unsigned char c) {
+			return static_cast<std::uint32_t>(std::lround(c * alpha / 255.));
+		};
+		exact &= expected[i] == (alpha << 24 | premultiplied(source[4 * i]) << 16 | premultiplied(source[4 * i + 2]));
+	}
+	CHECK(exact);
+
+	for(std::size_t n = 0; n < 70; ++n) {
+		Bytes source = randomBytes(n, 4 * n);
+		Pixels expected(n), converted(n);
+		PixelConversion::Scalar::rgbaToARGB32(source.data(), expected.data(), n);
+		PixelConversion::rgbaToARGB32(source.data(), converted.data(), n);
+		CHECK(converted == expected);
+	}
+}
+
+TEST_CASE("Test downscaling with a box filter", "[Support][PixelConversion]") {
+	// 4x2 to 2x1: each destination pixel is the average of 2x2 pixels
+	Bytes source {
+		0, 0, 0, 0,  4, 8, 12, 255,  100, 100, 100, 100,  0, 0, 0, 0,
+		2, 4, 6, 255,  4, 8, 12, 255,  101, 101, 101, 101,  0, 0, 0, 0};
+	Bytes destination(8);
+	PixelConversion::downscale(source.data(), 4, 2, 16, destination.data(), 2, 1, 8);
+	CHECK(destination == Bytes{3, 5, 8, 191, 50, 50, 50, 50});
+
+	auto [source_width, source_height, width, height] = GENERATE(table<int,int,int,int>({
+		{7, 5, 3, 2}, {64, 48, 10, 7}, {133, 100, 17, 13}, {20, 20, 20, 20}, {3, 2, 6, 4}}));
+	// rows with padding
+	std::size_t source_stride = 4 * source_width + 12, stride = 4 * width + 4;
+	source = randomBytes(source_width, source_stride * source_height);
+	Bytes expected(stride * height), scaled(stride * height);
+	PixelConversion::Scalar::downscale(source.data(), source_width, source_height, source_stride,
+			expected.data(), width, height, stride);
+	PixelConversion::downscale(source.data(), source_width, source_height, source_stride,
+			scaled.data(), width, height, stride);
+	CHECK(scaled == expected);
+	if(width == source_width && height == source_height)
+		for(int y = 0; y < height; ++y)
+			CHECK(Bytes(scaled.begin() + y * stride, scaled.begin() + y * stride + 4 * width) ==
+					Bytes(source.begin() + y * source_stride, source.begin() + y * source_stride + 4 * width));
+}
+
+TEST_CASE("Benchmark pixel conversions", "[.][benchmark][Support][PixelConversion]") {
+	// a 1024x768 image, about what is decoded for a thumbnail
+	constexpr std::size_t n = 1024 * 768;
+	Bytes rgba = randomBytes(1, 4 * n);
+	Pixels argb(n);
+	Bytes scaled(256 * 192 * 4);
+	INFO("instruction set: " << PixelConversion::getInstructionSet());
+
+	BENCHMARK("RGB to ARGB32 (scalar)") {
+		PixelConversion::Scalar::rgbToARGB32(rgba.data(), argb.data(), n);
+		return argb[n / 2];
+	};
+	BENCHMARK("RGB to ARGB32") {
+		PixelConversion::rgbToARGB32(rgba.data(), argb.data(), n);
+		return argb[n / 2];
+	};
+	BENCHMARK("RGBA to ARGB32 (scalar)") {
+		PixelConversion::Scalar::rgbaToARGB32(rgba.data(), argb.data(), n);
+		return argb[n / 2];
+	};
+	BENCHMARK("RGBA to ARGB32") {
+		PixelConversion::rgbaToARGB32(rgba.data(), argb.data(), n);
+		return argb[n / 2];
+	};
+	BENCHMARK("downscale 1024x768 to 256x192 (scalar)") {
+		PixelConversion::Scalar::downscale(rgba.data(), 1024, 768, 4096, scaled.data(), 256, 192, 1024);
+		return scaled[0];
+	};
+	BENCHMARK("downscale 1024x768 to 256x192") {
+		PixelConversion::downscale(rgba.data(), 1024, 768, 4096, scaled.data(), 256, 192, 1024);
+		return scaled[0];
+	};
+}
+
+} /* namespace PixelConversion_tests */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
@@ -0,0 +1,133 @@
+/*
+ * QueuedWrites_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "Record/AlbumRecord.h"
+#include "exceptions.h"
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::AlbumRecord;
+using PhotoLibrary::DatabaseInterface::constraint_error;
+
+TEST_CASE("Test queued writes", "[queueWrite][backend]") {
+	BackendFactory db { ":memory:" };
+	std::vector<int> ids;
+	for(const char* name : {"2014", "2015", "2016"}) {
+		AlbumRecord album(0, AlbumRecord::Options::NONE, name);
+		db.newEntry(album);
+		ids.push_back(db.getID(album));
+	}
+
+	SECTION("A thread should read its own queued writes") {
+		for(int id : ids)
+			db.queueWrite([id](BackendFactory& backend) {
+				backend.setOptionBits<AlbumRecord>(std::vector<int>{id}, AlbumRecord::Options::ROW_EXPANDED, true);
+			});
+		for(int id : ids)
+			CHECK(db.getEntry<AlbumRecord>(id).getOptions() == AlbumRecord::Options::ROW_EXPANDED);
+
+		db.queueWrite([&ids](BackendFactory& backend) { backend.setParent<AlbumRecord>(ids[2], ids[0]); });
+		CHECK(db.getChildren<AlbumRecord>(ids[0]) == std::vector<int>{ids[2]});
+	}
+
+	SECTION("Failing writes should be reported and not affect the others") {
+		std::mutex errors_mutex;
+		int n_constraint_errors = 0;
+		db.setWriteErrorHandler([&](std::exception_ptr error) {
+			std::lock_guard<std::mutex> lck {errors_mutex};
+			try {
+				std::rethrow_exception(error);
+			}
+			catch (const constraint_error&) {
+				++n_constraint_errors;
+			}
+		});
+		db.queueWrite([&ids](BackendFactory& backend) { backend.setParent<AlbumRecord>(ids[1], ids[0]); });
+		db.queueWrite([&ids](BackendFactory& backend) {
+			backend.updateEntry(ids[2], AlbumRecord(0, AlbumRecord::Options::NONE, "renamed"));
+			backend.setParent<AlbumRecord>(ids[2], 1000);
+		});
+		db.queueWrite([&ids](BackendFactory& backend) { backend.setParent<AlbumRecord>(ids[0], 0); });
+		db.flushWrites();
+
+		std::lock_guard<std::mutex> lck {errors_mutex};
+		CHECK(n_constraint_errors == 1);
+		CHECK(db.getEntry<AlbumRecord>(ids[1]).getParent() == ids[0]);
+		// the failing write is rolled back completely
+		CHECK(db.getEntry<AlbumRecord>(ids[2]).getAlbumName() == "2016");
+		CHECK(db.getEntry<AlbumRecord>(ids[2]).getParent() == 0);
+	}
+
+	SECTION("Only the changes of committed writes should be reported") {
+		db.setWriteErrorHandler([](std::exception_ptr) {});
+		std::mutex changes_mutex;
+		std::vector<int> updated;
+		db.addChangeObserver([&](const BackendFactory::Change& change) {
+			std::lock_guard<std::mutex> lck {changes_mutex};
+			if(change.type == BackendFactory::Change::Type::UPDATED)
+				updated.push_back(change.id);
+		});
+		db.queueWrite([&ids](BackendFactory& backend) {
+			backend.updateEntry(ids[0], AlbumRecord(0, AlbumRecord::Options::NONE, "renamed"));
+			throw(std::runtime_error("rolled back"));
+		});
+		db.queueWrite([&ids](BackendFactory& backend) {
+			backend.updateEntry(ids[1], AlbumRecord(0, AlbumRecord::Options::NONE, "renamed"));
+		});
+		db.flushWrites();
+
+		std::lock_guard<std::mutex> lck {changes_mutex};
+		CHECK(updated == std::vector<int>{ids[1]});
+		CHECK(db.getEntry<AlbumRecord>(ids[0]).getAlbumName() == "2014");
+	}
+
+	SECTION("Other threads shouldn't write into the transaction of the queued writes") {
+		db.setWriteErrorHandler([](std::exception_ptr) {});
+		std::atomic<bool> started {false};
+		std::thread writer([&db, &started]() {
+			db.queueWrite([&started](BackendFactory&) {
+				started = true;
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+				throw(std::runtime_error("rolled back"));
+			});
+		});
+		writer.join();
+		while(!started)
+			std::this_thread::yield();
+		// waits until the failing write has been rolled back
+		db.newEntry(AlbumRecord(0, AlbumRecord::Options::NONE, "2017"));
+		db.flushWrites();
+		CHECK(db.getChildren<AlbumRecord>(0).size() == 4);
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
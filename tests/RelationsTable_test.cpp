@@ -80,6 +80,54 @@ TEST_CASE("Tests for RelationsTable", "[DatabaseInterface][RelationsTable]") {
 	CHECK(relations.getNumberCollections(9, relation_table) == 1);
 }
 
+TEST_CASE("Tests for the bulk operations of RelationsTable", "[DatabaseInterface][RelationsTable]") {
+	SQLiteAdapter::Database db { ":memory:" };
+	RelationsTable relations { db };
+
+	const char* create_table = "CREATE TABLE Relations( entry INTEGER, col INTEGER, UNIQUE (entry, col));"
+			"INSERT INTO Relations (col, entry) VALUES (7, 42);";
+	const std::array<const std::string,3> relation_table {"Relations", "col", "entry"};
+	db.querry(create_table, nullptr, nullptr);
+
+	std::vector<int> entries {3, 5, 8, 13, 42};
+	CHECK(relations.newRelations(entries, 7, relation_table) == 4);
+	CHECK_THAT(relations.getEntries(7, relation_table), Catch::UnorderedEquals(entries));
+	CHECK(relations.newRelations(entries, 7, relation_table) == 0);
+	CHECK(relations.newRelations(std::vector<int>{}, 7, relation_table) == 0);
+
+	std::vector<int> collections {7, 11, 12};
+	CHECK(relations.newRelations(std::vector<int>{1, 3}, collections, relation_table) == 5);
+	CHECK_THAT(relations.getCollections(3, relation_table), Catch::UnorderedEquals(collections));
+	CHECK_THAT(relations.getCollections(1, relation_table), Catch::UnorderedEquals(collections));
+	CHECK(relations.getNumberEntries(7, relation_table) == 6);
+
+	CHECK(relations.deleteRelations(std::vector<int>{5, 8, 9}, 7, relation_table) == 2);
+	CHECK_THAT(relations.getEntries(7, relation_table), Catch::UnorderedEquals(std::vector<int>{1, 3, 13, 42}));
+	CHECK(relations.deleteRelations(std::vector<int>{5, 8, 9}, 7, relation_table) == 0);
+
+	CHECK(relations.deleteRelations(std::vector<int>{1, 3, 13}, std::vector<int>{7, 11}, relation_table) == 5);
+	CHECK(relations.getEntries(7, relation_table) == std::vector<int>{42});
+	CHECK(relations.getEntries(11, relation_table).empty());
+	CHECK_THAT(relations.getEntries(12, relation_table), Catch::UnorderedEquals(std::vector<int>{1, 3}));
+}
+
+TEST_CASE("Tests for counting a selection of entries per collection", "[DatabaseInterface][RelationsTable]") {
+	SQLiteAdapter::Database db { ":memory:" };
+	RelationsTable relations { db };
+
+	const char* create_table = "CREATE TABLE Relations( entry INTEGER, col INTEGER, UNIQUE (entry, col));"
+			"INSERT INTO Relations (col, entry) VALUES (1, 1), (1, 2), (1, 3), (2, 2), (3, 4);";
+	const std::array<const std::string,3> relation_table {"Relations", "col", "entry"};
+	db.querry(create_table, nullptr, nullptr);
+
+	CHECK(relations.getNumberEntriesPerCollection(std::vector<int>{}, relation_table).empty());
+	CHECK(relations.getNumberEntriesPerCollection(std::vector<int>{5, 6}, relation_table).empty());
+	CHECK(relations.getNumberEntriesPerCollection(std::vector<int>{1, 2, 3}, relation_table)
+			== std::unordered_map<int,int>{{1, 3}, {2, 1}});
+	CHECK(relations.getNumberEntriesPerCollection(std::vector<int>{2, 4, 5}, relation_table)
+			== std::unordered_map<int,int>{{1, 1}, {2, 1}, {3, 1}});
+}
+
 } /* namespace DatabaseInterface_tests */
 } /* namespace DatabaseInterface */
 } /* namespace PhotoLibrary */
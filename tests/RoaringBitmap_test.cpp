@@ -0,0 +1,142 @@
+/*
+ * RoaringBitmap_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../src/Support/RoaringBitmap.h"
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace RoaringBitmap_tests {
+
+using Values = std::set<RoaringBitmap::value_type>;
+
+/**
+ * Random values: dense in [0, 2^16) (bitmap containers), sparse
+ * above (array containers).
+ */
+Values randomValues(unsigned int seed, int n_dense, int n_sparse) {
+	std::mt19937 generator(seed);
+	std::uniform_int_distribution<RoaringBitmap::value_type> dense(0, 0xFFFF);
+	std::uniform_int_distribution<RoaringBitmap::value_type> sparse(0x10000, 0x4FFFF);
+	Values values;
+	for(int i = 0; i < n_dense; ++i)
+		values.insert(dense(generator));
+	for(int i = 0; i < n_sparse; ++i)
+		values.insert(sparse(generator));
+	return values;
+}
+
+std::vector<RoaringBitmap::value_type> toVector(const Values& values) {
+	return std::vector<RoaringBitmap::value_type>(values.begin(), values.end());
+}
+
+TEST_CASE("Test RoaringBitmap's basic functionality", "[Support][RoaringBitmap]") {
+	RoaringBitmap bitmap;
+	CHECK(bitmap.empty());
+	CHECK(bitmap.cardinality() == 0);
+	CHECK(bitmap.toVector().empty());
+
+	CHECK(bitmap.add(5));
+	CHECK_FALSE(bitmap.add(5));
+	CHECK(bitmap.add(70000));
+	CHECK(bitmap.add(3));
+	CHECK(bitmap.contains(5));
+	CHECK(bitmap.contains(70000));
+	CHECK_FALSE(bitmap.contains(4));
+	CHECK_FALSE(bitmap.contains(70001));
+	CHECK(bitmap.cardinality() == 3);
+	CHECK(bitmap.toVector() == std::vector<RoaringBitmap::value_type>{3, 5, 70000});
+
+	CHECK(bitmap.remove(70000));
+	CHECK_FALSE(bitmap.remove(70000));
+	CHECK_FALSE(bitmap.remove(8));
+	CHECK(bitmap == RoaringBitmap{3, 5});
+
+	bitmap.clear();
+	CHECK(bitmap.empty());
+	CHECK(bitmap == RoaringBitmap());
+}
+
+TEST_CASE("Test RoaringBitmap's conversion between containers", "[Support][RoaringBitmap]") {
+	RoaringBitmap bitmap;
+	const RoaringBitmap::value_type n = RoaringBitmap::max_array_size + 100;
+	for(RoaringBitmap::value_type i = 0; i < n; ++i)
+		CHECK(bitmap.add(i * 2));
+	CHECK(bitmap.cardinality() == n);
+	CHECK(bitmap.contains(2 * (n - 1)));
+	CHECK_FALSE(bitmap.contains(2 * n - 1));
+
+	for(RoaringBitmap::value_type i = 0; i < 200; ++i)
+		CHECK(bitmap.remove(i * 2));
+	CHECK(bitmap.cardinality() == n - 200);
+	std::vector<RoaringBitmap::value_type> expected;
+	for(RoaringBitmap::value_type i = 200; i < n; ++i)
+		expected.push_back(i * 2);
+	CHECK(bitmap.toVector() == expected);
+	CHECK(bitmap == RoaringBitmap(expected.begin(), expected.end()));
+}
+
+TEST_CASE("Test RoaringBitmap's set operations", "[Support][RoaringBitmap]") {
+	auto [n_dense_a, n_dense_b] = GENERATE(table<int,int>({{100, 100}, {20000, 30}, {30, 20000}, {20000, 40000}}));
+	Values a_values = randomValues(1, n_dense_a, 3000);
+	Values b_values = randomValues(2, n_dense_b, 5000);
+	RoaringBitmap a(a_values.begin(), a_values.end());
+	RoaringBitmap b(b_values.begin(), b_values.end());
+
+	CHECK(a.cardinality() == a_values.size());
+	CHECK(a.toVector() == toVector(a_values));
+
+	Values expected;
+	std::set_intersection(a_values.begin(), a_values.end(), b_values.begin(), b_values.end(),
+			std::inserter(expected, expected.end()));
+	CHECK((a & b).toVector() == toVector(expected));
+	CHECK(a.andCardinality(b) == expected.size());
+	CHECK(b.andCardinality(a) == expected.size());
+
+	expected.clear();
+	std::set_union(a_values.begin(), a_values.end(), b_values.begin(), b_values.end(),
+			std::inserter(expected, expected.end()));
+	CHECK((a | b).toVector() == toVector(expected));
+	CHECK((a | b) == RoaringBitmap(expected.begin(), expected.end()));
+
+	expected.clear();
+	std::set_difference(a_values.begin(), a_values.end(), b_values.begin(), b_values.end(),
+			std::inserter(expected, expected.end()));
+	CHECK((a - b).toVector() == toVector(expected));
+	CHECK((a - b) == RoaringBitmap(expected.begin(), expected.end()));
+
+	RoaringBitmap c(a);
+	c -= a;
+	CHECK(c.empty());
+	c |= b;
+	CHECK(c == b);
+	c &= a;
+	CHECK(c == (a & b));
+}
+
+} /* namespace RoaringBitmap_tests */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */
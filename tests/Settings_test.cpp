@@ -0,0 +1,88 @@
+/*
+ * Settings_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "Record/AlbumRecord.h"
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <filesystem>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using WindowProperties = BackendFactory::WindowProperties;
+
+TEST_CASE("Test saving window properties", "[WindowProperties][backend]") {
+	BackendFactory db { ":memory:" };
+	CHECK(db.getWindowProperty(WindowProperties::WINDOW_WIDTH) == 1800);
+	CHECK(db.getWindowProperty(WindowProperties::TILE_WIDTH) == 250);
+	CHECK(db.getWindowProperty(WindowProperties::N_THREADS) >= 1);
+	CHECK_FALSE(db.saveWindowProperties());
+
+	for(int width = 1000; width < 1100; ++width)
+		db.setWindowProperty(WindowProperties::WINDOW_WIDTH, width);
+	db.setWindowProperty(WindowProperties::TILE_WIDTH, 180);
+	CHECK(db.getWindowProperty(WindowProperties::WINDOW_WIDTH) == 1099);
+
+	SECTION("Changes should only be saved after the given time without changes") {
+		CHECK_FALSE(db.saveWindowProperties(std::chrono::hours(1)));
+		CHECK(db.saveWindowProperties());
+		CHECK_FALSE(db.saveWindowProperties());
+		db.flushWrites();
+
+		db.setWindowProperty(WindowProperties::WINDOW_WIDTH, 500);
+		db.loadWindowProperties();
+		CHECK(db.getWindowProperty(WindowProperties::WINDOW_WIDTH) == 1099);
+		CHECK(db.getWindowProperty(WindowProperties::TILE_WIDTH) == 180);
+		CHECK(db.getWindowProperty(WindowProperties::WINDOW_HEIGHT) == 1200);
+	}
+
+	SECTION("Unsaved changes should be discarded when loading") {
+		db.loadWindowProperties();
+		CHECK(db.getWindowProperty(WindowProperties::WINDOW_WIDTH) == 1800);
+		CHECK_FALSE(db.saveWindowProperties());
+	}
+
+	SECTION("Setting the saved value again shouldn't cause a write") {
+		CHECK(db.saveWindowProperties());
+		db.setWindowProperty(WindowProperties::TILE_WIDTH, 180);
+		CHECK_FALSE(db.saveWindowProperties());
+	}
+}
+
+TEST_CASE("Test reopening a database file", "[WindowProperties][backend]") {
+	auto filename = std::filesystem::temp_directory_path() / "PhotoLibrary_Settings_test.db";
+	std::filesystem::remove(filename);
+	{
+		BackendFactory db { filename.c_str() };
+		db.setWindowProperty(WindowProperties::TILE_WIDTH, 180);
+		db.newEntry(RecordClasses::AlbumRecord(0, RecordClasses::AlbumRecord::Options::NONE, "Album"));
+	}
+	{
+		BackendFactory db { filename.c_str() };
+		CHECK(db.getWindowProperty(WindowProperties::TILE_WIDTH) == 180);
+		CHECK(db.getChildren<RecordClasses::AlbumRecord>(0).size() == 1);
+	}
+	std::filesystem::remove(filename);
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
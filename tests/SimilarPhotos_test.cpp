@@ -0,0 +1,102 @@
+/*
+ * SimilarPhotos_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "FileFingerprint.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::DirectoryRecord;
+using RecordClasses::PhotoRecord;
+
+TEST_CASE("Test finding similar photos", "[findSimilarPhotos][backend]") {
+	BackendFactory db { ":memory:" };
+	using V = std::vector<int>;
+	using H = std::vector<std::uint64_t>;
+
+	int d_photos = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "Photos", "/home/user/Photos"), db);
+	int d_2020 = add(DirectoryRecord(d_photos, DirectoryRecord::Options::NONE, "2020", "2020"), db);
+	int p1 = add(PhotoRecord(d_photos, "1.jpg"), db);
+	int p2 = add(PhotoRecord(d_2020, "2.jpg"), db);
+	int p3 = add(PhotoRecord(d_2020, "3.jpg"), db);
+	int p4 = add(PhotoRecord(d_2020, "4.jpg"), db);
+	int p5 = add(PhotoRecord(d_photos, "5.jpg"), db);
+
+	SECTION("New photos should be returned for hashing with their paths") {
+		auto photos = db.getUnhashedPhotos(0, 100);
+		CHECK(ids(photos) == V{p1, p2, p3, p4, p5});
+		CHECK(photos[0].path == "/home/user/Photos/1.jpg");
+		CHECK(photos[1].path == "/home/user/Photos/2020/2.jpg");
+		CHECK(ids(db.getUnhashedPhotos(p2, 2)) == V{p3, p4});
+
+		db.setPerceptualHashes(V{p1, p3}, H{1, 2});
+		CHECK(ids(db.getUnhashedPhotos(0, 100)) == V{p2, p4, p5});
+
+		db.queueWrite([=](BackendFactory& backend) { backend.setPerceptualHashes(V{p2, p4, p5}, H{3, 4, 5}); });
+		CHECK(db.getUnhashedPhotos(0, 100).empty());
+	}
+
+	SECTION("Photos that couldn't be hashed should only be returned again when their file changes") {
+		db.setPerceptualHashesFailed(V{p2, p4});
+		CHECK(ids(db.getUnhashedPhotos(0, 100)) == V{p1, p3, p5});
+		db.updatePhotoFiles(V{p2, p4}, std::vector<PhotoRecord>{PhotoRecord(d_2020, "2.jpg"), PhotoRecord(d_2020, "4.jpg")},
+				std::vector<FileFingerprint>{{100, 200, 300}, {0, 0, 0}});
+		CHECK(ids(db.getUnhashedPhotos(0, 100)) == V{p1, p2, p3, p5});
+	}
+
+	SECTION("Changed files should be hashed again") {
+		db.setPerceptualHashes(V{p1, p2, p3, p4, p5}, H{1, 2, 3, 4, 5});
+		db.updatePhotoFiles(V{p2, p4}, std::vector<PhotoRecord>{PhotoRecord(d_2020, "2.jpg"), PhotoRecord(d_2020, "4.jpg")},
+				std::vector<FileFingerprint>{{100, 200, 300}, {0, 0, 0}});
+		CHECK(ids(db.getUnhashedPhotos(0, 100)) == V{p2});
+	}
+
+	SECTION("Photos with close hashes should be grouped") {
+		const std::uint64_t a = 0x0123456789ABCDEF;
+		const std::uint64_t b = 0xFEDCBA9876543210;
+		// p1, p3 and p5 form a chain: p1 and p5 are only similar through p3
+		db.setPerceptualHashes(V{p1, p2, p3, p4, p5}, H{a, b, a ^ 0b1111, b ^ (1ull << 63), a ^ 0b11111111});
+		CHECK(db.findSimilarPhotos(0).empty());
+		CHECK(db.findSimilarPhotos(1) == std::vector<V>{{p2, p4}});
+		CHECK(db.findSimilarPhotos(4) == std::vector<V>{{p1, p3, p5}, {p2, p4}});
+		CHECK(db.findSimilarPhotos(64) == std::vector<V>{{p1, p2, p3, p4, p5}});
+
+		CHECK(db.getSimilarPhotos(p1, 4) == V{p3});
+		CHECK(db.getSimilarPhotos(p1, 8) == V{p3, p5});
+		CHECK(db.getSimilarPhotos(p3, 4) == V{p1, p5});
+		CHECK(db.getSimilarPhotos(p2, 0).empty());
+
+		db.updatePhotoFiles(V{p3}, std::vector<PhotoRecord>{PhotoRecord(d_2020, "3.jpg")},
+				std::vector<FileFingerprint>{{1, 1, 1}});
+		CHECK(db.getSimilarPhotos(p3, 64).empty());
+		CHECK(db.findSimilarPhotos(4) == std::vector<V>{{p2, p4}});
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
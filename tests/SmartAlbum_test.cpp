@@ -0,0 +1,178 @@
+/*
+ * SmartAlbum_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "Record/AlbumRecord.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/KeywordRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::AlbumRecord;
+using RecordClasses::DirectoryRecord;
+using RecordClasses::KeywordRecord;
+using RecordClasses::PhotoRecord;
+using Relations = BackendFactory::Relations;
+
+namespace {
+
+std::vector<int> photosIn(int album, BackendFactory& db) {
+	std::vector<int> photos;
+	for(auto photo : db.getEntriesBitmap<Relations::PHOTOS_ALBUMS>(album).toVector())
+		photos.push_back(static_cast<int>(photo));
+	return photos;
+}
+
+}
+
+TEST_CASE("Test smart albums", "[SmartAlbum][backend]") {
+	BackendFactory db { ":memory:" };
+	using V = std::vector<int>;
+
+	int d1 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2020", "/home/user/Photos/2020"), db);
+	int d2 = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "2021", "/home/user/Photos/2021"), db);
+
+	int p1 = add(PhotoRecord(d1, "1.jpg", 1, 1590000000, 1920, 1080), db);
+	int p2 = add(PhotoRecord(d1, "2.jpg", 3, 1590500000, 1080, 1920), db);
+	int p3 = add(PhotoRecord(d2, "3.jpg", 5, 1621252800, 4000, 3000), db);
+
+	int k_places = add(KeywordRecord(0, KeywordRecord::Options::NONE, "Places"), db);
+	int k_venice = add(KeywordRecord(k_places, KeywordRecord::Options::NONE, "Venice"), db);
+	int k_people = add(KeywordRecord(0, KeywordRecord::Options::NONE, "People"), db);
+	db.newRelation<Relations::PHOTOS_KEYWORDS>(p1, k_venice);
+
+	int a_best = add(AlbumRecord(0, AlbumRecord::Options::NONE, "Best"), db);
+	int s_good = db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Good"), "rating>=3");
+	int s_places = db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Places"), "keyword:Places");
+
+	SECTION("New smart albums should contain all matching photos") {
+		CHECK(photosIn(s_good, db) == V{p2, p3});
+		CHECK(photosIn(s_places, db) == V{p1});
+		CHECK(db.getNumberPhotos<AlbumRecord>(s_good, false) == 2);
+		CHECK(db.getSmartAlbumRule(s_good) == "rating>=3");
+		AlbumRecord record = db.getEntry<AlbumRecord>(s_good);
+		CHECK((record.getOptions() & AlbumRecord::Options::SMART_ALBUM));
+		CHECK_THROWS_AS(db.getSmartAlbumRule(a_best), DatabaseInterface::missing_entry);
+	}
+
+	SECTION("Invalid rules should not add an album") {
+		CHECK_THROWS_AS(db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Bad"), "rating>"), filter_error);
+		CHECK_THROWS_AS(db.getID(AlbumRecord(0, AlbumRecord::Options::NONE, "Bad")), DatabaseInterface::missing_entry);
+		CHECK_THROWS_AS(db.setSmartAlbumRule(s_good, "rating>"), filter_error);
+		CHECK(db.getSmartAlbumRule(s_good) == "rating>=3");
+		CHECK_THROWS_AS(db.setSmartAlbumRule(a_best, "rating>=1"), DatabaseInterface::missing_entry);
+	}
+
+	SECTION("Smart albums should follow changes of photos") {
+		int p4 = add(PhotoRecord(d2, "4.jpg", 4, 1621252900, 640, 480), db);
+		CHECK(photosIn(s_good, db) == V{p2, p3, p4});
+
+		db.updateEntry(p2, PhotoRecord(d1, "2.jpg", 2, 1590500000, 1080, 1920));
+		CHECK(photosIn(s_good, db) == V{p3, p4});
+
+		db.deleteEntry<PhotoRecord>(p3);
+		CHECK(photosIn(s_good, db) == V{p4});
+	}
+
+	SECTION("Smart albums should follow changes of relations") {
+		db.newRelations<Relations::PHOTOS_KEYWORDS>(std::vector<int>{p2, p3}, k_venice);
+		CHECK(photosIn(s_places, db) == V{p1, p2, p3});
+
+		db.deleteRelation<Relations::PHOTOS_KEYWORDS>(p1, k_venice);
+		CHECK(photosIn(s_places, db) == V{p2, p3});
+
+		int s_best = db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Best good"), "album:Best");
+		CHECK(photosIn(s_best, db).empty());
+		db.newRelation<Relations::PHOTOS_ALBUMS>(p1, a_best);
+		CHECK(photosIn(s_best, db) == V{p1});
+	}
+
+	SECTION("Smart albums should follow changes of keywords") {
+		db.setParent<KeywordRecord>(k_venice, k_people);
+		CHECK(photosIn(s_places, db).empty());
+
+		db.updateEntry(k_people, KeywordRecord(0, KeywordRecord::Options::NONE, "Places and people"));
+		db.setSmartAlbumRule(s_places, "keyword:\"Places and people\"");
+		CHECK(photosIn(s_places, db) == V{p1});
+
+		db.deleteEntry<KeywordRecord>(k_venice);
+		CHECK(photosIn(s_places, db).empty());
+	}
+
+	SECTION("Photos added by hand should stay in smart albums") {
+		db.newRelation<Relations::PHOTOS_ALBUMS>(p1, s_good);
+		db.newRelations<Relations::PHOTOS_ALBUMS>(std::vector<int>{p2}, s_good);
+		CHECK(photosIn(s_good, db) == V{p1, p2, p3});
+
+		db.updateEntry(p1, PhotoRecord(d1, "1.jpg", 2, 1590000000, 1920, 1080));
+		db.updateEntry(p2, PhotoRecord(d1, "2.jpg", 1, 1590500000, 1080, 1920));
+		db.updateEntry(p3, PhotoRecord(d2, "3.jpg", 1, 1621252800, 4000, 3000));
+		CHECK(photosIn(s_good, db) == V{p1, p2});
+
+		db.setSmartAlbumRule(s_good, "rating>=4");
+		CHECK(photosIn(s_good, db) == V{p1, p2});
+		db.deleteRelation<Relations::PHOTOS_ALBUMS>(p1, s_good);
+		CHECK(photosIn(s_good, db) == V{p2});
+	}
+
+	SECTION("Smart albums should be evaluated after the smart albums they refer to") {
+		int s_first = db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "First"), "album:Second");
+		int s_second = db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Second"), "album:Good");
+		CHECK(photosIn(s_second, db) == V{p2, p3});
+		CHECK(photosIn(s_first, db) == V{p2, p3});
+
+		int p4 = add(PhotoRecord(d2, "4.jpg", 4, 1621252900, 640, 480), db);
+		CHECK(photosIn(s_first, db) == V{p2, p3, p4});
+
+		db.setSmartAlbumRule(s_good, "rating>=5");
+		CHECK(photosIn(s_first, db) == V{p3});
+
+		db.updateEntry(s_good, AlbumRecord(0, AlbumRecord::Options::SMART_ALBUM, "Very good"));
+		CHECK(photosIn(s_second, db).empty());
+		CHECK(photosIn(s_first, db).empty());
+	}
+
+	SECTION("Rules referring to each other in a cycle should be rejected") {
+		CHECK_THROWS_AS(db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Self"), "album:Self"), filter_error);
+		CHECK_THROWS_AS(db.getID(AlbumRecord(0, AlbumRecord::Options::NONE, "Self")), DatabaseInterface::missing_entry);
+
+		int s_best = db.newSmartAlbum(AlbumRecord(0, AlbumRecord::Options::NONE, "Best places"), "album:Places AND rating>=1");
+		CHECK(photosIn(s_best, db) == V{p1});
+		CHECK_THROWS_AS(db.setSmartAlbumRule(s_places, "album:\"Best places\""), filter_error);
+		CHECK(db.getSmartAlbumRule(s_places) == "keyword:Places");
+		CHECK(photosIn(s_places, db) == V{p1});
+	}
+
+	SECTION("Deleted smart albums should no longer be updated") {
+		db.deleteEntry<AlbumRecord>(s_good);
+		CHECK_THROWS_AS(db.getSmartAlbumRule(s_good), DatabaseInterface::missing_entry);
+		add(PhotoRecord(d2, "4.jpg", 4, 1621252900, 640, 480), db);
+		CHECK(photosIn(s_good, db).empty());
+		CHECK(photosIn(s_places, db) == V{p1});
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
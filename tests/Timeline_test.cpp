@@ -0,0 +1,101 @@
+/*
+ * Timeline_test.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "BackendFactory.h"
+#include "BackendFactory_tests.h"
+#include "Record/DirectoryRecord.h"
+#include "Record/PhotoRecord.h"
+#include <catch2/catch.hpp>
+#include <stdexcept>
+
+namespace PhotoLibrary {
+namespace Backend {
+namespace Tests {
+
+using RecordClasses::DirectoryRecord;
+using RecordClasses::PhotoRecord;
+using PhotoOrder = BackendFactory::PhotoOrder;
+using Periods = std::vector<BackendFactory::TimelinePeriod>;
+
+TEST_CASE("Test the timeline", "[Timeline][backend]") {
+	BackendFactory db { ":memory:" };
+	CHECK(db.getTimeline().empty());
+
+	int dir = add(DirectoryRecord(0, DirectoryRecord::Options::NONE, "Photos", "/home/user/Photos"), db);
+	// 2020-05-20 18:40, 2021-05-17 00:00, 2021-05-17 23:59:59, 2021-06-01 00:00
+	int p1 = add(PhotoRecord(dir, "1.jpg", 0, 1590000000, 100, 100), db);
+	int p2 = add(PhotoRecord(dir, "2.jpg", 0, 1621209600, 100, 100), db);
+	int p3 = add(PhotoRecord(dir, "3.jpg", 0, 1621295999, 100, 100), db);
+	int p4 = add(PhotoRecord(dir, "4.jpg", 0, 1622505600, 100, 100), db);
+	// without a date
+	std::vector<int> undated = {add(PhotoRecord(dir, "5.jpg", 0, 0, 100, 100), db)};
+
+	CHECK(db.getTimeline() == Periods{{2020, 0, 0, 1}, {2021, 0, 0, 3}});
+	CHECK(db.getTimeline(1970).empty());
+	CHECK(db.getTimeline(2021) == Periods{{2021, 5, 0, 2}, {2021, 6, 0, 1}});
+	CHECK(db.getTimeline(2021, 5) == Periods{{2021, 5, 17, 2}});
+	CHECK(db.getTimeline(2019).empty());
+	CHECK(db.checkPhotoCounts());
+
+	using V = std::vector<int>;
+	CHECK(db.getPhotosTaken(2021) == V{p2, p3, p4});
+	CHECK(db.getPhotosTaken(2021, 5) == V{p2, p3});
+	CHECK(db.getPhotosTaken(2021, 5, 17, PhotoOrder::DATETIME, true) == V{p3, p2});
+	CHECK(db.getPhotosTaken(2021, 5, 18).empty());
+	CHECK(db.getPhotosTaken(2020, 5, 20) == V{p1});
+	CHECK(db.getPhotosTaken(1970).empty());
+	CHECK_THROWS_AS(db.getPhotosTaken(2021, 13), std::invalid_argument);
+	CHECK_THROWS_AS(db.getPhotosTaken(2021, 2, 29), std::invalid_argument);
+	CHECK_THROWS_AS(db.getPhotosTaken(2021, 0, 1), std::invalid_argument);
+
+	SECTION("The timeline should follow changes of the photos") {
+		db.updateEntry(p4, PhotoRecord(dir, "4.jpg", 0, 1590000000, 100, 100));
+		db.deletePhotos(undated);
+		db.deleteEntry<PhotoRecord>(p3);
+		CHECK(db.getTimeline() == Periods{{2020, 0, 0, 2}, {2021, 0, 0, 1}});
+		CHECK(db.getTimeline(2020) == Periods{{2020, 5, 0, 2}});
+		CHECK(db.getTimeline(2020, 5) == Periods{{2020, 5, 20, 2}});
+		CHECK(db.getTimeline(2021, 6).empty());
+		CHECK(db.getPhotosTaken(2020, 5) == V{p1, p4});
+		CHECK(db.checkPhotoCounts());
+
+		db.deleteEntry<DirectoryRecord>(dir);
+		CHECK(db.getTimeline().empty());
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Photos getting a date should be counted") {
+		db.updateEntry(undated[0], PhotoRecord(dir, "5.jpg", 0, 1621209600, 100, 100));
+		CHECK(db.getTimeline(2021, 5) == Periods{{2021, 5, 17, 3}});
+		db.updateEntry(p1, PhotoRecord(dir, "1.jpg", 0, 0, 100, 100));
+		CHECK(db.getTimeline() == Periods{{2021, 0, 0, 4}});
+		CHECK(db.checkPhotoCounts());
+	}
+
+	SECTION("Rebuilding should give the same timeline") {
+		db.rebuildPhotoCounts();
+		CHECK(db.getTimeline() == Periods{{2020, 0, 0, 1}, {2021, 0, 0, 3}});
+		CHECK(db.getTimeline(2021) == Periods{{2021, 5, 0, 2}, {2021, 6, 0, 1}});
+		CHECK(db.checkPhotoCounts());
+	}
+}
+
+} /* namespace Tests */
+} /* namespace Backend */
+} /* namespace PhotoLibrary */
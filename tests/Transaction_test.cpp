@@ -0,0 +1,81 @@
+/*
+ * RelationsTable_tests.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <Database.h>
+#include <SQLQuerry.h>
+#include <Transaction.h>
+#include <catch2/catch.hpp>
+#include <stdexcept>
+
+namespace PhotoLibrary {
+namespace SQLiteAdapter {
+namespace SQLiteAdapter_tests {
+
+namespace {
+
+int countRows(Database& db) {
+	SQLQuerry querry(db, "SELECT COUNT(*) FROM Test;");
+	querry.nextRow();
+	return querry.getColumnInt(0);
+}
+
+}
+
+TEST_CASE("Tests for Transaction", "[SQLiteAdapter][Transaction]") {
+	Database db { ":memory:" };
+	db.querry("CREATE TABLE Test(value INTEGER);", nullptr, nullptr);
+
+	SECTION("Committed changes should be kept") {
+		Transaction transaction(db);
+		db.querry("INSERT INTO Test VALUES (1);", nullptr, nullptr);
+		transaction.commit();
+		CHECK(countRows(db) == 1);
+	}
+
+	SECTION("Changes should be rolled back if an exception is thrown") {
+		CHECK_THROWS_AS([&db]() {
+			Transaction transaction(db);
+			db.querry("INSERT INTO Test VALUES (1);", nullptr, nullptr);
+			throw(std::runtime_error("failed"));
+		}(), std::runtime_error);
+		CHECK(countRows(db) == 0);
+		// no transaction is left open
+		CHECK_NOTHROW(Transaction(db).commit());
+	}
+
+	SECTION("Rolling back a savepoint should keep the enclosing transaction") {
+		Transaction transaction(db);
+		db.querry("INSERT INTO Test VALUES (1);", nullptr, nullptr);
+		{
+			Transaction savepoint(db, "nested");
+			db.querry("INSERT INTO Test VALUES (2);", nullptr, nullptr);
+		}
+		{
+			Transaction savepoint(db, "nested");
+			db.querry("INSERT INTO Test VALUES (3);", nullptr, nullptr);
+			savepoint.commit();
+		}
+		transaction.commit();
+		CHECK(countRows(db) == 2);
+	}
+}
+
+} /* namespace SQLiteAdapter_tests */
+} /* namespace SQLiteAdapter */
+} /* namespace PhotoLibrary */
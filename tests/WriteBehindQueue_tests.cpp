@@ -0,0 +1,132 @@
+/*
+ * WriteBehindQueue_tests.cpp
+ *
+ * This file is part of PhotoLibrary
+ * Copyright (C) 2021 Sven Rieper
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "../src/Support/WriteBehindQueue.h"
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace PhotoLibrary {
+namespace Support {
+
+namespace WriteBehindQueue_tests {
+
+TEST_CASE("Test WriteBehindQueue's group commit", "[support][WriteBehindQueue]") {
+	std::vector<std::size_t> groups;
+	std::promise<void> started;
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	std::vector<int> values;
+	{
+		WriteBehindQueue queue([&](std::vector<WriteBehindQueue::Write>& writes) {
+			groups.push_back(writes.size());
+			for(auto& write : writes)
+				write();
+		}, nullptr, 4);
+		CHECK_FALSE(queue.pending());
+
+		// the first write blocks the writer thread, so the others queue up
+		queue.push([&values, &started, released]() {
+			started.set_value();
+			released.wait();
+			values.push_back(0);
+		});
+		started.get_future().wait();
+		for(int i = 1; i < 7; ++i)
+			queue.push([&values, i]() { values.push_back(i); });
+		CHECK(queue.pending());
+		release.set_value();
+		queue.flush();
+		CHECK_FALSE(queue.pending());
+		CHECK(values == std::vector<int>{0, 1, 2, 3, 4, 5, 6});
+
+		queue.push([&values]() { values.push_back(7); });
+	}
+	// destroying the queue runs the remaining writes
+	CHECK(values.size() == 8);
+	REQUIRE(groups.size() >= 3);
+	CHECK(groups[0] == 1);
+	CHECK(groups[1] == 4);
+	CHECK(groups[2] == 2);
+}
+
+TEST_CASE("Test WriteBehindQueue's read your own writes", "[support][WriteBehindQueue]") {
+	constexpr int n_threads = 4;
+	constexpr int n_writes = 200;
+	std::vector<std::atomic<int>> values(n_threads);
+	WriteBehindQueue queue([](std::vector<WriteBehindQueue::Write>& writes) {
+		for(auto& write : writes)
+			write();
+	}, nullptr);
+
+	std::atomic<int> errors {0};
+	std::vector<std::thread> threads;
+	for(int t = 0; t < n_threads; ++t)
+		threads.emplace_back([&, t]() {
+			for(int i = 1; i <= n_writes; ++i) {
+				queue.push([&values, t, i]() {
+					std::this_thread::yield();
+					values[t] = i;
+				});
+				if(i % 10 == 0) {
+					queue.waitForOwnWrites();
+					if(values[t] != i)
+						++errors;
+				}
+			}
+		});
+	for(auto& thread : threads)
+		thread.join();
+	CHECK(errors == 0);
+
+	// a thread without writes doesn't wait
+	queue.waitForOwnWrites();
+}
+
+TEST_CASE("Test WriteBehindQueue's error handling", "[support][WriteBehindQueue]") {
+	std::vector<std::string> errors;
+	int n_written = 0;
+	{
+		WriteBehindQueue queue([&n_written](std::vector<WriteBehindQueue::Write>& writes) {
+			for(auto& write : writes)
+				write();
+			n_written += writes.size();
+		}, [&errors](std::exception_ptr error) {
+			try {
+				std::rethrow_exception(error);
+			}
+			catch (const std::runtime_error& e) {
+				errors.push_back(e.what());
+			}
+		});
+		queue.push([]() { throw std::runtime_error("failed"); });
+		queue.flush();
+		queue.push([]() {});
+	}
+	CHECK(errors == std::vector<std::string>{"failed"});
+	CHECK(n_written == 1);
+}
+
+} /* namespace WriteBehindQueue_tests */
+
+} /* namespace Support */
+} /* namespace PhotoLibrary */